@@ -0,0 +1,437 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.cpp
+// ============
+// render the scene offscreen along a scripted camera path and report
+// the frame times as JSON
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+#include "RenderStats.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+// declaration of global variables
+namespace
+{
+	// frames rendered before measuring, once the textures are resident
+	const int WARMUP_FRAMES = 30;
+	// most frames spent waiting for the textures to become resident
+	const int MAX_LOADING_FRAMES = 2000;
+
+	// the camera path sweeps around the front of the house
+	const glm::vec3 PATH_TARGET = glm::vec3(0.0f, 0.3f, 2.8f);
+	const float PATH_SWEEP_DEGREES = 55.0f;
+	const float PATH_MIN_RADIUS = 3.5f;
+	const float PATH_MAX_RADIUS = 6.5f;
+	const float PATH_MIN_HEIGHT = 0.4f;
+	const float PATH_MAX_HEIGHT = 1.8f;
+
+	/***********************************************************
+	 *  EscapeJSON()
+	 *
+	 *  This function is used for escaping the quotes and
+	 *  backslashes of a string written into the JSON report.
+	 ***********************************************************/
+	std::string EscapeJSON(const std::string& text)
+	{
+		std::string escaped;
+		for (char c : text)
+		{
+			if ((c == '"') || (c == '\\'))
+			{
+				escaped += '\\';
+			}
+			escaped += c;
+		}
+		return(escaped);
+	}
+
+	/***********************************************************
+	 *  GetGLString()
+	 *
+	 *  This function is used for reading an OpenGL string that
+	 *  may be NULL.
+	 ***********************************************************/
+	std::string GetGLString(GLenum name)
+	{
+		const GLubyte* value = glGetString(name);
+		return((NULL != value) ? std::string((const char*)value) : std::string());
+	}
+}
+
+/***********************************************************
+ *  BenchmarkRunner()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BenchmarkRunner::BenchmarkRunner(const BENCH_OPTIONS& options)
+{
+	m_options = options;
+	m_framebuffer = 0;
+	m_colorBuffer = 0;
+	m_depthBuffer = 0;
+	memset(m_timerQueries, 0, sizeof(m_timerQueries));
+}
+
+/***********************************************************
+ *  ~BenchmarkRunner()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+BenchmarkRunner::~BenchmarkRunner()
+{
+	if (m_timerQueries[0] != 0)
+	{
+		glDeleteQueries(QUERY_RING_SIZE, m_timerQueries);
+	}
+	DestroyRenderTarget();
+}
+
+/***********************************************************
+ *  ParseOptions()
+ *
+ *  This method is used for reading the benchmark settings
+ *  from the command line:
+ *
+ *    --bench [--frames N] [--width W] [--height H]
+ *            [--out report.json] [--egl]
+ *
+ *  The benchmark is enabled only when --bench is present.
+ ***********************************************************/
+BenchmarkRunner::BENCH_OPTIONS BenchmarkRunner::ParseOptions(int argc, char* argv[])
+{
+	BENCH_OPTIONS options;
+	options.bEnabled = false;
+	options.bUseEGL = false;
+	options.frames = 600;
+	options.width = 1280;
+	options.height = 720;
+	options.outputPath = "bench_results.json";
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		bool bHasValue = (i + 1 < argc);
+
+		if (argument == "--bench")
+			options.bEnabled = true;
+		else if (argument == "--egl")
+			options.bUseEGL = true;
+		else if ((argument == "--frames") && bHasValue)
+			options.frames = std::max(1, atoi(argv[++i]));
+		else if ((argument == "--width") && bHasValue)
+			options.width = std::max(1, atoi(argv[++i]));
+		else if ((argument == "--height") && bHasValue)
+			options.height = std::max(1, atoi(argv[++i]));
+		else if ((argument == "--out") && bHasValue)
+			options.outputPath = argv[++i];
+	}
+
+	return(options);
+}
+
+/***********************************************************
+ *  CreateRenderTarget()
+ *
+ *  This method is used for creating the framebuffer object
+ *  the benchmark frames are rendered into, with a color and
+ *  a depth renderbuffer of the requested size.
+ ***********************************************************/
+bool BenchmarkRunner::CreateRenderTarget()
+{
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_options.width, m_options.height);
+
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_options.width, m_options.height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR: benchmark framebuffer is incomplete, status 0x" << std::hex << status << std::dec << std::endl;
+		return(false);
+	}
+
+	glViewport(0, 0, m_options.width, m_options.height);
+
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyRenderTarget()
+ *
+ *  This method is used for freeing the offscreen render
+ *  target.
+ ***********************************************************/
+void BenchmarkRunner::DestroyRenderTarget()
+{
+	if (m_framebuffer != 0)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (m_colorBuffer != 0)
+	{
+		glDeleteRenderbuffers(1, &m_colorBuffer);
+		m_colorBuffer = 0;
+	}
+	if (m_depthBuffer != 0)
+	{
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_depthBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  RenderFrame()
+ *
+ *  This method is used for rendering one frame from the
+ *  camera path.  The camera position depends only on the
+ *  frame index, so every run sees the same frames.
+ ***********************************************************/
+void BenchmarkRunner::RenderFrame(
+	int frameIndex,
+	SceneManager* pSceneManager,
+	ViewManager* pViewManager,
+	ShaderManager* pShaderManager,
+	GLStateCache* pStateCache)
+{
+	// one full sweep over the measured frames
+	float t = (float)frameIndex / (float)m_options.frames;
+	float wave = 0.5f - 0.5f * cosf(t * 2.0f * 3.14159265f);
+	float angle = glm::radians(PATH_SWEEP_DEGREES * sinf(t * 2.0f * 3.14159265f));
+	float radius = PATH_MAX_RADIUS - (PATH_MAX_RADIUS - PATH_MIN_RADIUS) * wave;
+	float height = PATH_MIN_HEIGHT + (PATH_MAX_HEIGHT - PATH_MIN_HEIGHT) * wave;
+
+	glm::vec3 cameraPosition = PATH_TARGET + glm::vec3(radius * sinf(angle), height, radius * cosf(angle));
+	glm::mat4 view = glm::lookAt(cameraPosition, PATH_TARGET, glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(
+		glm::radians(45.0f),
+		(float)m_options.width / (float)m_options.height,
+		0.1f, 100.0f);
+
+	pStateCache->BeginFrame();
+	RenderStats::BeginFrame();
+	pStateCache->Enable(GL_DEPTH_TEST);
+	glClearColor(0.18f, 0.12f, 0.26f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	pStateCache->UseProgram(pShaderManager->m_programID);
+
+	pViewManager->SetCameraUniforms(projection, view, cameraPosition);
+	pSceneManager->SetCameraPosition(cameraPosition);
+	pSceneManager->SetViewFrustum(projection * view);
+	pSceneManager->SetLodProjection(projection);
+	pSceneManager->RenderScene();
+	RenderStats::EndFrame();
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for running the benchmark.  Frames
+ *  are rendered until the textures are resident and the
+ *  driver has warmed up, then the measured frames are
+ *  rendered and the report is written.  The GPU time of
+ *  each frame is read a few frames later, so waiting for a
+ *  query never stalls the measured frames.
+ ***********************************************************/
+bool BenchmarkRunner::Run(
+	SceneManager* pSceneManager,
+	ViewManager* pViewManager,
+	ShaderManager* pShaderManager,
+	GLStateCache* pStateCache)
+{
+	if (!CreateRenderTarget())
+	{
+		return(false);
+	}
+
+	std::cout << "INFO: benchmark on " << GetGLString(GL_RENDERER) << ", "
+		<< m_options.frames << " frames at " << m_options.width << "x" << m_options.height << std::endl;
+
+	// let the background texture loads finish, then warm up
+	int loadingFrames = 0;
+	while (pSceneManager->AreTexturesLoading() && (loadingFrames < MAX_LOADING_FRAMES))
+	{
+		RenderFrame(0, pSceneManager, pViewManager, pShaderManager, pStateCache);
+		loadingFrames++;
+	}
+	for (int i = 0; i < WARMUP_FRAMES; i++)
+	{
+		RenderFrame(0, pSceneManager, pViewManager, pShaderManager, pStateCache);
+	}
+	glFinish();
+
+	glGenQueries(QUERY_RING_SIZE, m_timerQueries);
+	m_samples.assign(m_options.frames, FRAME_SAMPLE());
+
+	for (int frame = 0; frame < m_options.frames; frame++)
+	{
+		int slot = frame % QUERY_RING_SIZE;
+
+		// read the GPU time of the frame that last used this query
+		if (frame >= QUERY_RING_SIZE)
+		{
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(m_timerQueries[slot], GL_QUERY_RESULT, &elapsed);
+			m_samples[frame - QUERY_RING_SIZE].gpuMilliseconds = (double)elapsed / 1.0e6;
+		}
+
+		auto cpuStart = std::chrono::steady_clock::now();
+
+		glBeginQuery(GL_TIME_ELAPSED, m_timerQueries[slot]);
+		RenderFrame(frame, pSceneManager, pViewManager, pShaderManager, pStateCache);
+		glEndQuery(GL_TIME_ELAPSED);
+
+		auto cpuEnd = std::chrono::steady_clock::now();
+
+		FRAME_SAMPLE& sample = m_samples[frame];
+		sample.cpuMilliseconds = std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count();
+		sample.drawCalls = pSceneManager->GetLastFrameDrawCalls();
+
+		// the counters of this frame are closed by the next BeginFrame
+		if (frame > 0)
+		{
+			m_samples[frame - 1].stateCounters = pStateCache->GetLastFrameCounters();
+		}
+	}
+
+	// close the counters of the last frame and read the last queries
+	pStateCache->BeginFrame();
+	m_samples[m_options.frames - 1].stateCounters = pStateCache->GetLastFrameCounters();
+	glFinish();
+	for (int frame = std::max(0, m_options.frames - QUERY_RING_SIZE); frame < m_options.frames; frame++)
+	{
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(m_timerQueries[frame % QUERY_RING_SIZE], GL_QUERY_RESULT, &elapsed);
+		m_samples[frame].gpuMilliseconds = (double)elapsed / 1.0e6;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	return(WriteReport());
+}
+
+/***********************************************************
+ *  Summarize()
+ *
+ *  This method is used for getting the min, mean, max and
+ *  nearest-rank percentiles of a series of values.
+ ***********************************************************/
+BenchmarkRunner::SERIES_SUMMARY BenchmarkRunner::Summarize(std::vector<double> values)
+{
+	SERIES_SUMMARY summary = {};
+	if (values.empty())
+	{
+		return(summary);
+	}
+
+	std::sort(values.begin(), values.end());
+
+	double total = 0.0;
+	for (double value : values)
+	{
+		total += value;
+	}
+
+	auto Percentile = [&](double percent)
+		{
+			size_t rank = (size_t)std::ceil(percent / 100.0 * (double)values.size());
+			return(values[std::min(values.size() - 1, (rank > 0) ? rank - 1 : 0)]);
+		};
+
+	summary.min = values.front();
+	summary.max = values.back();
+	summary.mean = total / (double)values.size();
+	summary.p50 = Percentile(50.0);
+	summary.p95 = Percentile(95.0);
+	summary.p99 = Percentile(99.0);
+
+	return(summary);
+}
+
+/***********************************************************
+ *  WriteReport()
+ *
+ *  This method is used for writing the benchmark report as
+ *  JSON to the output file, and a one-line summary to the
+ *  console.
+ ***********************************************************/
+bool BenchmarkRunner::WriteReport() const
+{
+	std::vector<double> cpuTimes;
+	std::vector<double> gpuTimes;
+	std::vector<double> drawCalls;
+	std::vector<double> programBinds;
+	std::vector<double> textureBinds;
+	std::vector<double> uniformWrites;
+
+	for (const FRAME_SAMPLE& sample : m_samples)
+	{
+		cpuTimes.push_back(sample.cpuMilliseconds);
+		gpuTimes.push_back(sample.gpuMilliseconds);
+		drawCalls.push_back((double)sample.drawCalls);
+		programBinds.push_back((double)sample.stateCounters.programBinds.issued);
+		textureBinds.push_back((double)sample.stateCounters.textureBinds.issued);
+		uniformWrites.push_back((double)sample.stateCounters.uniformWrites.issued);
+	}
+
+	SERIES_SUMMARY cpu = Summarize(cpuTimes);
+	SERIES_SUMMARY gpu = Summarize(gpuTimes);
+	SERIES_SUMMARY draws = Summarize(drawCalls);
+
+	auto WriteTimes = [](std::ofstream& out, const char* name, const SERIES_SUMMARY& summary)
+		{
+			out << "  \"" << name << "\": { \"min\": " << summary.min
+				<< ", \"mean\": " << summary.mean
+				<< ", \"p50\": " << summary.p50
+				<< ", \"p95\": " << summary.p95
+				<< ", \"p99\": " << summary.p99
+				<< ", \"max\": " << summary.max << " },\n";
+		};
+
+	std::ofstream report(m_options.outputPath, std::ios::trunc);
+	if (!report.is_open())
+	{
+		std::cout << "ERROR: could not write benchmark report: " << m_options.outputPath << std::endl;
+		return(false);
+	}
+
+	report << "{\n";
+	report << "  \"renderer\": \"" << EscapeJSON(GetGLString(GL_RENDERER)) << "\",\n";
+	report << "  \"version\": \"" << EscapeJSON(GetGLString(GL_VERSION)) << "\",\n";
+	report << "  \"frames\": " << m_options.frames << ",\n";
+	report << "  \"width\": " << m_options.width << ",\n";
+	report << "  \"height\": " << m_options.height << ",\n";
+	WriteTimes(report, "cpu_frame_ms", cpu);
+	WriteTimes(report, "gpu_frame_ms", gpu);
+	report << "  \"draw_calls_per_frame\": { \"min\": " << draws.min
+		<< ", \"mean\": " << draws.mean
+		<< ", \"max\": " << draws.max << " },\n";
+	report << "  \"state_changes_per_frame\": { \"program_binds\": " << Summarize(programBinds).mean
+		<< ", \"texture_binds\": " << Summarize(textureBinds).mean
+		<< ", \"uniform_writes\": " << Summarize(uniformWrites).mean << " }\n";
+	report << "}\n";
+
+	std::cout << "INFO: benchmark cpu p50 " << cpu.p50 << " ms, p99 " << cpu.p99
+		<< " ms - gpu p50 " << gpu.p50 << " ms, p99 " << gpu.p99
+		<< " ms - " << draws.mean << " draws/frame - written to " << m_options.outputPath << std::endl;
+
+	return(report.good());
+}
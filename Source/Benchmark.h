@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.h
+// ============
+// render the scene offscreen along a scripted camera path and report
+// the frame times as JSON
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLStateCache.h"
+#include "SceneManager.h"
+#include "ShaderManager.h"
+#include "ViewManager.h"
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  BenchmarkRunner
+ *
+ *  This class runs the --bench mode.  The scene is rendered
+ *  into a framebuffer object for a fixed number of frames
+ *  while the camera flies the same path every run, and the
+ *  CPU and GPU time of each frame is recorded.  At the end
+ *  min, mean, p50, p95 and p99 of both, along with the draw
+ *  call and state change counts, are written as JSON.
+ ***********************************************************/
+class BenchmarkRunner
+{
+public:
+	// settings of one benchmark run, from the command line
+	struct BENCH_OPTIONS
+	{
+		bool bEnabled;
+		bool bUseEGL;			// EGL instead of OSMesa
+		int frames;
+		int width;
+		int height;
+		std::string outputPath;
+	};
+
+	// constructor
+	BenchmarkRunner(const BENCH_OPTIONS& options);
+	// destructor
+	~BenchmarkRunner();
+
+	// read the benchmark settings from the command line
+	static BENCH_OPTIONS ParseOptions(int argc, char* argv[]);
+
+	// render the benchmark frames and write the report
+	bool Run(
+		SceneManager* pSceneManager,
+		ViewManager* pViewManager,
+		ShaderManager* pShaderManager,
+		GLStateCache* pStateCache);
+
+private:
+	// timer queries in flight before the oldest one is read
+	static const int QUERY_RING_SIZE = 4;
+
+	// values recorded for one measured frame
+	struct FRAME_SAMPLE
+	{
+		double cpuMilliseconds;
+		double gpuMilliseconds;
+		unsigned int drawCalls;
+		GLStateCache::FRAME_COUNTERS stateCounters;
+	};
+
+	// min, mean and percentiles of one series of values
+	struct SERIES_SUMMARY
+	{
+		double min;
+		double mean;
+		double p50;
+		double p95;
+		double p99;
+		double max;
+	};
+
+	BENCH_OPTIONS m_options;
+	// offscreen render target
+	GLuint m_framebuffer;
+	GLuint m_colorBuffer;
+	GLuint m_depthBuffer;
+	// ring of GL_TIME_ELAPSED queries, one per frame in flight
+	GLuint m_timerQueries[QUERY_RING_SIZE];
+	// recorded frames
+	std::vector<FRAME_SAMPLE> m_samples;
+
+	// create and free the offscreen render target
+	bool CreateRenderTarget();
+	void DestroyRenderTarget();
+	// render one frame seen from the camera path at a frame index
+	void RenderFrame(
+		int frameIndex,
+		SceneManager* pSceneManager,
+		ViewManager* pViewManager,
+		ShaderManager* pShaderManager,
+		GLStateCache* pStateCache);
+	// summarize one series of values
+	static SERIES_SUMMARY Summarize(std::vector<double> values);
+	// write the report to the output file
+	bool WriteReport() const;
+};
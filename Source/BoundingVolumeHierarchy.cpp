@@ -0,0 +1,593 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.cpp
+// ============
+// tree of axis-aligned boxes over the scene objects, used for frustum
+// culling, ray picking and box range queries
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// half the surface area of a box, enough to compare split costs
+	float HalfArea(const glm::vec3& boxMin, const glm::vec3& boxMax)
+	{
+		glm::vec3 size = glm::max(boxMax - boxMin, glm::vec3(0.0f));
+		return(size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	// check whether two boxes share any point
+	bool BoxesOverlap(const glm::vec3& minA, const glm::vec3& maxA, const glm::vec3& minB, const glm::vec3& maxB)
+	{
+		return((minA.x <= maxB.x) && (maxA.x >= minB.x) &&
+			(minA.y <= maxB.y) && (maxA.y >= minB.y) &&
+			(minA.z <= maxB.z) && (maxA.z >= minB.z));
+	}
+}
+
+/***********************************************************
+ *  BoundingVolumeHierarchy()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+}
+
+/***********************************************************
+ *  GetBox()
+ *
+ *  This method is used for getting the minimum and maximum
+ *  corners of one box in the passed in bounds.
+ ***********************************************************/
+void BoundingVolumeHierarchy::GetBox(const BOUNDS_ARRAYS& bounds, size_t index, glm::vec3& boxMin, glm::vec3& boxMax)
+{
+	glm::vec3 center = glm::vec3(bounds.centerX[index], bounds.centerY[index], bounds.centerZ[index]);
+	glm::vec3 extents = glm::vec3(bounds.extentX[index], bounds.extentY[index], bounds.extentZ[index]);
+
+	boxMin = center - extents;
+	boxMax = center + extents;
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the tree over the
+ *  passed in item boxes.  The items are split recursively
+ *  on box centroids, and then the item boxes are copied in
+ *  leaf order for the queries.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Build(const BOUNDS_ARRAYS& bounds)
+{
+	uint32_t count = (uint32_t)bounds.Size();
+
+	Clear();
+	if (count == 0)
+	{
+		return;
+	}
+
+	m_items.resize(count);
+	m_buildCentroids.resize(count);
+	for (uint32_t item = 0; item < count; item++)
+	{
+		m_items[item] = item;
+		m_buildCentroids[item] = glm::vec3(bounds.centerX[item], bounds.centerY[item], bounds.centerZ[item]);
+	}
+
+	// a binary tree with at least one item per leaf has fewer
+	// than twice as many nodes as items
+	m_nodes.reserve(2 * count);
+	m_itemLeaves.resize(count);
+	BuildNode(bounds, 0, count, INVALID_CHILD);
+
+	m_itemPositions.resize(count);
+	m_itemBounds.Resize(count);
+	for (uint32_t position = 0; position < count; position++)
+	{
+		m_itemPositions[m_items[position]] = position;
+		CopyItemBounds(bounds, m_items[position]);
+	}
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used for building the subtree over a run
+ *  of items.  Each axis is cut into bins by the item
+ *  centroids and the split between bins with the lowest
+ *  surface area cost is taken.  When the centroids are all
+ *  in one place the run is simply cut in half, so a leaf
+ *  never holds more than MAX_LEAF_ITEMS items.
+ ***********************************************************/
+int BoundingVolumeHierarchy::BuildNode(const BOUNDS_ARRAYS& bounds, uint32_t first, uint32_t count, int parent)
+{
+	int nodeIndex = (int)m_nodes.size();
+	m_nodes.push_back(BVH_NODE());
+
+	glm::vec3 nodeMin = glm::vec3(FLT_MAX);
+	glm::vec3 nodeMax = glm::vec3(-FLT_MAX);
+	glm::vec3 centroidMin = glm::vec3(FLT_MAX);
+	glm::vec3 centroidMax = glm::vec3(-FLT_MAX);
+	for (uint32_t position = first; position < first + count; position++)
+	{
+		glm::vec3 boxMin, boxMax;
+		GetBox(bounds, m_items[position], boxMin, boxMax);
+		nodeMin = glm::min(nodeMin, boxMin);
+		nodeMax = glm::max(nodeMax, boxMax);
+		centroidMin = glm::min(centroidMin, m_buildCentroids[m_items[position]]);
+		centroidMax = glm::max(centroidMax, m_buildCentroids[m_items[position]]);
+	}
+
+	BVH_NODE& node = m_nodes[nodeIndex];
+	node.boundsMin = nodeMin;
+	node.boundsMax = nodeMax;
+	node.firstItem = first;
+	node.itemCount = count;
+	node.rightChild = INVALID_CHILD;
+	node.parent = parent;
+
+	if (count <= MAX_LEAF_ITEMS)
+	{
+		for (uint32_t position = first; position < first + count; position++)
+		{
+			m_itemLeaves[m_items[position]] = nodeIndex;
+		}
+		return(nodeIndex);
+	}
+
+	// find the cheapest split between bins over all three axes
+	int bestAxis = -1;
+	int bestSplit = 0;
+	float bestCost = FLT_MAX;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = centroidMax[axis] - centroidMin[axis];
+		if (extent <= 0.0f)
+		{
+			continue;
+		}
+
+		uint32_t binCounts[SPLIT_BINS] = {};
+		glm::vec3 binMin[SPLIT_BINS];
+		glm::vec3 binMax[SPLIT_BINS];
+		for (int bin = 0; bin < SPLIT_BINS; bin++)
+		{
+			binMin[bin] = glm::vec3(FLT_MAX);
+			binMax[bin] = glm::vec3(-FLT_MAX);
+		}
+
+		float binScale = SPLIT_BINS / extent;
+		for (uint32_t position = first; position < first + count; position++)
+		{
+			uint32_t item = m_items[position];
+			int bin = std::min(SPLIT_BINS - 1, (int)((m_buildCentroids[item][axis] - centroidMin[axis]) * binScale));
+			glm::vec3 boxMin, boxMax;
+			GetBox(bounds, item, boxMin, boxMax);
+			binCounts[bin]++;
+			binMin[bin] = glm::min(binMin[bin], boxMin);
+			binMax[bin] = glm::max(binMax[bin], boxMax);
+		}
+
+		// sweep from the right to get the cost of every right side
+		float rightCosts[SPLIT_BINS];
+		glm::vec3 sweepMin = glm::vec3(FLT_MAX);
+		glm::vec3 sweepMax = glm::vec3(-FLT_MAX);
+		uint32_t sweepCount = 0;
+		for (int bin = SPLIT_BINS - 1; bin > 0; bin--)
+		{
+			sweepCount += binCounts[bin];
+			sweepMin = glm::min(sweepMin, binMin[bin]);
+			sweepMax = glm::max(sweepMax, binMax[bin]);
+			rightCosts[bin] = (sweepCount > 0) ? sweepCount * HalfArea(sweepMin, sweepMax) : 0.0f;
+		}
+
+		// then from the left, splitting after each bin
+		sweepMin = glm::vec3(FLT_MAX);
+		sweepMax = glm::vec3(-FLT_MAX);
+		sweepCount = 0;
+		for (int bin = 0; bin < SPLIT_BINS - 1; bin++)
+		{
+			sweepCount += binCounts[bin];
+			sweepMin = glm::min(sweepMin, binMin[bin]);
+			sweepMax = glm::max(sweepMax, binMax[bin]);
+			if ((sweepCount == 0) || (sweepCount == count))
+			{
+				continue;
+			}
+
+			float cost = sweepCount * HalfArea(sweepMin, sweepMax) + rightCosts[bin + 1];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = bin;
+			}
+		}
+	}
+
+	uint32_t leftCount = 0;
+	if (bestAxis >= 0)
+	{
+		float axisMin = centroidMin[bestAxis];
+		float binScale = SPLIT_BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+		const std::vector<glm::vec3>& centroids = m_buildCentroids;
+		uint32_t* pMiddle = std::partition(
+			&m_items[first],
+			&m_items[first] + count,
+			[&](uint32_t item)
+			{
+				int bin = std::min(SPLIT_BINS - 1, (int)((centroids[item][bestAxis] - axisMin) * binScale));
+				return(bin <= bestSplit);
+			});
+		leftCount = (uint32_t)(pMiddle - &m_items[first]);
+	}
+
+	// no usable split, so cut the run in half
+	if ((leftCount == 0) || (leftCount == count))
+	{
+		leftCount = count / 2;
+	}
+
+	BuildNode(bounds, first, leftCount, nodeIndex);
+	int rightChild = BuildNode(bounds, first + leftCount, count - leftCount, nodeIndex);
+	m_nodes[nodeIndex].rightChild = rightChild;
+
+	return(nodeIndex);
+}
+
+/***********************************************************
+ *  CopyItemBounds()
+ *
+ *  This method is used for copying the box of one item from
+ *  the passed in bounds to its leaf-order position.
+ ***********************************************************/
+void BoundingVolumeHierarchy::CopyItemBounds(const BOUNDS_ARRAYS& bounds, uint32_t item)
+{
+	uint32_t position = m_itemPositions[item];
+
+	m_itemBounds.centerX[position] = bounds.centerX[item];
+	m_itemBounds.centerY[position] = bounds.centerY[item];
+	m_itemBounds.centerZ[position] = bounds.centerZ[item];
+	m_itemBounds.extentX[position] = bounds.extentX[item];
+	m_itemBounds.extentY[position] = bounds.extentY[item];
+	m_itemBounds.extentZ[position] = bounds.extentZ[item];
+}
+
+/***********************************************************
+ *  RefitNode()
+ *
+ *  This method is used for recomputing the box of a node,
+ *  from its item boxes for a leaf or from its two children
+ *  otherwise.
+ ***********************************************************/
+void BoundingVolumeHierarchy::RefitNode(int nodeIndex)
+{
+	BVH_NODE& node = m_nodes[nodeIndex];
+
+	if (node.rightChild == INVALID_CHILD)
+	{
+		node.boundsMin = glm::vec3(FLT_MAX);
+		node.boundsMax = glm::vec3(-FLT_MAX);
+		for (uint32_t position = node.firstItem; position < node.firstItem + node.itemCount; position++)
+		{
+			glm::vec3 boxMin, boxMax;
+			GetBox(m_itemBounds, position, boxMin, boxMax);
+			node.boundsMin = glm::min(node.boundsMin, boxMin);
+			node.boundsMax = glm::max(node.boundsMax, boxMax);
+		}
+	}
+	else
+	{
+		const BVH_NODE& left = m_nodes[nodeIndex + 1];
+		const BVH_NODE& right = m_nodes[node.rightChild];
+		node.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+		node.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+	}
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for recomputing every node box from
+ *  the passed in item boxes, keeping the tree shape.  The
+ *  children of a node always come after it, so walking the
+ *  nodes backwards refits the children first.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Refit(const BOUNDS_ARRAYS& bounds)
+{
+	for (uint32_t item = 0; item < (uint32_t)m_items.size(); item++)
+	{
+		CopyItemBounds(bounds, item);
+	}
+
+	for (int nodeIndex = (int)m_nodes.size() - 1; nodeIndex >= 0; nodeIndex--)
+	{
+		RefitNode(nodeIndex);
+	}
+}
+
+/***********************************************************
+ *  RefitItems()
+ *
+ *  This method is used for updating the boxes of the items
+ *  that moved and refitting the nodes from their leaves up
+ *  to the root.  The tree shape is kept, so a few moving
+ *  objects cost a few short walks instead of a rebuild.
+ ***********************************************************/
+void BoundingVolumeHierarchy::RefitItems(const BOUNDS_ARRAYS& bounds, const std::vector<uint32_t>& items)
+{
+	for (uint32_t item : items)
+	{
+		CopyItemBounds(bounds, item);
+	}
+
+	for (uint32_t item : items)
+	{
+		for (int nodeIndex = m_itemLeaves[item]; nodeIndex != INVALID_CHILD; nodeIndex = m_nodes[nodeIndex].parent)
+		{
+			RefitNode(nodeIndex);
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for listing the items that are not
+ *  completely outside the frustum, in no particular order.
+ *  Subtrees outside the frustum are skipped, subtrees fully
+ *  inside add all their items at once, and only the leaves
+ *  on the frustum border test their item boxes, with the
+ *  SIMD batch test.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QueryFrustum(const FrustumCuller::FRUSTUM& frustum, std::vector<uint32_t>& visible) const
+{
+	visible.clear();
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	m_stack.clear();
+	m_stack.push_back(0);
+	while (!m_stack.empty())
+	{
+		const BVH_NODE& node = m_nodes[m_stack.back()];
+		int nodeIndex = m_stack.back();
+		m_stack.pop_back();
+
+		glm::vec3 center = (node.boundsMin + node.boundsMax) * 0.5f;
+		glm::vec3 extents = (node.boundsMax - node.boundsMin) * 0.5f;
+		FrustumCuller::CONTAINMENT containment = FrustumCuller::ClassifyBox(frustum, center, extents);
+		if (containment == FrustumCuller::CONTAINMENT::Outside)
+		{
+			continue;
+		}
+
+		if (containment == FrustumCuller::CONTAINMENT::Inside)
+		{
+			visible.insert(visible.end(), m_items.begin() + node.firstItem, m_items.begin() + node.firstItem + node.itemCount);
+		}
+		else if (node.rightChild == INVALID_CHILD)
+		{
+			m_leafVisible.clear();
+			FrustumCuller::CullBoundsRange(frustum, m_itemBounds, node.firstItem, node.itemCount, m_leafVisible);
+			for (uint32_t position : m_leafVisible)
+			{
+				visible.push_back(m_items[position]);
+			}
+		}
+		else
+		{
+			m_stack.push_back(node.rightChild);
+			m_stack.push_back(nodeIndex + 1);
+		}
+	}
+}
+
+/***********************************************************
+ *  IntersectRay()
+ *
+ *  This method is used for finding the distance at which a
+ *  ray enters a box with the slab test.  The entry is zero
+ *  when the ray starts inside the box.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::IntersectRay(
+	const glm::vec3& origin,
+	const glm::vec3& inverseDirection,
+	const glm::vec3& boxMin,
+	const glm::vec3& boxMax,
+	float maxDistance,
+	float& entry)
+{
+	float nearest = 0.0f;
+	float farthest = maxDistance;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float t0 = (boxMin[axis] - origin[axis]) * inverseDirection[axis];
+		float t1 = (boxMax[axis] - origin[axis]) * inverseDirection[axis];
+		nearest = std::max(nearest, std::min(t0, t1));
+		farthest = std::min(farthest, std::max(t0, t1));
+	}
+
+	entry = nearest;
+	return(nearest <= farthest);
+}
+
+/***********************************************************
+ *  QueryRay()
+ *
+ *  This method is used for finding the nearest item box
+ *  along a ray.  The nearer child is visited first, and a
+ *  node is skipped once the ray enters it beyond the best
+ *  hit so far.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::QueryRay(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float maxDistance,
+	uint32_t& item,
+	float& distance) const
+{
+	bool bHit = false;
+
+	if (m_nodes.empty())
+	{
+		return(false);
+	}
+
+	// a zero direction component becomes a huge inverse, so
+	// the slabs on that axis either always or never hold the ray
+	glm::vec3 inverseDirection;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float component = (direction[axis] != 0.0f) ? direction[axis] : 1e-30f;
+		inverseDirection[axis] = 1.0f / component;
+	}
+
+	float bestDistance = maxDistance;
+	m_stack.clear();
+	m_stack.push_back(0);
+	while (!m_stack.empty())
+	{
+		int nodeIndex = m_stack.back();
+		const BVH_NODE& node = m_nodes[nodeIndex];
+		m_stack.pop_back();
+
+		float entry = 0.0f;
+		if (!IntersectRay(origin, inverseDirection, node.boundsMin, node.boundsMax, bestDistance, entry))
+		{
+			continue;
+		}
+
+		if (node.rightChild == INVALID_CHILD)
+		{
+			for (uint32_t position = node.firstItem; position < node.firstItem + node.itemCount; position++)
+			{
+				glm::vec3 boxMin, boxMax;
+				GetBox(m_itemBounds, position, boxMin, boxMax);
+				if (IntersectRay(origin, inverseDirection, boxMin, boxMax, bestDistance, entry))
+				{
+					bestDistance = entry;
+					item = m_items[position];
+					bHit = true;
+				}
+			}
+		}
+		else
+		{
+			// push the farther child first so the nearer one is popped first
+			const BVH_NODE& left = m_nodes[nodeIndex + 1];
+			const BVH_NODE& right = m_nodes[node.rightChild];
+			float leftAlong = glm::dot((left.boundsMin + left.boundsMax) * 0.5f - origin, direction);
+			float rightAlong = glm::dot((right.boundsMin + right.boundsMax) * 0.5f - origin, direction);
+			if (leftAlong < rightAlong)
+			{
+				m_stack.push_back(node.rightChild);
+				m_stack.push_back(nodeIndex + 1);
+			}
+			else
+			{
+				m_stack.push_back(nodeIndex + 1);
+				m_stack.push_back(node.rightChild);
+			}
+		}
+	}
+
+	if (bHit)
+	{
+		distance = bestDistance;
+	}
+
+	return(bHit);
+}
+
+/***********************************************************
+ *  QueryOverlap()
+ *
+ *  This method is used for listing the items whose box
+ *  overlaps the passed in box, in no particular order.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QueryOverlap(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<uint32_t>& items) const
+{
+	items.clear();
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	m_stack.clear();
+	m_stack.push_back(0);
+	while (!m_stack.empty())
+	{
+		int nodeIndex = m_stack.back();
+		const BVH_NODE& node = m_nodes[nodeIndex];
+		m_stack.pop_back();
+
+		if (!BoxesOverlap(node.boundsMin, node.boundsMax, boxMin, boxMax))
+		{
+			continue;
+		}
+
+		if (node.rightChild == INVALID_CHILD)
+		{
+			for (uint32_t position = node.firstItem; position < node.firstItem + node.itemCount; position++)
+			{
+				glm::vec3 itemMin, itemMax;
+				GetBox(m_itemBounds, position, itemMin, itemMax);
+				if (BoxesOverlap(itemMin, itemMax, boxMin, boxMax))
+				{
+					items.push_back(m_items[position]);
+				}
+			}
+		}
+		else
+		{
+			m_stack.push_back(node.rightChild);
+			m_stack.push_back(nodeIndex + 1);
+		}
+	}
+}
+
+/***********************************************************
+ *  GetItemCount()
+ *
+ *  This method is used for getting the number of items the
+ *  tree was built over.
+ ***********************************************************/
+size_t BoundingVolumeHierarchy::GetItemCount() const
+{
+	return(m_items.size());
+}
+
+/***********************************************************
+ *  GetNodeCount()
+ *
+ *  This method is used for getting the number of tree
+ *  nodes.
+ ***********************************************************/
+size_t BoundingVolumeHierarchy::GetNodeCount() const
+{
+	return(m_nodes.size());
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing every node and item.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Clear()
+{
+	m_nodes.clear();
+	m_items.clear();
+	m_itemPositions.clear();
+	m_itemLeaves.clear();
+	m_itemBounds.Clear();
+}
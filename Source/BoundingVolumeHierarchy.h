@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.h
+// ============
+// tree of axis-aligned boxes over the scene objects, used for frustum
+// culling, ray picking and box range queries
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrustumCuller.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  BoundingVolumeHierarchy
+ *
+ *  This class builds a binary tree of boxes over a set of
+ *  item boxes.  The tree is built once with the binned
+ *  surface area heuristic, and when items move their leaves
+ *  and ancestors are refit in place instead of rebuilding.
+ *  Nodes are stored depth-first with the left child right
+ *  after its parent, and the item boxes are kept in leaf
+ *  order, so every subtree covers one contiguous run of
+ *  items and a subtree found fully inside the frustum is
+ *  accepted without visiting its children.  The queries
+ *  share one traversal stack and must not be run from more
+ *  than one thread at a time.
+ ***********************************************************/
+class BoundingVolumeHierarchy
+{
+public:
+	// constructor
+	BoundingVolumeHierarchy();
+
+	// build the tree over the passed in item boxes, the item
+	// index of each box is its position in bounds
+	void Build(const BOUNDS_ARRAYS& bounds);
+	// recompute every node box from the passed in item boxes
+	void Refit(const BOUNDS_ARRAYS& bounds);
+	// update the boxes of the listed items and refit the nodes
+	// above them
+	void RefitItems(const BOUNDS_ARRAYS& bounds, const std::vector<uint32_t>& items);
+
+	// replace the contents of visible with the items that are
+	// not completely outside the frustum
+	void QueryFrustum(const FrustumCuller::FRUSTUM& frustum, std::vector<uint32_t>& visible) const;
+	// find the nearest item box hit by a ray within maxDistance,
+	// returns false when no box is hit
+	bool QueryRay(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float maxDistance,
+		uint32_t& item,
+		float& distance) const;
+	// replace the contents of items with the items whose box
+	// overlaps the passed in box
+	void QueryOverlap(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<uint32_t>& items) const;
+
+	// get the number of items the tree was built over
+	size_t GetItemCount() const;
+	// get the number of tree nodes
+	size_t GetNodeCount() const;
+	// remove every node and item
+	void Clear();
+
+private:
+	// one tree node, a leaf when rightChild is INVALID_CHILD,
+	// otherwise the left child is the next node
+	struct BVH_NODE
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		uint32_t firstItem;
+		uint32_t itemCount;
+		int rightChild;
+		int parent;
+	};
+
+	static const int INVALID_CHILD = -1;
+	// most items a leaf is allowed to hold
+	static const uint32_t MAX_LEAF_ITEMS = 4;
+	// number of centroid bins tried per axis when splitting
+	static const int SPLIT_BINS = 12;
+
+	std::vector<BVH_NODE> m_nodes;
+	// item index of each leaf-order position
+	std::vector<uint32_t> m_items;
+	// leaf-order position and leaf node of each item
+	std::vector<uint32_t> m_itemPositions;
+	std::vector<int> m_itemLeaves;
+	// item boxes in leaf order
+	BOUNDS_ARRAYS m_itemBounds;
+	// scratch buffers reused by the build and the queries
+	std::vector<glm::vec3> m_buildCentroids;
+	mutable std::vector<int> m_stack;
+	mutable std::vector<uint32_t> m_leafVisible;
+
+	// build the subtree over the leaf-order items [first, first + count)
+	int BuildNode(const BOUNDS_ARRAYS& bounds, uint32_t first, uint32_t count, int parent);
+	// recompute the box of one node from its items or children
+	void RefitNode(int nodeIndex);
+	// copy one item box from bounds into leaf order
+	void CopyItemBounds(const BOUNDS_ARRAYS& bounds, uint32_t item);
+	// get the box of an item from the passed in bounds
+	static void GetBox(const BOUNDS_ARRAYS& bounds, size_t index, glm::vec3& boxMin, glm::vec3& boxMax);
+	// find where a ray enters a box, returns false on a miss
+	static bool IntersectRay(
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		const glm::vec3& boxMin,
+		const glm::vec3& boxMax,
+		float maxDistance,
+		float& entry);
+};
@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////////////
+// cookedtexture.h
+// ============
+// layout of the cooked texture files written by the TextureCooker tool
+// and read back by the TextureLoader - keep the two in step
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/***********************************************************
+ *  Cooked texture file layout
+ *
+ *  COOKED_TEXTURE_HEADER
+ *  COOKED_TEXTURE_LEVEL[levelCount]	- largest level first
+ *  level data, each level starting on a 16 byte boundary
+ *
+ *  Every level of the mip chain is stored ready to upload,
+ *  either as RGBA8 pixels or as BC1 (DXT1) blocks, so the
+ *  file can be mapped into memory and handed straight to
+ *  OpenGL with no decoding or mipmap generation.
+ ***********************************************************/
+
+// file name extension of the cooked textures
+const char* const COOKED_TEXTURE_EXTENSION = ".ctex";
+// "CTEX" read as a little endian integer
+const uint32_t COOKED_TEXTURE_MAGIC = 0x58455443;
+const uint32_t COOKED_TEXTURE_VERSION = 1;
+// most levels in a mip chain - enough for 65536 x 65536
+const uint32_t COOKED_TEXTURE_MAX_LEVELS = 17;
+
+// pixel formats of the stored levels
+const uint32_t COOKED_FORMAT_RGBA8 = 1;
+const uint32_t COOKED_FORMAT_BC1 = 2;
+
+// the rows were flipped vertically when cooked, bottom row first
+const uint32_t COOKED_FLAG_FLIPPED_Y = 0x1;
+
+struct COOKED_TEXTURE_HEADER
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t format;
+	uint32_t flags;
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+	uint32_t reserved;
+};
+
+struct COOKED_TEXTURE_LEVEL
+{
+	uint32_t width;
+	uint32_t height;
+	uint32_t offset;		// from the start of the file
+	uint32_t size;			// bytes of level data
+};
+
+static_assert(sizeof(COOKED_TEXTURE_HEADER) == 32, "COOKED_TEXTURE_HEADER is written to disk as is");
+static_assert(sizeof(COOKED_TEXTURE_LEVEL) == 16, "COOKED_TEXTURE_LEVEL is written to disk as is");
+
+/***********************************************************
+ *  GetCookedTexturePath()
+ *
+ *  This function is used for getting the path of the cooked
+ *  texture for a source image, by swapping its extension.
+ ***********************************************************/
+inline std::string GetCookedTexturePath(const std::string& sourcePath)
+{
+	size_t dot = sourcePath.find_last_of('.');
+	size_t slash = sourcePath.find_last_of("/\\");
+
+	if ((dot == std::string::npos) || ((slash != std::string::npos) && (dot < slash)))
+	{
+		return(sourcePath + COOKED_TEXTURE_EXTENSION);
+	}
+
+	return(sourcePath.substr(0, dot) + COOKED_TEXTURE_EXTENSION);
+}
+
+/***********************************************************
+ *  GetCookedLevelSize()
+ *
+ *  This function is used for getting the number of bytes of
+ *  one level in the passed in format.  BC1 stores each 4x4
+ *  block of pixels in 8 bytes.
+ ***********************************************************/
+inline uint32_t GetCookedLevelSize(uint32_t format, uint32_t width, uint32_t height)
+{
+	if (format == COOKED_FORMAT_BC1)
+	{
+		return(((width + 3) / 4) * ((height + 3) / 4) * 8);
+	}
+
+	return(width * height * 4);
+}
+
+/***********************************************************
+ *  ValidateCookedTexture()
+ *
+ *  This function is used for checking that a block of memory
+ *  holds a complete cooked texture of a known version, with
+ *  every level inside the block.
+ ***********************************************************/
+inline bool ValidateCookedTexture(const unsigned char* data, size_t size)
+{
+	COOKED_TEXTURE_HEADER header;
+
+	if ((NULL == data) || (size < sizeof(header)))
+	{
+		return(false);
+	}
+	memcpy(&header, data, sizeof(header));
+
+	if ((header.magic != COOKED_TEXTURE_MAGIC) ||
+		(header.version != COOKED_TEXTURE_VERSION) ||
+		((header.format != COOKED_FORMAT_RGBA8) && (header.format != COOKED_FORMAT_BC1)) ||
+		(header.levelCount == 0) ||
+		(header.levelCount > COOKED_TEXTURE_MAX_LEVELS) ||
+		(size < sizeof(header) + header.levelCount * sizeof(COOKED_TEXTURE_LEVEL)))
+	{
+		return(false);
+	}
+
+	const unsigned char* levelTable = data + sizeof(header);
+	for (uint32_t i = 0; i < header.levelCount; i++)
+	{
+		COOKED_TEXTURE_LEVEL level;
+		memcpy(&level, levelTable + i * sizeof(level), sizeof(level));
+
+		if ((level.size != GetCookedLevelSize(header.format, level.width, level.height)) ||
+			((size_t)level.offset + level.size > size))
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
@@ -0,0 +1,276 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustumculler.cpp
+// ============
+// test world-space bounding boxes against the view frustum and list the
+// ones that can be seen
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrustumCuller.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__) || \
+	(defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define FRUSTUM_CULLER_SIMD 1
+#include <emmintrin.h>
+#else
+#define FRUSTUM_CULLER_SIMD 0
+#endif
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for setting the number of boxes.
+ ***********************************************************/
+void BOUNDS_ARRAYS::Resize(size_t count)
+{
+	centerX.resize(count, 0.0f);
+	centerY.resize(count, 0.0f);
+	centerZ.resize(count, 0.0f);
+	extentX.resize(count, 0.0f);
+	extentY.resize(count, 0.0f);
+	extentZ.resize(count, 0.0f);
+}
+
+/***********************************************************
+ *  Set()
+ *
+ *  This method is used for replacing the box at index.
+ ***********************************************************/
+void BOUNDS_ARRAYS::Set(size_t index, const glm::vec3& center, const glm::vec3& extents)
+{
+	centerX[index] = center.x;
+	centerY[index] = center.y;
+	centerZ[index] = center.z;
+	extentX[index] = extents.x;
+	extentY[index] = extents.y;
+	extentZ[index] = extents.z;
+}
+
+/***********************************************************
+ *  Size()
+ *
+ *  This method is used for getting the number of boxes.
+ ***********************************************************/
+size_t BOUNDS_ARRAYS::Size() const
+{
+	return(centerX.size());
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing every box.
+ ***********************************************************/
+void BOUNDS_ARRAYS::Clear()
+{
+	Resize(0);
+}
+
+/***********************************************************
+ *  ExtractFrustum()
+ *
+ *  This method is used for extracting the six frustum
+ *  planes from the combined projection and view matrix, by
+ *  adding and subtracting its rows.  The planes are
+ *  normalized so the plane distances are in world units.
+ ***********************************************************/
+FrustumCuller::FRUSTUM FrustumCuller::ExtractFrustum(const glm::mat4& projectionView)
+{
+	FRUSTUM frustum;
+
+	// rows of the column-major matrix
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(
+			projectionView[0][row],
+			projectionView[1][row],
+			projectionView[2][row],
+			projectionView[3][row]);
+	}
+
+	frustum.planes[0] = rows[3] + rows[0];	// left
+	frustum.planes[1] = rows[3] - rows[0];	// right
+	frustum.planes[2] = rows[3] + rows[1];	// bottom
+	frustum.planes[3] = rows[3] - rows[1];	// top
+	frustum.planes[4] = rows[3] + rows[2];	// near
+	frustum.planes[5] = rows[3] - rows[2];	// far
+
+	for (glm::vec4& plane : frustum.planes)
+	{
+		float length = glm::length(glm::vec3(plane));
+		if (length > 0.0f)
+		{
+			plane /= length;
+		}
+	}
+
+	return(frustum);
+}
+
+/***********************************************************
+ *  TransformBounds()
+ *
+ *  This method is used for moving a local box into world
+ *  space.  The center goes through the model matrix, and
+ *  each world half extent is the sum of the local half
+ *  extents weighted by the absolute matrix elements, which
+ *  gives the smallest world box around the rotated box.
+ ***********************************************************/
+void FrustumCuller::TransformBounds(
+	const glm::mat4& model,
+	const glm::vec3& localCenter,
+	const glm::vec3& localExtents,
+	glm::vec3& worldCenter,
+	glm::vec3& worldExtents)
+{
+	worldCenter = glm::vec3(model * glm::vec4(localCenter, 1.0f));
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		worldExtents[axis] =
+			fabsf(model[0][axis]) * localExtents.x +
+			fabsf(model[1][axis]) * localExtents.y +
+			fabsf(model[2][axis]) * localExtents.z;
+	}
+}
+
+/***********************************************************
+ *  IsVisible()
+ *
+ *  This method is used for testing one box against the
+ *  frustum.  The box is outside when the corner farthest
+ *  along a plane normal is still behind that plane.
+ ***********************************************************/
+bool FrustumCuller::IsVisible(const FRUSTUM& frustum, const glm::vec3& center, const glm::vec3& extents)
+{
+	for (const glm::vec4& plane : frustum.planes)
+	{
+		float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+		float reach = fabsf(plane.x) * extents.x + fabsf(plane.y) * extents.y + fabsf(plane.z) * extents.z;
+		if (distance + reach < 0.0f)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  ClassifyBox()
+ *
+ *  This method is used for finding where a box lies
+ *  relative to the frustum.  The box is fully inside when
+ *  even its corner nearest to each plane is in front of it,
+ *  which lets a hierarchy accept a whole subtree at once.
+ ***********************************************************/
+FrustumCuller::CONTAINMENT FrustumCuller::ClassifyBox(const FRUSTUM& frustum, const glm::vec3& center, const glm::vec3& extents)
+{
+	CONTAINMENT containment = CONTAINMENT::Inside;
+
+	for (const glm::vec4& plane : frustum.planes)
+	{
+		float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+		float reach = fabsf(plane.x) * extents.x + fabsf(plane.y) * extents.y + fabsf(plane.z) * extents.z;
+		if (distance + reach < 0.0f)
+		{
+			return(CONTAINMENT::Outside);
+		}
+		if (distance - reach < 0.0f)
+		{
+			containment = CONTAINMENT::Intersects;
+		}
+	}
+
+	return(containment);
+}
+
+/***********************************************************
+ *  CullBounds()
+ *
+ *  This method is used for listing every box that is not
+ *  completely outside the frustum.
+ ***********************************************************/
+void FrustumCuller::CullBounds(const FRUSTUM& frustum, const BOUNDS_ARRAYS& bounds, std::vector<uint32_t>& visible)
+{
+	visible.clear();
+	CullBoundsRange(frustum, bounds, 0, bounds.Size(), visible);
+}
+
+/***********************************************************
+ *  CullBoundsRange()
+ *
+ *  This method is used for appending the boxes of a range
+ *  that are not completely outside the frustum.  With SSE2
+ *  four boxes are tested against each plane at once; the
+ *  boxes left over at the end are tested one at a time.
+ ***********************************************************/
+void FrustumCuller::CullBoundsRange(
+	const FRUSTUM& frustum,
+	const BOUNDS_ARRAYS& bounds,
+	size_t first,
+	size_t count,
+	std::vector<uint32_t>& visible)
+{
+	size_t last = first + count;
+
+#if FRUSTUM_CULLER_SIMD
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	__m128 absX[6], absY[6], absZ[6];
+	for (int p = 0; p < 6; p++)
+	{
+		const glm::vec4& plane = frustum.planes[p];
+		planeX[p] = _mm_set1_ps(plane.x);
+		planeY[p] = _mm_set1_ps(plane.y);
+		planeZ[p] = _mm_set1_ps(plane.z);
+		planeW[p] = _mm_set1_ps(plane.w);
+		absX[p] = _mm_set1_ps(fabsf(plane.x));
+		absY[p] = _mm_set1_ps(fabsf(plane.y));
+		absZ[p] = _mm_set1_ps(fabsf(plane.z));
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	for (; first + 4 <= last; first += 4)
+	{
+		__m128 cx = _mm_loadu_ps(&bounds.centerX[first]);
+		__m128 cy = _mm_loadu_ps(&bounds.centerY[first]);
+		__m128 cz = _mm_loadu_ps(&bounds.centerZ[first]);
+		__m128 ex = _mm_loadu_ps(&bounds.extentX[first]);
+		__m128 ey = _mm_loadu_ps(&bounds.extentY[first]);
+		__m128 ez = _mm_loadu_ps(&bounds.extentZ[first]);
+
+		__m128 outside = zero;
+		for (int p = 0; p < 6; p++)
+		{
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+				_mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+			__m128 reach = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)),
+				_mm_mul_ps(absZ[p], ez));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), zero));
+		}
+
+		int outsideMask = _mm_movemask_ps(outside);
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if ((outsideMask & (1 << lane)) == 0)
+			{
+				visible.push_back((uint32_t)(first + lane));
+			}
+		}
+	}
+#endif
+
+	for (size_t i = first; i < last; i++)
+	{
+		glm::vec3 center = glm::vec3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+		glm::vec3 extents = glm::vec3(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+		if (IsVisible(frustum, center, extents))
+		{
+			visible.push_back((uint32_t)i);
+		}
+	}
+}
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustumculler.h
+// ============
+// test world-space bounding boxes against the view frustum and list the
+// ones that can be seen
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  BOUNDS_ARRAYS
+ *
+ *  The world-space axis-aligned bounding boxes of many
+ *  objects, as centers and half extents in structure-of-
+ *  arrays layout, so the culling kernel can test several
+ *  boxes against a plane at once.
+ ***********************************************************/
+struct BOUNDS_ARRAYS
+{
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> extentX;
+	std::vector<float> extentY;
+	std::vector<float> extentZ;
+
+	// set the number of boxes, new boxes are empty at the origin
+	void Resize(size_t count);
+	// replace the box at index
+	void Set(size_t index, const glm::vec3& center, const glm::vec3& extents);
+	// get the number of boxes
+	size_t Size() const;
+	// remove every box
+	void Clear();
+};
+
+/***********************************************************
+ *  FrustumCuller
+ *
+ *  This class finds the boxes that are at least partly
+ *  inside the six planes of the view frustum.  A box is
+ *  only rejected when it is completely behind one plane,
+ *  so a few boxes near the frustum corners are kept even
+ *  though they are not visible - never the other way
+ *  around.  The batch test runs 4 boxes at a time with SSE2
+ *  where it is available.
+ ***********************************************************/
+class FrustumCuller
+{
+public:
+	// the six planes as (normal, distance), normals pointing
+	// into the frustum: left, right, bottom, top, near, far
+	struct FRUSTUM
+	{
+		glm::vec4 planes[6];
+	};
+
+	// where a box lies relative to the frustum
+	enum class CONTAINMENT
+	{
+		Outside,
+		Intersects,
+		Inside
+	};
+
+	// extract the frustum planes from projection * view
+	static FRUSTUM ExtractFrustum(const glm::mat4& projectionView);
+	// transform a local box by a model matrix into the world
+	// box that encloses it
+	static void TransformBounds(
+		const glm::mat4& model,
+		const glm::vec3& localCenter,
+		const glm::vec3& localExtents,
+		glm::vec3& worldCenter,
+		glm::vec3& worldExtents);
+	// test one box against the frustum
+	static bool IsVisible(const FRUSTUM& frustum, const glm::vec3& center, const glm::vec3& extents);
+	// find whether a box is outside, partly inside or fully
+	// inside the frustum
+	static CONTAINMENT ClassifyBox(const FRUSTUM& frustum, const glm::vec3& center, const glm::vec3& extents);
+	// replace the contents of visible with the indices of the
+	// boxes that can be seen, in increasing order
+	static void CullBounds(const FRUSTUM& frustum, const BOUNDS_ARRAYS& bounds, std::vector<uint32_t>& visible);
+	// append the indices of the boxes [first, first + count)
+	// that can be seen to visible
+	static void CullBoundsRange(
+		const FRUSTUM& frustum,
+		const BOUNDS_ARRAYS& bounds,
+		size_t first,
+		size_t count,
+		std::vector<uint32_t>& visible);
+};
@@ -0,0 +1,276 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.cpp
+// ============
+// remember the OpenGL state set by the scene and skip the calls that would
+// not change it
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLStateCache.h"
+#include "RenderStats.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstring>
+
+/***********************************************************
+ *  GLStateCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GLStateCache::GLStateCache()
+{
+	m_pCurrentUniforms = NULL;
+	m_frameCounters = {};
+	m_lastFrameCounters = {};
+	Invalidate();
+}
+
+/***********************************************************
+ *  ~GLStateCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GLStateCache::~GLStateCache()
+{
+	m_pCurrentUniforms = NULL;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for closing the counters of the last
+ *  frame and starting to count the calls of a new frame.
+ ***********************************************************/
+void GLStateCache::BeginFrame()
+{
+	m_lastFrameCounters = m_frameCounters;
+	m_frameCounters = {};
+}
+
+/***********************************************************
+ *  GetLastFrameCounters()
+ *
+ *  This method is used for getting the number of issued and
+ *  skipped calls of the last completed frame.
+ ***********************************************************/
+const GLStateCache::FRAME_COUNTERS& GLStateCache::GetLastFrameCounters() const
+{
+	return(m_lastFrameCounters);
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting all remembered state,
+ *  so the next call of every kind is issued.
+ ***********************************************************/
+void GLStateCache::Invalidate()
+{
+	// nothing is ever bound as UNKNOWN_NAME, so the first
+	// calls after this are always issued
+	m_currentProgram = UNKNOWN_NAME;
+	m_activeTextureUnit = UNKNOWN_NAME;
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		m_boundTextures[i] = UNKNOWN_NAME;
+	}
+	m_capabilities.clear();
+	m_uniformValues.clear();
+	m_pCurrentUniforms = NULL;
+}
+
+/***********************************************************
+ *  UseProgram()
+ *
+ *  This method is used for making a program current.  The
+ *  uniform values remembered for that program stay valid,
+ *  because OpenGL keeps uniform values per program.
+ ***********************************************************/
+void GLStateCache::UseProgram(GLuint program)
+{
+	if (program == m_currentProgram)
+	{
+		m_frameCounters.programBinds.skipped++;
+		return;
+	}
+
+	glUseProgram(program);
+	m_currentProgram = program;
+	m_pCurrentUniforms = &m_uniformValues[program];
+	m_frameCounters.programBinds.issued++;
+	RenderStats::CountProgramBind();
+}
+
+/***********************************************************
+ *  GetCurrentProgram()
+ *
+ *  This method is used for getting the program made current
+ *  last, so a pass that switches programs can switch back.
+ ***********************************************************/
+GLuint GLStateCache::GetCurrentProgram() const
+{
+	return(m_currentProgram);
+}
+
+/***********************************************************
+ *  BindTexture2D()
+ *
+ *  This method is used for binding a 2D texture to a texture
+ *  unit, switching the active texture unit only when needed.
+ ***********************************************************/
+void GLStateCache::BindTexture2D(GLuint unit, GLuint texture)
+{
+	if ((unit < MAX_TEXTURE_UNITS) && (m_boundTextures[unit] == texture))
+	{
+		m_frameCounters.textureBinds.skipped++;
+		return;
+	}
+
+	if (unit != m_activeTextureUnit)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		m_activeTextureUnit = unit;
+	}
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	if (unit < MAX_TEXTURE_UNITS)
+	{
+		m_boundTextures[unit] = texture;
+	}
+	m_frameCounters.textureBinds.issued++;
+	RenderStats::CountTextureBind();
+}
+
+/***********************************************************
+ *  SetCapability()
+ *
+ *  This method is used for enabling or disabling an OpenGL
+ *  capability when its known state differs.
+ ***********************************************************/
+void GLStateCache::SetCapability(GLenum capability, bool bEnabled)
+{
+	auto found = m_capabilities.find(capability);
+	if ((found != m_capabilities.end()) && (found->second == bEnabled))
+	{
+		m_frameCounters.capabilityToggles.skipped++;
+		return;
+	}
+
+	if (bEnabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+
+	m_capabilities[capability] = bEnabled;
+	m_frameCounters.capabilityToggles.issued++;
+}
+
+/***********************************************************
+ *  Enable() / Disable()
+ *
+ *  These methods are used for enabling and disabling an
+ *  OpenGL capability through the cache.
+ ***********************************************************/
+void GLStateCache::Enable(GLenum capability)
+{
+	SetCapability(capability, true);
+}
+
+void GLStateCache::Disable(GLenum capability)
+{
+	SetCapability(capability, false);
+}
+
+/***********************************************************
+ *  UniformChanged()
+ *
+ *  This method is used for comparing a uniform value with
+ *  the last value written to the same location of the
+ *  current program.  When it differs, or nothing was written
+ *  yet, the new value is remembered and true is returned.
+ ***********************************************************/
+bool GLStateCache::UniformChanged(GLint location, const void* data, GLsizei bytes)
+{
+	// inactive uniforms are ignored by OpenGL anyway
+	if (location < 0)
+	{
+		m_frameCounters.uniformWrites.skipped++;
+		return(false);
+	}
+
+	// without a program made current through the cache there is
+	// nothing to compare against, so the write goes through
+	if (NULL == m_pCurrentUniforms)
+	{
+		m_frameCounters.uniformWrites.issued++;
+		RenderStats::CountUniformWrite();
+		return(true);
+	}
+
+	if ((size_t)location >= m_pCurrentUniforms->size())
+	{
+		m_pCurrentUniforms->resize(location + 1, UNIFORM_VALUE());
+	}
+
+	UNIFORM_VALUE& value = (*m_pCurrentUniforms)[location];
+	if (value.bValid && (value.bytes == bytes) && (memcmp(value.data, data, bytes) == 0))
+	{
+		m_frameCounters.uniformWrites.skipped++;
+		return(false);
+	}
+
+	value.bValid = true;
+	value.bytes = bytes;
+	memcpy(value.data, data, bytes);
+	m_frameCounters.uniformWrites.issued++;
+	RenderStats::CountUniformWrite();
+
+	return(true);
+}
+
+/***********************************************************
+ *  Uniform setters
+ *
+ *  These methods are used for writing uniform values of the
+ *  current program, skipping writes of unchanged values.
+ ***********************************************************/
+void GLStateCache::SetBoolValue(ShaderManager::UNIFORM_HANDLE handle, bool value)
+{
+	SetIntValue(handle, (int)value);
+}
+
+void GLStateCache::SetIntValue(ShaderManager::UNIFORM_HANDLE handle, int value)
+{
+	if (UniformChanged(handle, &value, sizeof(value)))
+		glUniform1i(handle, value);
+}
+
+void GLStateCache::SetFloatValue(ShaderManager::UNIFORM_HANDLE handle, float value)
+{
+	if (UniformChanged(handle, &value, sizeof(value)))
+		glUniform1f(handle, value);
+}
+
+void GLStateCache::SetVec2Value(ShaderManager::UNIFORM_HANDLE handle, const glm::vec2& value)
+{
+	if (UniformChanged(handle, glm::value_ptr(value), sizeof(float) * 2))
+		glUniform2fv(handle, 1, glm::value_ptr(value));
+}
+
+void GLStateCache::SetVec3Value(ShaderManager::UNIFORM_HANDLE handle, const glm::vec3& value)
+{
+	if (UniformChanged(handle, glm::value_ptr(value), sizeof(float) * 3))
+		glUniform3fv(handle, 1, glm::value_ptr(value));
+}
+
+void GLStateCache::SetVec4Value(ShaderManager::UNIFORM_HANDLE handle, const glm::vec4& value)
+{
+	if (UniformChanged(handle, glm::value_ptr(value), sizeof(float) * 4))
+		glUniform4fv(handle, 1, glm::value_ptr(value));
+}
+
+void GLStateCache::SetMat4Value(ShaderManager::UNIFORM_HANDLE handle, const glm::mat4& value)
+{
+	if (UniformChanged(handle, glm::value_ptr(value), sizeof(float) * 16))
+		glUniformMatrix4fv(handle, 1, GL_FALSE, glm::value_ptr(value));
+}
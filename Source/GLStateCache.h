@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.h
+// ============
+// remember the OpenGL state set by the scene and skip the calls that would
+// not change it
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  GLStateCache
+ *
+ *  This class sits between the scene code and OpenGL.  It
+ *  remembers the current program, the texture bound to each
+ *  texture unit, the enabled capabilities and the last value
+ *  written to each uniform, and only issues the calls that
+ *  actually change something.  Issued and skipped calls are
+ *  counted for every frame.
+ ***********************************************************/
+class GLStateCache
+{
+public:
+	// constructor
+	GLStateCache();
+	// destructor
+	~GLStateCache();
+
+	// issued and skipped calls of one kind
+	struct CALL_COUNT
+	{
+		unsigned int issued;
+		unsigned int skipped;
+	};
+
+	// calls counted since the start of the frame
+	struct FRAME_COUNTERS
+	{
+		CALL_COUNT programBinds;
+		CALL_COUNT textureBinds;
+		CALL_COUNT capabilityToggles;
+		CALL_COUNT uniformWrites;
+	};
+
+private:
+	// maximum number of texture units that are tracked
+	static const int MAX_TEXTURE_UNITS = 16;
+	// marks a program, texture or unit as not known, OpenGL
+	// hands out names counting up from 1 and never this one
+	static const GLuint UNKNOWN_NAME = ~0u;
+
+	// last value written to one uniform location
+	struct UNIFORM_VALUE
+	{
+		bool bValid;
+		GLsizei bytes;
+		float data[16];
+	};
+
+	// the program currently in use
+	GLuint m_currentProgram;
+	// the active texture unit and the texture bound to each unit
+	GLuint m_activeTextureUnit;
+	GLuint m_boundTextures[MAX_TEXTURE_UNITS];
+	// the known state of each enabled/disabled capability
+	std::unordered_map<GLenum, bool> m_capabilities;
+	// last written uniform values, per program and location
+	std::unordered_map<GLuint, std::vector<UNIFORM_VALUE>> m_uniformValues;
+	std::vector<UNIFORM_VALUE>* m_pCurrentUniforms;
+	// calls counted for the current and the last completed frame
+	FRAME_COUNTERS m_frameCounters;
+	FRAME_COUNTERS m_lastFrameCounters;
+
+	// compare a uniform value with the last written one, and
+	// remember it when it differs
+	bool UniformChanged(GLint location, const void* data, GLsizei bytes);
+	// enable or disable a capability when its state differs
+	void SetCapability(GLenum capability, bool bEnabled);
+
+public:
+	// start counting the calls of a new frame
+	void BeginFrame();
+	// get the calls counted for the last completed frame
+	const FRAME_COUNTERS& GetLastFrameCounters() const;
+	// forget the remembered state, after OpenGL was changed
+	// without going through the cache
+	void Invalidate();
+
+	// make a program the current program
+	void UseProgram(GLuint program);
+	// get the program made current last
+	GLuint GetCurrentProgram() const;
+	// bind a 2D texture to a texture unit
+	void BindTexture2D(GLuint unit, GLuint texture);
+	// enable or disable an OpenGL capability
+	void Enable(GLenum capability);
+	void Disable(GLenum capability);
+
+	// write uniform values of the current program
+	void SetBoolValue(ShaderManager::UNIFORM_HANDLE handle, bool value);
+	void SetIntValue(ShaderManager::UNIFORM_HANDLE handle, int value);
+	void SetFloatValue(ShaderManager::UNIFORM_HANDLE handle, float value);
+	void SetVec2Value(ShaderManager::UNIFORM_HANDLE handle, const glm::vec2& value);
+	void SetVec3Value(ShaderManager::UNIFORM_HANDLE handle, const glm::vec3& value);
+	void SetVec4Value(ShaderManager::UNIFORM_HANDLE handle, const glm::vec4& value);
+	void SetMat4Value(ShaderManager::UNIFORM_HANDLE handle, const glm::mat4& value);
+};
@@ -0,0 +1,361 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuprofiler.cpp
+// ============
+// measure the CPU and GPU time of named scopes of each frame with
+// OpenGL timestamp queries
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GpuProfiler.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// declaration of global variables
+namespace
+{
+	// name of the scope wrapping the whole frame
+	const char* g_FrameScopeName = "frame";
+}
+
+/***********************************************************
+ *  GpuProfiler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GpuProfiler::GpuProfiler()
+{
+	for (FRAME_RECORD& frame : m_frames)
+	{
+		frame.frameNumber = 0;
+		frame.bPending = false;
+		frame.queriesUsed = 0;
+	}
+	m_pCurrentFrame = NULL;
+	m_frameNumber = 0;
+	m_droppedFrames = 0;
+	m_startTime = std::chrono::steady_clock::now();
+
+	// the whole-frame scope is always the first one
+	GetScopeIndex(g_FrameScopeName);
+}
+
+/***********************************************************
+ *  ~GpuProfiler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GpuProfiler::~GpuProfiler()
+{
+	for (FRAME_RECORD& frame : m_frames)
+	{
+		if (!frame.queries.empty())
+		{
+			glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+			frame.queries.clear();
+		}
+	}
+	m_pCurrentFrame = NULL;
+}
+
+/***********************************************************
+ *  GetCpuMilliseconds()
+ *
+ *  This method is used for getting the CPU time since the
+ *  profiler was created, in milliseconds.
+ ***********************************************************/
+double GpuProfiler::GetCpuMilliseconds() const
+{
+	return(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_startTime).count());
+}
+
+/***********************************************************
+ *  AcquireQuery()
+ *
+ *  This method is used for getting the next unused query
+ *  object of the current frame, creating more as needed.
+ ***********************************************************/
+GLuint GpuProfiler::AcquireQuery()
+{
+	FRAME_RECORD& frame = *m_pCurrentFrame;
+
+	if (frame.queriesUsed == frame.queries.size())
+	{
+		GLuint query = 0;
+		glGenQueries(1, &query);
+		frame.queries.push_back(query);
+	}
+
+	return(frame.queries[frame.queriesUsed++]);
+}
+
+/***********************************************************
+ *  GetScopeIndex()
+ *
+ *  This method is used for getting the statistics index of
+ *  a scope name, adding new names as they are seen.
+ ***********************************************************/
+int GpuProfiler::GetScopeIndex(const std::string& name)
+{
+	auto found = m_scopeIndices.find(name);
+	if (found != m_scopeIndices.end())
+	{
+		return(found->second);
+	}
+
+	SCOPE_STATS stats = {};
+	stats.name = name;
+	m_scopeStats.push_back(stats);
+
+	int index = (int)m_scopeStats.size() - 1;
+	m_scopeIndices[name] = index;
+
+	return(index);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a new frame.  The frame
+ *  that last used the same slot of the ring is read back
+ *  first, then the whole-frame scope is begun.
+ ***********************************************************/
+void GpuProfiler::BeginFrame()
+{
+	FRAME_RECORD& frame = m_frames[m_frameNumber % FRAME_LATENCY];
+
+	if (frame.bPending)
+	{
+		ResolveFrame(frame);
+	}
+
+	frame.frameNumber = m_frameNumber;
+	frame.bPending = false;
+	frame.scopes.clear();
+	frame.queriesUsed = 0;
+
+	m_pCurrentFrame = &frame;
+	m_openScopes.clear();
+
+	BeginScope(g_FrameScopeName);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for finishing the frame, closing any
+ *  scopes left open along with the whole-frame scope.
+ ***********************************************************/
+void GpuProfiler::EndFrame()
+{
+	if (NULL == m_pCurrentFrame)
+	{
+		return;
+	}
+
+	while (!m_openScopes.empty())
+	{
+		EndScope();
+	}
+
+	m_pCurrentFrame->bPending = true;
+	m_pCurrentFrame = NULL;
+	m_frameNumber++;
+}
+
+/***********************************************************
+ *  BeginScope()
+ *
+ *  This method is used for starting a named scope.  Scopes
+ *  must be ended in the reverse order they were begun.
+ ***********************************************************/
+void GpuProfiler::BeginScope(const std::string& name)
+{
+	if (NULL == m_pCurrentFrame)
+	{
+		return;
+	}
+
+	SCOPE_RECORD scope;
+	scope.scopeIndex = GetScopeIndex(name);
+	scope.startQuery = AcquireQuery();
+	scope.endQuery = AcquireQuery();
+	scope.cpuStart = GetCpuMilliseconds();
+	scope.cpuEnd = scope.cpuStart;
+
+	glQueryCounter(scope.startQuery, GL_TIMESTAMP);
+
+	m_openScopes.push_back(m_pCurrentFrame->scopes.size());
+	m_pCurrentFrame->scopes.push_back(scope);
+}
+
+/***********************************************************
+ *  EndScope()
+ *
+ *  This method is used for finishing the most recently
+ *  begun scope.
+ ***********************************************************/
+void GpuProfiler::EndScope()
+{
+	if ((NULL == m_pCurrentFrame) || m_openScopes.empty())
+	{
+		return;
+	}
+
+	SCOPE_RECORD& scope = m_pCurrentFrame->scopes[m_openScopes.back()];
+	m_openScopes.pop_back();
+
+	glQueryCounter(scope.endQuery, GL_TIMESTAMP);
+	scope.cpuEnd = GetCpuMilliseconds();
+}
+
+/***********************************************************
+ *  ResolveFrame()
+ *
+ *  This method is used for reading back the timestamps of a
+ *  finished frame into the rolling averages and the CSV
+ *  file.  Timestamps complete in order, so when the last
+ *  query of the frame is available all of them are.
+ ***********************************************************/
+void GpuProfiler::ResolveFrame(FRAME_RECORD& frame)
+{
+	frame.bPending = false;
+	if (frame.queriesUsed == 0)
+	{
+		return;
+	}
+
+	GLint bAvailable = GL_FALSE;
+	glGetQueryObjectiv(frame.queries[frame.queriesUsed - 1], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+	if (bAvailable == GL_FALSE)
+	{
+		m_droppedFrames++;
+		return;
+	}
+
+	// a name can be scoped more than once a frame, so the
+	// times are summed per name before they are recorded
+	std::vector<double> cpuTotals(m_scopeStats.size(), 0.0);
+	std::vector<double> gpuTotals(m_scopeStats.size(), 0.0);
+	std::vector<bool> bSeen(m_scopeStats.size(), false);
+
+	for (const SCOPE_RECORD& scope : frame.scopes)
+	{
+		GLuint64 gpuStart = 0;
+		GLuint64 gpuEnd = 0;
+		glGetQueryObjectui64v(scope.startQuery, GL_QUERY_RESULT, &gpuStart);
+		glGetQueryObjectui64v(scope.endQuery, GL_QUERY_RESULT, &gpuEnd);
+
+		cpuTotals[scope.scopeIndex] += scope.cpuEnd - scope.cpuStart;
+		if (gpuEnd > gpuStart)
+		{
+			gpuTotals[scope.scopeIndex] += (double)(gpuEnd - gpuStart) / 1.0e6;
+		}
+		bSeen[scope.scopeIndex] = true;
+	}
+
+	for (size_t i = 0; i < m_scopeStats.size(); i++)
+	{
+		if (!bSeen[i])
+		{
+			continue;
+		}
+
+		SCOPE_STATS& stats = m_scopeStats[i];
+		stats.cpuHistory[stats.next] = cpuTotals[i];
+		stats.gpuHistory[stats.next] = gpuTotals[i];
+		stats.next = (stats.next + 1) % AVERAGE_WINDOW;
+		if (stats.samples < AVERAGE_WINDOW)
+		{
+			stats.samples++;
+		}
+
+		if (m_csvFile.is_open())
+		{
+			m_csvFile << frame.frameNumber << "," << stats.name << ","
+				<< cpuTotals[i] << "," << gpuTotals[i] << "\n";
+		}
+	}
+}
+
+/***********************************************************
+ *  GetAverages()
+ *
+ *  This method is used for getting the rolling averages of
+ *  the CPU and GPU time of one scope.
+ ***********************************************************/
+void GpuProfiler::GetAverages(const SCOPE_STATS& stats, double& cpuMilliseconds, double& gpuMilliseconds) const
+{
+	cpuMilliseconds = 0.0;
+	gpuMilliseconds = 0.0;
+
+	for (int i = 0; i < stats.samples; i++)
+	{
+		cpuMilliseconds += stats.cpuHistory[i];
+		gpuMilliseconds += stats.gpuHistory[i];
+	}
+
+	if (stats.samples > 0)
+	{
+		cpuMilliseconds /= stats.samples;
+		gpuMilliseconds /= stats.samples;
+	}
+}
+
+/***********************************************************
+ *  OpenCSV()
+ *
+ *  This method is used for opening the CSV file that every
+ *  resolved scope is written to, one row per scope per frame.
+ ***********************************************************/
+bool GpuProfiler::OpenCSV(const std::string& path)
+{
+	m_csvFile.open(path, std::ios::trunc);
+	if (!m_csvFile.is_open())
+	{
+		std::cout << "ERROR: could not open profiler CSV file: " << path << std::endl;
+		return(false);
+	}
+
+	m_csvFile << "frame,scope,cpu_ms,gpu_ms\n";
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetOverlayText()
+ *
+ *  This method is used for getting the rolling averages of
+ *  every scope as one line of text.  The whole-frame scope
+ *  comes first and tells whether the CPU or the GPU took
+ *  longer.
+ ***********************************************************/
+std::string GpuProfiler::GetOverlayText() const
+{
+	std::ostringstream text;
+	text << std::fixed << std::setprecision(2);
+
+	for (size_t i = 0; i < m_scopeStats.size(); i++)
+	{
+		double cpuMilliseconds = 0.0;
+		double gpuMilliseconds = 0.0;
+		GetAverages(m_scopeStats[i], cpuMilliseconds, gpuMilliseconds);
+
+		if (i == 0)
+		{
+			text << "cpu " << cpuMilliseconds << " ms / gpu " << gpuMilliseconds << " ms "
+				<< ((gpuMilliseconds > cpuMilliseconds) ? "(GPU-bound)" : "(CPU-bound)");
+		}
+		else
+		{
+			text << " | " << m_scopeStats[i].name << " " << cpuMilliseconds << "/" << gpuMilliseconds;
+		}
+	}
+
+	if (m_droppedFrames > 0)
+	{
+		text << " | dropped " << m_droppedFrames;
+	}
+
+	return(text.str());
+}
@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuprofiler.h
+// ============
+// measure the CPU and GPU time of named scopes of each frame with
+// OpenGL timestamp queries
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  GpuProfiler
+ *
+ *  This class times named scopes of the frame on both the
+ *  CPU and the GPU.  Each scope writes a GL_TIMESTAMP query
+ *  when it begins and ends, so scopes can nest inside the
+ *  whole-frame scope.  The queries of a frame are read back
+ *  FRAME_LATENCY frames later, when the GPU is long done
+ *  with them - a frame whose results are still not ready is
+ *  dropped rather than waited for.  Rolling averages of each
+ *  scope are kept for the overlay text, and every resolved
+ *  scope can be written to a CSV file.
+ ***********************************************************/
+class GpuProfiler
+{
+public:
+	// constructor
+	GpuProfiler();
+	// destructor
+	~GpuProfiler();
+
+	// start and finish the whole-frame scope
+	void BeginFrame();
+	void EndFrame();
+	// start and finish a named scope inside the frame
+	void BeginScope(const std::string& name);
+	void EndScope();
+
+	// write every resolved scope to a CSV file from now on
+	bool OpenCSV(const std::string& path);
+	// get the rolling averages as one line of text
+	std::string GetOverlayText() const;
+
+private:
+	// frames between issuing the queries and reading them
+	static const int FRAME_LATENCY = 4;
+	// number of frames in the rolling averages
+	static const int AVERAGE_WINDOW = 60;
+
+	// one timed scope of a frame
+	struct SCOPE_RECORD
+	{
+		int scopeIndex;
+		GLuint startQuery;
+		GLuint endQuery;
+		double cpuStart;
+		double cpuEnd;
+	};
+
+	// the scopes and queries of one frame in flight
+	struct FRAME_RECORD
+	{
+		unsigned long long frameNumber;
+		bool bPending;
+		std::vector<SCOPE_RECORD> scopes;
+		std::vector<GLuint> queries;
+		size_t queriesUsed;
+	};
+
+	// rolling history of one named scope
+	struct SCOPE_STATS
+	{
+		std::string name;
+		double cpuHistory[AVERAGE_WINDOW];
+		double gpuHistory[AVERAGE_WINDOW];
+		int samples;
+		int next;
+	};
+
+	FRAME_RECORD m_frames[FRAME_LATENCY];
+	FRAME_RECORD* m_pCurrentFrame;
+	unsigned long long m_frameNumber;
+	unsigned long long m_droppedFrames;
+	// scopes that were begun and not yet ended
+	std::vector<size_t> m_openScopes;
+	// statistics of every scope name seen so far
+	std::vector<SCOPE_STATS> m_scopeStats;
+	std::unordered_map<std::string, int> m_scopeIndices;
+	// time base of the CPU timings
+	std::chrono::steady_clock::time_point m_startTime;
+	// CSV output, when opened
+	std::ofstream m_csvFile;
+
+	// get the CPU time in milliseconds since the profiler started
+	double GetCpuMilliseconds() const;
+	// get the next unused query of the current frame
+	GLuint AcquireQuery();
+	// get the index of a scope name, adding it when new
+	int GetScopeIndex(const std::string& name);
+	// read back the queries of a finished frame
+	void ResolveFrame(FRAME_RECORD& frame);
+	// get the rolling averages of one scope
+	void GetAverages(const SCOPE_STATS& stats, double& cpuMilliseconds, double& gpuMilliseconds) const;
+};
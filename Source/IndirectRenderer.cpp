@@ -0,0 +1,586 @@
+///////////////////////////////////////////////////////////////////////////////
+// indirectrenderer.cpp
+// ============
+// draw many objects from the shared mesh arena with multi-draw indirect
+// commands and per-object data written to persistently mapped buffers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "IndirectRenderer.h"
+#include "RenderStats.h"
+#include "TraceRecorder.h"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	// flags of the persistently mapped buffers - coherent, so
+	// the writes are seen by the GPU without explicit flushes
+	const GLbitfield RING_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	// how long one wait on a fence lasts before it is retried,
+	// in nanoseconds
+	const GLuint64 FENCE_WAIT_TIMEOUT = 1000000;
+
+	// objects tested by one work group of the cull pass - see
+	// local_size_x in shaders/cullShader.glsl
+	const GLuint CULL_GROUP_SIZE = 64;
+}
+
+/***********************************************************
+ *  IndirectRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+IndirectRenderer::IndirectRenderer(ShapeMeshes* pMeshes, GLStateCache* pStateCache)
+{
+	m_pMeshes = pMeshes;
+	m_pStateCache = pStateCache;
+	m_objectRing = {};
+	m_commandRing = {};
+	m_boundsRing = {};
+	m_culledObjectBuffer = 0;
+	m_cullProgram = 0;
+	for (int i = 0; i < 6; i++)
+	{
+		m_frustumPlaneLocations[i] = -1;
+		// a plane every point is in front of
+		m_frustumPlanes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	m_firstObjectLocation = -1;
+	m_objectCountLocation = -1;
+	for (int i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		m_fences[i] = NULL;
+	}
+	m_region = 0;
+	m_maxObjects = 0;
+	m_objectCount = 0;
+	m_commandCount = 0;
+	m_firstUnflushedCommand = 0;
+	m_firstUnflushedObject = 0;
+	m_unflushedIndices = 0;
+	m_lastCommand = {};
+	m_bLastCommandShared = false;
+}
+
+/***********************************************************
+ *  ~IndirectRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+IndirectRenderer::~IndirectRenderer()
+{
+	Destroy();
+	m_pMeshes = NULL;
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the object and command
+ *  rings for up to maxObjects objects per frame, and the
+ *  bounds ring and culled object buffer when culling.  Each
+ *  region starts on the storage buffer offset alignment,
+ *  so it can be bound as a range of its own.  Any buffers
+ *  from an earlier call are freed first.
+ ***********************************************************/
+bool IndirectRenderer::Initialize(GLuint maxObjects)
+{
+	Destroy();
+
+	if ((GLEW_ARB_buffer_storage == GL_FALSE) || (GLEW_ARB_multi_draw_indirect == GL_FALSE))
+	{
+		std::cout << "ERROR: GPU-driven rendering needs buffer storage and multi-draw indirect" << std::endl;
+		return(false);
+	}
+
+	if (maxObjects == 0)
+	{
+		maxObjects = 1;
+	}
+
+	GLint alignment = 0;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment <= 0)
+	{
+		alignment = 256;
+	}
+
+	GLsizeiptr objectRegion = (GLsizeiptr)maxObjects * sizeof(OBJECT_STD430);
+	objectRegion = ((objectRegion + alignment - 1) / alignment) * alignment;
+	GLsizeiptr commandRegion = (GLsizeiptr)maxObjects * sizeof(DRAW_COMMAND);
+	commandRegion = ((commandRegion + alignment - 1) / alignment) * alignment;
+	GLsizeiptr boundsRegion = (GLsizeiptr)maxObjects * sizeof(CULL_BOUNDS_STD430);
+	boundsRegion = ((boundsRegion + alignment - 1) / alignment) * alignment;
+
+	bool bCreated = CreateRing(m_objectRing, GL_SHADER_STORAGE_BUFFER, objectRegion) &&
+		CreateRing(m_commandRing, GL_DRAW_INDIRECT_BUFFER, commandRegion);
+	if (bCreated && (m_cullProgram != 0))
+	{
+		bCreated = CreateRing(m_boundsRing, GL_SHADER_STORAGE_BUFFER, boundsRegion);
+
+		glGenBuffers(1, &m_culledObjectBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_culledObjectBuffer);
+		glBufferStorage(GL_SHADER_STORAGE_BUFFER, objectRegion * FRAMES_IN_FLIGHT, NULL, 0);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	if (!bCreated)
+	{
+		std::cout << "ERROR: could not map the GPU-driven draw buffers" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	m_pMeshes->ReserveArenaObjects(maxObjects);
+	m_maxObjects = maxObjects;
+	m_region = 0;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the rings and fences.
+ *  OpenGL keeps a deleted buffer alive until the draws that
+ *  read it are done, so nothing is waited for here.
+ ***********************************************************/
+void IndirectRenderer::Destroy()
+{
+	for (int i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		if (NULL != m_fences[i])
+		{
+			glDeleteSync(m_fences[i]);
+			m_fences[i] = NULL;
+		}
+	}
+
+	DestroyRing(m_objectRing);
+	DestroyRing(m_commandRing);
+	DestroyRing(m_boundsRing);
+	if (m_culledObjectBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_culledObjectBuffer);
+		m_culledObjectBuffer = 0;
+	}
+	m_maxObjects = 0;
+	m_objectCount = 0;
+	m_commandCount = 0;
+	m_firstUnflushedCommand = 0;
+	m_firstUnflushedObject = 0;
+	m_unflushedIndices = 0;
+	m_bLastCommandShared = false;
+}
+
+/***********************************************************
+ *  IsInitialized()
+ *
+ *  This method is used for checking whether the rings were
+ *  created.
+ ***********************************************************/
+bool IndirectRenderer::IsInitialized() const
+{
+	return(m_maxObjects > 0);
+}
+
+/***********************************************************
+ *  GetMaxObjects()
+ *
+ *  This method is used for getting the number of objects a
+ *  frame can hold.
+ ***********************************************************/
+GLuint IndirectRenderer::GetMaxObjects() const
+{
+	return(m_maxObjects);
+}
+
+/***********************************************************
+ *  SetCullProgram()
+ *
+ *  This method is used for setting the compute program of
+ *  the cull pass, or turning the pass off with 0.  The
+ *  buffers are created again to add or drop the ones the
+ *  pass needs.  When that fails the pass stays off.
+ ***********************************************************/
+bool IndirectRenderer::SetCullProgram(GLuint cullProgram)
+{
+	if (cullProgram != 0)
+	{
+		if ((GLEW_ARB_compute_shader == GL_FALSE) || (GLEW_ARB_shader_storage_buffer_object == GL_FALSE))
+		{
+			std::cout << "ERROR: GPU culling needs compute shaders and shader storage buffers" << std::endl;
+			return(false);
+		}
+
+		GLint planeLocations[6];
+		for (int i = 0; i < 6; i++)
+		{
+			std::string name = "frustumPlanes[" + std::to_string(i) + "]";
+			planeLocations[i] = glGetUniformLocation(cullProgram, name.c_str());
+		}
+		GLint firstObjectLocation = glGetUniformLocation(cullProgram, "firstObject");
+		GLint objectCountLocation = glGetUniformLocation(cullProgram, "objectCount");
+		if ((planeLocations[0] < 0) || (firstObjectLocation < 0) || (objectCountLocation < 0))
+		{
+			std::cout << "ERROR: the cull program lacks the frustum and object range uniforms" << std::endl;
+			return(false);
+		}
+
+		for (int i = 0; i < 6; i++)
+		{
+			m_frustumPlaneLocations[i] = planeLocations[i];
+		}
+		m_firstObjectLocation = firstObjectLocation;
+		m_objectCountLocation = objectCountLocation;
+	}
+
+	if (cullProgram == m_cullProgram)
+	{
+		return(true);
+	}
+
+	GLuint maxObjects = m_maxObjects;
+	m_cullProgram = cullProgram;
+	if ((maxObjects > 0) && !Initialize(maxObjects))
+	{
+		m_cullProgram = 0;
+		Initialize(maxObjects);
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  IsCulling()
+ *
+ *  This method is used for checking whether the objects are
+ *  culled on the GPU.
+ ***********************************************************/
+bool IndirectRenderer::IsCulling() const
+{
+	return(m_cullProgram != 0);
+}
+
+/***********************************************************
+ *  SetCullFrustum()
+ *
+ *  This method is used for setting the frustum planes the
+ *  cull pass tests the objects against.  Until it is set
+ *  every object is kept.
+ ***********************************************************/
+void IndirectRenderer::SetCullFrustum(const FrustumCuller::FRUSTUM& frustum)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		m_frustumPlanes[i] = frustum.planes[i];
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for moving on to the next region of
+ *  the rings and binding it.  When the GPU has not yet
+ *  passed the fence of the frame that last wrote the
+ *  region, the CPU waits for it here; with three regions
+ *  that only happens when the CPU is more than two frames
+ *  ahead.
+ ***********************************************************/
+void IndirectRenderer::BeginFrame()
+{
+	if (!IsInitialized())
+	{
+		return;
+	}
+
+	m_region = (m_region + 1) % FRAMES_IN_FLIGHT;
+
+	if (NULL != m_fences[m_region])
+	{
+		TRACE_SCOPE("wait for draw buffers");
+
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		for (;;)
+		{
+			GLenum result = glClientWaitSync(m_fences[m_region], flags, FENCE_WAIT_TIMEOUT);
+			if ((result == GL_ALREADY_SIGNALED) || (result == GL_CONDITION_SATISFIED) || (result == GL_WAIT_FAILED))
+			{
+				break;
+			}
+			flags = 0;
+		}
+		glDeleteSync(m_fences[m_region]);
+		m_fences[m_region] = NULL;
+	}
+
+	m_objectCount = 0;
+	m_commandCount = 0;
+	m_firstUnflushedCommand = 0;
+	m_firstUnflushedObject = 0;
+	m_unflushedIndices = 0;
+	m_bLastCommandShared = false;
+
+	if (m_cullProgram == 0)
+	{
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, OBJECT_BUFFER_BINDING, m_objectRing.buffer,
+			GetRegionOffset(m_objectRing), m_objectRing.regionSize);
+		return;
+	}
+
+	// the vertex shader reads the survivors the cull pass
+	// copies out of the queued objects
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, OBJECT_BUFFER_BINDING, m_culledObjectBuffer,
+		GetRegionOffset(m_objectRing), m_objectRing.regionSize);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, CULL_INPUT_BINDING, m_objectRing.buffer,
+		GetRegionOffset(m_objectRing), m_objectRing.regionSize);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, CULL_BOUNDS_BINDING, m_boundsRing.buffer,
+		GetRegionOffset(m_boundsRing), m_boundsRing.regionSize);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, CULL_COMMAND_BINDING, m_commandRing.buffer,
+		GetRegionOffset(m_commandRing), m_commandRing.regionSize);
+}
+
+/***********************************************************
+ *  AddObject()
+ *
+ *  This method is used for queuing an object that is drawn
+ *  whether or not it is in view.
+ ***********************************************************/
+bool IndirectRenderer::AddObject(const ShapeMeshes::ARENA_MESH& mesh, const OBJECT_STD430& object, bool bKeepOrder)
+{
+	return(QueueObject(mesh, object, glm::vec3(0.0f), glm::vec3(0.0f), false, bKeepOrder));
+}
+
+/***********************************************************
+ *  AddCulledObject()
+ *
+ *  This method is used for queuing an object that the cull
+ *  pass only keeps when its world bounds touch the frustum.
+ ***********************************************************/
+bool IndirectRenderer::AddCulledObject(
+	const ShapeMeshes::ARENA_MESH& mesh,
+	const OBJECT_STD430& object,
+	const glm::vec3& center,
+	const glm::vec3& extents,
+	bool bKeepOrder)
+{
+	return(QueueObject(mesh, object, center, extents, true, bKeepOrder));
+}
+
+/***********************************************************
+ *  QueueObject()
+ *
+ *  This method is used for writing the values of one object
+ *  into the current region and queuing a draw command for
+ *  it.  The object index goes into the base instance of the
+ *  command.  An object that follows another of the same mesh
+ *  extends that command by one instance instead, so runs of
+ *  one shape cost a single command.  Under culling the
+ *  survivors of a command are packed in any order, so an
+ *  object that has to keep its place gets a command of its
+ *  own, and the command starts with no instances for the
+ *  cull pass to count up.
+ ***********************************************************/
+bool IndirectRenderer::QueueObject(
+	const ShapeMeshes::ARENA_MESH& mesh,
+	const OBJECT_STD430& object,
+	const glm::vec3& center,
+	const glm::vec3& extents,
+	bool bCullable,
+	bool bKeepOrder)
+{
+	if (!IsInitialized() || (m_objectCount >= m_maxObjects))
+	{
+		return(false);
+	}
+
+	GLuint objectIndex = m_objectCount++;
+	memcpy(m_objectRing.pMapped + GetRegionOffset(m_objectRing) + objectIndex * sizeof(OBJECT_STD430),
+		&object, sizeof(OBJECT_STD430));
+
+	bool bShared = !bKeepOrder || (m_cullProgram == 0);
+	if ((m_commandCount > m_firstUnflushedCommand) && m_bLastCommandShared && bShared &&
+		(m_lastCommand.firstIndex == mesh.firstIndex) && (m_lastCommand.baseVertex == mesh.baseVertex))
+	{
+		if (m_cullProgram == 0)
+		{
+			m_lastCommand.instanceCount++;
+		}
+	}
+	else
+	{
+		m_lastCommand.count = mesh.indexCount;
+		m_lastCommand.instanceCount = (m_cullProgram == 0) ? 1 : 0;
+		m_lastCommand.firstIndex = mesh.firstIndex;
+		m_lastCommand.baseVertex = mesh.baseVertex;
+		m_lastCommand.baseInstance = objectIndex;
+		m_bLastCommandShared = bShared;
+		m_commandCount++;
+	}
+
+	DRAW_COMMAND* pCommands = (DRAW_COMMAND*)(m_commandRing.pMapped + GetRegionOffset(m_commandRing));
+	pCommands[m_commandCount - 1] = m_lastCommand;
+	m_unflushedIndices += (GLsizei)mesh.indexCount;
+
+	if (m_cullProgram != 0)
+	{
+		CULL_BOUNDS_STD430 bounds;
+		bounds.center = center;
+		bounds.commandIndex = m_commandCount - 1;
+		bounds.extents = extents;
+		bounds.bCullable = bCullable ? 1 : 0;
+		memcpy(m_boundsRing.pMapped + GetRegionOffset(m_boundsRing) + objectIndex * sizeof(CULL_BOUNDS_STD430),
+			&bounds, sizeof(CULL_BOUNDS_STD430));
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  FlushDraws()
+ *
+ *  This method is used for drawing the commands queued
+ *  since the last flush with one multi-draw call, under
+ *  whatever render state is set at the time.  When culling,
+ *  the cull pass runs over their objects first; the index
+ *  count passed on for the stats is the one before culling,
+ *  since the survivors are never read back.
+ ***********************************************************/
+bool IndirectRenderer::FlushDraws()
+{
+	if (!IsInitialized() || (m_commandCount == m_firstUnflushedCommand))
+	{
+		return(false);
+	}
+
+	if (m_cullProgram != 0)
+	{
+		CullUnflushedObjects();
+	}
+
+	GLsizei commandCount = (GLsizei)(m_commandCount - m_firstUnflushedCommand);
+	GLintptr commandOffset = GetRegionOffset(m_commandRing) + m_firstUnflushedCommand * sizeof(DRAW_COMMAND);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandRing.buffer);
+	m_pMeshes->DrawArenaIndirect(commandOffset, commandCount, m_unflushedIndices);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	m_firstUnflushedCommand = m_commandCount;
+	m_firstUnflushedObject = m_objectCount;
+	m_unflushedIndices = 0;
+
+	return(true);
+}
+
+/***********************************************************
+ *  CullUnflushedObjects()
+ *
+ *  This method is used for running the cull pass over the
+ *  objects queued since the last flush.  The barrier makes
+ *  the instance counts and the copied objects visible to
+ *  the multi-draw call and the vertex shader that follow.
+ ***********************************************************/
+void IndirectRenderer::CullUnflushedObjects()
+{
+	GLuint objectCount = m_objectCount - m_firstUnflushedObject;
+	GLuint drawProgram = m_pStateCache->GetCurrentProgram();
+
+	m_pStateCache->UseProgram(m_cullProgram);
+	for (int i = 0; i < 6; i++)
+	{
+		m_pStateCache->SetVec4Value(m_frustumPlaneLocations[i], m_frustumPlanes[i]);
+	}
+	m_pStateCache->SetIntValue(m_firstObjectLocation, (int)m_firstUnflushedObject);
+	m_pStateCache->SetIntValue(m_objectCountLocation, (int)objectCount);
+
+	glDispatchCompute((objectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+	m_pStateCache->UseProgram(drawProgram);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for placing the fence that tells
+ *  when the GPU is done with the region written this frame.
+ ***********************************************************/
+void IndirectRenderer::EndFrame()
+{
+	if (!IsInitialized())
+	{
+		return;
+	}
+
+	FlushDraws();
+	size_t uploadBytes = m_objectCount * sizeof(OBJECT_STD430) + m_commandCount * sizeof(DRAW_COMMAND);
+	if (m_cullProgram != 0)
+	{
+		uploadBytes += m_objectCount * sizeof(CULL_BOUNDS_STD430);
+	}
+	RenderStats::CountBufferUpload(uploadBytes);
+
+	if (NULL != m_fences[m_region])
+	{
+		glDeleteSync(m_fences[m_region]);
+	}
+	m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/***********************************************************
+ *  CreateRing()
+ *
+ *  This method is used for creating an immutable buffer with
+ *  one region per frame in flight and mapping the whole of
+ *  it for as long as it lives.
+ ***********************************************************/
+bool IndirectRenderer::CreateRing(PERSISTENT_RING& ring, GLenum target, GLsizeiptr regionSize)
+{
+	GLsizeiptr size = regionSize * FRAMES_IN_FLIGHT;
+
+	glGenBuffers(1, &ring.buffer);
+	glBindBuffer(target, ring.buffer);
+	glBufferStorage(target, size, NULL, RING_FLAGS);
+	ring.pMapped = (unsigned char*)glMapBufferRange(target, 0, size, RING_FLAGS);
+	glBindBuffer(target, 0);
+	ring.regionSize = regionSize;
+
+	return(NULL != ring.pMapped);
+}
+
+/***********************************************************
+ *  DestroyRing()
+ *
+ *  This method is used for unmapping and freeing a ring.
+ ***********************************************************/
+void IndirectRenderer::DestroyRing(PERSISTENT_RING& ring)
+{
+	if (ring.buffer != 0)
+	{
+		if (NULL != ring.pMapped)
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, ring.buffer);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &ring.buffer);
+	}
+	ring = {};
+}
+
+/***********************************************************
+ *  GetRegionOffset()
+ *
+ *  This method is used for getting the byte offset of the
+ *  region of a ring written this frame.
+ ***********************************************************/
+GLintptr IndirectRenderer::GetRegionOffset(const PERSISTENT_RING& ring) const
+{
+	return((GLintptr)ring.regionSize * m_region);
+}
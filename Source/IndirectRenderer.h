@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////////////
+// indirectrenderer.h
+// ============
+// draw many objects from the shared mesh arena with multi-draw indirect
+// commands and per-object data written to persistently mapped buffers
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrustumCuller.h"
+#include "GLStateCache.h"
+#include "ShapeMeshes.h"
+#include "UniformBlocks.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  IndirectRenderer
+ *
+ *  This class issues the GPU-driven draw path.  Every object
+ *  queued in a frame gets its values written to an object
+ *  storage buffer and an indirect draw command that points
+ *  into the shared mesh arena, and the commands queued
+ *  under one render state go out with a single
+ *  glMultiDrawElementsIndirect call.  Both buffers are
+ *  created with glBufferStorage and stay mapped for their
+ *  whole life, split into one region per frame in flight.
+ *  A fence is placed after the draws of each frame, and a
+ *  region is only written again once the GPU has passed
+ *  the fence of the frame that last used it, so the CPU
+ *  never writes over data still being read.
+ *
+ *  With a cull program set, the objects are tested against
+ *  the view frustum on the GPU instead.  Each command is
+ *  queued with no instances, and before each multi-draw
+ *  call a compute pass tests the queued objects, counts the
+ *  survivors into the instance count of their command and
+ *  copies their values to a GPU-only object buffer, packed
+ *  from the base instance of the command.  Nothing is read
+ *  back to the CPU.
+ ***********************************************************/
+class IndirectRenderer
+{
+public:
+	// frames the CPU may run ahead of the GPU
+	static const int FRAMES_IN_FLIGHT = 3;
+
+	// constructor
+	IndirectRenderer(ShapeMeshes* pMeshes, GLStateCache* pStateCache);
+	// destructor
+	~IndirectRenderer();
+
+	// create the buffers for up to maxObjects objects per
+	// frame, returns false when the context lacks buffer
+	// storage or multi-draw indirect
+	bool Initialize(GLuint maxObjects);
+	// free the buffers and fences
+	void Destroy();
+	// check whether the buffers were created
+	bool IsInitialized() const;
+	// get the number of objects a frame can hold
+	GLuint GetMaxObjects() const;
+
+	// set the compute program that culls the queued objects,
+	// 0 to draw every object, returns false when the program
+	// lacks its uniforms or the buffers cannot be created
+	bool SetCullProgram(GLuint cullProgram);
+	// check whether the objects are culled on the GPU
+	bool IsCulling() const;
+	// set the frustum the objects are culled against
+	void SetCullFrustum(const FrustumCuller::FRUSTUM& frustum);
+
+	// wait until the next region is free and start writing it
+	void BeginFrame();
+	// queue one object that is always drawn, returns false
+	// when the frame is full.  bKeepOrder stops a culled
+	// frame from drawing it out of queue order with the
+	// objects around it
+	bool AddObject(const ShapeMeshes::ARENA_MESH& mesh, const OBJECT_STD430& object, bool bKeepOrder = false);
+	// queue one object that the cull pass tests with its
+	// world bounds, drawn always when culling is off
+	bool AddCulledObject(
+		const ShapeMeshes::ARENA_MESH& mesh,
+		const OBJECT_STD430& object,
+		const glm::vec3& center,
+		const glm::vec3& extents,
+		bool bKeepOrder = false);
+	// draw the objects queued since the last flush with one
+	// call, returns false when there was nothing to draw
+	bool FlushDraws();
+	// fence the region written this frame
+	void EndFrame();
+
+private:
+	// one indirect draw command, laid out as OpenGL reads it
+	struct DRAW_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// a persistently mapped buffer split into one region per
+	// frame in flight
+	struct PERSISTENT_RING
+	{
+		GLuint buffer;
+		unsigned char* pMapped;
+		GLsizeiptr regionSize;
+	};
+
+	// pointer to the meshes holding the shared arena
+	ShapeMeshes* m_pMeshes;
+	// pointer to the state cache the cull pass switches
+	// programs through
+	GLStateCache* m_pStateCache;
+	PERSISTENT_RING m_objectRing;
+	PERSISTENT_RING m_commandRing;
+	// bounds of the queued objects, only created for culling
+	PERSISTENT_RING m_boundsRing;
+	// objects that survived the cull pass, one region per
+	// frame in flight, only written by the GPU
+	GLuint m_culledObjectBuffer;
+	// compute program of the cull pass, 0 when not culling
+	GLuint m_cullProgram;
+	// uniform locations of the cull program
+	GLint m_frustumPlaneLocations[6];
+	GLint m_firstObjectLocation;
+	GLint m_objectCountLocation;
+	glm::vec4 m_frustumPlanes[6];
+	// fence placed after the draws of each region
+	GLsync m_fences[FRAMES_IN_FLIGHT];
+	// region being written this frame
+	int m_region;
+	GLuint m_maxObjects;
+	// objects and commands queued this frame
+	GLuint m_objectCount;
+	GLuint m_commandCount;
+	// first command and object not yet drawn, and the indices
+	// the commands from there draw before any culling
+	GLuint m_firstUnflushedCommand;
+	GLuint m_firstUnflushedObject;
+	GLsizei m_unflushedIndices;
+	// copy of the last command, so it is never read back from
+	// the write-only mapping, and whether later objects may
+	// join it
+	DRAW_COMMAND m_lastCommand;
+	bool m_bLastCommandShared;
+
+	// create and map one ring
+	bool CreateRing(PERSISTENT_RING& ring, GLenum target, GLsizeiptr regionSize);
+	// unmap and free one ring
+	void DestroyRing(PERSISTENT_RING& ring);
+	// get the byte offset of the current region of a ring
+	GLintptr GetRegionOffset(const PERSISTENT_RING& ring) const;
+	// write one object and its bounds and queue its command
+	bool QueueObject(
+		const ShapeMeshes::ARENA_MESH& mesh,
+		const OBJECT_STD430& object,
+		const glm::vec3& center,
+		const glm::vec3& extents,
+		bool bCullable,
+		bool bKeepOrder);
+	// run the cull pass over the objects not yet drawn
+	void CullUnflushedObjects();
+};
@@ -0,0 +1,489 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// run small jobs on a pool of worker threads that steal work from each
+// other, with job dependencies and a parallel loop over index ranges
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+#include "TraceRecorder.h"
+
+#include <algorithm>
+
+/***********************************************************
+ *  JOB
+ *
+ *  The function of a job, the dependencies it still waits
+ *  for, and the jobs waiting for it.  The list of waiting
+ *  jobs and the finished flag change under the job mutex,
+ *  so a dependency never finishes between being checked and
+ *  being waited on.
+ ***********************************************************/
+struct JobSystem::JOB
+{
+	JOB_FUNCTION function;
+	// unfinished dependencies, plus one while being submitted
+	std::atomic<int> remainingDependencies;
+	std::atomic<bool> bFinished;
+	std::mutex mutex;
+	std::vector<JOB_HANDLE> dependents;
+};
+
+// declaration of global variables
+namespace
+{
+	// the job system the calling thread works for, and the
+	// queue it owns there
+	thread_local const JobSystem* t_pOwner = NULL;
+	thread_local int t_queueIndex = -1;
+
+	// one running ParallelFor, which the calling thread and
+	// its helper jobs take ranges of until none are left
+	struct PARALLEL_LOOP
+	{
+		const JobSystem::RANGE_FUNCTION* pFunction;
+		size_t count;
+		size_t grainSize;
+		// first index of the next range to hand out
+		std::atomic<size_t> nextFirst;
+		// helper jobs that did not finish yet
+		std::atomic<int> activeHelpers;
+	};
+
+	/***********************************************************
+	 *  RunRanges()
+	 *
+	 *  This function is used for running the ranges of a loop
+	 *  one after another until every range was taken.
+	 ***********************************************************/
+	void RunRanges(PARALLEL_LOOP& loop)
+	{
+		for (;;)
+		{
+			size_t first = loop.nextFirst.fetch_add(loop.grainSize);
+			if (first >= loop.count)
+			{
+				return;
+			}
+			(*loop.pFunction)(first, std::min(first + loop.grainSize, loop.count));
+		}
+	}
+}
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+JobSystem::JobSystem(unsigned int workerCount)
+{
+	m_queuedJobs = 0;
+	m_nextQueue = 0;
+	m_bStopping = false;
+	m_sleepingWaiters = 0;
+
+	// leave one core for the thread that submits the work
+	if (workerCount == 0)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		workerCount = (cores > 1) ? cores - 1 : 1;
+	}
+
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		m_queues.push_back(std::unique_ptr<WORKER_QUEUE>(new WORKER_QUEUE()));
+	}
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		m_workers.emplace_back(&JobSystem::WorkerLoop, this, (int)i);
+	}
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_bStopping = true;
+	}
+	m_jobQueued.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+	m_queues.clear();
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used for creating a job that runs once
+ *  every listed dependency finished.  The job counts one
+ *  extra dependency while the list is walked, so it cannot
+ *  be queued by a dependency finishing half way through.
+ ***********************************************************/
+JobSystem::JOB_HANDLE JobSystem::Submit(JOB_FUNCTION function, const std::vector<JOB_HANDLE>& dependencies)
+{
+	JOB_HANDLE job = std::make_shared<JOB>();
+	job->function = std::move(function);
+	job->remainingDependencies = 1;
+	job->bFinished = false;
+
+	for (const JOB_HANDLE& dependency : dependencies)
+	{
+		if (!dependency)
+		{
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+		if (!dependency->bFinished)
+		{
+			dependency->dependents.push_back(job);
+			job->remainingDependencies++;
+		}
+	}
+
+	if (job->remainingDependencies.fetch_sub(1) == 1)
+	{
+		Enqueue(job);
+	}
+
+	return(job);
+}
+
+/***********************************************************
+ *  IsFinished()
+ *
+ *  This method is used for checking whether a job finished.
+ *  An empty handle counts as finished.
+ ***********************************************************/
+bool JobSystem::IsFinished(const JOB_HANDLE& job) const
+{
+	return(!job || job->bFinished);
+}
+
+/***********************************************************
+ *  Wait()
+ *
+ *  This method is used for blocking until a job finished.
+ *  The calling thread runs queued jobs while it waits,
+ *  starting with its own queue when it is a worker.
+ ***********************************************************/
+void JobSystem::Wait(const JOB_HANDLE& job)
+{
+	WaitUntil(
+		[this, &job]()
+		{
+			return(IsFinished(job));
+		});
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for running a loop body over [0,
+ *  count) in ranges of grainSize.  Rather than one job per
+ *  range, at most one helper job per worker is queued, and
+ *  the helpers and the calling thread take ranges off a
+ *  shared counter until none are left.  The helpers come
+ *  from a pool that is reused by every loop, so a loop
+ *  allocates nothing, and a loop that fits one range never
+ *  leaves the thread.  The loop lives on the stack, so the
+ *  call only returns once every helper let go of it.
+ ***********************************************************/
+void JobSystem::ParallelFor(size_t count, size_t grainSize, const RANGE_FUNCTION& function)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (grainSize == 0)
+	{
+		grainSize = 1;
+	}
+
+	size_t rangeCount = (count + grainSize - 1) / grainSize;
+	int helperCount = (int)std::min(rangeCount - 1, m_workers.size());
+
+	PARALLEL_LOOP loop;
+	loop.pFunction = &function;
+	loop.count = count;
+	loop.grainSize = grainSize;
+	loop.nextFirst = 0;
+	loop.activeHelpers = helperCount;
+
+	PARALLEL_LOOP* pLoop = &loop;
+	for (int i = 0; i < helperCount; i++)
+	{
+		JOB_HANDLE job = AcquireLoopJob();
+		job->function =
+			[pLoop]()
+			{
+				RunRanges(*pLoop);
+				pLoop->activeHelpers--;
+			};
+		Enqueue(job);
+	}
+
+	RunRanges(loop);
+	WaitUntil(
+		[pLoop]()
+		{
+			return(pLoop->activeHelpers == 0);
+		});
+}
+
+/***********************************************************
+ *  GetWorkerCount()
+ *
+ *  This method is used for getting the number of worker
+ *  threads.
+ ***********************************************************/
+unsigned int JobSystem::GetWorkerCount() const
+{
+	return((unsigned int)m_workers.size());
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is the body of each worker thread.  The
+ *  worker runs jobs for as long as any queue holds one, and
+ *  sleeps once they are all empty.
+ ***********************************************************/
+void JobSystem::WorkerLoop(int queueIndex)
+{
+	TRACE_THREAD_NAME("job worker");
+	t_pOwner = this;
+	t_queueIndex = queueIndex;
+
+	for (;;)
+	{
+		if (RunOneJob(queueIndex))
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_jobQueued.wait(lock, [this]() { return(m_bStopping || (m_queuedJobs > 0)); });
+		if (m_bStopping)
+		{
+			return;
+		}
+	}
+}
+
+/***********************************************************
+ *  Enqueue()
+ *
+ *  This method is used for putting a job that is ready to
+ *  run into a queue.  A worker puts it into its own queue;
+ *  any other thread spreads its jobs over the queues in
+ *  turn.  The sleep mutex is taken before waking a worker,
+ *  so a worker about to sleep cannot miss the job.
+ ***********************************************************/
+void JobSystem::Enqueue(const JOB_HANDLE& job)
+{
+	int queueIndex = GetOwnQueue();
+	if (queueIndex < 0)
+	{
+		queueIndex = (int)(m_nextQueue++ % m_queues.size());
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_queues[queueIndex]->mutex);
+		m_queues[queueIndex]->jobs.push_back(job);
+	}
+	m_queuedJobs++;
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_jobQueued.notify_one();
+	WakeWaiters();
+}
+
+/***********************************************************
+ *  RunOneJob()
+ *
+ *  This method is used for running one queued job.  The
+ *  newest job of the own queue is taken first, while its
+ *  data is still in the cache; otherwise the oldest job of
+ *  the next queue that has one is stolen, which tends to be
+ *  the biggest piece of work left there.
+ ***********************************************************/
+bool JobSystem::RunOneJob(int ownQueue)
+{
+	JOB_HANDLE job;
+
+	if (ownQueue >= 0)
+	{
+		WORKER_QUEUE& queue = *m_queues[ownQueue];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = queue.jobs.back();
+			queue.jobs.pop_back();
+		}
+	}
+
+	int queueCount = (int)m_queues.size();
+	for (int i = 1; !job && (i <= queueCount); i++)
+	{
+		int victim = (ownQueue + i + queueCount) % queueCount;
+		if (victim == ownQueue)
+		{
+			continue;
+		}
+
+		WORKER_QUEUE& queue = *m_queues[victim];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = queue.jobs.front();
+			queue.jobs.pop_front();
+		}
+	}
+
+	if (!job)
+	{
+		return(false);
+	}
+
+	m_queuedJobs--;
+	job->function();
+	FinishJob(job);
+
+	return(true);
+}
+
+/***********************************************************
+ *  FinishJob()
+ *
+ *  This method is used for marking a job finished and
+ *  queuing each waiting job that no longer waits for
+ *  anything.  The function is released here, so whatever
+ *  it captured does not live on with the handle.
+ ***********************************************************/
+void JobSystem::FinishJob(const JOB_HANDLE& job)
+{
+	std::vector<JOB_HANDLE> dependents;
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		job->function = nullptr;
+		dependents.swap(job->dependents);
+		job->bFinished = true;
+	}
+
+	for (const JOB_HANDLE& dependent : dependents)
+	{
+		if (dependent->remainingDependencies.fetch_sub(1) == 1)
+		{
+			Enqueue(dependent);
+		}
+	}
+
+	WakeWaiters();
+}
+
+/***********************************************************
+ *  WaitUntil()
+ *
+ *  This method is used for running queued jobs until a
+ *  condition holds.  With nothing left to run the thread
+ *  sleeps until a job is queued or finishes, instead of
+ *  spinning.  The sleeping count goes up before the
+ *  condition is checked, and WakeWaiters reads it after the
+ *  change it reports, so a change that comes in between
+ *  always wakes the thread.
+ ***********************************************************/
+void JobSystem::WaitUntil(const std::function<bool()>& isDone)
+{
+	int ownQueue = GetOwnQueue();
+	while (!isDone())
+	{
+		if (RunOneJob(ownQueue))
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_sleepingWaiters++;
+		m_jobChanged.wait(lock,
+			[this, &isDone]()
+			{
+				return(isDone() || (m_queuedJobs > 0));
+			});
+		m_sleepingWaiters--;
+	}
+}
+
+/***********************************************************
+ *  WakeWaiters()
+ *
+ *  This method is used for waking the threads sleeping in
+ *  WaitUntil, so they check their condition again.  While
+ *  none sleeps it costs a single atomic read.
+ ***********************************************************/
+void JobSystem::WakeWaiters()
+{
+	if (m_sleepingWaiters == 0)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_jobChanged.notify_all();
+}
+
+/***********************************************************
+ *  AcquireLoopJob()
+ *
+ *  This method is used for getting a helper job for a
+ *  parallel loop.  A pooled job is idle once it finished
+ *  and the pool holds the only handle to it; locking its
+ *  mutex waits for FinishJob to be done with it.  A new job
+ *  is only added when every pooled one is in use.
+ ***********************************************************/
+JobSystem::JOB_HANDLE JobSystem::AcquireLoopJob()
+{
+	std::lock_guard<std::mutex> lock(m_loopJobsMutex);
+
+	for (const JOB_HANDLE& job : m_loopJobs)
+	{
+		if (job->bFinished && (job.use_count() == 1))
+		{
+			std::lock_guard<std::mutex> jobLock(job->mutex);
+			job->remainingDependencies = 0;
+			job->bFinished = false;
+			return(job);
+		}
+	}
+
+	JOB_HANDLE job = std::make_shared<JOB>();
+	job->remainingDependencies = 0;
+	job->bFinished = false;
+	m_loopJobs.push_back(job);
+
+	return(job);
+}
+
+/***********************************************************
+ *  GetOwnQueue()
+ *
+ *  This method is used for getting the queue the calling
+ *  thread owns, which only a worker of this job system has.
+ ***********************************************************/
+int JobSystem::GetOwnQueue() const
+{
+	return((t_pOwner == this) ? t_queueIndex : -1);
+}
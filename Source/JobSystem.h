@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// run small jobs on a pool of worker threads that steal work from each
+// other, with job dependencies and a parallel loop over index ranges
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class spreads CPU work over the cores.  Every
+ *  worker thread owns a queue of jobs: it takes its newest
+ *  job first, while a worker whose queue ran dry steals the
+ *  oldest job of another queue, so the work evens out
+ *  without a single shared queue everyone contends on.  A
+ *  job can depend on other jobs and is only queued once all
+ *  of them finished.  A thread that waits for a job runs
+ *  queued jobs in the meantime, so waiting from inside a
+ *  job does not tie up a worker, and sleeps once there is
+ *  nothing left to run.  Nothing here touches OpenGL; the
+ *  jobs must not either.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	// one submitted job, only referred to through its handle
+	struct JOB;
+	typedef std::shared_ptr<JOB> JOB_HANDLE;
+	typedef std::function<void()> JOB_FUNCTION;
+	// body of a parallel loop, called for [first, last)
+	typedef std::function<void(size_t first, size_t last)> RANGE_FUNCTION;
+
+	// constructor - starts the worker threads, one per core
+	// but the calling one when workerCount is 0
+	JobSystem(unsigned int workerCount = 0);
+	// destructor - stops the worker threads, dropping the
+	// jobs that did not start
+	~JobSystem();
+
+	// queue a job to run once every listed job finished
+	JOB_HANDLE Submit(
+		JOB_FUNCTION function,
+		const std::vector<JOB_HANDLE>& dependencies = std::vector<JOB_HANDLE>());
+	// check whether a job finished
+	bool IsFinished(const JOB_HANDLE& job) const;
+	// run queued jobs until a job finished
+	void Wait(const JOB_HANDLE& job);
+	// split [0, count) into ranges of grainSize and run them
+	// on the workers and the calling thread, returning once
+	// every range is done; no memory is allocated once the
+	// pool of helper jobs has grown to the worker count
+	void ParallelFor(size_t count, size_t grainSize, const RANGE_FUNCTION& function);
+	// get the number of worker threads
+	unsigned int GetWorkerCount() const;
+
+private:
+	// the job queue of one worker
+	struct WORKER_QUEUE
+	{
+		std::mutex mutex;
+		std::deque<JOB_HANDLE> jobs;
+	};
+
+	std::vector<std::thread> m_workers;
+	std::vector<std::unique_ptr<WORKER_QUEUE>> m_queues;
+	// jobs sitting in any queue
+	std::atomic<int> m_queuedJobs;
+	// queue the next job from outside the workers goes to
+	std::atomic<unsigned int> m_nextQueue;
+	// idle workers sleep on this until a job is queued
+	std::mutex m_sleepMutex;
+	std::condition_variable m_jobQueued;
+	bool m_bStopping;
+	// waiting threads with nothing to run sleep on this, under
+	// the same mutex, until a job is queued or finishes; it
+	// is only signalled while one of them sleeps
+	std::condition_variable m_jobChanged;
+	std::atomic<int> m_sleepingWaiters;
+	// the helper jobs ParallelFor hands its ranges to, reused
+	// from one loop to the next
+	std::mutex m_loopJobsMutex;
+	std::vector<JOB_HANDLE> m_loopJobs;
+
+	// body of each worker thread
+	void WorkerLoop(int queueIndex);
+	// put a job whose dependencies finished into a queue
+	void Enqueue(const JOB_HANDLE& job);
+	// take a job from the own queue or steal one and run it,
+	// returns false when every queue was empty
+	bool RunOneJob(int ownQueue);
+	// mark a job finished and queue the jobs it released
+	void FinishJob(const JOB_HANDLE& job);
+	// run queued jobs until isDone returns true, sleeping
+	// while there is nothing to run
+	void WaitUntil(const std::function<bool()>& isDone);
+	// wake the threads sleeping in WaitUntil
+	void WakeWaiters();
+	// get an idle helper job of the pool, adding one when
+	// they are all in use
+	JOB_HANDLE AcquireLoopJob();
+	// get the queue of the calling thread, -1 for a thread
+	// that is not one of the workers
+	int GetOwnQueue() const;
+};
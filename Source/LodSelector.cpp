@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// lodselector.cpp
+// ============
+// choose the level of detail of an object from its projected size on
+// the screen
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LodSelector.h"
+
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// smallest projected size, as a fraction of half the
+	// viewport height, still drawn at each level but the last
+	const float LEVEL_MIN_SIZES[LodSelector::LEVEL_COUNT - 1] = { 0.15f, 0.05f };
+
+	// how far past a threshold the size has to go before the
+	// level changes, as a fraction of the threshold
+	const float HYSTERESIS = 0.2f;
+
+	// closest distance used for the projection, so an object
+	// around the camera does not divide by zero
+	const float MIN_DISTANCE = 0.001f;
+}
+
+/***********************************************************
+ *  LodSelector()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LodSelector::LodSelector()
+{
+	m_projectionScale = 1.0f;
+	m_bPerspective = true;
+	m_bProjectionSet = false;
+	m_cameraPosition = glm::vec3(0.0f);
+}
+
+/***********************************************************
+ *  SetProjection()
+ *
+ *  This method is used for taking the screen scale from the
+ *  camera projection matrix.  Its second diagonal element
+ *  maps a size at unit distance to half the viewport
+ *  height, and a perspective projection is told apart by
+ *  the -1 that copies the depth into w.
+ ***********************************************************/
+void LodSelector::SetProjection(const glm::mat4& projection)
+{
+	m_projectionScale = fabsf(projection[1][1]);
+	m_bPerspective = (projection[2][3] != 0.0f);
+	m_bProjectionSet = true;
+}
+
+/***********************************************************
+ *  SetCameraPosition()
+ *
+ *  This method is used for setting the camera position the
+ *  object distances are measured from.
+ ***********************************************************/
+void LodSelector::SetCameraPosition(const glm::vec3& cameraPosition)
+{
+	m_cameraPosition = cameraPosition;
+}
+
+/***********************************************************
+ *  GetProjectedSize()
+ *
+ *  This method is used for getting the projected radius of
+ *  a sphere as a fraction of half the viewport height.
+ ***********************************************************/
+float LodSelector::GetProjectedSize(const glm::vec3& center, float radius) const
+{
+	if (!m_bPerspective)
+	{
+		return(radius * m_projectionScale);
+	}
+
+	float distance = glm::length(center - m_cameraPosition);
+	if (distance < MIN_DISTANCE)
+	{
+		distance = MIN_DISTANCE;
+	}
+
+	return(radius * m_projectionScale / distance);
+}
+
+/***********************************************************
+ *  SelectLevel()
+ *
+ *  This method is used for choosing the level of an object
+ *  that is drawn at currentLevel.  The level only gets finer
+ *  once the size is clearly above the threshold of the
+ *  finer level, and only gets coarser once it is clearly
+ *  below the threshold of its own level.  Everything is
+ *  drawn at level 0 until a projection is set.
+ ***********************************************************/
+int LodSelector::SelectLevel(int currentLevel, const glm::vec3& center, float radius) const
+{
+	if (!m_bProjectionSet)
+	{
+		return(0);
+	}
+
+	float size = GetProjectedSize(center, radius);
+	int level = currentLevel;
+
+	while ((level > 0) && (size > LEVEL_MIN_SIZES[level - 1] * (1.0f + HYSTERESIS)))
+	{
+		level--;
+	}
+	while ((level < LEVEL_COUNT - 1) && (size < LEVEL_MIN_SIZES[level] * (1.0f - HYSTERESIS)))
+	{
+		level++;
+	}
+
+	return(level);
+}
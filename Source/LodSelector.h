@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+// lodselector.h
+// ============
+// choose the level of detail of an object from its projected size on
+// the screen
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  LodSelector
+ *
+ *  This class picks how finely a curved shape is drawn.
+ *  The bounding sphere of an object is projected with the
+ *  camera projection, and the object moves to a coarser
+ *  level once it covers less of the screen than the level
+ *  threshold.  Each threshold has a band around it that the
+ *  size has to cross before the level changes back, so an
+ *  object sitting right at a threshold does not flicker
+ *  between two levels while the camera moves.
+ ***********************************************************/
+class LodSelector
+{
+public:
+	// number of levels, level 0 being the finest
+	static const int LEVEL_COUNT = 3;
+
+	// constructor
+	LodSelector();
+
+	// take the screen scale from the camera projection matrix
+	void SetProjection(const glm::mat4& projection);
+	// set the camera position the distances are measured from
+	void SetCameraPosition(const glm::vec3& cameraPosition);
+
+	// get the projected radius of a sphere, as a fraction of
+	// half the viewport height
+	float GetProjectedSize(const glm::vec3& center, float radius) const;
+	// choose the level of an object drawn at currentLevel
+	int SelectLevel(int currentLevel, const glm::vec3& center, float radius) const;
+
+private:
+	// half the viewport height over the distance, per unit of size
+	float m_projectionScale;
+	// false for an orthographic projection, where the
+	// projected size does not depend on the distance
+	bool m_bPerspective;
+	// set once a projection was passed in
+	bool m_bProjectionSet;
+	glm::vec3 m_cameraPosition;
+};
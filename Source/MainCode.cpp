@@ -1,294 +1,608 @@
-﻿#include <iostream>         // error handling and output
-#include <cstdlib>          // EXIT_FAILURE
-
-#include <GL/glew.h>        // GLEW library
-#include "GLFW/glfw3.h"     // GLFW library
-
-// GLM Math Header inclusions
-#include <glm/glm.hpp>
-#include <glm/gtx/transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-
-
-#include "SceneManager.h"
-#include "ViewManager.h"
-#include "ShapeMeshes.h"
-#include "ShaderManager.h"
-#include <ranges>
-
-// Namespace for declaring global variables
-namespace
-{
-	// Macro for window title
-	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
-
-	// Main GLFW window
-	GLFWwindow* g_Window = nullptr;
-
-	// scene manager object for managing the 3D scene prepare and render
-	SceneManager* g_SceneManager = nullptr;
-	// shader manager object for dynamic interaction with the shader code
-	ShaderManager* g_ShaderManager = nullptr;
-	// view manager object for managing the 3D view setup and projection to 2D
-	ViewManager* g_ViewManager = nullptr;
-
-	// --- Camera state ---
-	glm::vec3 camPos = glm::vec3(0.0f, 1.2f, 6.0f);
-	glm::vec3 camFront = glm::vec3(0.0f, 0.0f, -1.0f);
-	glm::vec3 camUp = glm::vec3(0.0f, 1.0f, 0.0f);
-
-	// yaw/pitch for mouse look
-	float yaw = -90.0f;
-	float pitch = 0.0f;
-
-	// movement & sensitivity (scroll will adjust baseSpeed)
-	float baseSpeed = 2.5f;
-	float moveSpeed = 2.5f;
-	float mouseSens = 0.12f;
-
-	// frame timing
-	float deltaTime = 0.0f;
-	float lastFrame = 0.0f;
-
-	// mouse bookkeeping
-	bool   firstMouse = true;
-	double lastX = 0.0, lastY = 0.0;
-
-	// projection mode
-	enum class ProjMode { Perspective, Ortho };
-	ProjMode gProj = ProjMode::Perspective;
-
-	// edge-detect flags for P/O toggles
-	bool keyPWasDown = false;
-	bool keyOWasDown = false;
-
-}
-
-// Function declarations - all functions that are called manually
-// need to be pre-declared at the beginning of the source code.
-bool InitializeGLFW();
-bool InitializeGLEW();
-
-void mouse_callback(GLFWwindow*, double xpos, double ypos) {
-	if (firstMouse) { lastX = xpos; lastY = ypos; firstMouse = false; }
-	double xoff = xpos - lastX;
-	double yoff = lastY - ypos; // invert Y
-	lastX = xpos; lastY = ypos;
-
-	xoff *= mouseSens; yoff *= mouseSens;
-	yaw += (float)xoff;
-	pitch += (float)yoff;
-	pitch = glm::clamp(pitch, -89.0f, 89.0f);
-
-	glm::vec3 f;
-	f.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-	f.y = sin(glm::radians(pitch));
-	f.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-	camFront = glm::normalize(f);
-}
-
-void scroll_callback(GLFWwindow*, double, double yoff) {
-	baseSpeed += (float)yoff * 0.25f;
-	baseSpeed = glm::clamp(baseSpeed, 0.5f, 10.0f);
-}
-
-void processInput(GLFWwindow* w) {
-	moveSpeed = baseSpeed * deltaTime;
-
-	// WASD pan/zoom; QE vertical
-	glm::vec3 right = glm::normalize(glm::cross(camFront, camUp));
-	if (glfwGetKey(w, GLFW_KEY_W) == GLFW_PRESS) camPos += camFront * moveSpeed;
-	if (glfwGetKey(w, GLFW_KEY_S) == GLFW_PRESS) camPos -= camFront * moveSpeed;
-	if (glfwGetKey(w, GLFW_KEY_A) == GLFW_PRESS) camPos -= right * moveSpeed;
-	if (glfwGetKey(w, GLFW_KEY_D) == GLFW_PRESS) camPos += right * moveSpeed;
-	if (glfwGetKey(w, GLFW_KEY_Q) == GLFW_PRESS) camPos -= camUp * moveSpeed;
-	if (glfwGetKey(w, GLFW_KEY_E) == GLFW_PRESS) camPos += camUp * moveSpeed;
-
-	// Projection toggles with edge detect
-	bool pDown = glfwGetKey(w, GLFW_KEY_P) == GLFW_PRESS;
-	bool oDown = glfwGetKey(w, GLFW_KEY_O) == GLFW_PRESS;
-	if (pDown && !keyPWasDown) gProj = ProjMode::Perspective;
-	if (oDown && !keyOWasDown) gProj = ProjMode::Ortho;
-	keyPWasDown = pDown;
-	keyOWasDown = oDown;
-}
-
-
-/***********************************************************
- *  main(int, char*)
- *
- *  This function gets called after the application has been
- *  launched.
- ***********************************************************/
-int main(int argc, char* argv[])
-{
-	// if GLFW fails initialization, then terminate the application
-	if (InitializeGLFW() == false)
-	{
-		return(EXIT_FAILURE);
-	}
-
-	// try to create a new shader manager object
-	g_ShaderManager = new ShaderManager();
-	// try to create a new view manager object
-	g_ViewManager = new ViewManager(
-		g_ShaderManager);
-
-	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
-
-	// Lock cursor for FPS-style look (optional)
-	glfwSetInputMode(g_Window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-	// Mouse & scroll callbacks
-	glfwSetCursorPosCallback(g_Window, mouse_callback);
-	glfwSetScrollCallback(g_Window, scroll_callback);
-
-	// if GLEW fails initialization, then terminate the application
-	if (InitializeGLEW() == false)
-	{
-		return(EXIT_FAILURE);
-	}
-
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"../../Utilities/shaders/vertexShader.glsl",
-		"../../Utilities/shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
-
-	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
-	g_SceneManager->PrepareScene();
-
-	// loop will keep running until the application is closed 
-	// or until an error has occurred
-	while (!glfwWindowShouldClose(g_Window))
-	{
-		glEnable(GL_DEPTH_TEST);
-		glClearColor(0.18f, 0.12f, 0.26f, 1.0f);  // dark purple sky base
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// frame timing
-		float currentFrame = (float)glfwGetTime();
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
-
-		//  read keyboard (WASD/QE) and projection toggles
-		processInput(g_Window);
-
-		g_ShaderManager->use();
-
-		// build our projection (P or O) & send to shader
-		int width, height;
-		glfwGetFramebufferSize(g_Window, &width, &height);
-		float aspect = (height > 0) ? (float)width / (float)height : 1.0f;
-
-		glm::mat4 projection(1.0f);
-		if (gProj == ProjMode::Perspective) {
-			projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 100.0f);
-		}
-		else {
-			// ortho box size chosen to comfortably frame house
-			float orthoH = 3.5f;
-			float orthoW = orthoH * aspect;
-			projection = glm::ortho(-orthoW, orthoW, -orthoH, orthoH, 0.1f, 100.0f);
-
-			// optional: in ortho, look straight on (no horizon/floor)
-			camFront = glm::vec3(0, 0, -1);
-			camUp = glm::vec3(0, 1, 0);
-			
-		}                     
-		// timing
-		processInput(g_Window);
-
-		// build projection/view
-		g_ShaderManager->setMat4Value("projection", projection);
-
-		glm::mat4 view = glm::lookAt(camPos, camPos + camFront, camUp);
-		g_ShaderManager->setMat4Value("view", view);
-		g_ShaderManager->setVec3Value("viewPosition", camPos); 
-
-
-		// draw the scene
-		g_SceneManager->RenderScene();
-
-		glfwSwapBuffers(g_Window);
-		glfwPollEvents();
-	}
-
-
-	// clear the allocated manager objects from memory
-	if (NULL != g_SceneManager)
-	{
-		delete g_SceneManager;
-		g_SceneManager = NULL;
-	}
-	if (NULL != g_ViewManager)
-	{
-		delete g_ViewManager;
-		g_ViewManager = NULL;
-	}
-	if (NULL != g_ShaderManager)
-	{
-		delete g_ShaderManager;
-		g_ShaderManager = NULL;
-	}
-
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
-}
-
-/***********************************************************
- *	InitializeGLFW()
- * 
- *  This function is used to initialize the GLFW library.   
- ***********************************************************/
-bool InitializeGLFW()
-{
-	// GLFW: initialize and configure library
-	// --------------------------------------
-	glfwInit();
-
-#ifdef __APPLE__
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#else
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#endif
-	// GLFW: end -------------------------------
-
-	return(true);
-}
-
-/***********************************************************
- *	InitializeGLEW()
- *
- *  This function is used to initialize the GLEW library.
- ***********************************************************/
-bool InitializeGLEW()
-{
-	// GLEW: initialize
-	// -----------------------------------------
-	GLenum GLEWInitResult = GLEW_OK;
-
-	// try to initialize the GLEW library
-	GLEWInitResult = glewInit();
-	if (GLEW_OK != GLEWInitResult)
-	{
-		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
-		return false;
-	}
-	// GLEW: end -------------------------------
-
-	// Displays a successful OpenGL initialization message
-	std::cout << "INFO: OpenGL Successfully Initialized\n";
-	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
-
-	return(true);
+﻿#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <fstream>          // render stats JSON-lines file
+
+#include <GL/glew.h>        // GLEW library
+#include "GLFW/glfw3.h"     // GLFW library
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+
+#include "Benchmark.h"
+#include "GLStateCache.h"
+#include "GpuProfiler.h"
+#include "JobSystem.h"
+#include "RenderStats.h"
+#include "SimulationThread.h"
+#include "TraceRecorder.h"
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "ShapeMeshes.h"
+#include "ShaderManager.h"
+#include <ranges>
+
+// Namespace for declaring global variables
+namespace
+{
+	// Macro for window title
+	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
+
+	// Main GLFW window
+	GLFWwindow* g_Window = nullptr;
+
+	// scene manager object for managing the 3D scene prepare and render
+	SceneManager* g_SceneManager = nullptr;
+	// shader manager object for dynamic interaction with the shader code
+	ShaderManager* g_ShaderManager = nullptr;
+	// state cache object for skipping redundant OpenGL calls
+	GLStateCache* g_StateCache = nullptr;
+	// profiler timing the frame and object groups, with --profile
+	GpuProfiler* g_Profiler = nullptr;
+	// worker threads the per-frame scene work is split over
+	JobSystem* g_JobSystem = nullptr;
+	// view manager object for managing the 3D view setup and projection to 2D
+	ViewManager* g_ViewManager = nullptr;
+
+	// steps the camera at a fixed rate on its own thread, fed
+	// with the input gathered here every frame
+	SimulationThread* g_Simulation = nullptr;
+
+	// --- Camera state ---
+	// the camera drawn this frame, interpolated from the simulation
+	glm::vec3 camPos = glm::vec3(0.0f, 1.2f, 6.0f);
+	glm::vec3 camFront = glm::vec3(0.0f, 0.0f, -1.0f);
+	glm::vec3 camUp = glm::vec3(0.0f, 1.0f, 0.0f);
+
+	// yaw/pitch the mouse look starts from
+	const float START_YAW = -90.0f;
+	const float START_PITCH = 0.0f;
+
+	// mouse bookkeeping
+	bool   firstMouse = true;
+	double lastX = 0.0, lastY = 0.0;
+
+	// mouse and wheel movement since the input was last handed
+	// to the simulation
+	float pendingMouseX = 0.0f;
+	float pendingMouseY = 0.0f;
+	float pendingScroll = 0.0f;
+
+	// projection mode
+	enum class ProjMode { Perspective, Ortho };
+	ProjMode gProj = ProjMode::Perspective;
+
+	// with --continuous every frame is drawn, as for benchmarks;
+	// otherwise a frame is only drawn when something it shows
+	// changed, and the loop sleeps in between
+	bool g_bContinuous = false;
+	// set when the window contents were damaged and have to be
+	// drawn again even though nothing changed
+	bool g_bRedrawNeeded = true;
+	// longest the loop sleeps waiting for events while the
+	// picture stays the same
+	const double IDLE_WAIT_SECONDS = 0.5;
+
+	// how often the state cache and render counters are reported, in frames
+	const unsigned int STATE_REPORT_INTERVAL = 600;
+	unsigned int frameCount = 0;
+
+	// how often the profiler averages are shown, in frames, and
+	// the file every profiled frame is written to
+	const unsigned int PROFILE_OVERLAY_INTERVAL = 30;
+	const char* const PROFILE_CSV_PATH = "profile.csv";
+
+	// with --stats, the render counters of every frame are
+	// appended to this file as one JSON object per line
+	std::ofstream g_StatsFile;
+
+	// with --trace, the startup phases and the frame loop are
+	// recorded and written to this file on exit
+	const char* const TRACE_PATH = "trace.json";
+
+	// farthest a mouse pick reaches, the far clipping plane
+	const float PICK_DISTANCE = 100.0f;
+
+}
+
+// Function declarations - all functions that are called manually
+// need to be pre-declared at the beginning of the source code.
+bool InitializeGLFW(const BenchmarkRunner::BENCH_OPTIONS& benchOptions);
+bool InitializeGLEW(bool bHeadless);
+
+// the mouse only gathers movement here; the simulation turns
+// it into yaw/pitch on its next tick
+void mouse_callback(GLFWwindow*, double xpos, double ypos) {
+	if (firstMouse) { lastX = xpos; lastY = ypos; firstMouse = false; }
+	pendingMouseX += (float)(xpos - lastX);
+	pendingMouseY += (float)(lastY - ypos); // invert Y
+	lastX = xpos; lastY = ypos;
+}
+
+// left click picks the object at the screen center, where
+// the locked cursor aims, by casting a ray along the view
+void mouse_button_callback(GLFWwindow*, int button, int action, int) {
+	if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS || NULL == g_SceneManager) return;
+
+	float distance = 0.0f;
+	SceneGraph::NODE_HANDLE node = g_SceneManager->PickNode(camPos, camFront, PICK_DISTANCE, distance);
+	if (node == SceneGraph::INVALID_NODE)
+		std::cout << "INFO: nothing picked" << std::endl;
+	else
+		std::cout << "INFO: picked scene node " << node << " at distance " << distance << std::endl;
+}
+
+// the window was uncovered or needs its contents again, so
+// the last frame is drawn anew even though nothing changed
+void window_refresh_callback(GLFWwindow*) {
+	g_bRedrawNeeded = true;
+}
+
+// the wheel changes the move speed, on the simulation's next tick
+void scroll_callback(GLFWwindow*, double, double yoff) {
+	pendingScroll += (float)yoff;
+}
+
+// hand the keys held (WASD/QE, P/O) and the mouse and wheel
+// movement since the last frame to the simulation; when it
+// has not caught up, the movement stays for the next frame
+void processInput(GLFWwindow* w) {
+	TRACE_SCOPE("input");
+	SimulationThread::INPUT_SAMPLE input;
+	input.keys = 0;
+	if (glfwGetKey(w, GLFW_KEY_W) == GLFW_PRESS) input.keys |= SimulationThread::KEY_FORWARD;
+	if (glfwGetKey(w, GLFW_KEY_S) == GLFW_PRESS) input.keys |= SimulationThread::KEY_BACK;
+	if (glfwGetKey(w, GLFW_KEY_A) == GLFW_PRESS) input.keys |= SimulationThread::KEY_LEFT;
+	if (glfwGetKey(w, GLFW_KEY_D) == GLFW_PRESS) input.keys |= SimulationThread::KEY_RIGHT;
+	if (glfwGetKey(w, GLFW_KEY_Q) == GLFW_PRESS) input.keys |= SimulationThread::KEY_DOWN;
+	if (glfwGetKey(w, GLFW_KEY_E) == GLFW_PRESS) input.keys |= SimulationThread::KEY_UP;
+	if (glfwGetKey(w, GLFW_KEY_P) == GLFW_PRESS) input.keys |= SimulationThread::KEY_PERSPECTIVE;
+	if (glfwGetKey(w, GLFW_KEY_O) == GLFW_PRESS) input.keys |= SimulationThread::KEY_ORTHOGRAPHIC;
+	input.mouseDeltaX = pendingMouseX;
+	input.mouseDeltaY = pendingMouseY;
+	input.scroll = pendingScroll;
+
+	if (g_Simulation->PushInput(input)) {
+		pendingMouseX = 0.0f;
+		pendingMouseY = 0.0f;
+		pendingScroll = 0.0f;
+	}
+}
+
+
+/***********************************************************
+ *  main(int, char*)
+ *
+ *  This function gets called after the application has been
+ *  launched.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	// --bench renders offscreen along a fixed camera path and exits
+	BenchmarkRunner::BENCH_OPTIONS benchOptions = BenchmarkRunner::ParseOptions(argc, argv);
+
+	// --trace records a timeline of startup and every frame,
+	// so tracing has to start before anything else runs.  Each
+	// thread holds TraceRecorder::EVENTS_PER_THREAD events,
+	// about a minute of frames on the main thread; the events
+	// after that are dropped and counted when the file is written
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--trace")
+		{
+			TraceRecorder::Start();
+			TRACE_THREAD_NAME("main");
+		}
+	}
+
+	TRACE_BEGIN("startup");
+
+	// if GLFW fails initialization, then terminate the application
+	bool bInitialized = false;
+	{
+		TRACE_SCOPE("InitializeGLFW");
+		bInitialized = InitializeGLFW(benchOptions);
+	}
+	if (bInitialized == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// try to create a new shader manager object
+	g_ShaderManager = new ShaderManager();
+	// try to create a new view manager object
+	g_ViewManager = new ViewManager(
+		g_ShaderManager);
+
+	// try to create the main display window
+	{
+		TRACE_SCOPE("CreateDisplayWindow");
+		g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	}
+	if (NULL == g_Window)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	if (!benchOptions.bEnabled)
+	{
+		// Lock cursor for FPS-style look (optional)
+		glfwSetInputMode(g_Window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+		// Mouse & scroll callbacks
+		glfwSetCursorPosCallback(g_Window, mouse_callback);
+		glfwSetScrollCallback(g_Window, scroll_callback);
+		glfwSetMouseButtonCallback(g_Window, mouse_button_callback);
+		glfwSetWindowRefreshCallback(g_Window, window_refresh_callback);
+	}
+
+	// if GLEW fails initialization, then terminate the application
+	{
+		TRACE_SCOPE("InitializeGLEW");
+		bInitialized = InitializeGLEW(benchOptions.bEnabled);
+	}
+	if (bInitialized == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// load the shader code from the project GLSL files
+	{
+		TRACE_SCOPE("LoadShaders");
+		g_ShaderManager->LoadShaders(
+			"shaders/vertexShader.glsl",
+			"shaders/fragmentShader.glsl");
+	}
+	// all program binds, texture binds, capability toggles and
+	// per-draw uniform writes go through the state cache
+	g_StateCache = new GLStateCache();
+	g_StateCache->UseProgram(g_ShaderManager->m_programID);
+
+	// try to create a new scene manager object and prepare the 3D scene
+	g_SceneManager = new SceneManager(g_ShaderManager, g_StateCache);
+	g_JobSystem = new JobSystem();
+	g_SceneManager->SetJobSystem(g_JobSystem);
+	{
+		TRACE_SCOPE("PrepareScene");
+		g_SceneManager->PrepareScene();
+	}
+
+	// --profile times the frame and each object group on the
+	// CPU and GPU, shown in the window title and written as CSV,
+	// --stats <file> appends the render counters of every frame
+	// to a JSON-lines file, --gpu-driven draws the scene
+	// with multi-draw indirect calls, --gpu-culling also
+	// culls those draws with a compute pass, and --continuous
+	// draws every frame even when nothing changed
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if ((argument == "--profile") && benchOptions.bEnabled)
+		{
+			// the profiler queries would add to the frame times
+			// the benchmark measures
+			std::cout << "INFO: --profile is ignored with --bench" << std::endl;
+		}
+		else if (argument == "--profile")
+		{
+			g_Profiler = new GpuProfiler();
+			g_Profiler->OpenCSV(PROFILE_CSV_PATH);
+			g_SceneManager->SetProfiler(g_Profiler);
+		}
+		else if ((argument == "--stats") && (i + 1 < argc))
+		{
+			g_StatsFile.open(argv[++i], std::ios::app);
+			if (!g_StatsFile.is_open())
+			{
+				std::cout << "ERROR: could not open render stats file: " << argv[i] << std::endl;
+			}
+		}
+		else if (argument == "--gpu-driven")
+		{
+			if (!g_SceneManager->SetGpuDrivenRendering(true))
+			{
+				std::cout << "INFO: drawing the scene with the regular draw path" << std::endl;
+			}
+		}
+		else if (argument == "--gpu-culling")
+		{
+			GLuint cullProgram = g_ShaderManager->LoadComputeShader("shaders/cullShader.glsl");
+			if ((cullProgram == 0) || !g_SceneManager->SetGpuCulling(cullProgram))
+			{
+				std::cout << "INFO: culling the scene on the CPU" << std::endl;
+			}
+		}
+		else if (argument == "--continuous")
+		{
+			g_bContinuous = true;
+		}
+	}
+
+	TRACE_END("startup");
+
+	int exitCode = EXIT_SUCCESS;
+	if (benchOptions.bEnabled)
+	{
+		BenchmarkRunner benchmark(benchOptions);
+		if (!benchmark.Run(g_SceneManager, g_ViewManager, g_ShaderManager, g_StateCache))
+		{
+			exitCode = EXIT_FAILURE;
+		}
+	}
+
+	// the camera moves on the simulation thread, at a fixed
+	// tick however fast the frames go
+	if (!benchOptions.bEnabled)
+	{
+		g_Simulation = new SimulationThread(camPos, START_YAW, START_PITCH);
+		g_Simulation->Start();
+	}
+
+	// the view the last drawn frame showed, to tell whether
+	// the next one would look any different
+	glm::vec3 drawnCamPos(0.0f);
+	glm::vec3 drawnCamFront(0.0f);
+	ProjMode drawnProj = ProjMode::Perspective;
+	int drawnWidth = -1, drawnHeight = -1;
+
+	// loop will keep running until the application is closed 
+	// or until an error has occurred
+	while (!benchOptions.bEnabled && !glfwWindowShouldClose(g_Window))
+	{
+		// hand the keyboard (WASD/QE), projection toggles and
+		// mouse to the simulation, and take the camera it has
+		// reached by now, between its two latest ticks
+		processInput(g_Window);
+		SimulationThread::CAMERA_SNAPSHOT camera = g_Simulation->GetInterpolatedCamera();
+		camPos = camera.position;
+		camFront = SimulationThread::GetFront(camera);
+		camUp = glm::vec3(0, 1, 0);
+		gProj = camera.bOrthographic ? ProjMode::Ortho : ProjMode::Perspective;
+
+		int width, height;
+		glfwGetFramebufferSize(g_Window, &width, &height);
+
+		// when nothing the frame shows changed, the last frame
+		// stays on screen and the loop sleeps until an event
+		// arrives - or only until the next tick while the
+		// simulation still has input to apply
+		bool bDirty = g_bContinuous || g_bRedrawNeeded ||
+			(camPos != drawnCamPos) || (camFront != drawnCamFront) || (gProj != drawnProj) ||
+			(width != drawnWidth) || (height != drawnHeight) ||
+			g_SceneManager->HasSceneChanged();
+		if (!bDirty)
+		{
+			TRACE_SCOPE("idle");
+			if (g_Simulation->IsSettled())
+				glfwWaitEventsTimeout(IDLE_WAIT_SECONDS);
+			else
+				glfwWaitEventsTimeout(1.0 / SimulationThread::TICKS_PER_SECOND);
+			continue;
+		}
+		g_bRedrawNeeded = false;
+		drawnCamPos = camPos;
+		drawnCamFront = camFront;
+		drawnProj = gProj;
+		drawnWidth = width;
+		drawnHeight = height;
+
+		TRACE_SCOPE("frame");
+		g_StateCache->BeginFrame();
+		RenderStats::BeginFrame();
+		if (NULL != g_Profiler)
+		{
+			g_Profiler->BeginFrame();
+		}
+		g_StateCache->Enable(GL_DEPTH_TEST);
+		glClearColor(0.18f, 0.12f, 0.26f, 1.0f);  // dark purple sky base
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		TRACE_BEGIN("view setup");
+		g_StateCache->UseProgram(g_ShaderManager->m_programID);
+
+		// build our projection (P or O) & send to shader
+		float aspect = (height > 0) ? (float)width / (float)height : 1.0f;
+
+		glm::mat4 projection(1.0f);
+		if (gProj == ProjMode::Perspective) {
+			projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 100.0f);
+		}
+		else {
+			// ortho box size chosen to comfortably frame house;
+			// the simulation looks straight on (no horizon/floor)
+			float orthoH = 3.5f;
+			float orthoW = orthoH * aspect;
+			projection = glm::ortho(-orthoW, orthoW, -orthoH, orthoH, 0.1f, 100.0f);
+		}
+
+		// build projection/view and send them with the camera
+		// position to the camera uniform buffer in one update
+		glm::mat4 view = glm::lookAt(camPos, camPos + camFront, camUp);
+		g_ViewManager->SetCameraUniforms(projection, view, camPos);
+		TRACE_END("view setup");
+
+
+		// draw the scene, culled and ordered against the current camera
+		g_SceneManager->SetCameraPosition(camPos);
+		g_SceneManager->SetViewFrustum(projection * view);
+		g_SceneManager->SetLodProjection(projection);
+		double renderStart = glfwGetTime();
+		g_SceneManager->RenderScene();
+		RenderStats::AddRenderSceneTime((glfwGetTime() - renderStart) * 1000.0);
+
+		if (NULL != g_Profiler)
+		{
+			g_Profiler->EndFrame();
+		}
+
+		double swapStart = glfwGetTime();
+		TRACE_BEGIN("swap");
+		glfwSwapBuffers(g_Window);
+		TRACE_END("swap");
+		RenderStats::AddSwapBuffersTime((glfwGetTime() - swapStart) * 1000.0);
+		RenderStats::EndFrame();
+		TRACE_BEGIN("input");
+		glfwPollEvents();
+		TRACE_END("input");
+
+		if (g_StatsFile.is_open())
+		{
+			g_StatsFile << RenderStats::FormatJSON(RenderStats::GetLastFrame(), frameCount) << "\n";
+		}
+
+		// there is no text rendering, so the profiler averages
+		// are shown in the window title
+		if ((NULL != g_Profiler) && ((frameCount % PROFILE_OVERLAY_INTERVAL) == 0))
+		{
+			std::string title = std::string(WINDOW_TITLE) + " - " + g_Profiler->GetOverlayText();
+			glfwSetWindowTitle(g_Window, title.c_str());
+		}
+
+		// report how many state changes were issued and skipped
+		if ((++frameCount % STATE_REPORT_INTERVAL) == 0)
+		{
+			const GLStateCache::FRAME_COUNTERS& counters = g_StateCache->GetLastFrameCounters();
+			std::cout << "INFO: GL state calls issued/skipped -"
+				<< " programs " << counters.programBinds.issued << "/" << counters.programBinds.skipped
+				<< ", textures " << counters.textureBinds.issued << "/" << counters.textureBinds.skipped
+				<< ", toggles " << counters.capabilityToggles.issued << "/" << counters.capabilityToggles.skipped
+				<< ", uniforms " << counters.uniformWrites.issued << "/" << counters.uniformWrites.skipped
+				<< std::endl;
+			std::cout << "INFO: render stats - " << RenderStats::FormatText(RenderStats::GetLastFrame()) << std::endl;
+		}
+	}
+
+
+	// clear the allocated manager objects from memory
+	if (NULL != g_Simulation)
+	{
+		delete g_Simulation;
+		g_Simulation = NULL;
+	}
+	if (NULL != g_SceneManager)
+	{
+		delete g_SceneManager;
+		g_SceneManager = NULL;
+	}
+	if (NULL != g_ViewManager)
+	{
+		delete g_ViewManager;
+		g_ViewManager = NULL;
+	}
+	if (NULL != g_Profiler)
+	{
+		delete g_Profiler;
+		g_Profiler = NULL;
+	}
+	if (NULL != g_JobSystem)
+	{
+		delete g_JobSystem;
+		g_JobSystem = NULL;
+	}
+	if (NULL != g_StateCache)
+	{
+		delete g_StateCache;
+		g_StateCache = NULL;
+	}
+	if (NULL != g_ShaderManager)
+	{
+		delete g_ShaderManager;
+		g_ShaderManager = NULL;
+	}
+
+	if (TraceRecorder::IsRecording())
+	{
+		TraceRecorder::WriteFile(TRACE_PATH);
+	}
+
+	// Terminates the program successfully
+	exit(exitCode); 
+}
+
+/***********************************************************
+ *	InitializeGLFW()
+ * 
+ *  This function is used to initialize the GLFW library.
+ *  For the benchmark the null platform is used, so no
+ *  display is needed, with an OSMesa or EGL context.
+ ***********************************************************/
+bool InitializeGLFW(const BenchmarkRunner::BENCH_OPTIONS& benchOptions)
+{
+	// GLFW: initialize and configure library
+	// --------------------------------------
+	if (benchOptions.bEnabled)
+	{
+#ifdef GLFW_PLATFORM_NULL
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else
+		std::cout << "ERROR: --bench needs GLFW 3.4 or newer for headless rendering" << std::endl;
+		return(false);
+#endif
+	}
+
+	if (glfwInit() == GLFW_FALSE)
+	{
+		std::cout << "ERROR: GLFW failed to initialize" << std::endl;
+		return(false);
+	}
+
+	if (benchOptions.bEnabled)
+	{
+		// the window is never shown, the frames go to a framebuffer object
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API,
+			benchOptions.bUseEGL ? GLFW_EGL_CONTEXT_API : GLFW_OSMESA_CONTEXT_API);
+		// llvmpipe offers 4.5, which covers the 4.4 shaders
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		return(true);
+	}
+
+#ifdef __APPLE__
+	// set the version of OpenGL and profile to use
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#else
+	// set the version of OpenGL and profile to use
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#endif
+	// GLFW: end -------------------------------
+
+	return(true);
+}
+
+/***********************************************************
+ *	InitializeGLEW()
+ *
+ *  This function is used to initialize the GLEW library.
+ *  Headless contexts have no window system display, so only
+ *  the context part of GLEW is initialized for them.
+ ***********************************************************/
+bool InitializeGLEW(bool bHeadless)
+{
+	// GLEW: initialize
+	// -----------------------------------------
+	GLenum GLEWInitResult = GLEW_OK;
+
+	// try to initialize the GLEW library
+	GLEWInitResult = bHeadless ? glewContextInit() : glewInit();
+	if (GLEW_OK != GLEWInitResult)
+	{
+		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
+		return false;
+	}
+	// GLEW: end -------------------------------
+
+	// Displays a successful OpenGL initialization message
+	std::cout << "INFO: OpenGL Successfully Initialized\n";
+	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
+
+	return(true);
 }
\ No newline at end of file
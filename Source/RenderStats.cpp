@@ -0,0 +1,213 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstats.cpp
+// ============
+// count the work submitted to OpenGL each frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderStats.h"
+
+#include <iomanip>
+#include <sstream>
+
+RenderStats::RENDER_STATS RenderStats::m_currentFrame = {};
+RenderStats::RENDER_STATS RenderStats::m_lastFrame = {};
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for clearing the counters at the
+ *  start of a frame.
+ ***********************************************************/
+void RenderStats::BeginFrame()
+{
+	m_currentFrame = {};
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for finishing the frame.  Its
+ *  counters stay readable through GetLastFrame() while the
+ *  next frame is counted.
+ ***********************************************************/
+void RenderStats::EndFrame()
+{
+	m_lastFrame = m_currentFrame;
+}
+
+/***********************************************************
+ *  GetLastFrame()
+ *
+ *  This method is used for getting the counters of the last
+ *  finished frame.
+ ***********************************************************/
+const RenderStats::RENDER_STATS& RenderStats::GetLastFrame()
+{
+	return(m_lastFrame);
+}
+
+/***********************************************************
+ *  CountDraw()
+ *
+ *  This method is used for counting one draw call of
+ *  indexed triangles.
+ ***********************************************************/
+void RenderStats::CountDraw(GLsizei indexCount, GLsizei instanceCount)
+{
+	m_currentFrame.drawCalls++;
+	m_currentFrame.triangles += (unsigned long long)(indexCount / 3) * instanceCount;
+}
+
+/***********************************************************
+ *  CountLodDraw()
+ *
+ *  This method is used for counting a curved shape drawn at
+ *  a level of detail.  The triangles are already part of
+ *  the frame total; these counters show how they split
+ *  across the levels.
+ ***********************************************************/
+void RenderStats::CountLodDraw(int lodLevel, GLsizei indexCount, GLsizei instanceCount)
+{
+	m_currentFrame.lodObjects[lodLevel] += instanceCount;
+	m_currentFrame.lodTriangles[lodLevel] += (unsigned long long)(indexCount / 3) * instanceCount;
+}
+
+/***********************************************************
+ *  CountCulledDraws()
+ *
+ *  This method is used for counting the draws that were
+ *  not issued because they are outside the view frustum.
+ ***********************************************************/
+void RenderStats::CountCulledDraws(unsigned int count)
+{
+	m_currentFrame.culledDraws += count;
+}
+
+/***********************************************************
+ *  CountUniformWrite()
+ *
+ *  This method is used for counting one glUniform call.
+ ***********************************************************/
+void RenderStats::CountUniformWrite()
+{
+	m_currentFrame.uniformWrites++;
+}
+
+/***********************************************************
+ *  CountTextureBind()
+ *
+ *  This method is used for counting one glBindTexture call.
+ ***********************************************************/
+void RenderStats::CountTextureBind()
+{
+	m_currentFrame.textureBinds++;
+}
+
+/***********************************************************
+ *  CountProgramBind()
+ *
+ *  This method is used for counting one glUseProgram call.
+ ***********************************************************/
+void RenderStats::CountProgramBind()
+{
+	m_currentFrame.programBinds++;
+}
+
+/***********************************************************
+ *  CountBufferUpload()
+ *
+ *  This method is used for counting the bytes sent to a
+ *  buffer or texture.
+ ***********************************************************/
+void RenderStats::CountBufferUpload(size_t bytes)
+{
+	m_currentFrame.bufferUploadBytes += bytes;
+}
+
+/***********************************************************
+ *  AddRenderSceneTime()
+ *
+ *  This method is used for adding the time spent in
+ *  SceneManager::RenderScene().
+ ***********************************************************/
+void RenderStats::AddRenderSceneTime(double milliseconds)
+{
+	m_currentFrame.renderSceneMilliseconds += milliseconds;
+}
+
+/***********************************************************
+ *  AddSwapBuffersTime()
+ *
+ *  This method is used for adding the time spent in
+ *  glfwSwapBuffers().
+ ***********************************************************/
+void RenderStats::AddSwapBuffersTime(double milliseconds)
+{
+	m_currentFrame.swapBuffersMilliseconds += milliseconds;
+}
+
+/***********************************************************
+ *  FormatJSON()
+ *
+ *  This method is used for formatting counters as a single
+ *  line JSON object, one line per frame in a JSON-lines
+ *  file.
+ ***********************************************************/
+std::string RenderStats::FormatJSON(const RENDER_STATS& stats, unsigned long long frameNumber)
+{
+	std::ostringstream json;
+	json << std::fixed << std::setprecision(4)
+		<< "{\"frame\": " << frameNumber
+		<< ", \"draw_calls\": " << stats.drawCalls
+		<< ", \"culled_draws\": " << stats.culledDraws
+		<< ", \"triangles\": " << stats.triangles
+		<< ", \"uniform_writes\": " << stats.uniformWrites
+		<< ", \"texture_binds\": " << stats.textureBinds
+		<< ", \"program_binds\": " << stats.programBinds
+		<< ", \"buffer_upload_bytes\": " << stats.bufferUploadBytes
+		<< ", \"render_scene_ms\": " << stats.renderSceneMilliseconds
+		<< ", \"swap_buffers_ms\": " << stats.swapBuffersMilliseconds;
+	for (int level = 0; level < LodSelector::LEVEL_COUNT; level++)
+	{
+		json << ", \"lod" << level << "_objects\": " << stats.lodObjects[level]
+			<< ", \"lod" << level << "_triangles\": " << stats.lodTriangles[level];
+	}
+	json << "}";
+
+	return(json.str());
+}
+
+/***********************************************************
+ *  FormatText()
+ *
+ *  This method is used for formatting counters as a single
+ *  line of text for the console.
+ ***********************************************************/
+std::string RenderStats::FormatText(const RENDER_STATS& stats)
+{
+	std::ostringstream text;
+	text << std::fixed << std::setprecision(3)
+		<< "draws " << stats.drawCalls
+		<< ", culled " << stats.culledDraws
+		<< ", triangles " << stats.triangles
+		<< ", uniforms " << stats.uniformWrites
+		<< ", texture binds " << stats.textureBinds
+		<< ", program binds " << stats.programBinds
+		<< ", uploaded " << stats.bufferUploadBytes << " bytes"
+		<< ", render " << stats.renderSceneMilliseconds << " ms"
+		<< ", swap " << stats.swapBuffersMilliseconds << " ms";
+
+	// objects and triangles per level of detail, finest first
+	text << ", lod objects";
+	for (int level = 0; level < LodSelector::LEVEL_COUNT; level++)
+	{
+		text << ((level == 0) ? " " : "/") << stats.lodObjects[level];
+	}
+	text << ", lod triangles";
+	for (int level = 0; level < LodSelector::LEVEL_COUNT; level++)
+	{
+		text << ((level == 0) ? " " : "/") << stats.lodTriangles[level];
+	}
+
+	return(text.str());
+}
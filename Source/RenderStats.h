@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstats.h
+// ============
+// count the work submitted to OpenGL each frame
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "LodSelector.h"
+
+#include <GL/glew.h>
+
+#include <string>
+
+/***********************************************************
+ *  RenderStats
+ *
+ *  This class collects the per-frame render counters.  The
+ *  draw, bind, uniform and upload calls count themselves
+ *  where they are issued, so every path into OpenGL is
+ *  covered without the callers passing a counter around.
+ *  All the counting happens on the thread that owns the
+ *  OpenGL context.
+ ***********************************************************/
+class RenderStats
+{
+public:
+	// counters of one frame
+	struct RENDER_STATS
+	{
+		unsigned int drawCalls;
+		unsigned int culledDraws;
+		unsigned long long triangles;
+		// curved shapes drawn and their triangles, per level of detail
+		unsigned int lodObjects[LodSelector::LEVEL_COUNT];
+		unsigned long long lodTriangles[LodSelector::LEVEL_COUNT];
+		unsigned int uniformWrites;
+		unsigned int textureBinds;
+		unsigned int programBinds;
+		unsigned long long bufferUploadBytes;
+		double renderSceneMilliseconds;
+		double swapBuffersMilliseconds;
+	};
+
+	// start counting a new frame
+	static void BeginFrame();
+	// finish the frame, making its counters the last frame's
+	static void EndFrame();
+	// get the counters of the last finished frame
+	static const RENDER_STATS& GetLastFrame();
+
+	// count one draw call of triangles, once per instance
+	static void CountDraw(GLsizei indexCount, GLsizei instanceCount = 1);
+	// count the objects and triangles of a curved shape drawn
+	// at a level of detail, once per instance
+	static void CountLodDraw(int lodLevel, GLsizei indexCount, GLsizei instanceCount = 1);
+	// count the draws skipped by the frustum culling
+	static void CountCulledDraws(unsigned int count);
+	// count the state changes and uploads sent to OpenGL
+	static void CountUniformWrite();
+	static void CountTextureBind();
+	static void CountProgramBind();
+	static void CountBufferUpload(size_t bytes);
+	// add the time spent rendering the scene and swapping buffers
+	static void AddRenderSceneTime(double milliseconds);
+	static void AddSwapBuffersTime(double milliseconds);
+
+	// format counters as one line of JSON
+	static std::string FormatJSON(const RENDER_STATS& stats, unsigned long long frameNumber);
+	// format counters as one line of readable text
+	static std::string FormatText(const RENDER_STATS& stats);
+
+private:
+	static RENDER_STATS m_currentFrame;
+	static RENDER_STATS m_lastFrame;
+};
@@ -0,0 +1,334 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.cpp
+// ============
+// hierarchy of transform nodes whose world matrices are only recomputed
+// for the subtrees that changed
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneGraph.h"
+
+#include <algorithm>
+
+// declaration of global variables
+namespace
+{
+	// slots composed by one job when the composition is
+	// split over a job system
+	const int COMPOSE_SLICE_SIZE = 512;
+}
+
+/***********************************************************
+ *  SceneGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneGraph::SceneGraph()
+{
+	m_pJobSystem = NULL;
+}
+
+/***********************************************************
+ *  AddNode()
+ *
+ *  This method is used for adding a node under the passed
+ *  in parent.  The node goes into the slot right after the
+ *  last slot of the parent subtree, which keeps the arrays
+ *  depth-first; the slots behind it move up by one.  Nodes
+ *  are expected to be added while the scene is built, not
+ *  every frame.
+ ***********************************************************/
+SceneGraph::NODE_HANDLE SceneGraph::AddNode(
+	NODE_HANDLE parent,
+	const glm::vec3& scaleXYZ,
+	const glm::vec3& rotationDegreesXYZ,
+	const glm::vec3& positionXYZ)
+{
+	int parentSlot = INVALID_NODE;
+	int slot = (int)m_slotNodes.size();
+
+	if (parent != INVALID_NODE)
+	{
+		parentSlot = m_nodeSlots[parent];
+		slot = parentSlot + m_subtreeSizes[parentSlot];
+	}
+
+	// the slots from the insert position on move up by one
+	if (slot < (int)m_slotNodes.size())
+	{
+		for (int& nodeSlot : m_nodeSlots)
+		{
+			if (nodeSlot >= slot)
+			{
+				nodeSlot++;
+			}
+		}
+		for (int& otherParent : m_parentSlots)
+		{
+			if (otherParent >= slot)
+			{
+				otherParent++;
+			}
+		}
+	}
+
+	NODE_HANDLE node = (NODE_HANDLE)m_nodeSlots.size();
+
+	m_localTransforms.Insert(slot, scaleXYZ, rotationDegreesXYZ, positionXYZ);
+	m_parentSlots.insert(m_parentSlots.begin() + slot, parentSlot);
+	m_subtreeSizes.insert(m_subtreeSizes.begin() + slot, 1);
+	m_worldTransforms.insert(m_worldTransforms.begin() + slot, glm::mat4(1.0f));
+	m_slotNodes.insert(m_slotNodes.begin() + slot, node);
+	m_nodeSlots.push_back(slot);
+	m_nodeDirty.push_back(false);
+
+	// every ancestor subtree grows by the new node
+	for (int ancestor = parentSlot; ancestor != INVALID_NODE; ancestor = m_parentSlots[ancestor])
+	{
+		m_subtreeSizes[ancestor]++;
+	}
+
+	MarkDirty(node);
+
+	return(node);
+}
+
+/***********************************************************
+ *  SetLocalTransform()
+ *
+ *  This method is used for changing every local
+ *  transformation value of a node.
+ ***********************************************************/
+void SceneGraph::SetLocalTransform(
+	NODE_HANDLE node,
+	const glm::vec3& scaleXYZ,
+	const glm::vec3& rotationDegreesXYZ,
+	const glm::vec3& positionXYZ)
+{
+	m_localTransforms.Set(m_nodeSlots[node], scaleXYZ, rotationDegreesXYZ, positionXYZ);
+	MarkDirty(node);
+}
+
+/***********************************************************
+ *  SetLocalPosition()
+ *
+ *  This method is used for changing the local position of
+ *  a node.
+ ***********************************************************/
+void SceneGraph::SetLocalPosition(NODE_HANDLE node, const glm::vec3& positionXYZ)
+{
+	int slot = m_nodeSlots[node];
+
+	m_localTransforms.positionX[slot] = positionXYZ.x;
+	m_localTransforms.positionY[slot] = positionXYZ.y;
+	m_localTransforms.positionZ[slot] = positionXYZ.z;
+	MarkDirty(node);
+}
+
+/***********************************************************
+ *  SetLocalRotation()
+ *
+ *  This method is used for changing the local rotation of
+ *  a node.
+ ***********************************************************/
+void SceneGraph::SetLocalRotation(NODE_HANDLE node, const glm::vec3& rotationDegreesXYZ)
+{
+	int slot = m_nodeSlots[node];
+
+	m_localTransforms.rotationX[slot] = rotationDegreesXYZ.x;
+	m_localTransforms.rotationY[slot] = rotationDegreesXYZ.y;
+	m_localTransforms.rotationZ[slot] = rotationDegreesXYZ.z;
+	MarkDirty(node);
+}
+
+/***********************************************************
+ *  GetLocalPosition()
+ *
+ *  This method is used for getting the local position of
+ *  a node.
+ ***********************************************************/
+glm::vec3 SceneGraph::GetLocalPosition(NODE_HANDLE node) const
+{
+	int slot = m_nodeSlots[node];
+
+	return(glm::vec3(
+		m_localTransforms.positionX[slot],
+		m_localTransforms.positionY[slot],
+		m_localTransforms.positionZ[slot]));
+}
+
+/***********************************************************
+ *  GetLocalRotation()
+ *
+ *  This method is used for getting the local rotation of
+ *  a node, in degrees.
+ ***********************************************************/
+glm::vec3 SceneGraph::GetLocalRotation(NODE_HANDLE node) const
+{
+	int slot = m_nodeSlots[node];
+
+	return(glm::vec3(
+		m_localTransforms.rotationX[slot],
+		m_localTransforms.rotationY[slot],
+		m_localTransforms.rotationZ[slot]));
+}
+
+/***********************************************************
+ *  MarkDirty()
+ *
+ *  This method is used for adding a node to the nodes that
+ *  changed since the last update.
+ ***********************************************************/
+void SceneGraph::MarkDirty(NODE_HANDLE node)
+{
+	if (!m_nodeDirty[node])
+	{
+		m_nodeDirty[node] = true;
+		m_dirtyNodes.push_back(node);
+	}
+}
+
+/***********************************************************
+ *  UpdateWorldTransforms()
+ *
+ *  This method is used for recomputing the world matrices
+ *  of every dirty node and everything below it.  The dirty
+ *  slots are sorted, so a dirty node inside a subtree that
+ *  was already recomputed is skipped.  Nothing is done when
+ *  no node changed.
+ ***********************************************************/
+const std::vector<SceneGraph::NODE_HANDLE>& SceneGraph::UpdateWorldTransforms()
+{
+	m_updatedNodes.clear();
+	if (m_dirtyNodes.empty())
+	{
+		return(m_updatedNodes);
+	}
+
+	m_dirtySlots.clear();
+	for (NODE_HANDLE node : m_dirtyNodes)
+	{
+		m_dirtySlots.push_back(m_nodeSlots[node]);
+		m_nodeDirty[node] = false;
+	}
+	m_dirtyNodes.clear();
+	std::sort(m_dirtySlots.begin(), m_dirtySlots.end());
+
+	int updatedEnd = 0;
+	for (int slot : m_dirtySlots)
+	{
+		if (slot < updatedEnd)
+		{
+			continue;
+		}
+
+		updatedEnd = slot + m_subtreeSizes[slot];
+		UpdateSlots(slot, updatedEnd);
+	}
+
+	return(m_updatedNodes);
+}
+
+/***********************************************************
+ *  UpdateSlots()
+ *
+ *  This method is used for recomputing the world matrices
+ *  of a run of slots that holds whole subtrees.  The local
+ *  matrices of the run are composed in one batch, then each
+ *  slot is multiplied by its parent, which either lies
+ *  before the run and is up to date or was done earlier in
+ *  the same pass.  With a job system the local matrices of
+ *  a long run are composed in slices on the workers; each
+ *  one depends on its own slot only.
+ ***********************************************************/
+void SceneGraph::UpdateSlots(int first, int last)
+{
+	m_localMatrices.resize(last - first);
+	if ((NULL != m_pJobSystem) && (last - first > COMPOSE_SLICE_SIZE))
+	{
+		m_pJobSystem->ParallelFor(last - first, COMPOSE_SLICE_SIZE,
+			[this, first](size_t sliceFirst, size_t sliceLast)
+			{
+				TransformComposer::ComposeBatch(m_localTransforms, first + sliceFirst, sliceLast - sliceFirst,
+					m_localMatrices.data() + sliceFirst);
+			});
+	}
+	else
+	{
+		TransformComposer::ComposeBatch(m_localTransforms, first, last - first, m_localMatrices.data());
+	}
+
+	for (int slot = first; slot < last; slot++)
+	{
+		int parentSlot = m_parentSlots[slot];
+		if (parentSlot == INVALID_NODE)
+		{
+			m_worldTransforms[slot] = m_localMatrices[slot - first];
+		}
+		else
+		{
+			m_worldTransforms[slot] = m_worldTransforms[parentSlot] * m_localMatrices[slot - first];
+		}
+		m_updatedNodes.push_back(m_slotNodes[slot]);
+	}
+}
+
+/***********************************************************
+ *  HasDirtyNodes()
+ *
+ *  This method is used for checking whether any node
+ *  changed since the last update.
+ ***********************************************************/
+bool SceneGraph::HasDirtyNodes() const
+{
+	return(!m_dirtyNodes.empty());
+}
+
+/***********************************************************
+ *  GetWorldTransform()
+ *
+ *  This method is used for getting the world matrix of a
+ *  node as of the last update.
+ ***********************************************************/
+const glm::mat4& SceneGraph::GetWorldTransform(NODE_HANDLE node) const
+{
+	return(m_worldTransforms[m_nodeSlots[node]]);
+}
+
+/***********************************************************
+ *  GetNodeCount()
+ *
+ *  This method is used for getting the number of nodes.
+ ***********************************************************/
+size_t SceneGraph::GetNodeCount() const
+{
+	return(m_nodeSlots.size());
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing every node.
+ ***********************************************************/
+void SceneGraph::Clear()
+{
+	m_localTransforms.Clear();
+	m_parentSlots.clear();
+	m_subtreeSizes.clear();
+	m_worldTransforms.clear();
+	m_slotNodes.clear();
+	m_nodeSlots.clear();
+	m_dirtyNodes.clear();
+	m_nodeDirty.clear();
+}
+
+/***********************************************************
+ *  SetJobSystem()
+ *
+ *  This method is used for setting the job system that long
+ *  runs of local matrices are composed on.  NULL composes
+ *  them on the calling thread.
+ ***********************************************************/
+void SceneGraph::SetJobSystem(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+}
@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.h
+// ============
+// hierarchy of transform nodes whose world matrices are only recomputed
+// for the subtrees that changed
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "JobSystem.h"
+#include "TransformComposer.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  SceneGraph
+ *
+ *  This class holds a tree of nodes, each with a parent and
+ *  a local scale, rotation and position.  The nodes are
+ *  stored in flat arrays in depth-first order, so a parent
+ *  always comes before its children and every subtree is
+ *  one contiguous run of slots.  Changing a node only marks
+ *  it dirty; UpdateWorldTransforms() then recomputes each
+ *  dirty subtree in one forward pass over its run, so moving
+ *  a parent costs the size of its subtree and nothing else.
+ *  Nodes are referred to by handles that stay valid when
+ *  later nodes are inserted in front of them.
+ ***********************************************************/
+class SceneGraph
+{
+public:
+	typedef int NODE_HANDLE;
+	static const int INVALID_NODE = -1;
+
+	// constructor
+	SceneGraph();
+
+	// add a node under parent, or a root node for INVALID_NODE
+	NODE_HANDLE AddNode(
+		NODE_HANDLE parent,
+		const glm::vec3& scaleXYZ,
+		const glm::vec3& rotationDegreesXYZ,
+		const glm::vec3& positionXYZ);
+	// change the local transformation values of a node
+	void SetLocalTransform(
+		NODE_HANDLE node,
+		const glm::vec3& scaleXYZ,
+		const glm::vec3& rotationDegreesXYZ,
+		const glm::vec3& positionXYZ);
+	void SetLocalPosition(NODE_HANDLE node, const glm::vec3& positionXYZ);
+	void SetLocalRotation(NODE_HANDLE node, const glm::vec3& rotationDegreesXYZ);
+	// get the local transformation values of a node
+	glm::vec3 GetLocalPosition(NODE_HANDLE node) const;
+	glm::vec3 GetLocalRotation(NODE_HANDLE node) const;
+
+	// recompute the world matrices of the dirty subtrees and
+	// return the nodes whose world matrix was recomputed
+	const std::vector<NODE_HANDLE>& UpdateWorldTransforms();
+	// check whether any node changed since the last update
+	bool HasDirtyNodes() const;
+	// get the world matrix of a node as of the last update
+	const glm::mat4& GetWorldTransform(NODE_HANDLE node) const;
+	// get the number of nodes
+	size_t GetNodeCount() const;
+	// remove every node
+	void Clear();
+	// compose the local matrices on a job system, or NULL to
+	// compose them on the calling thread
+	void SetJobSystem(JobSystem* pJobSystem);
+
+private:
+	// local transformation values, parent slot, subtree size,
+	// world matrix and node handle of each slot, depth-first
+	TRANSFORM_ARRAYS m_localTransforms;
+	std::vector<int> m_parentSlots;
+	std::vector<int> m_subtreeSizes;
+	std::vector<glm::mat4> m_worldTransforms;
+	std::vector<NODE_HANDLE> m_slotNodes;
+	// slot of each node, indexed by node handle
+	std::vector<int> m_nodeSlots;
+	// nodes changed since the last update, each listed once
+	std::vector<NODE_HANDLE> m_dirtyNodes;
+	std::vector<bool> m_nodeDirty;
+	// scratch buffers reused by every update
+	std::vector<int> m_dirtySlots;
+	std::vector<glm::mat4> m_localMatrices;
+	std::vector<NODE_HANDLE> m_updatedNodes;
+
+	// optional job system the local matrices are composed on
+	JobSystem* m_pJobSystem;
+
+	// add a node to the list of nodes changed since the last update
+	void MarkDirty(NODE_HANDLE node);
+	// recompute the world matrices of the slots [first, last)
+	void UpdateSlots(int first, int last);
+};
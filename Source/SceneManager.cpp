@@ -1,833 +1,2538 @@
-﻿///////////////////////////////////////////////////////////////////////////////
-// shadermanager.cpp
-// ============
-// manage the loading and rendering of 3D scenes
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#include "SceneManager.h"
-
-#ifndef STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-#endif
-
-#include <glm/gtx/transform.hpp>
-
-// declaration of global variables
-namespace
-{
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
-}
-
-/***********************************************************
- *  SceneManager()
- *
- *  The constructor for the class
- ***********************************************************/
-SceneManager::SceneManager(ShaderManager *pShaderManager)
-{
-	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
-}
-
-/***********************************************************
- *  ~SceneManager()
- *
- *  The destructor for the class
- ***********************************************************/
-SceneManager::~SceneManager()
-{
-	m_pShaderManager = NULL;
-	delete m_basicMeshes;
-	m_basicMeshes = NULL;
-}
-
-/***********************************************************
- *  CreateGLTexture()
- *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
- ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
-{
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
-
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
-
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
-
-		return true;
-	}
-
-	std::cout << "Could not load image:" << filename << std::endl;
-
-	// Error loading the image
-	return false;
-}
-
-/***********************************************************
- *  BindGLTextures()
- *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
- ***********************************************************/
-void SceneManager::BindGLTextures()
-{
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
-	}
-}
-
-/***********************************************************
- *  DestroyGLTextures()
- *
- *  This method is used for freeing the memory in all the
- *  used texture memory slots.
- ***********************************************************/
-void SceneManager::DestroyGLTextures()
-{
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		glGenTextures(1, &m_textureIDs[i].ID);
-	}
-}
-
-/***********************************************************
- *  FindTextureID()
- *
- *  This method is used for getting an ID for the previously
- *  loaded texture bitmap associated with the passed in tag.
- ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
-{
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-			index++;
-	}
-
-	return(textureID);
-}
-
-/***********************************************************
- *  FindTextureSlot()
- *
- *  This method is used for getting a slot index for the previously
- *  loaded texture bitmap associated with the passed in tag.
- ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
-{
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
-	}
-
-	return(textureSlot);
-}
-
-/***********************************************************
- *  FindMaterial()
- *
- *  This method is used for getting a material from the previously
- *  defined materials list that is associated with the passed in tag.
- ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
-{
-	if (m_objectMaterials.size() == 0)
-	{
-		return(false);
-	}
-
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
-	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.ambientColor = m_objectMaterials[index].ambientColor;
-			material.ambientStrength = m_objectMaterials[index].ambientStrength;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
-		{
-			index++;
-		}
-	}
-
-	return(true);
-}
-
-/***********************************************************
- *  SetTransformations()
- *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
- ***********************************************************/
-void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ)
-{
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
-
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
-	}
-}
-
-/***********************************************************
- *  SetShaderColor()
- *
- *  This method is used for setting the passed in color
- *  into the shader for the next draw command
- ***********************************************************/
-void SceneManager::SetShaderColor(
-	float redColorValue,
-	float greenColorValue,
-	float blueColorValue,
-	float alphaValue)
-{
-	// variables for this method
-	glm::vec4 currentColor;
-
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
-
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
-	}
-}
-
-/***********************************************************
- *  SetShaderTexture()
- *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
- ***********************************************************/
-void SceneManager::SetShaderTexture(
-	std::string textureTag)
-{
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
-	}
-}
-
-/***********************************************************
- *  SetTextureUVScale()
- *
- *  This method is used for setting the texture UV scale
- *  values into the shader.
- ***********************************************************/
-void SceneManager::SetTextureUVScale(float u, float v)
-{
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
-	}
-}
-
-/***********************************************************
- *  SetShaderMaterial()
- *
- *  This method is used for passing the material values
- *  into the shader.
- ***********************************************************/
-void SceneManager::SetShaderMaterial(
-	std::string materialTag)
-{
-	if (m_objectMaterials.size() > 0)
-	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
-
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
-		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-		}
-	}
-}
-
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
-
-void SceneManager::DefineObjectMaterials()
-{
-	m_objectMaterials.clear();
-
-	// Snow / ground: bluish, low ambient 
-	m_objectMaterials.push_back({
-		/*ambientStrength*/ 0.18f,
-		/*ambientColor*/    glm::vec3(0.70f, 0.78f, 0.92f),  // blue-white
-		/*diffuseColor*/    glm::vec3(0.80f, 0.88f, 0.98f),
-		/*specularColor*/   glm::vec3(0.15f),
-		/*shininess*/       8.0f,
-		/*tag*/             "snow"
-		});
-
-	// House neutral/cool
-	m_objectMaterials.push_back({
-		0.15f,
-		glm::vec3(0.62f, 0.62f, 0.70f),
-		glm::vec3(0.70f, 0.70f, 0.78f),
-		glm::vec3(0.18f),
-		12.0f,
-		"house"
-		});
-
-}
-
-void SceneManager::SetupSceneLights()
-{
-	// Enable custom lighting in the shader
-	m_pShaderManager->setBoolValue("bUseLighting", true);
-
-	for (int i = 0; i < 4; ++i) {
-		std::string base = "lightSources[" + std::to_string(i) + "].";
-		m_pShaderManager->setVec3Value(base + "position", glm::vec3(0.0f));
-		m_pShaderManager->setVec3Value(base + "ambientColor", glm::vec3(0.0f));
-		m_pShaderManager->setVec3Value(base + "diffuseColor", glm::vec3(0.0f));
-		m_pShaderManager->setVec3Value(base + "specularColor", glm::vec3(0.0f));
-		m_pShaderManager->setFloatValue(base + "focalStrength", 1.0f);
-		m_pShaderManager->setFloatValue(base + "specularIntensity", 0.0f);
-	}
-
-		//— cool moonlight L0
-	{
-		const char* B = "lightSources[0].";
-		m_pShaderManager->setVec3Value(std::string(B) + "position", glm::vec3(6.0f, 7.0f, 3.0f));
-		m_pShaderManager->setVec3Value(std::string(B) + "ambientColor", glm::vec3(0.02f, 0.03f, 0.05f)); // tiny ambient
-		m_pShaderManager->setVec3Value(std::string(B) + "diffuseColor", glm::vec3(0.65f, 0.75f, 1.00f)); // strong cool
-		m_pShaderManager->setVec3Value(std::string(B) + "specularColor", glm::vec3(0.85f, 0.90f, 1.00f));
-		m_pShaderManager->setFloatValue(std::string(B) + "focalStrength", 32.0f);
-		m_pShaderManager->setFloatValue(std::string(B) + "specularIntensity", 0.60f);
-	}
-
-		//— lavender fill from left-back L1
-	{
-		const char* B = "lightSources[1].";
-		m_pShaderManager->setVec3Value(std::string(B) + "position", glm::vec3(-6.0f, 4.0f, -4.0f));
-		m_pShaderManager->setVec3Value(std::string(B) + "ambientColor", glm::vec3(0.00f));                 // no ambient
-		m_pShaderManager->setVec3Value(std::string(B) + "diffuseColor", glm::vec3(0.55f, 0.45f, 0.70f));   // lavender
-		m_pShaderManager->setVec3Value(std::string(B) + "specularColor", glm::vec3(0.20f, 0.16f, 0.28f));
-		m_pShaderManager->setFloatValue(std::string(B) + "focalStrength", 16.0f);
-		m_pShaderManager->setFloatValue(std::string(B) + "specularIntensity", 0.20f);
-	}
-
-}
-
-GLuint SceneManager::LoadTexture2D(const char* path, bool flipY)
-{
-	int w, h, n;
-	stbi_set_flip_vertically_on_load(flipY);
-	unsigned char* data = stbi_load(path, &w, &h, &n, 0);
-	if (!data) { std::cerr << "Failed to load texture: " << path << std::endl; return 0; }
-
-	GLenum fmt = (n == 4) ? GL_RGBA : GL_RGB;
-
-	GLuint tex = 0;
-	glGenTextures(1, &tex);
-	glBindTexture(GL_TEXTURE_2D, tex);
-	glTexImage2D(GL_TEXTURE_2D, 0, fmt, w, h, 0, fmt, GL_UNSIGNED_BYTE, data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	stbi_image_free(data);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	return tex;
-}
-
-
-/***********************************************************
- *  PrepareScene()
- *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
- ***********************************************************/
-void SceneManager::PrepareScene()
-{
-	DefineObjectMaterials();
-	SetupSceneLights();
-
-	// House pieces
-	m_basicMeshes->LoadBoxMesh();        // body, porch, frames
-	m_basicMeshes->LoadCylinderMesh();   // chimney cap
-	m_basicMeshes->LoadPrismMesh();      // roof
-	m_basicMeshes->LoadPlaneMesh();      // ground/backdrop 
-	m_basicMeshes->LoadConeMesh();         // foliage
-
-	// --- Load house textures ---
-	m_texBrick = LoadTexture2D("assets/textures/Brick.jpg");   // CC0 brick jpg
-	// roof shingles:
-	m_texRoof = LoadTexture2D("assets/textures/Roof.jpg");    // CC0 roof jpg
-
-	// Tell shader which texture unit the sampler uses (unit 0)
-	if (m_pShaderManager)
-		m_pShaderManager->setIntValue("objectTexture", 0);  
-
-}
-
-/***********************************************************
- *  RenderScene()
- *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
- ***********************************************************/
-void SceneManager::RenderScene()
-{
-	// ---------- working vars ----------
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	auto ApplyMat = [&](const char* tag)
-		{
-			for (const auto& M : m_objectMaterials)
-			{
-				if (M.tag == tag)
-				{
-					m_pShaderManager->setFloatValue("material.ambientStrength", M.ambientStrength);
-					m_pShaderManager->setVec3Value("material.ambientColor", M.ambientColor);
-					m_pShaderManager->setVec3Value("material.diffuseColor", M.diffuseColor);
-					m_pShaderManager->setVec3Value("material.specularColor", M.specularColor);
-					m_pShaderManager->setFloatValue("material.shininess", M.shininess);
-					break;
-				}
-			}
-		};
-
-
-	// Enable/disable a 2D texture for the next draw
-	auto UseTexture2D = [&](GLuint texID)
-		{
-			if (texID != 0)
-			{
-				m_pShaderManager->setIntValue("bUseTexture", true);
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, texID);
-			}
-			else
-			{
-				m_pShaderManager->setIntValue("bUseTexture", false);
-			}
-		};
-
-	// Optionally set UV tiling 
-	auto SetUV = [&](float u, float v)
-		{
-			if (m_pShaderManager) m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
-		};
-
-	// ---------- palette ----------
-	const glm::vec4 STONE = glm::vec4(0.78f, 0.78f, 0.84f, 1.0f); // body (light)
-	const glm::vec4 TRIM = glm::vec4(0.64f, 0.64f, 0.72f, 1.0f); // trim (brighter)
-	const glm::vec4 ROOF = glm::vec4(0.64f, 0.60f, 0.70f, 1.0f); // roof lavender
-	const glm::vec4 DOOR = glm::vec4(0.12f, 0.10f, 0.14f, 1.0f); // darker
-	const glm::vec4 GLASS = glm::vec4(0.60f, 0.85f, 0.92f, 1.0f); // darker cyan
-	const glm::vec3 H = glm::vec3(0.0f, -0.55f, 2.8f); //house anchor
-
-	// debugging contrast
-	 /*const glm::vec4 DOOR  = glm::vec4(1,0,0,1);
-	 const glm::vec4 GLASS = glm::vec4(0,1,0,1);*/
-
-
-	 // --- global scene nudges---
-	const float YF = -4.0f;                // small yaw for the whole scene
-
-	// ---- common anchors & nudges ----
-
-	const float BODY_Z = +0.10f;
-	const float FRONT_Z = 1.26f;
-	const float EPS_Z = 0.04f;  // tiny forward nudge to avoid z-fighting
-	const float FASCIA_Z = FRONT_Z;  // fascia/trim sits at the front
-	const float ROOF_Z = 0.08f;    // how far forward the roof planes sit
-	const float ROOF_Y = 2.10f;
-	const float FASCIA_Y = 1.60f;    // fascia height
-	const float PORCH_Y = -1.35f;
-	const float STEP_Y = -1.52f;   // step height
-	const float CHIMNEY_X = 0.90f;
-	const float CHIMNEY_Z = -0.60f;
-	const float CHIMNEY_BASE_Y = ROOF_Y + 1.45f;
-	const float CHIMNEY_CAP_Y = CHIMNEY_BASE_Y + 0.95f;
-
-	// helper to position relative to H
-	auto P = [&](float x, float y, float z) { return H + glm::vec3(x, y, z); };
-
-
-	// ---------- helper: capture *this* so member calls compile ----------
-	auto DrawBox = [this](glm::vec3 s, glm::vec3 rDegXYZ, glm::vec3 p, glm::vec4 color)
-		{
-			this->SetTransformations(s, rDegXYZ.x, rDegXYZ.y, rDegXYZ.z, p);
-			this->SetShaderColor(color.r, color.g, color.b, color.a);
-			this->m_basicMeshes->DrawBoxMesh();
-		};
-
-	auto DrawTree = [&](glm::vec3 basePos, float trunkH, float trunkR, float crownH, float crownR)
-		{
-			// tree trunk
-			SetTransformations(glm::vec3(trunkR, trunkH, trunkR), 0, 0, 0, basePos + glm::vec3(0.0f, trunkH * 0.5f, 0.0f));
-			m_pShaderManager->setIntValue("bUseTexture", false);
-			// cool brown 
-			SetShaderColor(0.35f, 0.30f, 0.28f, 1.0f);
-			m_basicMeshes->DrawCylinderMesh();
-
-			// foliage — slightly above trunk top
-			glm::vec3 crownPos = basePos + glm::vec3(0.0f, trunkH + crownH * 0.5f, 0.0f);
-			SetTransformations(glm::vec3(crownR, crownH, crownR), 0, 0, 0, crownPos);
-			// evergreen tone
-			SetShaderColor(0.55f, 0.70f, 0.68f, 1.0f);
-			m_basicMeshes->DrawConeMesh();
-
-			// snowy cap 
-			SetTransformations(glm::vec3(crownR * 0.55f, 0.08f, crownR * 0.55f), 0, 0, 0,
-				basePos + glm::vec3(0.0f, trunkH + crownH - 0.02f, 0.0f));
-			SetShaderColor(0.90f, 0.95f, 1.0f, 1.0f);
-			m_basicMeshes->DrawCylinderMesh();
-		};
-
-	auto DrawFenceLine = [&](glm::vec3 start, glm::vec3 dir, int posts, float spacing)
-		{
-			// two horizontal rails 
-			glm::vec3 mid = start + dir * (spacing * (posts - 1) * 0.5f);
-			// lower rail
-			SetTransformations(glm::vec3(spacing * posts, 0.05f, 0.12f), 0, 0, 0, mid + glm::vec3(0, -0.30f, 0));
-			m_pShaderManager->setIntValue("bUseTexture", false);
-			SetShaderColor(0.55f, 0.53f, 0.56f, 1.0f);  // desaturated wood/stone
-			m_basicMeshes->DrawBoxMesh();
-			// upper rail
-			SetTransformations(glm::vec3(spacing * posts, 0.05f, 0.12f), 0, 0, 0, mid + glm::vec3(0, 0.05f, 0));
-			SetShaderColor(0.58f, 0.56f, 0.60f, 1.0f);
-			m_basicMeshes->DrawBoxMesh();
-
-			// posts
-			for (int i = 0; i < posts; ++i)
-			{
-				glm::vec3 p = start + dir * (spacing * i);
-				SetTransformations(glm::vec3(0.10f, 0.60f, 0.10f), 0, 0, 0, p + glm::vec3(0, 0.15f, 0));
-				SetShaderColor(0.50f, 0.48f, 0.52f, 1.0f);
-				m_basicMeshes->DrawBoxMesh();
-			}
-		};
-
-	//// --- Mountain  ---
-	//auto DrawMountain = [this](glm::vec3 pos,
-	//	float baseRadius,
-	//	float height,
-	//	glm::vec4 bodyColor,
-	//	glm::vec4 capColor)
-	//	{
-	//		// body (cone)
-	//		SetTransformations(glm::vec3(baseRadius, height, baseRadius), 0, 0, 0, pos);
-	//		m_pShaderManager->setIntValue("bUseTexture", false);
-	//		SetShaderColor(bodyColor.r, bodyColor.g, bodyColor.b, bodyColor.a);
-	//		m_basicMeshes->DrawConeMesh();
-
-	//		// snow cap 
-	//		glm::vec3 capPos = pos + glm::vec3(0.0f, height * 0.75f, 0.0f);
-	//		SetTransformations(glm::vec3(baseRadius * 0.37f, 0.12f, baseRadius * 0.37f), 0, 0, 0, capPos);
-	//		SetShaderColor(capColor.r, capColor.g, capColor.b, capColor.a);
-	//		m_basicMeshes->DrawCylinderMesh();
-	//	};
-
-
-
-	// ---------------- BACKDROP / FLOOR ----------------
-
-	// Background wall
-	SetTransformations(
-		/*scale*/     glm::vec3(60.0f, 1.0f, 40.0f),
-		/*rot XYZ*/   90.0f, 0.0f, 0.0f,
-		/*position*/  glm::vec3(0.0f, 14.0f, -35.0f));
-	m_pShaderManager->setIntValue("bUseTexture", false);
-	SetShaderColor(0.28f, 0.22f, 0.42f, 1.0f);   // dusk purple
-	m_basicMeshes->DrawPlaneMesh();
-
-	// Ground (flat, bluish snow)
-	SetTransformations(
-		/*scale*/     glm::vec3(60.0f, 1.0f, 60.0f),
-		/*rot XYZ*/   -90.0f, 0.0f, 0.0f,
-		/*position*/  glm::vec3(0.0f, -2.0f, 0.0f));
-	SetShaderMaterial("snow");
-	m_pShaderManager->setIntValue("bUseTexture", false);
-	SetShaderColor(0.80f, 0.88f, 0.98f, 1.0f);   // blue-white snow
-	m_basicMeshes->DrawPlaneMesh();
-
-	// ---------------- HOUSE ----------------
-
-	// --- HOUSE BODY (Brick, tiled) ---
-	SetTransformations(glm::vec3(3.90f, 3.80f, 2.70f), /*X*/0, /*Y*/-4.0f, /*Z*/0,
-		/*pos*/   H + glm::vec3(0.0f, 0.0f, 0.10f));
-	SetShaderColor(1, 1, 1, 1);
-	SetShaderMaterial("house");
-	UseTexture2D(m_texBrick);
-	SetUV(3.0f, 2.0f);
-	m_basicMeshes->DrawBoxMesh();
-	UseTexture2D(0);
-
-
-	// --- LEFT BUMP-OUT (Brick, same tile) ---
-	SetTransformations(glm::vec3(1.50f, 2.40f, 2.20f), 0, -4.0f, 0,
-		H + glm::vec3(-1.60f, -0.10f, 0.20f));
-	SetShaderColor(1, 1, 1, 1);
-	SetShaderMaterial("house");
-	UseTexture2D(m_texBrick);
-	SetUV(3.0f, 2.0f);
-	m_basicMeshes->DrawBoxMesh();
-	UseTexture2D(0);
-
-
-	// Right front corner trim 
-	DrawBox(glm::vec3(0.06f, 3.80f, 0.06f),
-		glm::vec3(0, -4.0f, 0),
-		P(+1.82f, 0.0f, FRONT_Z),   // on the front face
-		TRIM);
-
-	// Door
-	DrawBox(glm::vec3(0.86f, 1.52f, 0.08f),
-		glm::vec3(0, -4.0f, 0),
-		P(0.00f, -0.55f, FRONT_Z + EPS_Z),
-		DOOR);
-
-	// Door frame 
-	DrawBox(glm::vec3(0.92f, 1.58f, 0.02f),
-		glm::vec3(0, -4.0f, 0),
-		P(0.00f, -0.55f, FRONT_Z + EPS_Z + 0.02f),
-		TRIM);
-
-	// Left window (bump-out)
-	DrawBox(glm::vec3(0.62f, 0.62f, 0.05f),
-		glm::vec3(0, -4.0f, 0),
-		P(-1.60f, 0.32f, FRONT_Z + EPS_Z),
-		GLASS);
-	DrawBox(glm::vec3(0.68f, 0.68f, 0.01f),
-		glm::vec3(0, -4.0f, 0),
-		P(-1.60f, 0.32f, FRONT_Z + EPS_Z + 0.02f),
-		TRIM);
-
-	// Right window (body)
-	DrawBox(glm::vec3(0.70f, 0.92f, 0.05f),
-		glm::vec3(0, -4.0f, 0),
-		P(+1.45f, 0.28f, FRONT_Z + EPS_Z),
-		GLASS);
-	DrawBox(glm::vec3(0.76f, 0.98f, 0.01f),
-		glm::vec3(0, -4.0f, 0),
-		P(+1.45f, 0.28f, FRONT_Z + EPS_Z + 0.02f),
-		TRIM);
-
-	// ------------ ROOF ------------
-
-// --- ROOF LEFT SLOPE ---
-	SetTransformations(glm::vec3(1.95f, 0.25f, 3.05f), 0, -4.0f, +30.0f,
-		H + glm::vec3(-0.78f, 3.00f, 0.06f));
-	SetShaderColor(1, 1, 1, 1);
-	SetShaderMaterial("house");
-	UseTexture2D(m_texRoof ? m_texRoof : m_texBrick);  //fallback to brick if roof won't render
-	SetUV(3.0f, 2.0f);
-	m_basicMeshes->DrawBoxMesh();
-	UseTexture2D(0);
-
-
-	// --- ROOF RIGHT SLOPE ---
-	SetTransformations(glm::vec3(1.95f, 0.25f, 3.05f), 0, -4.0f, -30.0f,
-		H + glm::vec3(+0.78f, 3.00f, 0.06f));
-	SetShaderColor(1, 1, 1, 1);
-	SetShaderMaterial("house");
-	UseTexture2D(m_texRoof ? m_texRoof : m_texBrick);;
-	SetUV(3.0f, 2.0f);
-	m_basicMeshes->DrawBoxMesh();
-	UseTexture2D(0);
-
-
-
-	/// stack
-	DrawBox(glm::vec3(0.45f, 1.10f, 0.45f),
-		glm::vec3(0.0f, -16.0f, 0.0f),
-		P(CHIMNEY_X, CHIMNEY_BASE_Y, CHIMNEY_Z),
-		TRIM);
-
-	// cap
-	SetTransformations(glm::vec3(0.60f, 0.12f, 0.60f), 0, 0, 0,
-		P(CHIMNEY_X, CHIMNEY_CAP_Y, CHIMNEY_Z));
-	SetShaderColor(TRIM.r, TRIM.g, TRIM.b, TRIM.a);
-	SetShaderMaterial("house");
-	m_pShaderManager->setIntValue("bUseTexture", false);
-	m_pShaderManager->setVec4Value("objectColor", glm::vec4(0.86f, 0.86f, 0.92f, 1.0f)); // light stone
-	m_basicMeshes->DrawBoxMesh();
-
-
-	// Front fascia
-	DrawBox(glm::vec3(3.80f, 0.07f, 0.10f),
-		glm::vec3(0, -4.0f, 0),
-		P(0.0f, FASCIA_Y, FASCIA_Z),
-		TRIM);
-
-
-	// Porch slab (touches front wall)
-	DrawBox(glm::vec3(2.20f, 0.14f, 1.60f),
-		glm::vec3(0, -4.0f, 0),
-		P(0.00f, PORCH_Y, FRONT_Z - 0.20f),  // slightly back so it tucks under
-		STONE);
-
-	// Step 
-	DrawBox(glm::vec3(1.70f, 0.12f, 0.75f),
-		glm::vec3(0, -4.0f, 0),
-		P(0.00f, STEP_Y, FRONT_Z + 0.20f),
-		STONE);
-
-	//// MOUNTAIN 
-	//DrawMountain(
-	//	/*pos*/        glm::vec3(0.0f, 1.3f, -11.5f),
-	//	/*baseRadius*/ 7.0f,
-	//	/*height*/     4.2f,
-	//	/*body*/       glm::vec4(0.62f, 0.82f, 0.78f, 1.0f),
-	//	/*cap*/        glm::vec4(0.93f, 0.96f, 1.0f, 1.0f)
-	//);
-
-
-	// snow cap 
-	SetTransformations(glm::vec3(2.6f, 0.12f, 2.6f), 0, 0, 0, glm::vec3(0.0f, 3.15f, -11.5f));
-	SetShaderColor(0.93f, 0.96f, 1.0f, 1.0f);
-	m_basicMeshes->DrawCylinderMesh();
-
-	// TREES
-	DrawTree(/*base*/ H + glm::vec3(-3.8f, -1.9f, 1.6f),  /*trunkH*/ 1.0f, /*trunkR*/ 0.18f,
-		/*crownH*/ 1.4f, /*crownR*/ 0.9f);
-
-	DrawTree(/*base*/ H + glm::vec3(+3.6f, -1.95f, 1.4f), /*trunkH*/ 0.9f, /*trunkR*/ 0.17f,
-		/*crownH*/ 1.2f, /*crownR*/ 0.8f);
-
-
-	// FENCE — short straight run in front, centered on house
-	glm::vec3 fenceStart = H + glm::vec3(-4.5f, -1.85f, 2.25f);
-	glm::vec3 fenceDir = glm::normalize(glm::vec3(1, 0, 0));
-	DrawFenceLine(fenceStart, fenceDir, /*posts*/ 10, /*spacing*/ 0.95f);
-
-
-}
+﻿///////////////////////////////////////////////////////////////////////////////
+// shadermanager.cpp
+// ============
+// manage the loading and rendering of 3D scenes
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneManager.h"
+#include "RenderStats.h"
+#include "TraceRecorder.h"
+
+#ifndef STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#endif
+
+#include <algorithm>
+
+// declaration of global variables
+namespace
+{
+	const char* g_ModelName = "model";
+	const char* g_ColorValueName = "objectColor";
+	const char* g_TextureValueName = "objectTexture";
+	const char* g_UseTextureName = "bUseTexture";
+	const char* g_UseLightingName = "bUseLighting";
+	const char* g_UseInstancingName = "bUseInstancing";
+	const char* g_UseBakedVerticesName = "bUseBakedVertices";
+	const char* g_UseObjectBufferName = "bUseObjectBuffer";
+	const char* g_UVScaleName = "UVscale";
+
+	// layout of the 64-bit draw sort key, from the most to the
+	// least significant bits.  Opaque draws sort by state first
+	// and then front-to-back; translucent draws sort back-to-front
+	// first, since blending needs that order to look right.
+	//   opaque:      [63] 0 | material 12 | texture 12 | mesh 3 | depth 24
+	//   translucent: [63] 1 | inverted depth 24 | material 12 | texture 12 | mesh 3
+	// while profiling, the object group goes into bits 51-58 of
+	// the opaque keys so each group is drawn as one contiguous,
+	// timed run.  The translucent keys never carry it, since
+	// the group would come before the depth and change how
+	// the blending looks; they are timed under one scope
+	const uint64_t SORT_TRANSLUCENT_BIT = 1ull << 63;
+	const uint64_t SORT_MATERIAL_MASK = 0xFFF;
+	const uint64_t SORT_TEXTURE_MASK = 0xFFF;
+	const uint64_t SORT_MESH_MASK = 0x7;
+	const uint64_t SORT_DEPTH_MASK = 0xFFFFFF;
+	const uint64_t SORT_GROUP_MASK = 0xFF;
+	const int SORT_GROUP_SHIFT = 51;
+	// profiler scope all the translucent draws are timed under
+	const int TRANSLUCENT_PROFILE_GROUP = -2;
+	const char* const TRANSLUCENT_PROFILE_NAME = "translucent";
+	// distances past this are clamped to the farthest depth bucket,
+	// matching the far plane of the perspective projection
+	const float SORT_MAX_DEPTH = 100.0f;
+
+	// packets, instances or nodes handled by one job when a
+	// per-frame loop is split over the job system
+	const size_t PARALLEL_GRAIN = 256;
+	// drawables tested by one job when the culling is split,
+	// and the fewest drawables it is split for - below that
+	// the spatial index on one thread is quicker
+	const size_t CULL_SLICE_SIZE = 1024;
+	const size_t PARALLEL_CULL_MIN_DRAWABLES = 4096;
+
+	/***********************************************************
+	 *  GetMeshBounds()
+	 *
+	 *  This function is used for getting the local bounding
+	 *  box of a basic shape mesh, as its center and half
+	 *  extents, matching how ShapeMeshes builds the shape.
+	 ***********************************************************/
+	void GetMeshBounds(SceneManager::MESH_TYPE mesh, glm::vec3& center, glm::vec3& extents)
+	{
+		switch (mesh)
+		{
+		case SceneManager::MESH_TYPE::Plane:
+			center = glm::vec3(0.0f);
+			extents = glm::vec3(1.0f, 0.0f, 1.0f);
+			break;
+		case SceneManager::MESH_TYPE::Cylinder:
+		case SceneManager::MESH_TYPE::Cone:
+			// unit radius, standing on the origin
+			center = glm::vec3(0.0f, 0.5f, 0.0f);
+			extents = glm::vec3(1.0f, 0.5f, 1.0f);
+			break;
+		case SceneManager::MESH_TYPE::Box:
+		case SceneManager::MESH_TYPE::Prism:
+		default:
+			center = glm::vec3(0.0f);
+			extents = glm::vec3(0.5f);
+			break;
+		}
+	}
+
+	// number of MESH_TYPE values
+	const int MESH_TYPE_COUNT = 5;
+
+	/***********************************************************
+	 *  BuildMeshData()
+	 *
+	 *  This function is used for generating the vertex and
+	 *  index data of a basic shape mesh, at a level of detail
+	 *  for the curved shapes.
+	 ***********************************************************/
+	void BuildMeshData(SceneManager::MESH_TYPE mesh, ShapeMeshes::MESH_DATA& data, int lodLevel = 0)
+	{
+		switch (mesh)
+		{
+		case SceneManager::MESH_TYPE::Box:
+			ShapeMeshes::BuildBoxMeshData(data);
+			break;
+		case SceneManager::MESH_TYPE::Plane:
+			ShapeMeshes::BuildPlaneMeshData(data);
+			break;
+		case SceneManager::MESH_TYPE::Cylinder:
+			ShapeMeshes::BuildCylinderMeshData(data, lodLevel);
+			break;
+		case SceneManager::MESH_TYPE::Cone:
+			ShapeMeshes::BuildConeMeshData(data, lodLevel);
+			break;
+		case SceneManager::MESH_TYPE::Prism:
+			ShapeMeshes::BuildPrismMeshData(data);
+			break;
+		}
+	}
+
+	/***********************************************************
+	 *  HasLevelsOfDetail()
+	 *
+	 *  This function is used for checking whether ShapeMeshes
+	 *  loads a basic shape mesh at several levels of detail.
+	 ***********************************************************/
+	bool HasLevelsOfDetail(SceneManager::MESH_TYPE mesh)
+	{
+		return((mesh == SceneManager::MESH_TYPE::Cylinder) || (mesh == SceneManager::MESH_TYPE::Cone));
+	}
+}
+
+/***********************************************************
+ *  SceneManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneManager::SceneManager(ShaderManager *pShaderManager, GLStateCache* pStateCache)
+{
+	m_pShaderManager = pShaderManager;
+	m_pStateCache = pStateCache;
+	m_basicMeshes = new ShapeMeshes();
+	m_pTextureLoader = new TextureLoader(pStateCache);
+	m_pProfiler = NULL;
+	m_pJobSystem = NULL;
+	m_currentGroup = INVALID_HANDLE;
+	m_profiledGroup = INVALID_HANDLE;
+	m_currentParent = SceneGraph::INVALID_NODE;
+	m_houseNode = SceneGraph::INVALID_NODE;
+	m_uniforms = {};
+	m_lightBuffer = 0;
+	m_materialBuffer = 0;
+	m_cameraPosition = glm::vec3(0.0f);
+	m_frustum = {};
+	m_bFrustumSet = false;
+	m_frameDrawCalls = 0;
+	m_bAddStatic = false;
+	m_pIndirectRenderer = NULL;
+	m_indirectTexture = 0;
+	m_indirectGroup = INVALID_HANDLE;
+	m_bSceneChanged = true;
+}
+
+/***********************************************************
+ *  ~SceneManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneManager::~SceneManager()
+{
+	m_pShaderManager = NULL;
+	m_pStateCache = NULL;
+	DestroyInstanceBatches();
+	DestroyStaticBatches();
+	delete m_pIndirectRenderer;
+	m_pIndirectRenderer = NULL;
+	delete m_pTextureLoader;
+	m_pTextureLoader = NULL;
+	delete m_basicMeshes;
+	m_basicMeshes = NULL;
+}
+
+/***********************************************************
+ *  CreateGLTexture()
+ *
+ *  This method is used for requesting a texture from an image
+ *  file and registering it in the next available texture slot.
+ *  The image is decoded and uploaded in the background, and
+ *  the texture shows a placeholder until then.  The handle of
+ *  the texture is returned.
+ ***********************************************************/
+SceneManager::TEXTURE_HANDLE SceneManager::CreateGLTexture(const char* filename, const std::string& tag)
+{
+	GLuint textureID = m_pTextureLoader->RequestTexture(filename, true, GL_LINEAR);
+
+	// register the requested texture and associate it with the special tag string
+	TEXTURE_HANDLE handle = (TEXTURE_HANDLE)m_textureIDs.size();
+	m_textureIDs.push_back({ tag, textureID });
+	m_textureHandles[tag] = handle;
+
+	return(handle);
+}
+
+/***********************************************************
+ *  BindGLTextures()
+ *
+ *  This method is used for binding the loaded textures to
+ *  OpenGL texture memory slots.  There are up to 16 slots,
+ *  so only the first 16 loaded textures are bound.
+ ***********************************************************/
+void SceneManager::BindGLTextures()
+{
+	for (int i = 0; (i < (int)m_textureIDs.size()) && (i < 16); i++)
+	{
+		// bind textures on corresponding texture units
+		m_pStateCache->BindTexture2D(i, m_textureIDs[i].ID);
+	}
+}
+
+/***********************************************************
+ *  DestroyGLTextures()
+ *
+ *  This method is used for freeing the memory in all the
+ *  used texture memory slots.
+ ***********************************************************/
+void SceneManager::DestroyGLTextures()
+{
+	for (TEXTURE_INFO& texture : m_textureIDs)
+	{
+		glDeleteTextures(1, &texture.ID);
+	}
+	m_textureIDs.clear();
+	m_textureHandles.clear();
+}
+
+/***********************************************************
+ *  FindTextureID()
+ *
+ *  This method is used for getting an ID for the previously
+ *  loaded texture bitmap associated with the passed in tag.
+ ***********************************************************/
+int SceneManager::FindTextureID(const std::string& tag) const
+{
+	TEXTURE_HANDLE handle = FindTextureSlot(tag);
+	if (handle == INVALID_HANDLE)
+	{
+		return(-1);
+	}
+
+	return((int)m_textureIDs[handle].ID);
+}
+
+/***********************************************************
+ *  FindTextureSlot()
+ *
+ *  This method is used for getting a slot index for the previously
+ *  loaded texture bitmap associated with the passed in tag.  The
+ *  slot index is the texture handle.
+ ***********************************************************/
+SceneManager::TEXTURE_HANDLE SceneManager::FindTextureSlot(const std::string& tag) const
+{
+	auto found = m_textureHandles.find(tag);
+	if (found == m_textureHandles.end())
+	{
+		return(INVALID_HANDLE);
+	}
+
+	return(found->second);
+}
+
+/***********************************************************
+ *  AddObjectMaterial()
+ *
+ *  This method is used for adding a material to the defined
+ *  materials list and returning its handle.  A material with
+ *  a tag that is already defined replaces the old one and
+ *  keeps its handle.
+ ***********************************************************/
+SceneManager::MATERIAL_HANDLE SceneManager::AddObjectMaterial(const OBJECT_MATERIAL& material)
+{
+	auto found = m_materialHandles.find(material.tag);
+	if (found != m_materialHandles.end())
+	{
+		m_objectMaterials[found->second] = material;
+		return(found->second);
+	}
+
+	MATERIAL_HANDLE handle = (MATERIAL_HANDLE)m_objectMaterials.size();
+	m_objectMaterials.push_back(material);
+	m_materialHandles[material.tag] = handle;
+
+	return(handle);
+}
+
+/***********************************************************
+ *  FindMaterial()
+ *
+ *  This method is used for getting a material from the previously
+ *  defined materials list that is associated with the passed in tag.
+ ***********************************************************/
+bool SceneManager::FindMaterial(const std::string& tag, OBJECT_MATERIAL& material) const
+{
+	MATERIAL_HANDLE handle = FindMaterialIndex(tag);
+	if (handle == INVALID_HANDLE)
+	{
+		return(false);
+	}
+
+	material = m_objectMaterials[handle];
+
+	return(true);
+}
+
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the handle of a material
+ *  in the previously defined materials list that is
+ *  associated with the passed in tag.
+ ***********************************************************/
+SceneManager::MATERIAL_HANDLE SceneManager::FindMaterialIndex(const std::string& tag) const
+{
+	auto found = m_materialHandles.find(tag);
+	if (found == m_materialHandles.end())
+	{
+		return(INVALID_HANDLE);
+	}
+
+	return(found->second);
+}
+
+/***********************************************************
+ *  BuildModelMatrix()
+ *
+ *  This method is used for building the model matrix from
+ *  the passed in transformation values.
+ ***********************************************************/
+glm::mat4 SceneManager::BuildModelMatrix(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	// translation * rotX * rotY * rotZ * scale, written out
+	// in closed form instead of multiplying five matrices
+	return(TransformComposer::Compose(
+		scaleXYZ,
+		glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees),
+		positionXYZ));
+}
+
+/***********************************************************
+ *  SetTransformations()
+ *
+ *  This method is used for setting the transform buffer
+ *  using the passed in transformation values.
+ ***********************************************************/
+void SceneManager::SetTransformations(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	glm::mat4 modelView = BuildModelMatrix(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+
+	if (NULL != m_pShaderManager)
+	{
+		m_pStateCache->SetMat4Value(m_uniforms.model, modelView);
+	}
+}
+
+/***********************************************************
+ *  SetShaderColor()
+ *
+ *  This method is used for setting the passed in color
+ *  into the shader for the next draw command
+ ***********************************************************/
+void SceneManager::SetShaderColor(
+	float redColorValue,
+	float greenColorValue,
+	float blueColorValue,
+	float alphaValue)
+{
+	// variables for this method
+	glm::vec4 currentColor;
+
+	currentColor.r = redColorValue;
+	currentColor.g = greenColorValue;
+	currentColor.b = blueColorValue;
+	currentColor.a = alphaValue;
+
+	if (NULL != m_pShaderManager)
+	{
+		m_pStateCache->SetIntValue(m_uniforms.useTexture, false);
+		m_pStateCache->SetVec4Value(m_uniforms.objectColor, currentColor);
+	}
+}
+
+/***********************************************************
+ *  SetShaderTexture()
+ *
+ *  This method is used for setting the texture data
+ *  associated with the passed in ID into the shader.
+ ***********************************************************/
+void SceneManager::SetShaderTexture(
+	const std::string& textureTag)
+{
+	if (NULL != m_pShaderManager)
+	{
+		m_pStateCache->SetIntValue(m_uniforms.useTexture, true);
+
+		int textureID = -1;
+		textureID = FindTextureSlot(textureTag);
+		m_pStateCache->SetIntValue(m_uniforms.objectTexture, textureID);
+	}
+}
+
+/***********************************************************
+ *  SetTextureUVScale()
+ *
+ *  This method is used for setting the texture UV scale
+ *  values into the shader.
+ ***********************************************************/
+void SceneManager::SetTextureUVScale(float u, float v)
+{
+	if (NULL != m_pShaderManager)
+	{
+		m_pStateCache->SetVec2Value(m_uniforms.uvScale, glm::vec2(u, v));
+	}
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for passing the material values
+ *  into the shader.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	const std::string& materialTag)
+{
+	SetShaderMaterial(FindMaterialIndex(materialTag));
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for selecting an already resolved
+ *  material from the material table in the shader.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	MATERIAL_HANDLE materialID)
+{
+	if ((NULL != m_pShaderManager) && (materialID >= 0))
+	{
+		m_pStateCache->SetIntValue(m_uniforms.materialIndex, materialID);
+	}
+}
+
+/***********************************************************
+ *  UploadMaterialTable()
+ *
+ *  This method is used for copying the defined materials
+ *  into the material table and sending it to the material
+ *  storage buffer.  The table is sized to the number of
+ *  defined materials, so there is no fixed limit.  It only
+ *  needs to run when the materials change.
+ ***********************************************************/
+void SceneManager::UploadMaterialTable()
+{
+	std::vector<MATERIAL_STD140> materialTable(m_objectMaterials.size());
+
+	for (size_t i = 0; i < m_objectMaterials.size(); i++)
+	{
+		const OBJECT_MATERIAL& material = m_objectMaterials[i];
+		materialTable[i].ambientColor = material.ambientColor;
+		materialTable[i].ambientStrength = material.ambientStrength;
+		materialTable[i].diffuseColor = material.diffuseColor;
+		materialTable[i].shininess = material.shininess;
+		materialTable[i].specularColor = material.specularColor;
+		materialTable[i].padding = 0.0f;
+	}
+
+	if (m_materialBuffer == 0)
+	{
+		m_materialBuffer = m_pShaderManager->CreateStorageBuffer(MATERIAL_BUFFER_BINDING);
+	}
+	m_pShaderManager->UpdateStorageBuffer(
+		m_materialBuffer,
+		(GLsizeiptr)(materialTable.size() * sizeof(MATERIAL_STD140)),
+		materialTable.data());
+	m_bSceneChanged = true;
+}
+
+/***********************************************************
+ *  AddDrawPacket()
+ *
+ *  This method is used for resolving the transformation,
+ *  material and texture of one object into a draw packet
+ *  and appending it to the retained draw list.  The
+ *  transformation values are relative to the current parent
+ *  node, and the model matrix is filled in by the next
+ *  UpdateSceneTransforms().  The index of the new packet is
+ *  returned.
+ ***********************************************************/
+size_t SceneManager::AddDrawPacket(
+	MESH_TYPE mesh,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegreesXYZ,
+	glm::vec3 positionXYZ,
+	glm::vec4 color,
+	const std::string& materialTag,
+	GLuint textureID,
+	glm::vec2 uvScale)
+{
+	DRAW_PACKET packet;
+
+	packet.mesh = mesh;
+	packet.model = glm::mat4(1.0f);
+	packet.nodeID = AddSceneNode(scaleXYZ, rotationDegreesXYZ, positionXYZ);
+	packet.lodLevel = 0;
+	packet.materialID = FindMaterialIndex(materialTag);
+	packet.textureID = textureID;
+	packet.color = color;
+	packet.uvScale = uvScale;
+	packet.groupID = m_currentGroup;
+	packet.bStatic = m_bAddStatic;
+	packet.staticBatch = INVALID_HANDLE;
+
+	m_nodeDraws[packet.nodeID].packetIndex = (int)m_drawPackets.size();
+	m_drawPackets.push_back(packet);
+	AddDrawable(packet.nodeID);
+
+	return(m_drawPackets.size() - 1);
+}
+
+/***********************************************************
+ *  MarkPacketDynamic()
+ *
+ *  This method is used for registering a draw packet whose
+ *  values must be re-evaluated every frame.  Packets that
+ *  are not marked dynamic are never touched after
+ *  PrepareScene().  A dynamic packet is never baked into a
+ *  static batch.
+ ***********************************************************/
+void SceneManager::MarkPacketDynamic(size_t packetIndex, PACKET_UPDATER updater)
+{
+	if (packetIndex < m_drawPackets.size())
+	{
+		m_drawPackets[packetIndex].bStatic = false;
+		m_dynamicPackets.push_back(std::make_pair(packetIndex, updater));
+	}
+}
+
+/***********************************************************
+ *  AddInstance()
+ *
+ *  This method is used for adding one untextured object to
+ *  the instance batch that matches its shape, material and
+ *  object group, creating the batch the first time it is needed.
+ *  Like a draw packet, the object gets a scene graph node
+ *  under the current parent.
+ ***********************************************************/
+void SceneManager::AddInstance(
+	MESH_TYPE mesh,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegreesXYZ,
+	glm::vec3 positionXYZ,
+	glm::vec4 color,
+	const std::string& materialTag)
+{
+	int materialID = FindMaterialIndex(materialTag);
+	int batchIndex = INVALID_HANDLE;
+
+	for (size_t i = 0; i < m_instanceBatches.size(); i++)
+	{
+		const INSTANCE_BATCH& batch = m_instanceBatches[i];
+		if ((batch.mesh == mesh) && (batch.materialID == materialID) &&
+			(batch.groupID == m_currentGroup))
+		{
+			batchIndex = (int)i;
+			break;
+		}
+	}
+
+	if (batchIndex == INVALID_HANDLE)
+	{
+		INSTANCE_BATCH batch;
+		batch.mesh = mesh;
+		batch.materialID = materialID;
+		batch.groupID = m_currentGroup;
+		batch.instanceBuffer = 0;
+		batch.bNeedsUpload = true;
+		for (int level = 0; level < LodSelector::LEVEL_COUNT; level++)
+		{
+			batch.lodFirst[level] = 0;
+			batch.lodCounts[level] = 0;
+		}
+		batchIndex = (int)m_instanceBatches.size();
+		m_instanceBatches.push_back(batch);
+	}
+
+	// the model matrix is filled in by the next UpdateSceneTransforms()
+	INSTANCE_BATCH& batch = m_instanceBatches[batchIndex];
+	ShapeMeshes::INSTANCE_DATA instance;
+	instance.model = glm::mat4(1.0f);
+	instance.color = color;
+
+	SceneGraph::NODE_HANDLE node = AddSceneNode(scaleXYZ, rotationDegreesXYZ, positionXYZ);
+	m_nodeDraws[node].batchIndex = batchIndex;
+	m_nodeDraws[node].instanceIndex = (int)batch.instances.size();
+	batch.visibleInstances.push_back((uint32_t)batch.instances.size());
+	batch.instances.push_back(instance);
+	batch.instanceLods.push_back(0);
+	batch.instanceDrawables.push_back((uint32_t)m_drawableNodes.size());
+	AddDrawable(node);
+}
+
+/***********************************************************
+ *  BeginPacketGroup()
+ *
+ *  This method is used for starting a named object group.
+ *  Every draw packet and instance added afterwards belongs
+ *  to it, and the profiler times each group as one scope.
+ ***********************************************************/
+void SceneManager::BeginPacketGroup(const std::string& name)
+{
+	for (size_t i = 0; i < m_packetGroups.size(); i++)
+	{
+		if (m_packetGroups[i] == name)
+		{
+			m_currentGroup = (int)i;
+			return;
+		}
+	}
+
+	m_packetGroups.push_back(name);
+	m_currentGroup = (int)m_packetGroups.size() - 1;
+}
+
+/***********************************************************
+ *  SetStaticObjects()
+ *
+ *  This method is used for setting whether the draw packets
+ *  added afterwards never move.  PrepareScene() bakes the
+ *  opaque static packets of each object group and texture
+ *  into one mesh, drawn with a single call.
+ ***********************************************************/
+void SceneManager::SetStaticObjects(bool bStatic)
+{
+	m_bAddStatic = bStatic;
+}
+
+/***********************************************************
+ *  AddSceneNode()
+ *
+ *  This method is used for adding a scene graph node under
+ *  the current parent node.  The node draws nothing until a
+ *  draw packet or instance is attached to it.
+ ***********************************************************/
+SceneGraph::NODE_HANDLE SceneManager::AddSceneNode(
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegreesXYZ,
+	glm::vec3 positionXYZ)
+{
+	SceneGraph::NODE_HANDLE node = m_sceneGraph.AddNode(m_currentParent, scaleXYZ, rotationDegreesXYZ, positionXYZ);
+
+	NODE_DRAW draw;
+	draw.packetIndex = INVALID_HANDLE;
+	draw.batchIndex = INVALID_HANDLE;
+	draw.instanceIndex = INVALID_HANDLE;
+	draw.drawableIndex = INVALID_HANDLE;
+	m_nodeDraws.push_back(draw);
+
+	return(node);
+}
+
+/***********************************************************
+ *  SetParentNode()
+ *
+ *  This method is used for setting the node that the draw
+ *  packets, instances and nodes added afterwards are
+ *  attached to.  SceneGraph::INVALID_NODE adds them as
+ *  roots, placed directly in world space.
+ ***********************************************************/
+void SceneManager::SetParentNode(SceneGraph::NODE_HANDLE node)
+{
+	m_currentParent = node;
+}
+
+/***********************************************************
+ *  AddDrawable()
+ *
+ *  This method is used for registering the draw packet or
+ *  instance of a node as a drawable, which gets world
+ *  bounds and an entry in the spatial index.
+ ***********************************************************/
+void SceneManager::AddDrawable(SceneGraph::NODE_HANDLE node)
+{
+	m_nodeDraws[node].drawableIndex = (int)m_drawableNodes.size();
+	m_drawableNodes.push_back(node);
+}
+
+/***********************************************************
+ *  UpdateSceneTransforms()
+ *
+ *  This method is used for recomputing the world matrices
+ *  of the scene graph nodes that moved and copying them
+ *  into the draw packets and instances of those nodes.  An
+ *  instance batch with a changed instance is flagged for
+ *  upload, and a static batch with a moved packet for a new
+ *  bake.  The matrices and bounds are copied on the job
+ *  system, the flags afterwards on this thread.  When no
+ *  node moved this costs one check.
+ ***********************************************************/
+void SceneManager::UpdateSceneTransforms()
+{
+	m_drawableBounds.Resize(m_drawableNodes.size());
+
+	if (!m_sceneGraph.HasDirtyNodes())
+	{
+		return;
+	}
+
+	const std::vector<SceneGraph::NODE_HANDLE>& updatedNodes = m_sceneGraph.UpdateWorldTransforms();
+
+	// each node only writes its own packet or instance and
+	// drawable, so the nodes can be split over the workers
+	ForEachRange(updatedNodes.size(), PARALLEL_GRAIN,
+		[this, &updatedNodes](size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; i++)
+			{
+				SceneGraph::NODE_HANDLE node = updatedNodes[i];
+				const NODE_DRAW& draw = m_nodeDraws[node];
+				if (draw.packetIndex != INVALID_HANDLE)
+				{
+					m_drawPackets[draw.packetIndex].model = m_sceneGraph.GetWorldTransform(node);
+					ComputeDrawableBounds(node);
+				}
+				else if (draw.batchIndex != INVALID_HANDLE)
+				{
+					m_instanceBatches[draw.batchIndex].instances[draw.instanceIndex].model = m_sceneGraph.GetWorldTransform(node);
+					ComputeDrawableBounds(node);
+				}
+			}
+		});
+
+	// the flags shared by several nodes are set on this thread
+	for (SceneGraph::NODE_HANDLE node : updatedNodes)
+	{
+		const NODE_DRAW& draw = m_nodeDraws[node];
+		if (draw.packetIndex != INVALID_HANDLE)
+		{
+			const DRAW_PACKET& packet = m_drawPackets[draw.packetIndex];
+			if (packet.staticBatch != INVALID_HANDLE)
+			{
+				m_staticBatches[packet.staticBatch].bNeedsBake = true;
+			}
+			m_movedDrawables.push_back((uint32_t)draw.drawableIndex);
+		}
+		else if (draw.batchIndex != INVALID_HANDLE)
+		{
+			m_instanceBatches[draw.batchIndex].bNeedsUpload = true;
+			m_movedDrawables.push_back((uint32_t)draw.drawableIndex);
+		}
+	}
+}
+
+/***********************************************************
+ *  UpdateDrawableBounds()
+ *
+ *  This method is used for recomputing the world bounding
+ *  box of the packet or instance of a node from its mesh
+ *  and model matrix.  The drawable is queued for the next
+ *  refit of the spatial index.
+ ***********************************************************/
+void SceneManager::UpdateDrawableBounds(SceneGraph::NODE_HANDLE node)
+{
+	ComputeDrawableBounds(node);
+	m_movedDrawables.push_back((uint32_t)m_nodeDraws[node].drawableIndex);
+}
+
+/***********************************************************
+ *  ComputeDrawableBounds()
+ *
+ *  This method is used for recomputing the world bounding
+ *  box of the packet or instance of a node.  Nothing shared
+ *  is written, so it can run for several nodes at once.
+ ***********************************************************/
+void SceneManager::ComputeDrawableBounds(SceneGraph::NODE_HANDLE node)
+{
+	const NODE_DRAW& draw = m_nodeDraws[node];
+	MESH_TYPE mesh;
+	const glm::mat4* pModel = NULL;
+	glm::vec3 localCenter, localExtents;
+	glm::vec3 center, extents;
+
+	if (draw.packetIndex != INVALID_HANDLE)
+	{
+		mesh = m_drawPackets[draw.packetIndex].mesh;
+		pModel = &m_drawPackets[draw.packetIndex].model;
+	}
+	else
+	{
+		const INSTANCE_BATCH& batch = m_instanceBatches[draw.batchIndex];
+		mesh = batch.mesh;
+		pModel = &batch.instances[draw.instanceIndex].model;
+	}
+
+	GetMeshBounds(mesh, localCenter, localExtents);
+	FrustumCuller::TransformBounds(*pModel, localCenter, localExtents, center, extents);
+	m_drawableBounds.Set(draw.drawableIndex, center, extents);
+}
+
+/***********************************************************
+ *  UpdateSpatialIndex()
+ *
+ *  This method is used for bringing the spatial index up to
+ *  date with the drawables that moved.  The index is built
+ *  over every drawable the first time, and after that only
+ *  the moved drawables and the nodes above them are refit.
+ ***********************************************************/
+void SceneManager::UpdateSpatialIndex()
+{
+	if (m_movedDrawables.empty())
+	{
+		return;
+	}
+
+	if (m_spatialIndex.GetItemCount() != m_drawableBounds.Size())
+	{
+		m_spatialIndex.Build(m_drawableBounds);
+	}
+	else
+	{
+		m_spatialIndex.RefitItems(m_drawableBounds, m_movedDrawables);
+	}
+	m_movedDrawables.clear();
+}
+
+/***********************************************************
+ *  CullDraws()
+ *
+ *  This method is used for listing the draw packets and
+ *  instances whose bounds touch the view frustum.  The
+ *  spatial index skips whole regions of the scene that are
+ *  out of view, or in a big scene with a job system the
+ *  drawables are tested in slices on the workers.  Each
+ *  instance batch lists its visible instances, and one
+ *  whose list differs from what its buffer holds is flagged
+ *  for upload.  Each static batch lists the index ranges of
+ *  its visible packets, so it draws only those.  Until a
+ *  frustum is set and the index is built, everything is
+ *  listed.  Under GPU culling every packet and instance is
+ *  listed for the GPU to test, and only the packets of the
+ *  static batches are tested here.
+ ***********************************************************/
+void SceneManager::CullDraws()
+{
+	UpdateSpatialIndex();
+
+	bool bGpuCulling = (NULL != m_pIndirectRenderer) && m_pIndirectRenderer->IsCulling();
+	if (!m_bFrustumSet || bGpuCulling || (m_spatialIndex.GetItemCount() != m_drawableNodes.size()))
+	{
+		m_visiblePackets.resize(m_drawPackets.size());
+		for (size_t i = 0; i < m_drawPackets.size(); i++)
+		{
+			m_visiblePackets[i] = (uint32_t)i;
+		}
+		m_visibleBatches.resize(m_instanceBatches.size());
+		for (size_t i = 0; i < m_instanceBatches.size(); i++)
+		{
+			m_visibleBatches[i] = (uint32_t)i;
+
+			INSTANCE_BATCH& batch = m_instanceBatches[i];
+			batch.visibleInstances.resize(batch.instances.size());
+			for (size_t instance = 0; instance < batch.instances.size(); instance++)
+			{
+				batch.visibleInstances[instance] = (uint32_t)instance;
+			}
+		}
+	}
+	else
+	{
+		// with workers and a big scene, slices of the flat box
+		// arrays are tested at once, each into its own list
+		if ((NULL != m_pJobSystem) && (m_drawableBounds.Size() >= PARALLEL_CULL_MIN_DRAWABLES))
+		{
+			m_sliceVisible.resize((m_drawableBounds.Size() + CULL_SLICE_SIZE - 1) / CULL_SLICE_SIZE);
+			m_pJobSystem->ParallelFor(m_drawableBounds.Size(), CULL_SLICE_SIZE,
+				[this](size_t first, size_t last)
+				{
+					std::vector<uint32_t>& visible = m_sliceVisible[first / CULL_SLICE_SIZE];
+					visible.clear();
+					FrustumCuller::CullBoundsRange(m_frustum, m_drawableBounds, first, last - first, visible);
+				});
+
+			m_visibleDrawables.clear();
+			for (const std::vector<uint32_t>& visible : m_sliceVisible)
+			{
+				m_visibleDrawables.insert(m_visibleDrawables.end(), visible.begin(), visible.end());
+			}
+		}
+		else
+		{
+			m_spatialIndex.QueryFrustum(m_frustum, m_visibleDrawables);
+		}
+
+		size_t instanceCount = 0;
+		for (INSTANCE_BATCH& batch : m_instanceBatches)
+		{
+			batch.visibleInstances.clear();
+			instanceCount += batch.instances.size();
+		}
+
+		size_t visibleInstanceCount = 0;
+		m_visiblePackets.clear();
+		m_batchVisible.assign(m_instanceBatches.size(), false);
+		for (uint32_t drawable : m_visibleDrawables)
+		{
+			const NODE_DRAW& draw = m_nodeDraws[m_drawableNodes[drawable]];
+			if (draw.packetIndex != INVALID_HANDLE)
+			{
+				m_visiblePackets.push_back((uint32_t)draw.packetIndex);
+			}
+			else
+			{
+				m_instanceBatches[draw.batchIndex].visibleInstances.push_back((uint32_t)draw.instanceIndex);
+				m_batchVisible[draw.batchIndex] = true;
+				visibleInstanceCount++;
+			}
+		}
+
+		// the spatial index lists the instances in any order,
+		// so they are sorted to compare with the uploaded ones
+		m_visibleBatches.clear();
+		for (size_t i = 0; i < m_batchVisible.size(); i++)
+		{
+			if (m_batchVisible[i])
+			{
+				INSTANCE_BATCH& batch = m_instanceBatches[i];
+				std::sort(batch.visibleInstances.begin(), batch.visibleInstances.end());
+				m_visibleBatches.push_back((uint32_t)i);
+			}
+		}
+
+		RenderStats::CountCulledDraws(
+			(unsigned int)((m_drawPackets.size() - m_visiblePackets.size()) +
+			(instanceCount - visibleInstanceCount)));
+	}
+
+	for (uint32_t batchIndex : m_visibleBatches)
+	{
+		INSTANCE_BATCH& batch = m_instanceBatches[batchIndex];
+		if (batch.visibleInstances != batch.uploadedInstances)
+		{
+			batch.bNeedsUpload = true;
+		}
+	}
+
+	// the visible packets baked into a static batch are drawn
+	// with their batch instead of on their own.  Under GPU
+	// culling they were listed untested, so each is tested
+	// here
+	size_t keptPackets = 0;
+	unsigned int culledBakedPackets = 0;
+	m_bakedPacketVisible.assign(m_drawPackets.size(), false);
+	for (uint32_t packetIndex : m_visiblePackets)
+	{
+		if (m_drawPackets[packetIndex].staticBatch == INVALID_HANDLE)
+		{
+			m_visiblePackets[keptPackets++] = packetIndex;
+			continue;
+		}
+
+		int drawable = m_nodeDraws[m_drawPackets[packetIndex].nodeID].drawableIndex;
+		if (bGpuCulling && m_bFrustumSet && (drawable != INVALID_HANDLE))
+		{
+			glm::vec3 center = glm::vec3(m_drawableBounds.centerX[drawable], m_drawableBounds.centerY[drawable], m_drawableBounds.centerZ[drawable]);
+			glm::vec3 extents = glm::vec3(m_drawableBounds.extentX[drawable], m_drawableBounds.extentY[drawable], m_drawableBounds.extentZ[drawable]);
+			m_bakedPacketVisible[packetIndex] = FrustumCuller::IsVisible(m_frustum, center, extents);
+			culledBakedPackets += m_bakedPacketVisible[packetIndex] ? 0 : 1;
+		}
+		else
+		{
+			m_bakedPacketVisible[packetIndex] = true;
+		}
+	}
+	m_visiblePackets.resize(keptPackets);
+	if (culledBakedPackets > 0)
+	{
+		RenderStats::CountCulledDraws(culledBakedPackets);
+	}
+
+	// the packets of a batch were baked one after another, so
+	// visible neighbours join into one range
+	m_visibleStaticBatches.clear();
+	for (size_t b = 0; b < m_staticBatches.size(); b++)
+	{
+		STATIC_BATCH& batch = m_staticBatches[b];
+		batch.drawCounts.clear();
+		batch.drawOffsets.clear();
+
+		GLuint rangeEnd = 0;
+		for (size_t slot = 0; slot < batch.packetIndices.size(); slot++)
+		{
+			if (!m_bakedPacketVisible[batch.packetIndices[slot]])
+			{
+				continue;
+			}
+
+			GLuint first = batch.packetFirstIndices[slot];
+			if (!batch.drawCounts.empty() && (first == rangeEnd))
+			{
+				batch.drawCounts.back() += batch.packetIndexCounts[slot];
+			}
+			else
+			{
+				batch.drawCounts.push_back(batch.packetIndexCounts[slot]);
+				batch.drawOffsets.push_back((const void*)(first * sizeof(GLuint)));
+			}
+			rangeEnd = first + batch.packetIndexCounts[slot];
+		}
+
+		if (!batch.drawCounts.empty())
+		{
+			m_visibleStaticBatches.push_back((uint32_t)b);
+		}
+	}
+}
+
+/***********************************************************
+ *  SelectLevelsOfDetail()
+ *
+ *  This method is used for choosing how finely each visible
+ *  cylinder and cone is drawn, from the projected size of
+ *  its world bounds.  An instance batch whose visible
+ *  instances changed level is flagged for upload, so its
+ *  buffer gets reordered by level.  The packets and batches are split
+ *  over the job system; each writes only its own level.
+ ***********************************************************/
+void SceneManager::SelectLevelsOfDetail()
+{
+	ForEachRange(m_visiblePackets.size(), PARALLEL_GRAIN,
+		[this](size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; i++)
+			{
+				DRAW_PACKET& packet = m_drawPackets[m_visiblePackets[i]];
+				int drawable = m_nodeDraws[packet.nodeID].drawableIndex;
+				if (!HasLevelsOfDetail(packet.mesh) || (drawable == INVALID_HANDLE))
+				{
+					continue;
+				}
+
+				glm::vec3 center = glm::vec3(m_drawableBounds.centerX[drawable], m_drawableBounds.centerY[drawable], m_drawableBounds.centerZ[drawable]);
+				glm::vec3 extents = glm::vec3(m_drawableBounds.extentX[drawable], m_drawableBounds.extentY[drawable], m_drawableBounds.extentZ[drawable]);
+				packet.lodLevel = m_lodSelector.SelectLevel(packet.lodLevel, center, glm::length(extents));
+			}
+		});
+
+	// one batch per job, since a batch holds many instances
+	ForEachRange(m_visibleBatches.size(), 1,
+		[this](size_t first, size_t last)
+		{
+			for (size_t b = first; b < last; b++)
+			{
+				INSTANCE_BATCH& batch = m_instanceBatches[m_visibleBatches[b]];
+				if (!HasLevelsOfDetail(batch.mesh))
+				{
+					continue;
+				}
+
+				for (uint32_t i : batch.visibleInstances)
+				{
+					uint32_t drawable = batch.instanceDrawables[i];
+					glm::vec3 center = glm::vec3(m_drawableBounds.centerX[drawable], m_drawableBounds.centerY[drawable], m_drawableBounds.centerZ[drawable]);
+					glm::vec3 extents = glm::vec3(m_drawableBounds.extentX[drawable], m_drawableBounds.extentY[drawable], m_drawableBounds.extentZ[drawable]);
+					int level = m_lodSelector.SelectLevel(batch.instanceLods[i], center, glm::length(extents));
+					if (level != batch.instanceLods[i])
+					{
+						batch.instanceLods[i] = level;
+						batch.bNeedsUpload = true;
+					}
+				}
+			}
+		});
+}
+
+/***********************************************************
+ *  UploadInstanceBatches()
+ *
+ *  This method is used for sending the per-instance data of
+ *  the instance batches that changed to GPU memory.  Only
+ *  the visible instances go into the buffer, so a batch
+ *  that is partly in view draws just that part.  The
+ *  instances of a cylinder or cone batch are ordered by
+ *  level of detail, so each level is one range of the
+ *  buffer and one instanced draw; any other batch draws
+ *  its instances at level 0.
+ ***********************************************************/
+void SceneManager::UploadInstanceBatches()
+{
+	for (INSTANCE_BATCH& batch : m_instanceBatches)
+	{
+		if (!batch.bNeedsUpload)
+		{
+			continue;
+		}
+		batch.bNeedsUpload = false;
+
+		bool bHasLevels = HasLevelsOfDetail(batch.mesh);
+		m_lodInstances.clear();
+		for (int level = 0; level < LodSelector::LEVEL_COUNT; level++)
+		{
+			batch.lodFirst[level] = (GLint)m_lodInstances.size();
+			for (uint32_t i : batch.visibleInstances)
+			{
+				int instanceLevel = bHasLevels ? batch.instanceLods[i] : 0;
+				if (instanceLevel == level)
+				{
+					m_lodInstances.push_back(batch.instances[i]);
+				}
+			}
+			batch.lodCounts[level] = (GLsizei)m_lodInstances.size() - batch.lodFirst[level];
+		}
+		batch.uploadedInstances = batch.visibleInstances;
+
+		if (batch.instanceBuffer == 0)
+		{
+			batch.instanceBuffer = m_basicMeshes->CreateInstanceBuffer(m_lodInstances);
+		}
+		else
+		{
+			m_basicMeshes->UpdateInstanceBuffer(batch.instanceBuffer, m_lodInstances);
+		}
+	}
+}
+
+/***********************************************************
+ *  DestroyInstanceBatches()
+ *
+ *  This method is used for freeing the GPU memory used by
+ *  the instance batches.
+ ***********************************************************/
+void SceneManager::DestroyInstanceBatches()
+{
+	for (INSTANCE_BATCH& batch : m_instanceBatches)
+	{
+		m_basicMeshes->DestroyInstanceBuffer(batch.instanceBuffer);
+		batch.instanceBuffer = 0;
+	}
+	m_instanceBatches.clear();
+}
+
+/***********************************************************
+ *  BuildStaticBatches()
+ *
+ *  This method is used for grouping the static draw packets
+ *  into static batches, one per object group and texture,
+ *  and baking each batch into a merged mesh.  Translucent
+ *  packets are left out so they keep their back-to-front
+ *  order.  The material of each packet goes into its
+ *  vertices, so packets with different materials and colors
+ *  still share a batch.  Each packet keeps its own range of
+ *  the merged indices, so it is still culled on its own.
+ ***********************************************************/
+void SceneManager::BuildStaticBatches()
+{
+	DestroyStaticBatches();
+
+	m_staticMeshData.resize(MESH_TYPE_COUNT);
+	for (int mesh = 0; mesh < MESH_TYPE_COUNT; mesh++)
+	{
+		m_staticMeshData[mesh] = {};
+		BuildMeshData((MESH_TYPE)mesh, m_staticMeshData[mesh]);
+	}
+
+	for (size_t i = 0; i < m_drawPackets.size(); i++)
+	{
+		DRAW_PACKET& packet = m_drawPackets[i];
+		packet.staticBatch = INVALID_HANDLE;
+		if (!packet.bStatic || (packet.color.a < 1.0f))
+		{
+			continue;
+		}
+
+		int batchIndex = INVALID_HANDLE;
+		for (size_t b = 0; b < m_staticBatches.size(); b++)
+		{
+			if ((m_staticBatches[b].groupID == packet.groupID) &&
+				(m_staticBatches[b].textureID == packet.textureID))
+			{
+				batchIndex = (int)b;
+				break;
+			}
+		}
+
+		if (batchIndex == INVALID_HANDLE)
+		{
+			STATIC_BATCH batch;
+			batch.textureID = packet.textureID;
+			batch.groupID = packet.groupID;
+			batch.mesh = {};
+			batch.bNeedsBake = true;
+			m_staticBatches.push_back(batch);
+			batchIndex = (int)m_staticBatches.size() - 1;
+		}
+
+		m_staticBatches[batchIndex].packetIndices.push_back(i);
+		packet.staticBatch = batchIndex;
+	}
+
+	BakeStaticBatches();
+}
+
+/***********************************************************
+ *  BakeStaticBatches()
+ *
+ *  This method is used for baking the static batches that
+ *  are new or had a packet moved.  Every packet of the
+ *  batch is moved into world space with its current model
+ *  matrix, the range of indices it got is noted, and the
+ *  merged mesh is sent to GPU memory again.
+ ***********************************************************/
+void SceneManager::BakeStaticBatches()
+{
+	for (STATIC_BATCH& batch : m_staticBatches)
+	{
+		if (!batch.bNeedsBake)
+		{
+			continue;
+		}
+		batch.bNeedsBake = false;
+
+		m_bakedVertices.clear();
+		m_bakedIndices.clear();
+		batch.packetFirstIndices.clear();
+		batch.packetIndexCounts.clear();
+		for (size_t packetIndex : batch.packetIndices)
+		{
+			const DRAW_PACKET& packet = m_drawPackets[packetIndex];
+			batch.packetFirstIndices.push_back((GLuint)m_bakedIndices.size());
+			ShapeMeshes::AppendBakedMesh(
+				m_staticMeshData[(int)packet.mesh],
+				packet.model,
+				packet.uvScale,
+				packet.color,
+				std::max(packet.materialID, 0),
+				m_bakedVertices,
+				m_bakedIndices);
+			batch.packetIndexCounts.push_back((GLsizei)m_bakedIndices.size() - (GLsizei)batch.packetFirstIndices.back());
+		}
+
+		m_basicMeshes->UploadBakedMesh(batch.mesh, m_bakedVertices, m_bakedIndices);
+	}
+}
+
+/***********************************************************
+ *  DestroyStaticBatches()
+ *
+ *  This method is used for freeing the GPU memory used by
+ *  the static batches.
+ ***********************************************************/
+void SceneManager::DestroyStaticBatches()
+{
+	for (STATIC_BATCH& batch : m_staticBatches)
+	{
+		m_basicMeshes->DestroyBakedMesh(batch.mesh);
+	}
+	m_staticBatches.clear();
+}
+
+/***********************************************************
+ *  SetCameraPosition()
+ *
+ *  This method is used for setting the camera position that
+ *  the draws are ordered against in RenderScene().
+ ***********************************************************/
+void SceneManager::SetCameraPosition(const glm::vec3& cameraPosition)
+{
+	m_cameraPosition = cameraPosition;
+	m_lodSelector.SetCameraPosition(cameraPosition);
+}
+
+/***********************************************************
+ *  SetViewFrustum()
+ *
+ *  This method is used for setting the combined projection
+ *  and view matrix of the camera.  From then on RenderScene()
+ *  skips the draws whose bounds are outside its frustum.
+ ***********************************************************/
+void SceneManager::SetViewFrustum(const glm::mat4& projectionView)
+{
+	m_frustum = FrustumCuller::ExtractFrustum(projectionView);
+	m_bFrustumSet = true;
+}
+
+/***********************************************************
+ *  SetLodProjection()
+ *
+ *  This method is used for setting the camera projection
+ *  that the projected sizes of the curved shapes are
+ *  measured with.  Until it is set every shape is drawn at
+ *  its finest level.
+ ***********************************************************/
+void SceneManager::SetLodProjection(const glm::mat4& projection)
+{
+	m_lodSelector.SetProjection(projection);
+}
+
+/***********************************************************
+ *  GetLastFrameDrawCalls()
+ *
+ *  This method is used for getting the number of draw calls
+ *  issued by the last call to RenderScene().
+ ***********************************************************/
+unsigned int SceneManager::GetLastFrameDrawCalls() const
+{
+	return(m_frameDrawCalls);
+}
+
+/***********************************************************
+ *  AreTexturesLoading()
+ *
+ *  This method is used for checking whether any requested
+ *  texture still shows its placeholder image.
+ ***********************************************************/
+bool SceneManager::AreTexturesLoading() const
+{
+	return(m_pTextureLoader->GetPendingCount() > 0);
+}
+
+/***********************************************************
+ *  HasSceneChanged()
+ *
+ *  This method is used for checking whether rendering again
+ *  with the same camera could give a different image: the
+ *  lights or materials were rewritten, scene graph nodes
+ *  moved, textures are still replacing their placeholders,
+ *  or some packets are re-evaluated every frame.
+ ***********************************************************/
+bool SceneManager::HasSceneChanged() const
+{
+	return(m_bSceneChanged ||
+		m_sceneGraph.HasDirtyNodes() ||
+		AreTexturesLoading() ||
+		!m_dynamicPackets.empty());
+}
+
+/***********************************************************
+ *  SetProfiler()
+ *
+ *  This method is used for setting the profiler that times
+ *  each object group in RenderScene().  NULL turns the
+ *  group timing off.
+ ***********************************************************/
+void SceneManager::SetProfiler(GpuProfiler* pProfiler)
+{
+	m_pProfiler = pProfiler;
+}
+
+/***********************************************************
+ *  SetJobSystem()
+ *
+ *  This method is used for setting the job system that the
+ *  transform updates, culling, level of detail selection
+ *  and sort keys of each frame are split over.  Only the
+ *  draw calls stay on the render thread.  NULL does all of
+ *  it on the render thread.
+ ***********************************************************/
+void SceneManager::SetJobSystem(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+	m_sceneGraph.SetJobSystem(pJobSystem);
+}
+
+/***********************************************************
+ *  ForEachRange()
+ *
+ *  This method is used for running a loop body over [0,
+ *  count) in ranges of grainSize on the job system, or in
+ *  one range on the calling thread without one.
+ ***********************************************************/
+void SceneManager::ForEachRange(size_t count, size_t grainSize, const JobSystem::RANGE_FUNCTION& function)
+{
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor(count, grainSize, function);
+	}
+	else if (count > 0)
+	{
+		function(0, count);
+	}
+}
+
+/***********************************************************
+ *  SetGpuDrivenRendering()
+ *
+ *  This method is used for switching the scene to the
+ *  GPU-driven draw path.  Every shape at every level of
+ *  detail is loaded into the shared mesh arena, and the
+ *  per-frame buffers start out sized for the scene
+ *  drawables; they grow when a frame holds more objects.
+ *  When the context lacks buffer storage or multi-draw
+ *  indirect the scene stays on the regular path.
+ ***********************************************************/
+bool SceneManager::SetGpuDrivenRendering(bool bEnabled)
+{
+	if (!bEnabled)
+	{
+		delete m_pIndirectRenderer;
+		m_pIndirectRenderer = NULL;
+		m_basicMeshes->DestroyMeshArena();
+		m_arenaMeshes.clear();
+		return(true);
+	}
+
+	if (NULL != m_pIndirectRenderer)
+	{
+		return(true);
+	}
+
+	// the shapes without levels of detail repeat their one
+	// mesh at every level
+	m_arenaMeshes.resize(MESH_TYPE_COUNT * LodSelector::LEVEL_COUNT);
+	for (int mesh = 0; mesh < MESH_TYPE_COUNT; mesh++)
+	{
+		for (int level = 0; level < LodSelector::LEVEL_COUNT; level++)
+		{
+			int arenaIndex = mesh * LodSelector::LEVEL_COUNT + level;
+			if ((level > 0) && !HasLevelsOfDetail((MESH_TYPE)mesh))
+			{
+				m_arenaMeshes[arenaIndex] = m_arenaMeshes[arenaIndex - level];
+				continue;
+			}
+
+			ShapeMeshes::MESH_DATA data;
+			BuildMeshData((MESH_TYPE)mesh, data, level);
+			m_arenaMeshes[arenaIndex] = m_basicMeshes->AddArenaMesh(data);
+		}
+	}
+	m_basicMeshes->UploadMeshArena();
+
+	m_pIndirectRenderer = new IndirectRenderer(m_basicMeshes, m_pStateCache);
+	if (!m_pIndirectRenderer->Initialize((GLuint)m_drawableNodes.size()))
+	{
+		SetGpuDrivenRendering(false);
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetGpuCulling()
+ *
+ *  This method is used for moving the frustum culling of
+ *  the GPU-driven path onto the GPU, with the passed in
+ *  compute program, which turns the GPU-driven path on
+ *  first.  The CPU then hands every packet and instance to
+ *  the path, and only the static batches, which are drawn
+ *  with regular calls, are still tested on the CPU.  A
+ *  program of 0 culls on the CPU again.
+ ***********************************************************/
+bool SceneManager::SetGpuCulling(GLuint cullProgram)
+{
+	if (cullProgram == 0)
+	{
+		if (NULL != m_pIndirectRenderer)
+		{
+			m_pIndirectRenderer->SetCullProgram(0);
+		}
+		return(true);
+	}
+
+	if (!SetGpuDrivenRendering(true))
+	{
+		return(false);
+	}
+
+	return(m_pIndirectRenderer->SetCullProgram(cullProgram));
+}
+
+/***********************************************************
+ *  GetSceneGraph()
+ *
+ *  This method is used for getting the scene graph, so the
+ *  nodes can be moved between frames.  RenderScene() picks
+ *  up the moved nodes on its own.
+ ***********************************************************/
+SceneGraph& SceneManager::GetSceneGraph()
+{
+	return(m_sceneGraph);
+}
+
+/***********************************************************
+ *  GetHouseNode()
+ *
+ *  This method is used for getting the node that the house
+ *  and all of its parts are attached to.
+ ***********************************************************/
+SceneGraph::NODE_HANDLE SceneManager::GetHouseNode() const
+{
+	return(m_houseNode);
+}
+
+/***********************************************************
+ *  PickNode()
+ *
+ *  This method is used for finding the object under a ray,
+ *  such as one cast from the camera.  The node of the
+ *  nearest object whose bounds the ray enters within
+ *  maxDistance is returned along with the distance to it.
+ *  The spatial index is as of the last RenderScene().
+ ***********************************************************/
+SceneGraph::NODE_HANDLE SceneManager::PickNode(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float maxDistance,
+	float& distance) const
+{
+	uint32_t drawable = 0;
+
+	if (!m_spatialIndex.QueryRay(origin, direction, maxDistance, drawable, distance))
+	{
+		return(SceneGraph::INVALID_NODE);
+	}
+
+	return(m_drawableNodes[drawable]);
+}
+
+/***********************************************************
+ *  FindNodesInBox()
+ *
+ *  This method is used for listing the nodes of the objects
+ *  whose bounds overlap a world-space box, for proximity
+ *  checks around a point of the scene.
+ ***********************************************************/
+void SceneManager::FindNodesInBox(
+	const glm::vec3& boxMin,
+	const glm::vec3& boxMax,
+	std::vector<SceneGraph::NODE_HANDLE>& nodes) const
+{
+	std::vector<uint32_t> drawables;
+
+	m_spatialIndex.QueryOverlap(boxMin, boxMax, drawables);
+
+	nodes.clear();
+	for (uint32_t drawable : drawables)
+	{
+		nodes.push_back(m_drawableNodes[drawable]);
+	}
+}
+
+/***********************************************************
+ *  BuildSortKey()
+ *
+ *  This method is used for building the sort key of a draw
+ *  packet.  Draws sharing a material, texture and mesh end
+ *  up next to each other, so the state cache can skip the
+ *  repeated binds and uniform writes between them.
+ ***********************************************************/
+uint64_t SceneManager::BuildSortKey(const DRAW_PACKET& packet) const
+{
+	// distance from the camera to the object origin, quantized
+	glm::vec3 position = glm::vec3(packet.model[3]);
+	float distance = glm::length(position - m_cameraPosition);
+	float depth01 = std::min(distance / SORT_MAX_DEPTH, 1.0f);
+	uint64_t depth = (uint64_t)(depth01 * (float)SORT_DEPTH_MASK);
+
+	// -1 (no material) sorts ahead of the first material
+	uint64_t material = (uint64_t)(packet.materialID + 1) & SORT_MATERIAL_MASK;
+	uint64_t texture = (uint64_t)packet.textureID & SORT_TEXTURE_MASK;
+	uint64_t mesh = (uint64_t)packet.mesh & SORT_MESH_MASK;
+	uint64_t state = (material << 15) | (texture << 3) | mesh;
+
+	if (packet.color.a < 1.0f)
+	{
+		return(SORT_TRANSLUCENT_BIT | ((SORT_DEPTH_MASK - depth) << 27) | state);
+	}
+
+	// keep the opaque draws of one object group together while
+	// profiling, which only changes the order, not the image
+	uint64_t group = 0;
+	if (NULL != m_pProfiler)
+	{
+		group = ((uint64_t)(packet.groupID + 1) & SORT_GROUP_MASK) << SORT_GROUP_SHIFT;
+	}
+
+	return(group | (state << 24) | depth);
+}
+
+/***********************************************************
+ *  SortDrawQueue()
+ *
+ *  This method is used for filling the draw queue with the
+ *  draw packets that passed the culling and sorting it by
+ *  the packet sort keys.  The keys are built on the job
+ *  system.  The queue keeps its memory between frames.
+ ***********************************************************/
+void SceneManager::SortDrawQueue()
+{
+	m_drawQueue.resize(m_visiblePackets.size());
+	ForEachRange(m_visiblePackets.size(), PARALLEL_GRAIN,
+		[this](size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; i++)
+			{
+				size_t packetIndex = m_visiblePackets[i];
+				m_drawQueue[i].sortKey = BuildSortKey(m_drawPackets[packetIndex]);
+				m_drawQueue[i].packetIndex = packetIndex;
+			}
+		});
+
+	std::sort(m_drawQueue.begin(), m_drawQueue.end(),
+		[](const DRAW_ITEM& a, const DRAW_ITEM& b)
+		{
+			return(a.sortKey < b.sortKey);
+		});
+}
+
+/***********************************************************
+ *  EnterProfileGroup()
+ *
+ *  This method is used for switching the open profiler
+ *  scope when the next draw belongs to another object group.
+ *  INVALID_HANDLE closes the open scope, and
+ *  TRANSLUCENT_PROFILE_GROUP opens the one scope all the
+ *  translucent draws are timed under.
+ ***********************************************************/
+void SceneManager::EnterProfileGroup(int groupID)
+{
+	if ((NULL == m_pProfiler) || (groupID == m_profiledGroup))
+	{
+		return;
+	}
+
+	if (m_profiledGroup != INVALID_HANDLE)
+	{
+		m_pProfiler->EndScope();
+	}
+
+	m_profiledGroup = groupID;
+	if (m_profiledGroup == TRANSLUCENT_PROFILE_GROUP)
+	{
+		m_pProfiler->BeginScope(TRANSLUCENT_PROFILE_NAME);
+	}
+	else if (m_profiledGroup != INVALID_HANDLE)
+	{
+		m_pProfiler->BeginScope(m_packetGroups[m_profiledGroup]);
+	}
+}
+
+/***********************************************************
+ *  SubmitDrawPacket()
+ *
+ *  This method is used for setting the shader values held
+ *  in a draw packet and drawing the referenced mesh.
+ ***********************************************************/
+void SceneManager::SubmitDrawPacket(const DRAW_PACKET& packet)
+{
+	m_pStateCache->SetMat4Value(m_uniforms.model, packet.model);
+	m_pStateCache->SetVec4Value(m_uniforms.objectColor, packet.color);
+
+	SetShaderMaterial(packet.materialID);
+
+	if (packet.textureID != 0)
+	{
+		m_pStateCache->SetIntValue(m_uniforms.useTexture, true);
+		m_pStateCache->BindTexture2D(0, packet.textureID);
+		m_pStateCache->SetVec2Value(m_uniforms.uvScale, packet.uvScale);
+	}
+	else
+	{
+		m_pStateCache->SetIntValue(m_uniforms.useTexture, false);
+	}
+
+	switch (packet.mesh)
+	{
+	case MESH_TYPE::Box:
+		m_basicMeshes->DrawBoxMesh();
+		break;
+	case MESH_TYPE::Plane:
+		m_basicMeshes->DrawPlaneMesh();
+		break;
+	case MESH_TYPE::Cylinder:
+		m_basicMeshes->DrawCylinderMesh(true, true, true, packet.lodLevel);
+		break;
+	case MESH_TYPE::Cone:
+		m_basicMeshes->DrawConeMesh(true, packet.lodLevel);
+		break;
+	case MESH_TYPE::Prism:
+		m_basicMeshes->DrawPrismMesh();
+		break;
+	}
+
+	m_frameDrawCalls++;
+}
+
+/***********************************************************
+ *  SubmitInstanceBatch()
+ *
+ *  This method is used for drawing the visible objects in an
+ *  instance batch with one instanced draw call, or one per
+ *  level of detail in use for a cylinder or cone batch.
+ *  The model matrix and color come from the instance buffer
+ *  instead of the shader uniforms.
+ ***********************************************************/
+void SceneManager::SubmitInstanceBatch(const INSTANCE_BATCH& batch)
+{
+	// without levels of detail every uploaded instance is at level 0
+	GLsizei count = batch.lodCounts[0];
+
+	SetShaderMaterial(batch.materialID);
+	m_pStateCache->SetIntValue(m_uniforms.useTexture, false);
+
+	switch (batch.mesh)
+	{
+	case MESH_TYPE::Box:
+		m_basicMeshes->DrawBoxMeshInstanced(count, batch.instanceBuffer);
+		break;
+	case MESH_TYPE::Plane:
+		m_basicMeshes->DrawPlaneMeshInstanced(count, batch.instanceBuffer);
+		break;
+	case MESH_TYPE::Cylinder:
+	case MESH_TYPE::Cone:
+		for (int level = 0; level < LodSelector::LEVEL_COUNT; level++)
+		{
+			if (batch.lodCounts[level] == 0)
+			{
+				continue;
+			}
+			if (batch.mesh == MESH_TYPE::Cylinder)
+				m_basicMeshes->DrawCylinderMeshInstanced(batch.lodCounts[level], batch.instanceBuffer, level, batch.lodFirst[level]);
+			else
+				m_basicMeshes->DrawConeMeshInstanced(batch.lodCounts[level], batch.instanceBuffer, level, batch.lodFirst[level]);
+			m_frameDrawCalls++;
+		}
+		return;
+	case MESH_TYPE::Prism:
+		m_basicMeshes->DrawPrismMeshInstanced(count, batch.instanceBuffer);
+		break;
+	}
+
+	m_frameDrawCalls++;
+}
+
+/***********************************************************
+ *  SubmitStaticBatch()
+ *
+ *  This method is used for drawing the visible objects in a
+ *  static batch with one draw call over their index ranges.
+ *  The vertices are already in world space and carry their
+ *  color and material, and the texture coordinates are
+ *  already scaled.
+ ***********************************************************/
+void SceneManager::SubmitStaticBatch(const STATIC_BATCH& batch)
+{
+	if (batch.textureID != 0)
+	{
+		m_pStateCache->SetIntValue(m_uniforms.useTexture, true);
+		m_pStateCache->BindTexture2D(0, batch.textureID);
+		m_pStateCache->SetVec2Value(m_uniforms.uvScale, glm::vec2(1.0f, 1.0f));
+	}
+	else
+	{
+		m_pStateCache->SetIntValue(m_uniforms.useTexture, false);
+	}
+
+	m_basicMeshes->DrawBakedMesh(batch.mesh, batch.drawCounts, batch.drawOffsets);
+	m_frameDrawCalls++;
+}
+
+/***********************************************************
+ *  QueueIndirectObject()
+ *
+ *  This method is used for queuing one object for the
+ *  GPU-driven path.  Objects sharing a texture, and an
+ *  object group while profiling, build up into one run
+ *  that is drawn with a single call when the next object
+ *  needs another state.  Under GPU culling the object is
+ *  tested with the bounds of its drawable, when it has one.
+ ***********************************************************/
+void SceneManager::QueueIndirectObject(
+	MESH_TYPE mesh,
+	int lodLevel,
+	const glm::mat4& model,
+	const glm::vec4& color,
+	const glm::vec2& uvScale,
+	MATERIAL_HANDLE materialID,
+	GLuint textureID,
+	int groupID,
+	int drawable,
+	bool bKeepOrder)
+{
+	if (NULL == m_pProfiler)
+	{
+		groupID = INVALID_HANDLE;
+	}
+	if ((textureID != m_indirectTexture) || (groupID != m_indirectGroup))
+	{
+		FlushIndirectObjects();
+		m_indirectTexture = textureID;
+		m_indirectGroup = groupID;
+	}
+
+	OBJECT_STD430 object;
+	object.model = model;
+	object.color = color;
+	object.uvScale = (textureID != 0) ? uvScale : glm::vec2(1.0f, 1.0f);
+	object.materialIndex = std::max(materialID, 0);
+	object.padding = 0;
+
+	const ShapeMeshes::ARENA_MESH& arenaMesh = m_arenaMeshes[(int)mesh * LodSelector::LEVEL_COUNT + lodLevel];
+	bool bQueued = false;
+	if (m_pIndirectRenderer->IsCulling() && m_bFrustumSet && (drawable != INVALID_HANDLE))
+	{
+		glm::vec3 center = glm::vec3(m_drawableBounds.centerX[drawable], m_drawableBounds.centerY[drawable], m_drawableBounds.centerZ[drawable]);
+		glm::vec3 extents = glm::vec3(m_drawableBounds.extentX[drawable], m_drawableBounds.extentY[drawable], m_drawableBounds.extentZ[drawable]);
+		bQueued = m_pIndirectRenderer->AddCulledObject(arenaMesh, object, center, extents, bKeepOrder);
+	}
+	else
+	{
+		bQueued = m_pIndirectRenderer->AddObject(arenaMesh, object, bKeepOrder);
+	}
+
+	if (bQueued && HasLevelsOfDetail(mesh))
+	{
+		RenderStats::CountLodDraw(lodLevel, (GLsizei)arenaMesh.indexCount);
+	}
+}
+
+/***********************************************************
+ *  FlushIndirectObjects()
+ *
+ *  This method is used for setting the state of the queued
+ *  run of GPU-driven objects and drawing it.
+ ***********************************************************/
+void SceneManager::FlushIndirectObjects()
+{
+	EnterProfileGroup(m_indirectGroup);
+
+	if (m_indirectTexture != 0)
+	{
+		m_pStateCache->SetIntValue(m_uniforms.useTexture, true);
+		m_pStateCache->BindTexture2D(0, m_indirectTexture);
+	}
+	else
+	{
+		m_pStateCache->SetIntValue(m_uniforms.useTexture, false);
+	}
+
+	if (m_pIndirectRenderer->FlushDraws())
+	{
+		m_frameDrawCalls++;
+	}
+}
+
+/***********************************************************
+ *  SubmitSceneIndirect()
+ *
+ *  This method is used for issuing the visible scene through
+ *  the GPU-driven path, in the same order as the regular
+ *  path: the opaque packets and instances as runs of one
+ *  texture, the static batches, and the translucent packets
+ *  back-to-front.  The model matrix, color, texture scale
+ *  and material of each object come from the object buffer.
+ ***********************************************************/
+bool SceneManager::SubmitSceneIndirect()
+{
+	size_t objectCount = m_drawQueue.size();
+	for (uint32_t batchIndex : m_visibleBatches)
+	{
+		objectCount += m_instanceBatches[batchIndex].visibleInstances.size();
+	}
+	if ((objectCount > m_pIndirectRenderer->GetMaxObjects()) &&
+		!m_pIndirectRenderer->Initialize((GLuint)(objectCount * 2)))
+	{
+		SetGpuDrivenRendering(false);
+		return(false);
+	}
+
+	if (m_bFrustumSet)
+	{
+		m_pIndirectRenderer->SetCullFrustum(m_frustum);
+	}
+	m_pIndirectRenderer->BeginFrame();
+	m_indirectTexture = 0;
+	m_indirectGroup = INVALID_HANDLE;
+	m_pStateCache->SetVec2Value(m_uniforms.uvScale, glm::vec2(1.0f, 1.0f));
+	m_pStateCache->SetBoolValue(m_uniforms.useObjectBuffer, true);
+
+	size_t item = 0;
+	for (; item < m_drawQueue.size(); item++)
+	{
+		if (m_drawQueue[item].sortKey & SORT_TRANSLUCENT_BIT)
+		{
+			break;
+		}
+		const DRAW_PACKET& packet = m_drawPackets[m_drawQueue[item].packetIndex];
+		QueueIndirectObject(packet.mesh, packet.lodLevel, packet.model, packet.color, packet.uvScale,
+			packet.materialID, packet.textureID, packet.groupID, m_nodeDraws[packet.nodeID].drawableIndex, false);
+	}
+
+	for (uint32_t batchIndex : m_visibleBatches)
+	{
+		const INSTANCE_BATCH& batch = m_instanceBatches[batchIndex];
+		for (uint32_t i : batch.visibleInstances)
+		{
+			QueueIndirectObject(batch.mesh, batch.instanceLods[i], batch.instances[i].model, batch.instances[i].color,
+				glm::vec2(1.0f, 1.0f), batch.materialID, 0, batch.groupID, (int)batch.instanceDrawables[i], false);
+		}
+	}
+	FlushIndirectObjects();
+	m_pStateCache->SetBoolValue(m_uniforms.useObjectBuffer, false);
+
+	// the static batches are already one draw each
+	m_pStateCache->SetBoolValue(m_uniforms.useBakedVertices, true);
+	for (uint32_t batchIndex : m_visibleStaticBatches)
+	{
+		const STATIC_BATCH& batch = m_staticBatches[batchIndex];
+		EnterProfileGroup(batch.groupID);
+		SubmitStaticBatch(batch);
+	}
+	m_pStateCache->SetBoolValue(m_uniforms.useBakedVertices, false);
+
+	// only neighbouring translucent packets share a run, so
+	// the back-to-front order is kept; they are timed as one
+	m_pStateCache->SetBoolValue(m_uniforms.useObjectBuffer, true);
+	for (; item < m_drawQueue.size(); item++)
+	{
+		const DRAW_PACKET& packet = m_drawPackets[m_drawQueue[item].packetIndex];
+		QueueIndirectObject(packet.mesh, packet.lodLevel, packet.model, packet.color, packet.uvScale,
+			packet.materialID, packet.textureID, TRANSLUCENT_PROFILE_GROUP, m_nodeDraws[packet.nodeID].drawableIndex, true);
+	}
+	FlushIndirectObjects();
+	m_pStateCache->SetBoolValue(m_uniforms.useObjectBuffer, false);
+
+	m_pIndirectRenderer->EndFrame();
+
+	return(true);
+}
+
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
+
+/***********************************************************
+ *  ResolveUniformHandles()
+ *
+ *  This method is used for resolving the handles of every
+ *  shader uniform the scene sets, so the names are only
+ *  looked up once instead of on every draw.
+ ***********************************************************/
+void SceneManager::ResolveUniformHandles()
+{
+	m_uniforms.model = m_pShaderManager->GetUniformHandle(g_ModelName);
+	m_uniforms.objectColor = m_pShaderManager->GetUniformHandle(g_ColorValueName);
+	m_uniforms.objectTexture = m_pShaderManager->GetUniformHandle(g_TextureValueName);
+	m_uniforms.useTexture = m_pShaderManager->GetUniformHandle(g_UseTextureName);
+	m_uniforms.useLighting = m_pShaderManager->GetUniformHandle(g_UseLightingName);
+	m_uniforms.useInstancing = m_pShaderManager->GetUniformHandle(g_UseInstancingName);
+	m_uniforms.useBakedVertices = m_pShaderManager->GetUniformHandle(g_UseBakedVerticesName);
+	m_uniforms.useObjectBuffer = m_pShaderManager->GetUniformHandle(g_UseObjectBufferName);
+	m_uniforms.uvScale = m_pShaderManager->GetUniformHandle(g_UVScaleName);
+	m_uniforms.materialIndex = m_pShaderManager->GetUniformHandle("materialIndex");
+}
+
+void SceneManager::DefineObjectMaterials()
+{
+	m_objectMaterials.clear();
+	m_materialHandles.clear();
+
+	// Snow / ground: bluish, low ambient 
+	AddObjectMaterial({
+		/*ambientStrength*/ 0.18f,
+		/*ambientColor*/    glm::vec3(0.70f, 0.78f, 0.92f),  // blue-white
+		/*diffuseColor*/    glm::vec3(0.80f, 0.88f, 0.98f),
+		/*specularColor*/   glm::vec3(0.15f),
+		/*shininess*/       8.0f,
+		/*tag*/             "snow"
+		});
+
+	// House neutral/cool
+	AddObjectMaterial({
+		0.15f,
+		glm::vec3(0.62f, 0.62f, 0.70f),
+		glm::vec3(0.70f, 0.70f, 0.78f),
+		glm::vec3(0.18f),
+		12.0f,
+		"house"
+		});
+
+	UploadMaterialTable();
+}
+
+void SceneManager::SetupSceneLights()
+{
+	LIGHT_BLOCK lightBlock = {};
+
+	// Enable custom lighting in the shader
+	m_pStateCache->SetBoolValue(m_uniforms.useLighting, true);
+
+	auto SetLight = [&](int i, glm::vec3 position, glm::vec3 ambientColor, glm::vec3 diffuseColor,
+		glm::vec3 specularColor, float focalStrength, float specularIntensity)
+		{
+			LIGHT_SOURCE_STD140& L = lightBlock.lightSources[i];
+			L.position = position;
+			L.ambientColor = ambientColor;
+			L.diffuseColor = diffuseColor;
+			L.specularColor = specularColor;
+			L.focalStrength = focalStrength;
+			L.specularIntensity = specularIntensity;
+		};
+
+	for (int i = 0; i < TOTAL_LIGHTS; ++i) {
+		SetLight(i, glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), 1.0f, 0.0f);
+	}
+
+		//— cool moonlight L0
+	SetLight(0,
+		glm::vec3(6.0f, 7.0f, 3.0f),
+		glm::vec3(0.02f, 0.03f, 0.05f),		// tiny ambient
+		glm::vec3(0.65f, 0.75f, 1.00f),		// strong cool
+		glm::vec3(0.85f, 0.90f, 1.00f),
+		32.0f,
+		0.60f);
+
+		//— lavender fill from left-back L1
+	SetLight(1,
+		glm::vec3(-6.0f, 4.0f, -4.0f),
+		glm::vec3(0.00f),					// no ambient
+		glm::vec3(0.55f, 0.45f, 0.70f),		// lavender
+		glm::vec3(0.20f, 0.16f, 0.28f),
+		16.0f,
+		0.20f);
+
+	// the light block is only written when the lights change
+	if (m_lightBuffer == 0)
+	{
+		m_lightBuffer = m_pShaderManager->CreateUniformBuffer(LIGHT_BLOCK_BINDING, sizeof(LIGHT_BLOCK));
+	}
+	m_pShaderManager->UpdateUniformBuffer(m_lightBuffer, 0, sizeof(LIGHT_BLOCK), &lightBlock);
+	m_bSceneChanged = true;
+}
+
+GLuint SceneManager::LoadTexture2D(const char* path, bool flipY)
+{
+	// decoded and uploaded in the background - the texture
+	// shows a placeholder until its image is resident
+	return(m_pTextureLoader->RequestTexture(path, flipY));
+}
+
+
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene 
+ *  rendering
+ ***********************************************************/
+void SceneManager::PrepareScene()
+{
+	ResolveUniformHandles();
+	DefineObjectMaterials();
+	SetupSceneLights();
+
+	// House pieces
+	TRACE_BEGIN("load meshes");
+	m_basicMeshes->LoadBoxMesh();        // body, porch, frames
+	m_basicMeshes->LoadCylinderMesh();   // chimney cap
+	m_basicMeshes->LoadPrismMesh();      // roof
+	m_basicMeshes->LoadPlaneMesh();      // ground/backdrop 
+	m_basicMeshes->LoadConeMesh();         // foliage
+	TRACE_END("load meshes");
+
+	// --- Load house textures ---
+	TRACE_BEGIN("request textures");
+	m_texBrick = LoadTexture2D("assets/textures/Brick.jpg");   // CC0 brick jpg
+	// roof shingles:
+	m_texRoof = LoadTexture2D("assets/textures/Roof.jpg");    // CC0 roof jpg
+	TRACE_END("request textures");
+
+	// Tell shader which texture unit the sampler uses (unit 0)
+	if (m_pShaderManager)
+		m_pStateCache->SetIntValue(m_uniforms.objectTexture, 0);  
+
+	// compile the scene into the retained draw list, send the
+	// repeated objects to the instance buffers and bake the
+	// immovable ones into merged meshes
+	TRACE_BEGIN("BuildDrawPackets");
+	BuildDrawPackets();
+	UpdateSceneTransforms();
+	UpdateSpatialIndex();
+	UploadInstanceBatches();
+	BuildStaticBatches();
+	TRACE_END("BuildDrawPackets");
+}
+
+/***********************************************************
+ *  BuildDrawPackets()
+ *
+ *  This method is used for compiling every object in the 3D
+ *  scene into a draw packet.  It runs once from PrepareScene()
+ *  so the transforms, materials and textures are not
+ *  recomputed every frame.
+ ***********************************************************/
+void SceneManager::BuildDrawPackets()
+{
+	m_drawPackets.clear();
+	m_dynamicPackets.clear();
+	DestroyInstanceBatches();
+	DestroyStaticBatches();
+	m_bAddStatic = false;
+	m_packetGroups.clear();
+	m_currentGroup = INVALID_HANDLE;
+	m_sceneGraph.Clear();
+	m_nodeDraws.clear();
+	m_currentParent = SceneGraph::INVALID_NODE;
+	m_drawableNodes.clear();
+	m_drawableBounds.Clear();
+	m_movedDrawables.clear();
+	m_spatialIndex.Clear();
+
+	// ---------- palette ----------
+	const glm::vec4 STONE = glm::vec4(0.78f, 0.78f, 0.84f, 1.0f); // body (light)
+	const glm::vec4 TRIM = glm::vec4(0.64f, 0.64f, 0.72f, 1.0f); // trim (brighter)
+	const glm::vec4 ROOF = glm::vec4(0.64f, 0.60f, 0.70f, 1.0f); // roof lavender
+	const glm::vec4 DOOR = glm::vec4(0.12f, 0.10f, 0.14f, 1.0f); // darker
+	const glm::vec4 GLASS = glm::vec4(0.60f, 0.85f, 0.92f, 1.0f); // darker cyan
+	const glm::vec4 WHITE = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f); // untinted texture
+	const glm::vec3 H = glm::vec3(0.0f, -0.55f, 2.8f); //house anchor, yard origin
+
+	// debugging contrast
+	 /*const glm::vec4 DOOR  = glm::vec4(1,0,0,1);
+	 const glm::vec4 GLASS = glm::vec4(0,1,0,1);*/
+
+
+	 // --- global scene nudges---
+	const float YF = -4.0f;                // small yaw of the house node
+
+	// ---- common anchors & nudges ----
+
+	const float BODY_Z = +0.10f;
+	const float FRONT_Z = 1.26f;
+	const float EPS_Z = 0.04f;  // tiny forward nudge to avoid z-fighting
+	const float FASCIA_Z = FRONT_Z;  // fascia/trim sits at the front
+	const float ROOF_Z = 0.08f;    // how far forward the roof planes sit
+	const float ROOF_Y = 2.10f;
+	const float FASCIA_Y = 1.60f;    // fascia height
+	const float PORCH_Y = -1.35f;
+	const float STEP_Y = -1.52f;   // step height
+	const float CHIMNEY_X = 0.90f;
+	const float CHIMNEY_Z = -0.60f;
+	const float CHIMNEY_BASE_Y = ROOF_Y + 1.45f;
+	const float CHIMNEY_CAP_Y = CHIMNEY_BASE_Y + 0.95f;
+
+	// the yard sits at H and carries the trees and fence; the
+	// house is a child of the yard turned by YF, so its parts
+	// are placed relative to H and need no yaw of their own
+	SetParentNode(SceneGraph::INVALID_NODE);
+	SceneGraph::NODE_HANDLE yardNode = AddSceneNode(glm::vec3(1.0f), glm::vec3(0.0f), H);
+	SetParentNode(yardNode);
+	m_houseNode = AddSceneNode(glm::vec3(1.0f), glm::vec3(0.0f, YF, 0.0f), glm::vec3(0.0f));
+
+
+	// ---------- helper: untextured box with the house material ----------
+	auto DrawBox = [&](glm::vec3 s, glm::vec3 rDegXYZ, glm::vec3 p, glm::vec4 color)
+		{
+			AddDrawPacket(MESH_TYPE::Box, s, rDegXYZ, p, color, "house");
+		};
+
+	// trees and fences repeat across the scene, so they go
+	// into instance batches - one draw per shape for all of them
+	auto DrawTree = [&](glm::vec3 basePos, float trunkH, float trunkR, float crownH, float crownR)
+		{
+			// tree trunk - cool brown
+			AddInstance(MESH_TYPE::Cylinder,
+				glm::vec3(trunkR, trunkH, trunkR), glm::vec3(0.0f),
+				basePos + glm::vec3(0.0f, trunkH * 0.5f, 0.0f),
+				glm::vec4(0.35f, 0.30f, 0.28f, 1.0f), "house");
+
+			// foliage — slightly above trunk top, evergreen tone
+			glm::vec3 crownPos = basePos + glm::vec3(0.0f, trunkH + crownH * 0.5f, 0.0f);
+			AddInstance(MESH_TYPE::Cone,
+				glm::vec3(crownR, crownH, crownR), glm::vec3(0.0f),
+				crownPos,
+				glm::vec4(0.55f, 0.70f, 0.68f, 1.0f), "house");
+
+			// snowy cap 
+			AddInstance(MESH_TYPE::Cylinder,
+				glm::vec3(crownR * 0.55f, 0.08f, crownR * 0.55f), glm::vec3(0.0f),
+				basePos + glm::vec3(0.0f, trunkH + crownH - 0.02f, 0.0f),
+				glm::vec4(0.90f, 0.95f, 1.0f, 1.0f), "house");
+		};
+
+	auto DrawFenceLine = [&](glm::vec3 start, glm::vec3 dir, int posts, float spacing)
+		{
+			// two horizontal rails 
+			glm::vec3 mid = start + dir * (spacing * (posts - 1) * 0.5f);
+			// lower rail - desaturated wood/stone
+			AddInstance(MESH_TYPE::Box,
+				glm::vec3(spacing * posts, 0.05f, 0.12f), glm::vec3(0.0f),
+				mid + glm::vec3(0, -0.30f, 0),
+				glm::vec4(0.55f, 0.53f, 0.56f, 1.0f), "house");
+			// upper rail
+			AddInstance(MESH_TYPE::Box,
+				glm::vec3(spacing * posts, 0.05f, 0.12f), glm::vec3(0.0f),
+				mid + glm::vec3(0, 0.05f, 0),
+				glm::vec4(0.58f, 0.56f, 0.60f, 1.0f), "house");
+
+			// posts
+			for (int i = 0; i < posts; ++i)
+			{
+				glm::vec3 p = start + dir * (spacing * i);
+				AddInstance(MESH_TYPE::Box,
+					glm::vec3(0.10f, 0.60f, 0.10f), glm::vec3(0.0f),
+					p + glm::vec3(0, 0.15f, 0),
+					glm::vec4(0.50f, 0.48f, 0.52f, 1.0f), "house");
+			}
+		};
+
+	//// --- Mountain  ---
+	//auto DrawMountain = [&](glm::vec3 pos,
+	//	float baseRadius,
+	//	float height,
+	//	glm::vec4 bodyColor,
+	//	glm::vec4 capColor)
+	//	{
+	//		// body (cone)
+	//		AddDrawPacket(MESH_TYPE::Cone,
+	//			glm::vec3(baseRadius, height, baseRadius), glm::vec3(0.0f),
+	//			pos, bodyColor, "house");
+
+	//		// snow cap 
+	//		glm::vec3 capPos = pos + glm::vec3(0.0f, height * 0.75f, 0.0f);
+	//		AddDrawPacket(MESH_TYPE::Cylinder,
+	//			glm::vec3(baseRadius * 0.37f, 0.12f, baseRadius * 0.37f), glm::vec3(0.0f),
+	//			capPos, capColor, "house");
+	//	};
+
+
+
+	// nothing below moves once placed, so the draw packets are
+	// baked into static batches; the trees and fence are
+	// already instanced
+	SetStaticObjects(true);
+
+	// ---------------- BACKDROP / FLOOR ----------------
+	BeginPacketGroup("backdrop");
+	SetParentNode(SceneGraph::INVALID_NODE);
+
+	// Background wall - dusk purple
+	AddDrawPacket(MESH_TYPE::Plane,
+		/*scale*/     glm::vec3(60.0f, 1.0f, 40.0f),
+		/*rot XYZ*/   glm::vec3(90.0f, 0.0f, 0.0f),
+		/*position*/  glm::vec3(0.0f, 14.0f, -35.0f),
+		glm::vec4(0.28f, 0.22f, 0.42f, 1.0f), "house");
+
+	// Ground (flat, bluish snow)
+	AddDrawPacket(MESH_TYPE::Plane,
+		/*scale*/     glm::vec3(60.0f, 1.0f, 60.0f),
+		/*rot XYZ*/   glm::vec3(-90.0f, 0.0f, 0.0f),
+		/*position*/  glm::vec3(0.0f, -2.0f, 0.0f),
+		glm::vec4(0.80f, 0.88f, 0.98f, 1.0f), "snow");
+
+	// ---------------- HOUSE ----------------
+	BeginPacketGroup("house body");
+	SetParentNode(m_houseNode);
+
+	// --- HOUSE BODY (Brick, tiled) ---
+	AddDrawPacket(MESH_TYPE::Box,
+		glm::vec3(3.90f, 3.80f, 2.70f), glm::vec3(0.0f),
+		glm::vec3(0.0f, 0.0f, BODY_Z),
+		WHITE, "house", m_texBrick, glm::vec2(3.0f, 2.0f));
+
+	// --- LEFT BUMP-OUT (Brick, same tile) ---
+	AddDrawPacket(MESH_TYPE::Box,
+		glm::vec3(1.50f, 2.40f, 2.20f), glm::vec3(0.0f),
+		glm::vec3(-1.60f, -0.10f, 0.20f),
+		WHITE, "house", m_texBrick, glm::vec2(3.0f, 2.0f));
+
+
+	// Right front corner trim 
+	DrawBox(glm::vec3(0.06f, 3.80f, 0.06f),
+		glm::vec3(0.0f),
+		glm::vec3(+1.82f, 0.0f, FRONT_Z),   // on the front face
+		TRIM);
+
+	// Door
+	DrawBox(glm::vec3(0.86f, 1.52f, 0.08f),
+		glm::vec3(0.0f),
+		glm::vec3(0.00f, -0.55f, FRONT_Z + EPS_Z),
+		DOOR);
+
+	// Door frame 
+	DrawBox(glm::vec3(0.92f, 1.58f, 0.02f),
+		glm::vec3(0.0f),
+		glm::vec3(0.00f, -0.55f, FRONT_Z + EPS_Z + 0.02f),
+		TRIM);
+
+	// Left window (bump-out)
+	DrawBox(glm::vec3(0.62f, 0.62f, 0.05f),
+		glm::vec3(0.0f),
+		glm::vec3(-1.60f, 0.32f, FRONT_Z + EPS_Z),
+		GLASS);
+	DrawBox(glm::vec3(0.68f, 0.68f, 0.01f),
+		glm::vec3(0.0f),
+		glm::vec3(-1.60f, 0.32f, FRONT_Z + EPS_Z + 0.02f),
+		TRIM);
+
+	// Right window (body)
+	DrawBox(glm::vec3(0.70f, 0.92f, 0.05f),
+		glm::vec3(0.0f),
+		glm::vec3(+1.45f, 0.28f, FRONT_Z + EPS_Z),
+		GLASS);
+	DrawBox(glm::vec3(0.76f, 0.98f, 0.01f),
+		glm::vec3(0.0f),
+		glm::vec3(+1.45f, 0.28f, FRONT_Z + EPS_Z + 0.02f),
+		TRIM);
+
+	// ------------ ROOF ------------
+	BeginPacketGroup("roof");
+
+	// --- ROOF LEFT SLOPE ---
+	AddDrawPacket(MESH_TYPE::Box,
+		glm::vec3(1.95f, 0.25f, 3.05f), glm::vec3(0.0f, 0.0f, +30.0f),
+		glm::vec3(-0.78f, 3.00f, 0.06f),
+		WHITE, "house", m_texRoof, glm::vec2(3.0f, 2.0f));
+
+	// --- ROOF RIGHT SLOPE ---
+	AddDrawPacket(MESH_TYPE::Box,
+		glm::vec3(1.95f, 0.25f, 3.05f), glm::vec3(0.0f, 0.0f, -30.0f),
+		glm::vec3(+0.78f, 3.00f, 0.06f),
+		WHITE, "house", m_texRoof, glm::vec2(3.0f, 2.0f));
+
+
+
+	/// stack - turned -16 degrees in the world, under the house yaw
+	DrawBox(glm::vec3(0.45f, 1.10f, 0.45f),
+		glm::vec3(0.0f, -16.0f - YF, 0.0f),
+		glm::vec3(CHIMNEY_X, CHIMNEY_BASE_Y, CHIMNEY_Z),
+		TRIM);
+
+	// cap - light stone, square to the world
+	DrawBox(glm::vec3(0.60f, 0.12f, 0.60f),
+		glm::vec3(0.0f, -YF, 0.0f),
+		glm::vec3(CHIMNEY_X, CHIMNEY_CAP_Y, CHIMNEY_Z),
+		glm::vec4(0.86f, 0.86f, 0.92f, 1.0f));
+
+
+	// Front fascia
+	DrawBox(glm::vec3(3.80f, 0.07f, 0.10f),
+		glm::vec3(0.0f),
+		glm::vec3(0.0f, FASCIA_Y, FASCIA_Z),
+		TRIM);
+
+
+	// Porch slab (touches front wall)
+	BeginPacketGroup("house body");
+	DrawBox(glm::vec3(2.20f, 0.14f, 1.60f),
+		glm::vec3(0.0f),
+		glm::vec3(0.00f, PORCH_Y, FRONT_Z - 0.20f),  // slightly back so it tucks under
+		STONE);
+
+	// Step 
+	DrawBox(glm::vec3(1.70f, 0.12f, 0.75f),
+		glm::vec3(0.0f),
+		glm::vec3(0.00f, STEP_Y, FRONT_Z + 0.20f),
+		STONE);
+
+	//// MOUNTAIN 
+	//DrawMountain(
+	//	/*pos*/        glm::vec3(0.0f, 1.3f, -11.5f),
+	//	/*baseRadius*/ 7.0f,
+	//	/*height*/     4.2f,
+	//	/*body*/       glm::vec4(0.62f, 0.82f, 0.78f, 1.0f),
+	//	/*cap*/        glm::vec4(0.93f, 0.96f, 1.0f, 1.0f)
+	//);
+
+
+	// snow cap 
+	BeginPacketGroup("backdrop");
+	SetParentNode(SceneGraph::INVALID_NODE);
+	AddDrawPacket(MESH_TYPE::Cylinder,
+		glm::vec3(2.6f, 0.12f, 2.6f), glm::vec3(0.0f),
+		glm::vec3(0.0f, 3.15f, -11.5f),
+		glm::vec4(0.93f, 0.96f, 1.0f, 1.0f), "house");
+
+	// TREES
+	BeginPacketGroup("trees");
+	SetParentNode(yardNode);
+	DrawTree(/*base*/ glm::vec3(-3.8f, -1.9f, 1.6f),  /*trunkH*/ 1.0f, /*trunkR*/ 0.18f,
+		/*crownH*/ 1.4f, /*crownR*/ 0.9f);
+
+	DrawTree(/*base*/ glm::vec3(+3.6f, -1.95f, 1.4f), /*trunkH*/ 0.9f, /*trunkR*/ 0.17f,
+		/*crownH*/ 1.2f, /*crownR*/ 0.8f);
+
+
+	// FENCE — short straight run in front, centered on house
+	BeginPacketGroup("fence");
+	glm::vec3 fenceStart = glm::vec3(-4.5f, -1.85f, 2.25f);
+	glm::vec3 fenceDir = glm::normalize(glm::vec3(1, 0, 0));
+	DrawFenceLine(fenceStart, fenceDir, /*posts*/ 10, /*spacing*/ 0.95f);
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  walking the retained draw list built in PrepareScene()
+ *  in sorted order.  The opaque packets go first, then the
+ *  static and instance batches, and the translucent packets
+ *  last.  Only the scene graph nodes that moved and the
+ *  packets marked dynamic are re-evaluated, and draws
+ *  outside the view frustum are skipped.  On the GPU-driven
+ *  path the same draws go out as a few multi-draw indirect
+ *  calls.  With a profiler set, each object group is timed
+ *  as a scope.
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	TRACE_SCOPE("render");
+
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	m_frameDrawCalls = 0;
+	m_profiledGroup = INVALID_HANDLE;
+	m_bSceneChanged = false;
+
+	// bring in the textures that finished decoding, a few per frame
+	m_pTextureLoader->PumpUploads();
+
+	// pick up the scene graph nodes moved since the last frame
+	UpdateSceneTransforms();
+
+	// re-evaluate the packets that can change between frames
+	for (auto& dynamicPacket : m_dynamicPackets)
+	{
+		dynamicPacket.second(m_drawPackets[dynamicPacket.first]);
+		UpdateDrawableBounds(m_drawPackets[dynamicPacket.first].nodeID);
+	}
+
+	// skip everything outside the view frustum
+	{
+		TRACE_SCOPE("CullDraws");
+		CullDraws();
+	}
+
+	// coarser curved shapes in the distance, then send the
+	// instances that moved or changed level and re-bake the
+	// static batches that moved
+	{
+		TRACE_SCOPE("SelectLevelsOfDetail");
+		SelectLevelsOfDetail();
+	}
+	UploadInstanceBatches();
+	BakeStaticBatches();
+
+	{
+		TRACE_SCOPE("SortDrawQueue");
+		SortDrawQueue();
+	}
+
+	// the GPU-driven path issues the same draws from buffers
+	if ((NULL != m_pIndirectRenderer) && SubmitSceneIndirect())
+	{
+		EnterProfileGroup(INVALID_HANDLE);
+		return;
+	}
+
+	// opaque packets, grouped by state and front-to-back
+	size_t item = 0;
+	for (; item < m_drawQueue.size(); item++)
+	{
+		if (m_drawQueue[item].sortKey & SORT_TRANSLUCENT_BIT)
+		{
+			break;
+		}
+		const DRAW_PACKET& packet = m_drawPackets[m_drawQueue[item].packetIndex];
+		EnterProfileGroup(packet.groupID);
+		SubmitDrawPacket(packet);
+	}
+
+	// the immovable objects, one merged draw per group and texture
+	m_pStateCache->SetBoolValue(m_uniforms.useBakedVertices, true);
+	for (uint32_t batchIndex : m_visibleStaticBatches)
+	{
+		const STATIC_BATCH& batch = m_staticBatches[batchIndex];
+		EnterProfileGroup(batch.groupID);
+		SubmitStaticBatch(batch);
+	}
+	m_pStateCache->SetBoolValue(m_uniforms.useBakedVertices, false);
+
+	// the repeated objects go out with one draw per batch
+	m_pStateCache->SetBoolValue(m_uniforms.useInstancing, true);
+	for (uint32_t batchIndex : m_visibleBatches)
+	{
+		const INSTANCE_BATCH& batch = m_instanceBatches[batchIndex];
+		EnterProfileGroup(batch.groupID);
+		SubmitInstanceBatch(batch);
+	}
+	m_pStateCache->SetBoolValue(m_uniforms.useInstancing, false);
+
+	// translucent packets, back-to-front over everything
+	// opaque, timed as one since their groups are interleaved
+	for (; item < m_drawQueue.size(); item++)
+	{
+		const DRAW_PACKET& packet = m_drawPackets[m_drawQueue[item].packetIndex];
+		EnterProfileGroup(TRANSLUCENT_PROFILE_GROUP);
+		SubmitDrawPacket(packet);
+	}
+
+	EnterProfileGroup(INVALID_HANDLE);
+}
@@ -1,114 +1,486 @@
-///////////////////////////////////////////////////////////////////////////////
-// shadermanager.h
-// ============
-// manage the loading and rendering of 3D scenes
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#pragma once
-
-#include "ShaderManager.h"
-#include "ShapeMeshes.h"
-
-#include <string>
-#include <vector>
-
-/***********************************************************
- *  SceneManager
- *
- *  This class contains the code for preparing and rendering
- *  3D scenes, including the shader settings.
- ***********************************************************/
-class SceneManager
-{
-public:
-	// constructor
-	SceneManager(ShaderManager *pShaderManager);
-	// destructor
-	~SceneManager();
-
-	struct TEXTURE_INFO
-	{
-		std::string tag;
-		uint32_t ID;
-	};
-
-	struct OBJECT_MATERIAL
-	{
-		float ambientStrength;
-		glm::vec3 ambientColor;
-		glm::vec3 diffuseColor;
-		glm::vec3 specularColor;
-		float shininess;
-		std::string tag;
-	};
-
-private:
-	// --- Texture handles for the house ---
-	GLuint m_texBrick = 0;
-	GLuint m_texRoof = 0;
-	void DefineObjectMaterials();
-	void SetupSceneLights();
-	GLuint LoadTexture2D(const char* path, bool flipY = true);
-
-	// pointer to shader manager object
-	ShaderManager* m_pShaderManager;
-	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
-	// defined object materials
-	std::vector<OBJECT_MATERIAL> m_objectMaterials;
-
-	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
-	// bind loaded OpenGL textures to slots in memory
-	void BindGLTextures();
-	// free the loaded OpenGL textures
-	void DestroyGLTextures();
-	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
-	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
-
-	// set the transformation values 
-	// into the transform buffer
-	void SetTransformations(
-		glm::vec3 scaleXYZ,
-		float XrotationDegrees,
-		float YrotationDegrees,
-		float ZrotationDegrees,
-		glm::vec3 positionXYZ);
-
-	// set the color values into the shader
-	void SetShaderColor(
-		float redColorValue,
-		float greenColorValue,
-		float blueColorValue,
-		float alphaValue);
-
-	// set the texture data into the shader
-	void SetShaderTexture(
-		std::string textureTag);
-
-	// set the UV scale for the texture mapping
-	void SetTextureUVScale(
-		float u, float v);
-
-	// set the object material into the shader
-	void SetShaderMaterial(
-		std::string materialTag);
-
-public:
-
-	// The following methods are for the students to 
-	// customize for their own 3D scene
-	void PrepareScene();
-	void RenderScene();
-
+///////////////////////////////////////////////////////////////////////////////
+// shadermanager.h
+// ============
+// manage the loading and rendering of 3D scenes
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "BoundingVolumeHierarchy.h"
+#include "FrustumCuller.h"
+#include "LodSelector.h"
+#include "GLStateCache.h"
+#include "GpuProfiler.h"
+#include "IndirectRenderer.h"
+#include "JobSystem.h"
+#include "ShaderManager.h"
+#include "SceneGraph.h"
+#include "ShapeMeshes.h"
+#include "TextureLoader.h"
+#include "UniformBlocks.h"
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <unordered_map>
+
+/***********************************************************
+ *  SceneManager
+ *
+ *  This class contains the code for preparing and rendering
+ *  3D scenes, including the shader settings.
+ ***********************************************************/
+class SceneManager
+{
+public:
+	// constructor
+	SceneManager(ShaderManager *pShaderManager, GLStateCache* pStateCache);
+	// destructor
+	~SceneManager();
+
+	// compact handles returned when a material or texture is
+	// registered - looking one up is an array index
+	typedef int MATERIAL_HANDLE;
+	typedef int TEXTURE_HANDLE;
+	static const int INVALID_HANDLE = -1;
+
+	struct TEXTURE_INFO
+	{
+		std::string tag;
+		uint32_t ID;
+	};
+
+	struct OBJECT_MATERIAL
+	{
+		float ambientStrength;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+		std::string tag;
+	};
+
+	// basic shape meshes that a draw packet can reference
+	enum class MESH_TYPE
+	{
+		Box,
+		Plane,
+		Cylinder,
+		Cone,
+		Prism
+	};
+
+	// everything needed to issue one draw of a basic shape,
+	// resolved once so the per-frame render only walks a list
+	struct DRAW_PACKET
+	{
+		MESH_TYPE mesh;
+		glm::mat4 model;
+		MATERIAL_HANDLE materialID;	// INVALID_HANDLE for none
+		GLuint textureID;	// OpenGL texture, 0 when untextured
+		glm::vec4 color;
+		glm::vec2 uvScale;
+		int groupID;		// profiler group, INVALID_HANDLE for none
+		SceneGraph::NODE_HANDLE nodeID;	// node the model matrix comes from
+		int lodLevel;		// level of detail of a curved shape
+		bool bStatic;		// never moves, so it can be baked
+		int staticBatch;	// INVALID_HANDLE when drawn on its own
+	};
+
+	// callback used to re-evaluate a dynamic draw packet each frame
+	typedef std::function<void(DRAW_PACKET& packet)> PACKET_UPDATER;
+
+	// many untextured objects sharing one shape and material,
+	// issued with a single instanced draw call
+	struct INSTANCE_BATCH
+	{
+		MESH_TYPE mesh;
+		MATERIAL_HANDLE materialID;	// INVALID_HANDLE for none
+		int groupID;		// profiler group, INVALID_HANDLE for none
+		std::vector<ShapeMeshes::INSTANCE_DATA> instances;
+		GLuint instanceBuffer;
+		bool bNeedsUpload;	// an instance model or level changed since the last upload
+		// level of detail and drawable of each instance
+		std::vector<int> instanceLods;
+		std::vector<uint32_t> instanceDrawables;
+		// instances in view this frame, and the ones the
+		// instance buffer holds, in ascending order
+		std::vector<uint32_t> visibleInstances;
+		std::vector<uint32_t> uploadedInstances;
+		// range of the instance buffer drawn at each level, the
+		// buffer holds the visible instances ordered by level
+		GLint lodFirst[LodSelector::LEVEL_COUNT];
+		GLsizei lodCounts[LodSelector::LEVEL_COUNT];
+	};
+
+	// static opaque draw packets of one object group and
+	// texture, baked into world space and merged into one mesh
+	// whose visible packets are drawn with a single call
+	struct STATIC_BATCH
+	{
+		GLuint textureID;	// OpenGL texture, 0 when untextured
+		int groupID;		// profiler group, INVALID_HANDLE for none
+		std::vector<size_t> packetIndices;
+		// indices of the merged mesh each packet was baked into,
+		// in the order of packetIndices
+		std::vector<GLuint> packetFirstIndices;
+		std::vector<GLsizei> packetIndexCounts;
+		// index ranges of the packets in view this frame, with
+		// neighbouring ranges joined, as counts and byte offsets
+		std::vector<GLsizei> drawCounts;
+		std::vector<const void*> drawOffsets;
+		ShapeMeshes::BAKED_MESH mesh;
+		bool bNeedsBake;	// a packet moved since the last bake
+	};
+
+private:
+	// the micro-benchmarks time the private per-draw paths
+	friend class SceneManagerBenchmark;
+
+	// the draw packet or instance that takes its model matrix
+	// from a scene graph node, indexed by node handle.  Nodes
+	// that only carry their children have neither.
+	struct NODE_DRAW
+	{
+		int packetIndex;	// INVALID_HANDLE when not a draw packet
+		int batchIndex;		// INVALID_HANDLE when not an instance
+		int instanceIndex;
+		int drawableIndex;	// INVALID_HANDLE when the node draws nothing
+	};
+
+	// one entry of the per-frame draw queue - the packet index
+	// ordered by a key built from its render state and depth
+	struct DRAW_ITEM
+	{
+		uint64_t sortKey;
+		size_t packetIndex;
+	};
+
+	// shader uniform handles used while preparing and rendering,
+	// resolved once so the draw path never passes names
+	struct SCENE_UNIFORMS
+	{
+		ShaderManager::UNIFORM_HANDLE model;
+		ShaderManager::UNIFORM_HANDLE objectColor;
+		ShaderManager::UNIFORM_HANDLE objectTexture;
+		ShaderManager::UNIFORM_HANDLE useTexture;
+		ShaderManager::UNIFORM_HANDLE useLighting;
+		ShaderManager::UNIFORM_HANDLE useInstancing;
+		ShaderManager::UNIFORM_HANDLE useBakedVertices;
+		ShaderManager::UNIFORM_HANDLE useObjectBuffer;
+		ShaderManager::UNIFORM_HANDLE uvScale;
+		ShaderManager::UNIFORM_HANDLE materialIndex;
+	};
+
+	// --- Texture handles for the house ---
+	GLuint m_texBrick = 0;
+	GLuint m_texRoof = 0;
+	void ResolveUniformHandles();
+	void DefineObjectMaterials();
+	void SetupSceneLights();
+	GLuint LoadTexture2D(const char* path, bool flipY = true);
+
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+	// pointer to the OpenGL state cache that skips redundant calls
+	GLStateCache* m_pStateCache;
+	// resolved shader uniform handles
+	SCENE_UNIFORMS m_uniforms;
+	// uniform buffers holding the light sources and the material table
+	GLuint m_lightBuffer;
+	GLuint m_materialBuffer;
+	// pointer to basic shapes object
+	ShapeMeshes* m_basicMeshes;
+	// pointer to the background texture loader
+	TextureLoader* m_pTextureLoader;
+	// loaded textures info, indexed by texture handle
+	std::vector<TEXTURE_INFO> m_textureIDs;
+	// defined object materials, indexed by material handle
+	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// handles of the loaded textures and defined materials by tag
+	std::unordered_map<std::string, TEXTURE_HANDLE> m_textureHandles;
+	std::unordered_map<std::string, MATERIAL_HANDLE> m_materialHandles;
+	// retained list of draws compiled in PrepareScene()
+	std::vector<DRAW_PACKET> m_drawPackets;
+	// draw packets that are re-evaluated every frame
+	std::vector<std::pair<size_t, PACKET_UPDATER>> m_dynamicPackets;
+	// repeated objects drawn with instancing
+	std::vector<INSTANCE_BATCH> m_instanceBatches;
+	// immovable objects baked into merged meshes
+	std::vector<STATIC_BATCH> m_staticBatches;
+	// generated shape data the static batches are baked from,
+	// indexed by mesh type
+	std::vector<ShapeMeshes::MESH_DATA> m_staticMeshData;
+	// scratch buffers reused by every bake
+	std::vector<ShapeMeshes::BAKED_VERTEX> m_bakedVertices;
+	std::vector<GLuint> m_bakedIndices;
+	// whether the draw packets being added are static
+	bool m_bAddStatic;
+	// GPU-driven draw path, NULL while it is not in use
+	IndirectRenderer* m_pIndirectRenderer;
+	// every shape in the shared mesh arena, indexed by mesh
+	// type and then level of detail
+	std::vector<ShapeMeshes::ARENA_MESH> m_arenaMeshes;
+	// texture and object group of the GPU-driven draws queued
+	// since the last flush
+	GLuint m_indirectTexture;
+	int m_indirectGroup;
+	// draw packets in submission order, rebuilt every frame
+	std::vector<DRAW_ITEM> m_drawQueue;
+	// camera position used for the depth part of the sort key
+	glm::vec3 m_cameraPosition;
+	// view frustum the draws are culled against, once it is set
+	FrustumCuller::FRUSTUM m_frustum;
+	bool m_bFrustumSet;
+	// node and world bounds of every packet and instance,
+	// indexed by drawable
+	std::vector<SceneGraph::NODE_HANDLE> m_drawableNodes;
+	BOUNDS_ARRAYS m_drawableBounds;
+	// drawables whose bounds changed since the index was refit
+	std::vector<uint32_t> m_movedDrawables;
+	// spatial index over the drawable bounds
+	BoundingVolumeHierarchy m_spatialIndex;
+	// drawables, packets and batches that passed the culling
+	// this frame
+	std::vector<uint32_t> m_visibleDrawables;
+	// drawables each slice kept when the culling is split
+	// over the job system
+	std::vector<std::vector<uint32_t>> m_sliceVisible;
+	std::vector<uint32_t> m_visiblePackets;
+	std::vector<uint32_t> m_visibleBatches;
+	std::vector<bool> m_batchVisible;
+	std::vector<uint32_t> m_visibleStaticBatches;
+	// baked packets in view this frame, indexed by packet
+	std::vector<bool> m_bakedPacketVisible;
+	// chooses the level of detail of the curved shapes
+	LodSelector m_lodSelector;
+	// visible instances of a batch ordered by level of detail
+	// for an upload
+	std::vector<ShapeMeshes::INSTANCE_DATA> m_lodInstances;
+	// draw calls issued by the last RenderScene()
+	unsigned int m_frameDrawCalls;
+	// optional profiler timing each object group
+	GpuProfiler* m_pProfiler;
+	// optional job system the per-frame work is split over
+	JobSystem* m_pJobSystem;
+	// names of the object groups, indexed by group ID
+	std::vector<std::string> m_packetGroups;
+	// group assigned to the packets and instances being added
+	int m_currentGroup;
+	// group whose profiler scope is open during RenderScene()
+	int m_profiledGroup;
+	// transform hierarchy every packet and instance hangs off
+	SceneGraph m_sceneGraph;
+	// what each scene graph node draws, indexed by node handle
+	std::vector<NODE_DRAW> m_nodeDraws;
+	// parent of the packets and instances being added
+	SceneGraph::NODE_HANDLE m_currentParent;
+	// node carrying the house and its parts
+	SceneGraph::NODE_HANDLE m_houseNode;
+	// lights or materials changed since the last RenderScene()
+	bool m_bSceneChanged;
+
+	// load texture images and convert to OpenGL texture data
+	TEXTURE_HANDLE CreateGLTexture(const char* filename, const std::string& tag);
+	// bind loaded OpenGL textures to slots in memory
+	void BindGLTextures();
+	// free the loaded OpenGL textures
+	void DestroyGLTextures();
+	// find a loaded texture by tag
+	int FindTextureID(const std::string& tag) const;
+	TEXTURE_HANDLE FindTextureSlot(const std::string& tag) const;
+	// add a material to the defined materials, or replace the
+	// material already defined with the same tag
+	MATERIAL_HANDLE AddObjectMaterial(const OBJECT_MATERIAL& material);
+	// find a defined material by tag
+	bool FindMaterial(const std::string& tag, OBJECT_MATERIAL& material) const;
+	// find the handle of a defined material by tag
+	MATERIAL_HANDLE FindMaterialIndex(const std::string& tag) const;
+
+	// build the model matrix from the passed in transformation values
+	glm::mat4 BuildModelMatrix(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// set the transformation values 
+	// into the transform buffer
+	void SetTransformations(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// set the color values into the shader
+	void SetShaderColor(
+		float redColorValue,
+		float greenColorValue,
+		float blueColorValue,
+		float alphaValue);
+
+	// set the texture data into the shader
+	void SetShaderTexture(
+		const std::string& textureTag);
+
+	// set the UV scale for the texture mapping
+	void SetTextureUVScale(
+		float u, float v);
+
+	// set the object material into the shader
+	void SetShaderMaterial(
+		const std::string& materialTag);
+	void SetShaderMaterial(
+		MATERIAL_HANDLE materialID);
+	// send the defined materials to the material storage buffer
+	void UploadMaterialTable();
+
+	// add a draw packet to the retained draw list
+	size_t AddDrawPacket(
+		MESH_TYPE mesh,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegreesXYZ,
+		glm::vec3 positionXYZ,
+		glm::vec4 color,
+		const std::string& materialTag,
+		GLuint textureID = 0,
+		glm::vec2 uvScale = glm::vec2(1.0f, 1.0f));
+	// mark a draw packet to be re-evaluated every frame
+	void MarkPacketDynamic(size_t packetIndex, PACKET_UPDATER updater);
+	// add one object to the instance batch for its shape and material
+	void AddInstance(
+		MESH_TYPE mesh,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegreesXYZ,
+		glm::vec3 positionXYZ,
+		glm::vec4 color,
+		const std::string& materialTag);
+	// start a named object group for the objects added next
+	void BeginPacketGroup(const std::string& name);
+	// set whether the draw packets added next never move
+	void SetStaticObjects(bool bStatic);
+	// add a scene graph node under the current parent
+	SceneGraph::NODE_HANDLE AddSceneNode(
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegreesXYZ,
+		glm::vec3 positionXYZ);
+	// set the parent node of the objects added next
+	void SetParentNode(SceneGraph::NODE_HANDLE node);
+	// register the packet or instance of a node as a drawable
+	void AddDrawable(SceneGraph::NODE_HANDLE node);
+	// copy the recomputed world matrices into the draws
+	void UpdateSceneTransforms();
+	// recompute the world bounds of the drawable of a node
+	void UpdateDrawableBounds(SceneGraph::NODE_HANDLE node);
+	// recompute the world bounds of a node without queuing
+	// the refit, safe to run for different nodes at once
+	void ComputeDrawableBounds(SceneGraph::NODE_HANDLE node);
+	// run a loop body over [0, count) in ranges, on the job
+	// system when there is one
+	void ForEachRange(size_t count, size_t grainSize, const JobSystem::RANGE_FUNCTION& function);
+	// bring the spatial index up to date with the moved drawables
+	void UpdateSpatialIndex();
+	// cull the packets and batches against the view frustum
+	void CullDraws();
+	// choose the level of detail of the visible curved shapes
+	void SelectLevelsOfDetail();
+	// send the instance batches to GPU memory
+	void UploadInstanceBatches();
+	// free the GPU memory used by the instance batches
+	void DestroyInstanceBatches();
+	// group the static packets into static batches and bake them
+	void BuildStaticBatches();
+	// bake the static batches whose packets moved
+	void BakeStaticBatches();
+	// free the GPU memory used by the static batches
+	void DestroyStaticBatches();
+	// compile the scene objects into the retained draw list
+	void BuildDrawPackets();
+	// build the sort key of a draw packet for the current camera
+	uint64_t BuildSortKey(const DRAW_PACKET& packet) const;
+	// order the draw packets for submission
+	void SortDrawQueue();
+	// close the open profiler scope when the object group changes
+	void EnterProfileGroup(int groupID);
+	// issue the draw commands for one draw packet
+	void SubmitDrawPacket(const DRAW_PACKET& packet);
+	// issue the instanced draw command for one instance batch
+	void SubmitInstanceBatch(const INSTANCE_BATCH& batch);
+	// issue the draw command for one static batch
+	void SubmitStaticBatch(const STATIC_BATCH& batch);
+	// queue one object for the GPU-driven path, drawing the
+	// objects queued before it when the render state changes
+	void QueueIndirectObject(
+		MESH_TYPE mesh,
+		int lodLevel,
+		const glm::mat4& model,
+		const glm::vec4& color,
+		const glm::vec2& uvScale,
+		MATERIAL_HANDLE materialID,
+		GLuint textureID,
+		int groupID,
+		int drawable,
+		bool bKeepOrder);
+	// draw the objects queued for the GPU-driven path
+	void FlushIndirectObjects();
+	// issue the whole visible scene through the GPU-driven
+	// path, returns false when the path had to be turned off
+	bool SubmitSceneIndirect();
+
+public:
+
+	// The following methods are for the students to 
+	// customize for their own 3D scene
+	void PrepareScene();
+	void RenderScene();
+
+	// set the camera position used to order the draws by depth
+	void SetCameraPosition(const glm::vec3& cameraPosition);
+	// set projection * view, which the draws are culled against
+	void SetViewFrustum(const glm::mat4& projectionView);
+	// set the projection the levels of detail are chosen against
+	void SetLodProjection(const glm::mat4& projection);
+	// get the number of draw calls issued by the last render
+	unsigned int GetLastFrameDrawCalls() const;
+	// check whether requested textures are still loading
+	bool AreTexturesLoading() const;
+	// check whether the scene could look different from the
+	// last render even with the camera unchanged
+	bool HasSceneChanged() const;
+	// time the object groups with a profiler, or NULL for none
+	void SetProfiler(GpuProfiler* pProfiler);
+	// split the per-frame CPU work over a job system, or
+	// NULL to do it all on the render thread
+	void SetJobSystem(JobSystem* pJobSystem);
+	// draw the scene with multi-draw indirect calls from
+	// persistently mapped buffers, returns false when the
+	// context does not support it
+	bool SetGpuDrivenRendering(bool bEnabled);
+	// cull the GPU-driven draws with a compute program on the
+	// GPU, 0 to cull them on the CPU, returns false when the
+	// context does not support it
+	bool SetGpuCulling(GLuint cullProgram);
+	// get the scene graph, to move nodes between frames
+	SceneGraph& GetSceneGraph();
+	// get the node the house and its parts hang off
+	SceneGraph::NODE_HANDLE GetHouseNode() const;
+	// find the node of the nearest object whose bounds a ray
+	// hits, or SceneGraph::INVALID_NODE when none is hit
+	SceneGraph::NODE_HANDLE PickNode(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float maxDistance,
+		float& distance) const;
+	// list the nodes of the objects whose bounds overlap a box
+	void FindNodesInBox(
+		const glm::vec3& boxMin,
+		const glm::vec3& boxMax,
+		std::vector<SceneGraph::NODE_HANDLE>& nodes) const;
+
 };
\ No newline at end of file
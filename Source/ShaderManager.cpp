@@ -0,0 +1,477 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadermanager.cpp
+// ============
+// manage the loading of the GLSL shader code and the passing of values
+// into the shader uniforms
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderManager.h"
+#include "RenderStats.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+/***********************************************************
+ *  ShaderManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderManager::ShaderManager()
+{
+	m_programID = 0;
+}
+
+/***********************************************************
+ *  ~ShaderManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderManager::~ShaderManager()
+{
+	if (!m_uniformBuffers.empty())
+	{
+		glDeleteBuffers((GLsizei)m_uniformBuffers.size(), m_uniformBuffers.data());
+		m_uniformBuffers.clear();
+	}
+
+	for (GLuint program : m_computePrograms)
+	{
+		glDeleteProgram(program);
+	}
+	m_computePrograms.clear();
+
+	if (m_programID != 0)
+	{
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+	}
+}
+
+/***********************************************************
+ *  ReadShaderFile()
+ *
+ *  This method is used for reading the source code of a
+ *  shader from the passed in file.
+ ***********************************************************/
+bool ShaderManager::ReadShaderFile(const char* filePath, std::string& shaderCode)
+{
+	std::ifstream shaderFile(filePath);
+
+	if (!shaderFile.is_open())
+	{
+		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << filePath << std::endl;
+		return(false);
+	}
+
+	std::stringstream shaderStream;
+	shaderStream << shaderFile.rdbuf();
+	shaderCode = shaderStream.str();
+
+	return(true);
+}
+
+/***********************************************************
+ *  CompileShader()
+ *
+ *  This method is used for compiling one shader stage and
+ *  reporting any compile errors.  Zero is returned when the
+ *  shader fails to compile.
+ ***********************************************************/
+GLuint ShaderManager::CompileShader(GLenum shaderType, const std::string& shaderCode, const char* filePath)
+{
+	const char* source = shaderCode.c_str();
+	GLint success = 0;
+	GLuint shader = glCreateShader(shaderType);
+
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		GLchar infoLog[1024];
+		glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+		std::cout << "ERROR::SHADER_COMPILATION_ERROR in " << filePath << "\n" << infoLog << std::endl;
+		glDeleteShader(shader);
+		return(0);
+	}
+
+	return(shader);
+}
+
+/***********************************************************
+ *  LoadShaders()
+ *
+ *  This method is used for loading, compiling and linking
+ *  the vertex and fragment shaders into the shader program.
+ *  The uniform locations are cached once linking succeeds.
+ ***********************************************************/
+GLuint ShaderManager::LoadShaders(const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+	std::string vertexCode;
+	std::string fragmentCode;
+
+	if (!ReadShaderFile(vertexShaderPath, vertexCode) ||
+		!ReadShaderFile(fragmentShaderPath, fragmentCode))
+	{
+		return(0);
+	}
+
+	GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexCode, vertexShaderPath);
+	GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentCode, fragmentShaderPath);
+
+	if ((vertexShader == 0) || (fragmentShader == 0))
+	{
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		return(0);
+	}
+
+	GLuint shaders[2] = { vertexShader, fragmentShader };
+	GLuint program = LinkProgram(shaders, 2);
+	if (program == 0)
+	{
+		return(0);
+	}
+
+	if (m_programID != 0)
+	{
+		glDeleteProgram(m_programID);
+	}
+	m_programID = program;
+
+	CacheUniformLocations();
+
+	return(m_programID);
+}
+
+/***********************************************************
+ *  LoadComputeShader()
+ *
+ *  This method is used for loading, compiling and linking a
+ *  compute shader into a program of its own.  The program
+ *  does not replace the shader program; it is kept until
+ *  the manager is destroyed.
+ ***********************************************************/
+GLuint ShaderManager::LoadComputeShader(const char* computeShaderPath)
+{
+	std::string computeCode;
+
+	if (!ReadShaderFile(computeShaderPath, computeCode))
+	{
+		return(0);
+	}
+
+	GLuint computeShader = CompileShader(GL_COMPUTE_SHADER, computeCode, computeShaderPath);
+	if (computeShader == 0)
+	{
+		return(0);
+	}
+
+	GLuint program = LinkProgram(&computeShader, 1);
+	if (program != 0)
+	{
+		m_computePrograms.push_back(program);
+	}
+
+	return(program);
+}
+
+/***********************************************************
+ *  LinkProgram()
+ *
+ *  This method is used for linking compiled shader stages
+ *  into a program and reporting any link errors.  The
+ *  stages are deleted either way, and zero is returned when
+ *  the program fails to link.
+ ***********************************************************/
+GLuint ShaderManager::LinkProgram(const GLuint* shaders, int shaderCount)
+{
+	GLuint program = glCreateProgram();
+	for (int i = 0; i < shaderCount; i++)
+	{
+		glAttachShader(program, shaders[i]);
+	}
+	glLinkProgram(program);
+
+	// the shaders are no longer needed once linked into the program
+	for (int i = 0; i < shaderCount; i++)
+	{
+		glDeleteShader(shaders[i]);
+	}
+
+	GLint success = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		GLchar infoLog[1024];
+		glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+		std::cout << "ERROR::PROGRAM_LINKING_ERROR\n" << infoLog << std::endl;
+		glDeleteProgram(program);
+		return(0);
+	}
+
+	return(program);
+}
+
+/***********************************************************
+ *  CacheUniformLocations()
+ *
+ *  This method is used for resolving the location of every
+ *  active uniform in the linked program into the uniform
+ *  cache.  Array uniforms are registered under both their
+ *  "name[0]" and "name" spellings.
+ ***********************************************************/
+void ShaderManager::CacheUniformLocations()
+{
+	GLint uniformCount = 0;
+	GLint maxNameLength = 0;
+
+	m_uniformCache.clear();
+
+	glGetProgramiv(m_programID, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(m_programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<GLchar> nameBuffer(maxNameLength + 1);
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLint size = 0;
+		GLenum type = 0;
+		GLsizei length = 0;
+
+		glGetActiveUniform(m_programID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+
+		std::string name(nameBuffer.data(), length);
+		GLint location = glGetUniformLocation(m_programID, name.c_str());
+
+		// uniforms inside uniform blocks have no location
+		if (location < 0)
+		{
+			continue;
+		}
+
+		m_uniformCache[name] = location;
+
+		// allow arrays of basic types to be set without the [0]
+		if ((name.size() > 3) && (name.compare(name.size() - 3, 3, "[0]") == 0))
+		{
+			m_uniformCache[name.substr(0, name.size() - 3)] = location;
+		}
+	}
+}
+
+/***********************************************************
+ *  use()
+ *
+ *  This method is used for making the shader program the
+ *  active program for the following draw commands.
+ ***********************************************************/
+void ShaderManager::use()
+{
+	glUseProgram(m_programID);
+	RenderStats::CountProgramBind();
+}
+
+/***********************************************************
+ *  GetUniformHandle()
+ *
+ *  This method is used for getting the handle of a uniform
+ *  from the uniform cache.  Names that are not active in the
+ *  program are remembered with a handle of -1, which the
+ *  setters silently ignore, the same as OpenGL does.
+ ***********************************************************/
+ShaderManager::UNIFORM_HANDLE ShaderManager::GetUniformHandle(const std::string& name)
+{
+	auto found = m_uniformCache.find(name);
+	if (found != m_uniformCache.end())
+	{
+		return(found->second);
+	}
+
+	UNIFORM_HANDLE handle = glGetUniformLocation(m_programID, name.c_str());
+	m_uniformCache[name] = handle;
+
+	return(handle);
+}
+
+/***********************************************************
+ *  CreateUniformBuffer()
+ *
+ *  This method is used for creating a uniform buffer object
+ *  of the passed in size and attaching it to a uniform block
+ *  binding point.  The shaders declare the matching binding
+ *  in the layout of each uniform block.
+ ***********************************************************/
+GLuint ShaderManager::CreateUniformBuffer(GLuint bindingPoint, GLsizeiptr size)
+{
+	GLuint uniformBuffer = 0;
+
+	glGenBuffers(1, &uniformBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, uniformBuffer);
+
+	m_uniformBuffers.push_back(uniformBuffer);
+
+	return(uniformBuffer);
+}
+
+/***********************************************************
+ *  UpdateUniformBuffer()
+ *
+ *  This method is used for replacing part of the contents
+ *  of a uniform buffer object.
+ ***********************************************************/
+void ShaderManager::UpdateUniformBuffer(GLuint uniformBuffer, GLintptr offset, GLsizeiptr size, const void* data) const
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+	RenderStats::CountBufferUpload((size_t)size);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/***********************************************************
+ *  CreateStorageBuffer()
+ *
+ *  This method is used for creating an empty shader storage
+ *  buffer object and attaching it to a buffer block binding
+ *  point.  Unlike a uniform block, the block in the shader
+ *  can end in an unsized array, so the buffer can hold any
+ *  number of entries.
+ ***********************************************************/
+GLuint ShaderManager::CreateStorageBuffer(GLuint bindingPoint)
+{
+	GLuint storageBuffer = 0;
+
+	glGenBuffers(1, &storageBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, storageBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, 0, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, storageBuffer);
+
+	m_uniformBuffers.push_back(storageBuffer);
+
+	return(storageBuffer);
+}
+
+/***********************************************************
+ *  UpdateStorageBuffer()
+ *
+ *  This method is used for replacing the whole contents of
+ *  a shader storage buffer object.  The buffer takes the new
+ *  size, and stays attached to its binding point.
+ ***********************************************************/
+void ShaderManager::UpdateStorageBuffer(GLuint storageBuffer, GLsizeiptr size, const void* data) const
+{
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, storageBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_DRAW);
+	RenderStats::CountBufferUpload((size_t)size);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Handle setters
+ *
+ *  These methods are used for setting uniform values through
+ *  a handle that was resolved ahead of time.
+ ***********************************************************/
+void ShaderManager::setBoolValue(UNIFORM_HANDLE handle, bool value) const
+{
+	glUniform1i(handle, (int)value);
+	RenderStats::CountUniformWrite();
+}
+
+void ShaderManager::setIntValue(UNIFORM_HANDLE handle, int value) const
+{
+	glUniform1i(handle, value);
+	RenderStats::CountUniformWrite();
+}
+
+void ShaderManager::setFloatValue(UNIFORM_HANDLE handle, float value) const
+{
+	glUniform1f(handle, value);
+	RenderStats::CountUniformWrite();
+}
+
+void ShaderManager::setVec2Value(UNIFORM_HANDLE handle, glm::vec2 value) const
+{
+	glUniform2fv(handle, 1, glm::value_ptr(value));
+	RenderStats::CountUniformWrite();
+}
+
+void ShaderManager::setVec3Value(UNIFORM_HANDLE handle, glm::vec3 value) const
+{
+	glUniform3fv(handle, 1, glm::value_ptr(value));
+	RenderStats::CountUniformWrite();
+}
+
+void ShaderManager::setVec4Value(UNIFORM_HANDLE handle, glm::vec4 value) const
+{
+	glUniform4fv(handle, 1, glm::value_ptr(value));
+	RenderStats::CountUniformWrite();
+}
+
+void ShaderManager::setMat4Value(UNIFORM_HANDLE handle, glm::mat4 value) const
+{
+	glUniformMatrix4fv(handle, 1, GL_FALSE, glm::value_ptr(value));
+	RenderStats::CountUniformWrite();
+}
+
+void ShaderManager::setSampler2DValue(UNIFORM_HANDLE handle, int value) const
+{
+	glUniform1i(handle, value);
+	RenderStats::CountUniformWrite();
+}
+
+/***********************************************************
+ *  Name setters
+ *
+ *  These methods are used for setting uniform values by
+ *  name.  The name is resolved through the uniform cache.
+ ***********************************************************/
+void ShaderManager::setBoolValue(const std::string& name, bool value)
+{
+	setBoolValue(GetUniformHandle(name), value);
+}
+
+void ShaderManager::setIntValue(const std::string& name, int value)
+{
+	setIntValue(GetUniformHandle(name), value);
+}
+
+void ShaderManager::setFloatValue(const std::string& name, float value)
+{
+	setFloatValue(GetUniformHandle(name), value);
+}
+
+void ShaderManager::setVec2Value(const std::string& name, glm::vec2 value)
+{
+	setVec2Value(GetUniformHandle(name), value);
+}
+
+void ShaderManager::setVec3Value(const std::string& name, glm::vec3 value)
+{
+	setVec3Value(GetUniformHandle(name), value);
+}
+
+void ShaderManager::setVec4Value(const std::string& name, glm::vec4 value)
+{
+	setVec4Value(GetUniformHandle(name), value);
+}
+
+void ShaderManager::setMat4Value(const std::string& name, glm::mat4 value)
+{
+	setMat4Value(GetUniformHandle(name), value);
+}
+
+void ShaderManager::setSampler2DValue(const std::string& name, int value)
+{
+	setSampler2DValue(GetUniformHandle(name), value);
+}
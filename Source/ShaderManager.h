@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadermanager.h
+// ============
+// manage the loading of the GLSL shader code and the passing of values
+// into the shader uniforms
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  ShaderManager
+ *
+ *  This class contains the code for compiling and linking
+ *  the shader program and for setting its uniform values.
+ *  Uniform locations are resolved once after the program
+ *  is linked, so the setters never query OpenGL by name.
+ ***********************************************************/
+class ShaderManager
+{
+public:
+	// handle of a resolved uniform - its location in the program
+	typedef GLint UNIFORM_HANDLE;
+
+	// constructor
+	ShaderManager();
+	// destructor
+	~ShaderManager();
+
+	// the compiled and linked shader program
+	GLuint m_programID;
+
+	// load, compile and link the vertex and fragment shaders
+	GLuint LoadShaders(const char* vertexShaderPath, const char* fragmentShaderPath);
+	// load, compile and link a compute shader into a program
+	// of its own, freed along with the manager
+	GLuint LoadComputeShader(const char* computeShaderPath);
+	// make the shader program the active program
+	void use();
+
+	// get the handle of a uniform for use with the handle setters
+	UNIFORM_HANDLE GetUniformHandle(const std::string& name);
+
+	// set uniform values through a previously resolved handle
+	void setBoolValue(UNIFORM_HANDLE handle, bool value) const;
+	void setIntValue(UNIFORM_HANDLE handle, int value) const;
+	void setFloatValue(UNIFORM_HANDLE handle, float value) const;
+	void setVec2Value(UNIFORM_HANDLE handle, glm::vec2 value) const;
+	void setVec3Value(UNIFORM_HANDLE handle, glm::vec3 value) const;
+	void setVec4Value(UNIFORM_HANDLE handle, glm::vec4 value) const;
+	void setMat4Value(UNIFORM_HANDLE handle, glm::mat4 value) const;
+	void setSampler2DValue(UNIFORM_HANDLE handle, int value) const;
+
+	// create a uniform buffer object bound to a uniform block
+	// binding point, and update its contents
+	GLuint CreateUniformBuffer(GLuint bindingPoint, GLsizeiptr size);
+	void UpdateUniformBuffer(GLuint uniformBuffer, GLintptr offset, GLsizeiptr size, const void* data) const;
+	// create a shader storage buffer bound to a buffer block
+	// binding point, and replace its contents at any size
+	GLuint CreateStorageBuffer(GLuint bindingPoint);
+	void UpdateStorageBuffer(GLuint storageBuffer, GLsizeiptr size, const void* data) const;
+
+	// set uniform values by name - the name is looked up in
+	// the uniform cache rather than queried from OpenGL
+	void setBoolValue(const std::string& name, bool value);
+	void setIntValue(const std::string& name, int value);
+	void setFloatValue(const std::string& name, float value);
+	void setVec2Value(const std::string& name, glm::vec2 value);
+	void setVec3Value(const std::string& name, glm::vec3 value);
+	void setVec4Value(const std::string& name, glm::vec4 value);
+	void setMat4Value(const std::string& name, glm::mat4 value);
+	void setSampler2DValue(const std::string& name, int value);
+
+private:
+	// uniform locations of the linked program, keyed by name
+	std::unordered_map<std::string, UNIFORM_HANDLE> m_uniformCache;
+	// uniform and storage buffer objects created through this manager
+	std::vector<GLuint> m_uniformBuffers;
+	// compute programs created through this manager
+	std::vector<GLuint> m_computePrograms;
+
+	// read the source code of a shader file
+	bool ReadShaderFile(const char* filePath, std::string& shaderCode);
+	// compile one shader stage
+	GLuint CompileShader(GLenum shaderType, const std::string& shaderCode, const char* filePath);
+	// link the compiled shader stages into a program
+	GLuint LinkProgram(const GLuint* shaders, int shaderCount);
+	// fill the uniform cache with every active uniform of the program
+	void CacheUniformLocations();
+};
@@ -0,0 +1,990 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapemeshes.cpp
+// ============
+// create meshes for the basic 3D shapes used by the scene:
+//     box, cone, cylinder, plane, prism
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShapeMeshes.h"
+#include "RenderStats.h"
+#include "TraceRecorder.h"
+
+#include <cmath>
+#include <cstddef>
+
+// declaration of global variables
+namespace
+{
+	const float PI = 3.14159265358979323846f;
+
+	// number of slices around the curved shapes at each level
+	// of detail, finest first
+	const int LOD_SLICES[LodSelector::LEVEL_COUNT] = { 36, 16, 8 };
+
+	// vertex layout - position, normal, texture coordinate
+	const GLuint FLOATS_PER_VERTEX = 3;
+	const GLuint FLOATS_PER_NORMAL = 3;
+	const GLuint FLOATS_PER_UV = 2;
+	const GLuint STRIDE = FLOATS_PER_VERTEX + FLOATS_PER_NORMAL + FLOATS_PER_UV;
+
+	// attribute locations used by the vertex shader
+	const GLuint POSITION_LOCATION = 0;
+	const GLuint NORMAL_LOCATION = 1;
+	const GLuint UV_LOCATION = 2;
+	const GLuint INSTANCE_MODEL_LOCATION = 3;	// uses locations 3 to 6
+	const GLuint INSTANCE_COLOR_LOCATION = 7;
+	const GLuint BAKED_COLOR_LOCATION = 8;
+	const GLuint BAKED_MATERIAL_LOCATION = 9;
+	const GLuint OBJECT_INDEX_LOCATION = 10;
+
+	// index ranges of the parts of the curved shapes
+	GLsizei CapIndices(int lodLevel) { return(LOD_SLICES[lodLevel] * 3); }
+	GLsizei CylinderSideIndices(int lodLevel) { return(LOD_SLICES[lodLevel] * 6); }
+	GLsizei ConeSideIndices(int lodLevel) { return(LOD_SLICES[lodLevel] * 3); }
+
+	// append one vertex to the vertex data
+	void AddVertex(
+		std::vector<GLfloat>& verts,
+		glm::vec3 position,
+		glm::vec3 normal,
+		float u, float v)
+	{
+		verts.insert(verts.end(), {
+			position.x, position.y, position.z,
+			normal.x, normal.y, normal.z,
+			u, v });
+	}
+
+	// append a flat disc made of one fan of triangles, facing
+	// up or down, at the passed in height
+	void AddDisc(
+		std::vector<GLfloat>& verts,
+		std::vector<GLuint>& indices,
+		float y,
+		bool bFacingUp,
+		int slices)
+	{
+		GLuint center = (GLuint)(verts.size() / STRIDE);
+		glm::vec3 normal = glm::vec3(0.0f, bFacingUp ? 1.0f : -1.0f, 0.0f);
+
+		AddVertex(verts, glm::vec3(0.0f, y, 0.0f), normal, 0.5f, 0.5f);
+		for (int i = 0; i <= slices; i++)
+		{
+			float angle = 2.0f * PI * i / slices;
+			float x = cos(angle);
+			float z = sin(angle);
+			AddVertex(verts, glm::vec3(x, y, z), normal, 0.5f + x * 0.5f, 0.5f + z * 0.5f);
+		}
+
+		for (int i = 0; i < slices; i++)
+		{
+			GLuint rim = center + 1 + i;
+			if (bFacingUp)
+				indices.insert(indices.end(), { center, rim + 1, rim });
+			else
+				indices.insert(indices.end(), { center, rim, rim + 1 });
+		}
+	}
+}
+
+/***********************************************************
+ *  ShapeMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShapeMeshes::ShapeMeshes()
+{
+	m_BoxMesh = {};
+	for (int level = 0; level < LodSelector::LEVEL_COUNT; level++)
+	{
+		m_ConeMeshes[level] = {};
+		m_CylinderMeshes[level] = {};
+	}
+	m_PlaneMesh = {};
+	m_PrismMesh = {};
+	m_MeshArena.vao = 0;
+	m_MeshArena.vbos[0] = m_MeshArena.vbos[1] = m_MeshArena.vbos[2] = 0;
+	m_MeshArena.objectCount = 0;
+}
+
+/***********************************************************
+ *  ~ShapeMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShapeMeshes::~ShapeMeshes()
+{
+	DestroyMesh(m_BoxMesh);
+	for (int level = 0; level < LodSelector::LEVEL_COUNT; level++)
+	{
+		DestroyMesh(m_ConeMeshes[level]);
+		DestroyMesh(m_CylinderMeshes[level]);
+	}
+	DestroyMesh(m_PlaneMesh);
+	DestroyMesh(m_PrismMesh);
+	DestroyMeshArena();
+}
+
+/***********************************************************
+ *  UploadMesh()
+ *
+ *  This method is used for sending the generated vertex and
+ *  index data of a mesh to GPU memory and configuring the
+ *  vertex attributes that the shader reads.
+ ***********************************************************/
+void ShapeMeshes::UploadMesh(
+	GLMesh& mesh,
+	const std::vector<GLfloat>& verts,
+	const std::vector<GLuint>& indices)
+{
+	mesh.nVertices = (GLuint)(verts.size() / STRIDE);
+	mesh.nIndices = (GLuint)indices.size();
+
+	glGenVertexArrays(1, &mesh.vao);
+	glBindVertexArray(mesh.vao);
+
+	// create 2 buffers: first one for the vertex data; second one for the indices
+	glGenBuffers(2, mesh.vbos);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]);
+	glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), verts.data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	RenderStats::CountBufferUpload(verts.size() * sizeof(GLfloat) + indices.size() * sizeof(GLuint));
+
+	// strides between vertex coordinates
+	GLint stride = sizeof(GLfloat) * STRIDE;
+
+	// create the vertex attribute pointers
+	glVertexAttribPointer(POSITION_LOCATION, FLOATS_PER_VERTEX, GL_FLOAT, GL_FALSE, stride, (void*)0);
+	glEnableVertexAttribArray(POSITION_LOCATION);
+
+	glVertexAttribPointer(NORMAL_LOCATION, FLOATS_PER_NORMAL, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(GLfloat) * FLOATS_PER_VERTEX));
+	glEnableVertexAttribArray(NORMAL_LOCATION);
+
+	glVertexAttribPointer(UV_LOCATION, FLOATS_PER_UV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(GLfloat) * (FLOATS_PER_VERTEX + FLOATS_PER_NORMAL)));
+	glEnableVertexAttribArray(UV_LOCATION);
+
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DestroyMesh()
+ *
+ *  This method is used for freeing the GPU memory used by
+ *  a loaded mesh.
+ ***********************************************************/
+void ShapeMeshes::DestroyMesh(GLMesh& mesh)
+{
+	if (mesh.vao != 0)
+	{
+		glDeleteVertexArrays(1, &mesh.vao);
+		glDeleteBuffers(2, mesh.vbos);
+		mesh = {};
+	}
+}
+
+/***********************************************************
+ *  BuildBoxMeshData()
+ *
+ *  This method is used for generating a unit box centered
+ *  on the origin, with each face having its own normal.
+ ***********************************************************/
+void ShapeMeshes::BuildBoxMeshData(MESH_DATA& data)
+{
+	std::vector<GLfloat>& verts = data.verts;
+	std::vector<GLuint>& indices = data.indices;
+
+	// normal, right and up directions of each face
+	const glm::vec3 faces[6][3] = {
+		{ glm::vec3(0, 0, 1),  glm::vec3(1, 0, 0),  glm::vec3(0, 1, 0) },	// front
+		{ glm::vec3(0, 0, -1), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0) },	// back
+		{ glm::vec3(1, 0, 0),  glm::vec3(0, 0, -1), glm::vec3(0, 1, 0) },	// right
+		{ glm::vec3(-1, 0, 0), glm::vec3(0, 0, 1),  glm::vec3(0, 1, 0) },	// left
+		{ glm::vec3(0, 1, 0),  glm::vec3(1, 0, 0),  glm::vec3(0, 0, -1) },	// top
+		{ glm::vec3(0, -1, 0), glm::vec3(1, 0, 0),  glm::vec3(0, 0, 1) }	// bottom
+	};
+
+	for (int f = 0; f < 6; f++)
+	{
+		glm::vec3 n = faces[f][0];
+		glm::vec3 r = faces[f][1];
+		glm::vec3 u = faces[f][2];
+		GLuint base = (GLuint)(verts.size() / STRIDE);
+
+		AddVertex(verts, (n - r - u) * 0.5f, n, 0.0f, 0.0f);
+		AddVertex(verts, (n + r - u) * 0.5f, n, 1.0f, 0.0f);
+		AddVertex(verts, (n + r + u) * 0.5f, n, 1.0f, 1.0f);
+		AddVertex(verts, (n - r + u) * 0.5f, n, 0.0f, 1.0f);
+
+		indices.insert(indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+	}
+}
+
+/***********************************************************
+ *  BuildConeMeshData()
+ *
+ *  This method is used for generating a cone with a unit
+ *  radius base resting on the origin and its tip at a
+ *  height of 1, at the passed in level of detail.  The
+ *  bottom indices come first, then the sides.
+ ***********************************************************/
+void ShapeMeshes::BuildConeMeshData(MESH_DATA& data, int lodLevel)
+{
+	std::vector<GLfloat>& verts = data.verts;
+	std::vector<GLuint>& indices = data.indices;
+	int slices = LOD_SLICES[lodLevel];
+
+	// bottom
+	AddDisc(verts, indices, 0.0f, false, slices);
+
+	// sides - each slice gets its own tip vertex so the
+	// normals stay smooth around the cone
+	GLuint base = (GLuint)(verts.size() / STRIDE);
+	for (int i = 0; i <= slices; i++)
+	{
+		float angle = 2.0f * PI * i / slices;
+		float u = (float)i / slices;
+		glm::vec3 normal = glm::normalize(glm::vec3(cos(angle), 1.0f, sin(angle)));
+
+		AddVertex(verts, glm::vec3(cos(angle), 0.0f, sin(angle)), normal, u, 0.0f);
+		AddVertex(verts, glm::vec3(0.0f, 1.0f, 0.0f), normal, u, 1.0f);
+	}
+	for (int i = 0; i < slices; i++)
+	{
+		GLuint rim = base + i * 2;
+		indices.insert(indices.end(), { rim, rim + 1, rim + 2 });
+	}
+}
+
+/***********************************************************
+ *  BuildCylinderMeshData()
+ *
+ *  This method is used for generating a cylinder with a
+ *  unit radius, its bottom resting on the origin and its
+ *  top at a height of 1, at the passed in level of detail.
+ *  The bottom indices come first, then the top and sides.
+ ***********************************************************/
+void ShapeMeshes::BuildCylinderMeshData(MESH_DATA& data, int lodLevel)
+{
+	std::vector<GLfloat>& verts = data.verts;
+	std::vector<GLuint>& indices = data.indices;
+	int slices = LOD_SLICES[lodLevel];
+
+	// bottom and top
+	AddDisc(verts, indices, 0.0f, false, slices);
+	AddDisc(verts, indices, 1.0f, true, slices);
+
+	// sides
+	GLuint base = (GLuint)(verts.size() / STRIDE);
+	for (int i = 0; i <= slices; i++)
+	{
+		float angle = 2.0f * PI * i / slices;
+		float u = (float)i / slices;
+		glm::vec3 normal = glm::vec3(cos(angle), 0.0f, sin(angle));
+
+		AddVertex(verts, glm::vec3(normal.x, 0.0f, normal.z), normal, u, 0.0f);
+		AddVertex(verts, glm::vec3(normal.x, 1.0f, normal.z), normal, u, 1.0f);
+	}
+	for (int i = 0; i < slices; i++)
+	{
+		GLuint rim = base + i * 2;
+		indices.insert(indices.end(), { rim, rim + 1, rim + 3, rim, rim + 3, rim + 2 });
+	}
+}
+
+/***********************************************************
+ *  BuildPlaneMeshData()
+ *
+ *  This method is used for generating a flat plane facing
+ *  up, spanning -1 to 1 along the X and Z axes.
+ ***********************************************************/
+void ShapeMeshes::BuildPlaneMeshData(MESH_DATA& data)
+{
+	std::vector<GLfloat>& verts = data.verts;
+	std::vector<GLuint>& indices = data.indices;
+	const glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+
+	AddVertex(verts, glm::vec3(-1.0f, 0.0f, 1.0f), up, 0.0f, 0.0f);
+	AddVertex(verts, glm::vec3(1.0f, 0.0f, 1.0f), up, 1.0f, 0.0f);
+	AddVertex(verts, glm::vec3(1.0f, 0.0f, -1.0f), up, 1.0f, 1.0f);
+	AddVertex(verts, glm::vec3(-1.0f, 0.0f, -1.0f), up, 0.0f, 1.0f);
+
+	indices = { 0, 1, 2, 0, 2, 3 };
+}
+
+/***********************************************************
+ *  BuildPrismMeshData()
+ *
+ *  This method is used for generating a triangular prism
+ *  centered on the origin, with the triangle in the XY
+ *  plane and its apex pointing up.
+ ***********************************************************/
+void ShapeMeshes::BuildPrismMeshData(MESH_DATA& data)
+{
+	std::vector<GLfloat>& verts = data.verts;
+	std::vector<GLuint>& indices = data.indices;
+
+	const glm::vec3 left = glm::vec3(-0.5f, -0.5f, 0.0f);
+	const glm::vec3 right = glm::vec3(0.5f, -0.5f, 0.0f);
+	const glm::vec3 apex = glm::vec3(0.0f, 0.5f, 0.0f);
+	const glm::vec3 front = glm::vec3(0.0f, 0.0f, 0.5f);
+
+	// front and back triangles
+	for (float side = 1.0f; side >= -1.0f; side -= 2.0f)
+	{
+		GLuint base = (GLuint)(verts.size() / STRIDE);
+		glm::vec3 n = glm::vec3(0.0f, 0.0f, side);
+		AddVertex(verts, left + front * side, n, 0.0f, 0.0f);
+		AddVertex(verts, right + front * side, n, 1.0f, 0.0f);
+		AddVertex(verts, apex + front * side, n, 0.5f, 1.0f);
+		if (side > 0.0f)
+			indices.insert(indices.end(), { base, base + 1, base + 2 });
+		else
+			indices.insert(indices.end(), { base, base + 2, base + 1 });
+	}
+
+	// the three rectangular sides
+	const glm::vec3 edges[3][2] = { { left, right }, { right, apex }, { apex, left } };
+	for (int e = 0; e < 3; e++)
+	{
+		glm::vec3 a = edges[e][0];
+		glm::vec3 b = edges[e][1];
+		glm::vec3 n = glm::normalize(glm::cross(b - a, glm::vec3(0.0f, 0.0f, 1.0f)));
+		GLuint base = (GLuint)(verts.size() / STRIDE);
+
+		AddVertex(verts, a + front, n, 0.0f, 0.0f);
+		AddVertex(verts, b + front, n, 1.0f, 0.0f);
+		AddVertex(verts, b - front, n, 1.0f, 1.0f);
+		AddVertex(verts, a - front, n, 0.0f, 1.0f);
+
+		indices.insert(indices.end(), { base, base + 2, base + 1, base, base + 3, base + 2 });
+	}
+}
+
+/***********************************************************
+ *  LoadBoxMesh()
+ *
+ *  This method is used for loading the box mesh into GPU
+ *  memory.
+ ***********************************************************/
+void ShapeMeshes::LoadBoxMesh()
+{
+	TRACE_SCOPE("LoadBoxMesh");
+
+	MESH_DATA data;
+	BuildBoxMeshData(data);
+	UploadMesh(m_BoxMesh, data.verts, data.indices);
+}
+
+/***********************************************************
+ *  LoadConeMesh()
+ *
+ *  This method is used for loading the cone mesh into GPU
+ *  memory, once for every level of detail.
+ ***********************************************************/
+void ShapeMeshes::LoadConeMesh()
+{
+	TRACE_SCOPE("LoadConeMesh");
+
+	for (int level = 0; level < LodSelector::LEVEL_COUNT; level++)
+	{
+		MESH_DATA data;
+		BuildConeMeshData(data, level);
+		UploadMesh(m_ConeMeshes[level], data.verts, data.indices);
+	}
+}
+
+/***********************************************************
+ *  LoadCylinderMesh()
+ *
+ *  This method is used for loading the cylinder mesh into
+ *  GPU memory, once for every level of detail.
+ ***********************************************************/
+void ShapeMeshes::LoadCylinderMesh()
+{
+	TRACE_SCOPE("LoadCylinderMesh");
+
+	for (int level = 0; level < LodSelector::LEVEL_COUNT; level++)
+	{
+		MESH_DATA data;
+		BuildCylinderMeshData(data, level);
+		UploadMesh(m_CylinderMeshes[level], data.verts, data.indices);
+	}
+}
+
+/***********************************************************
+ *  LoadPlaneMesh()
+ *
+ *  This method is used for loading the plane mesh into GPU
+ *  memory.
+ ***********************************************************/
+void ShapeMeshes::LoadPlaneMesh()
+{
+	TRACE_SCOPE("LoadPlaneMesh");
+
+	MESH_DATA data;
+	BuildPlaneMeshData(data);
+	UploadMesh(m_PlaneMesh, data.verts, data.indices);
+}
+
+/***********************************************************
+ *  LoadPrismMesh()
+ *
+ *  This method is used for loading the prism mesh into GPU
+ *  memory.
+ ***********************************************************/
+void ShapeMeshes::LoadPrismMesh()
+{
+	TRACE_SCOPE("LoadPrismMesh");
+
+	MESH_DATA data;
+	BuildPrismMeshData(data);
+	UploadMesh(m_PrismMesh, data.verts, data.indices);
+}
+
+/***********************************************************
+ *  AppendBakedMesh()
+ *
+ *  This method is used for appending the generated data of
+ *  a shape to a baked mesh.  The positions are moved into
+ *  world space by the model matrix and the normals by its
+ *  inverse transpose, the texture coordinates are scaled
+ *  the way the shader would, and every vertex carries the
+ *  object color and material so objects with different
+ *  values can share one draw.
+ ***********************************************************/
+void ShapeMeshes::AppendBakedMesh(
+	const MESH_DATA& data,
+	const glm::mat4& model,
+	const glm::vec2& uvScale,
+	const glm::vec4& color,
+	int materialIndex,
+	std::vector<BAKED_VERTEX>& verts,
+	std::vector<GLuint>& indices)
+{
+	GLuint base = (GLuint)verts.size();
+	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+
+	for (size_t i = 0; i + STRIDE <= data.verts.size(); i += STRIDE)
+	{
+		const GLfloat* pVertex = &data.verts[i];
+		BAKED_VERTEX vertex;
+
+		vertex.position = glm::vec3(model * glm::vec4(pVertex[0], pVertex[1], pVertex[2], 1.0f));
+		vertex.normal = glm::normalize(normalMatrix * glm::vec3(pVertex[3], pVertex[4], pVertex[5]));
+		vertex.uv = glm::vec2(pVertex[6], pVertex[7]) * uvScale;
+		vertex.color = color;
+		vertex.materialIndex = (GLfloat)materialIndex;
+		verts.push_back(vertex);
+	}
+
+	for (GLuint index : data.indices)
+	{
+		indices.push_back(base + index);
+	}
+}
+
+/***********************************************************
+ *  UploadBakedMesh()
+ *
+ *  This method is used for sending baked vertex and index
+ *  data to GPU memory, creating the buffers the first time
+ *  and replacing their contents after that.
+ ***********************************************************/
+void ShapeMeshes::UploadBakedMesh(
+	BAKED_MESH& mesh,
+	const std::vector<BAKED_VERTEX>& verts,
+	const std::vector<GLuint>& indices)
+{
+	bool bCreate = (mesh.vao == 0);
+
+	if (bCreate)
+	{
+		glGenVertexArrays(1, &mesh.vao);
+		glGenBuffers(2, mesh.vbos);
+	}
+	mesh.nIndices = (GLsizei)indices.size();
+
+	glBindVertexArray(mesh.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]);
+	glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(BAKED_VERTEX), verts.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	RenderStats::CountBufferUpload(verts.size() * sizeof(BAKED_VERTEX) + indices.size() * sizeof(GLuint));
+
+	if (bCreate)
+	{
+		GLint stride = sizeof(BAKED_VERTEX);
+
+		glVertexAttribPointer(POSITION_LOCATION, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(BAKED_VERTEX, position));
+		glEnableVertexAttribArray(POSITION_LOCATION);
+		glVertexAttribPointer(NORMAL_LOCATION, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(BAKED_VERTEX, normal));
+		glEnableVertexAttribArray(NORMAL_LOCATION);
+		glVertexAttribPointer(UV_LOCATION, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(BAKED_VERTEX, uv));
+		glEnableVertexAttribArray(UV_LOCATION);
+		glVertexAttribPointer(BAKED_COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(BAKED_VERTEX, color));
+		glEnableVertexAttribArray(BAKED_COLOR_LOCATION);
+		glVertexAttribPointer(BAKED_MATERIAL_LOCATION, 1, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(BAKED_VERTEX, materialIndex));
+		glEnableVertexAttribArray(BAKED_MATERIAL_LOCATION);
+	}
+
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DestroyBakedMesh()
+ *
+ *  This method is used for freeing the GPU memory used by
+ *  a baked mesh.
+ ***********************************************************/
+void ShapeMeshes::DestroyBakedMesh(BAKED_MESH& mesh)
+{
+	if (mesh.vao != 0)
+	{
+		glDeleteVertexArrays(1, &mesh.vao);
+		glDeleteBuffers(2, mesh.vbos);
+		mesh = {};
+	}
+}
+
+/***********************************************************
+ *  DrawBakedMesh()
+ *
+ *  This method is used for drawing ranges of the indices
+ *  of a baked mesh with one call, so the objects merged
+ *  into it that are out of view can be left out.
+ ***********************************************************/
+void ShapeMeshes::DrawBakedMesh(
+	const BAKED_MESH& mesh,
+	const std::vector<GLsizei>& counts,
+	const std::vector<const void*>& offsets)
+{
+	if ((mesh.vao == 0) || counts.empty())
+	{
+		return;
+	}
+
+	GLsizei indexCount = 0;
+	for (GLsizei count : counts)
+	{
+		indexCount += count;
+	}
+
+	glBindVertexArray(mesh.vao);
+	glMultiDrawElements(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(), (GLsizei)counts.size());
+	RenderStats::CountDraw(indexCount);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing all of the triangles of
+ *  a loaded mesh once.
+ ***********************************************************/
+void ShapeMeshes::DrawMesh(const GLMesh& mesh)
+{
+	glBindVertexArray(mesh.vao);
+	glDrawElements(GL_TRIANGLES, mesh.nIndices, GL_UNSIGNED_INT, NULL);
+	RenderStats::CountDraw(mesh.nIndices);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DrawBoxMesh()
+ *
+ *  This method is used for drawing the box mesh.
+ ***********************************************************/
+void ShapeMeshes::DrawBoxMesh()
+{
+	DrawMesh(m_BoxMesh);
+}
+
+/***********************************************************
+ *  DrawConeMesh()
+ *
+ *  This method is used for drawing the cone mesh of a level
+ *  of detail, with or without its bottom.
+ ***********************************************************/
+void ShapeMeshes::DrawConeMesh(bool bDrawBottom, int lodLevel)
+{
+	GLsizei capIndices = CapIndices(lodLevel);
+	GLsizei sideIndices = ConeSideIndices(lodLevel);
+	GLsizei drawnIndices = sideIndices;
+
+	glBindVertexArray(m_ConeMeshes[lodLevel].vao);
+
+	if (bDrawBottom)
+	{
+		glDrawElements(GL_TRIANGLES, capIndices, GL_UNSIGNED_INT, NULL);
+		RenderStats::CountDraw(capIndices);
+		drawnIndices += capIndices;
+	}
+	glDrawElements(GL_TRIANGLES, sideIndices, GL_UNSIGNED_INT,
+		(void*)(sizeof(GLuint) * capIndices));
+	RenderStats::CountDraw(sideIndices);
+	RenderStats::CountLodDraw(lodLevel, drawnIndices);
+
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DrawCylinderMesh()
+ *
+ *  This method is used for drawing the chosen parts of the
+ *  cylinder mesh of a level of detail.
+ ***********************************************************/
+void ShapeMeshes::DrawCylinderMesh(bool bDrawTop, bool bDrawBottom, bool bDrawSides, int lodLevel)
+{
+	GLsizei capIndices = CapIndices(lodLevel);
+	GLsizei sideIndices = CylinderSideIndices(lodLevel);
+	GLsizei drawnIndices = 0;
+
+	glBindVertexArray(m_CylinderMeshes[lodLevel].vao);
+
+	if (bDrawBottom)
+	{
+		glDrawElements(GL_TRIANGLES, capIndices, GL_UNSIGNED_INT, NULL);
+		RenderStats::CountDraw(capIndices);
+		drawnIndices += capIndices;
+	}
+	if (bDrawTop)
+	{
+		glDrawElements(GL_TRIANGLES, capIndices, GL_UNSIGNED_INT,
+			(void*)(sizeof(GLuint) * capIndices));
+		RenderStats::CountDraw(capIndices);
+		drawnIndices += capIndices;
+	}
+	if (bDrawSides)
+	{
+		glDrawElements(GL_TRIANGLES, sideIndices, GL_UNSIGNED_INT,
+			(void*)(sizeof(GLuint) * capIndices * 2));
+		RenderStats::CountDraw(sideIndices);
+		drawnIndices += sideIndices;
+	}
+	RenderStats::CountLodDraw(lodLevel, drawnIndices);
+
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DrawPlaneMesh()
+ *
+ *  This method is used for drawing the plane mesh.
+ ***********************************************************/
+void ShapeMeshes::DrawPlaneMesh()
+{
+	DrawMesh(m_PlaneMesh);
+}
+
+/***********************************************************
+ *  DrawPrismMesh()
+ *
+ *  This method is used for drawing the prism mesh.
+ ***********************************************************/
+void ShapeMeshes::DrawPrismMesh()
+{
+	DrawMesh(m_PrismMesh);
+}
+
+/***********************************************************
+ *  CreateInstanceBuffer()
+ *
+ *  This method is used for creating a GPU buffer holding the
+ *  model matrix and color of every instance to be drawn by
+ *  one of the instanced draw methods.
+ ***********************************************************/
+GLuint ShapeMeshes::CreateInstanceBuffer(const std::vector<INSTANCE_DATA>& instances)
+{
+	GLuint instanceBuffer = 0;
+
+	glGenBuffers(1, &instanceBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(INSTANCE_DATA), instances.data(), GL_STATIC_DRAW);
+	RenderStats::CountBufferUpload(instances.size() * sizeof(INSTANCE_DATA));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return(instanceBuffer);
+}
+
+/***********************************************************
+ *  UpdateInstanceBuffer()
+ *
+ *  This method is used for replacing the contents of an
+ *  instance buffer, for instances that move.
+ ***********************************************************/
+void ShapeMeshes::UpdateInstanceBuffer(GLuint instanceBuffer, const std::vector<INSTANCE_DATA>& instances)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(INSTANCE_DATA), instances.data(), GL_DYNAMIC_DRAW);
+	RenderStats::CountBufferUpload(instances.size() * sizeof(INSTANCE_DATA));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  DestroyInstanceBuffer()
+ *
+ *  This method is used for freeing an instance buffer.
+ ***********************************************************/
+void ShapeMeshes::DestroyInstanceBuffer(GLuint instanceBuffer)
+{
+	if (instanceBuffer != 0)
+	{
+		glDeleteBuffers(1, &instanceBuffer);
+	}
+}
+
+/***********************************************************
+ *  DrawMeshInstanced()
+ *
+ *  This method is used for drawing a loaded mesh once for
+ *  each instance in the passed in buffer, starting at
+ *  firstInstance.  The instance attributes point that far
+ *  into the buffer, so no base instance support is needed.
+ *  The per-instance attributes are only enabled for the
+ *  duration of the draw so the regular draw methods are not
+ *  affected.
+ ***********************************************************/
+void ShapeMeshes::DrawMeshInstanced(
+	const GLMesh& mesh,
+	GLsizei instanceCount,
+	GLuint instanceBuffer,
+	GLint firstInstance)
+{
+	size_t firstOffset = sizeof(INSTANCE_DATA) * firstInstance;
+
+	if ((instanceCount <= 0) || (instanceBuffer == 0))
+	{
+		return;
+	}
+
+	glBindVertexArray(mesh.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+	// the model matrix takes one attribute location per column
+	for (GLuint column = 0; column < 4; column++)
+	{
+		GLuint location = INSTANCE_MODEL_LOCATION + column;
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(INSTANCE_DATA),
+			(void*)(firstOffset + offsetof(INSTANCE_DATA, model) + sizeof(glm::vec4) * column));
+		glVertexAttribDivisor(location, 1);
+		glEnableVertexAttribArray(location);
+	}
+	glVertexAttribPointer(INSTANCE_COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(INSTANCE_DATA),
+		(void*)(firstOffset + offsetof(INSTANCE_DATA, color)));
+	glVertexAttribDivisor(INSTANCE_COLOR_LOCATION, 1);
+	glEnableVertexAttribArray(INSTANCE_COLOR_LOCATION);
+
+	glDrawElementsInstanced(GL_TRIANGLES, mesh.nIndices, GL_UNSIGNED_INT, NULL, instanceCount);
+	RenderStats::CountDraw(mesh.nIndices, instanceCount);
+
+	for (GLuint location = INSTANCE_MODEL_LOCATION; location <= INSTANCE_COLOR_LOCATION; location++)
+	{
+		glDisableVertexAttribArray(location);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DrawBoxMeshInstanced()
+ *
+ *  This method is used for drawing the box mesh once for
+ *  each instance in the passed in buffer.
+ ***********************************************************/
+void ShapeMeshes::DrawBoxMeshInstanced(GLsizei instanceCount, GLuint instanceBuffer)
+{
+	DrawMeshInstanced(m_BoxMesh, instanceCount, instanceBuffer);
+}
+
+/***********************************************************
+ *  DrawConeMeshInstanced()
+ *
+ *  This method is used for drawing the cone mesh of a level
+ *  of detail once for each instance in the passed in buffer,
+ *  starting at firstInstance.
+ ***********************************************************/
+void ShapeMeshes::DrawConeMeshInstanced(GLsizei instanceCount, GLuint instanceBuffer, int lodLevel, GLint firstInstance)
+{
+	DrawMeshInstanced(m_ConeMeshes[lodLevel], instanceCount, instanceBuffer, firstInstance);
+	RenderStats::CountLodDraw(lodLevel, m_ConeMeshes[lodLevel].nIndices, instanceCount);
+}
+
+/***********************************************************
+ *  DrawCylinderMeshInstanced()
+ *
+ *  This method is used for drawing the cylinder mesh of a
+ *  level of detail once for each instance in the passed in
+ *  buffer, starting at firstInstance.
+ ***********************************************************/
+void ShapeMeshes::DrawCylinderMeshInstanced(GLsizei instanceCount, GLuint instanceBuffer, int lodLevel, GLint firstInstance)
+{
+	DrawMeshInstanced(m_CylinderMeshes[lodLevel], instanceCount, instanceBuffer, firstInstance);
+	RenderStats::CountLodDraw(lodLevel, m_CylinderMeshes[lodLevel].nIndices, instanceCount);
+}
+
+/***********************************************************
+ *  DrawPlaneMeshInstanced()
+ *
+ *  This method is used for drawing the plane mesh once for
+ *  each instance in the passed in buffer.
+ ***********************************************************/
+void ShapeMeshes::DrawPlaneMeshInstanced(GLsizei instanceCount, GLuint instanceBuffer)
+{
+	DrawMeshInstanced(m_PlaneMesh, instanceCount, instanceBuffer);
+}
+
+/***********************************************************
+ *  DrawPrismMeshInstanced()
+ *
+ *  This method is used for drawing the prism mesh once for
+ *  each instance in the passed in buffer.
+ ***********************************************************/
+void ShapeMeshes::DrawPrismMeshInstanced(GLsizei instanceCount, GLuint instanceBuffer)
+{
+	DrawMeshInstanced(m_PrismMesh, instanceCount, instanceBuffer);
+}
+
+/***********************************************************
+ *  AddArenaMesh()
+ *
+ *  This method is used for appending generated mesh data to
+ *  the shared mesh arena.  The indices are kept relative to
+ *  the mesh, and the returned range carries the base vertex
+ *  an indirect draw command adds to them.
+ ***********************************************************/
+ShapeMeshes::ARENA_MESH ShapeMeshes::AddArenaMesh(const MESH_DATA& data)
+{
+	ARENA_MESH mesh;
+
+	mesh.firstIndex = (GLuint)m_MeshArena.indices.size();
+	mesh.indexCount = (GLuint)data.indices.size();
+	mesh.baseVertex = (GLint)(m_MeshArena.verts.size() / STRIDE);
+
+	m_MeshArena.verts.insert(m_MeshArena.verts.end(), data.verts.begin(), data.verts.end());
+	m_MeshArena.indices.insert(m_MeshArena.indices.end(), data.indices.begin(), data.indices.end());
+
+	return(mesh);
+}
+
+/***********************************************************
+ *  UploadMeshArena()
+ *
+ *  This method is used for sending the shared mesh arena to
+ *  GPU memory.  The buffers are immutable, since the meshes
+ *  never change once loaded, and the CPU copy is released.
+ ***********************************************************/
+void ShapeMeshes::UploadMeshArena()
+{
+	DestroyMeshArena();
+
+	glGenVertexArrays(1, &m_MeshArena.vao);
+	glBindVertexArray(m_MeshArena.vao);
+	glGenBuffers(2, m_MeshArena.vbos);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_MeshArena.vbos[0]);
+	glBufferStorage(GL_ARRAY_BUFFER, m_MeshArena.verts.size() * sizeof(GLfloat), m_MeshArena.verts.data(), 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_MeshArena.vbos[1]);
+	glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, m_MeshArena.indices.size() * sizeof(GLuint), m_MeshArena.indices.data(), 0);
+	RenderStats::CountBufferUpload(m_MeshArena.verts.size() * sizeof(GLfloat) + m_MeshArena.indices.size() * sizeof(GLuint));
+
+	GLint stride = sizeof(GLfloat) * STRIDE;
+	glVertexAttribPointer(POSITION_LOCATION, FLOATS_PER_VERTEX, GL_FLOAT, GL_FALSE, stride, (void*)0);
+	glEnableVertexAttribArray(POSITION_LOCATION);
+	glVertexAttribPointer(NORMAL_LOCATION, FLOATS_PER_NORMAL, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(GLfloat) * FLOATS_PER_VERTEX));
+	glEnableVertexAttribArray(NORMAL_LOCATION);
+	glVertexAttribPointer(UV_LOCATION, FLOATS_PER_UV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(GLfloat) * (FLOATS_PER_VERTEX + FLOATS_PER_NORMAL)));
+	glEnableVertexAttribArray(UV_LOCATION);
+
+	glBindVertexArray(0);
+
+	m_MeshArena.verts = std::vector<GLfloat>();
+	m_MeshArena.indices = std::vector<GLuint>();
+}
+
+/***********************************************************
+ *  DestroyMeshArena()
+ *
+ *  This method is used for freeing the GPU memory used by
+ *  the shared mesh arena.
+ ***********************************************************/
+void ShapeMeshes::DestroyMeshArena()
+{
+	if (m_MeshArena.vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_MeshArena.vao);
+		glDeleteBuffers(3, m_MeshArena.vbos);
+		m_MeshArena.vao = 0;
+		m_MeshArena.vbos[0] = m_MeshArena.vbos[1] = m_MeshArena.vbos[2] = 0;
+		m_MeshArena.objectCount = 0;
+	}
+}
+
+/***********************************************************
+ *  ReserveArenaObjects()
+ *
+ *  This method is used for making sure the arena can draw
+ *  objectCount objects at once.  Each indirect command puts
+ *  the index of its object in its base instance, and the
+ *  instanced object index attribute is fetched at that
+ *  position, which hands the shader its object without
+ *  needing gl_BaseInstance.  The buffer holds 0, 1, 2, ...
+ *  and only grows.
+ ***********************************************************/
+void ShapeMeshes::ReserveArenaObjects(GLuint objectCount)
+{
+	if ((m_MeshArena.vao == 0) || (objectCount <= m_MeshArena.objectCount))
+	{
+		return;
+	}
+
+	std::vector<GLuint> objectIndices(objectCount);
+	for (GLuint i = 0; i < objectCount; i++)
+	{
+		objectIndices[i] = i;
+	}
+
+	glBindVertexArray(m_MeshArena.vao);
+	if (m_MeshArena.vbos[2] != 0)
+	{
+		glDeleteBuffers(1, &m_MeshArena.vbos[2]);
+	}
+	glGenBuffers(1, &m_MeshArena.vbos[2]);
+	glBindBuffer(GL_ARRAY_BUFFER, m_MeshArena.vbos[2]);
+	glBufferStorage(GL_ARRAY_BUFFER, objectIndices.size() * sizeof(GLuint), objectIndices.data(), 0);
+	RenderStats::CountBufferUpload(objectIndices.size() * sizeof(GLuint));
+
+	glVertexAttribIPointer(OBJECT_INDEX_LOCATION, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+	glVertexAttribDivisor(OBJECT_INDEX_LOCATION, 1);
+	glEnableVertexAttribArray(OBJECT_INDEX_LOCATION);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	m_MeshArena.objectCount = objectCount;
+}
+
+/***********************************************************
+ *  DrawArenaIndirect()
+ *
+ *  This method is used for drawing commandCount indirect
+ *  draw commands, read from the bound indirect buffer at
+ *  commandOffset, against the shared mesh arena with one
+ *  call.
+ ***********************************************************/
+void ShapeMeshes::DrawArenaIndirect(GLintptr commandOffset, GLsizei commandCount, GLsizei indexCount)
+{
+	if ((m_MeshArena.vao == 0) || (commandCount <= 0))
+	{
+		return;
+	}
+
+	glBindVertexArray(m_MeshArena.vao);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)commandOffset, commandCount, 0);
+	RenderStats::CountDraw(indexCount);
+	glBindVertexArray(0);
+}
@@ -0,0 +1,198 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapemeshes.h
+// ============
+// create meshes for the basic 3D shapes used by the scene:
+//     box, cone, cylinder, plane, prism
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "LodSelector.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  ShapeMeshes
+ *
+ *  This class contains the code for loading the basic 3D
+ *  shape meshes into GPU memory and drawing them, either
+ *  one object per draw or many instances per draw.  The
+ *  curved shapes are loaded once per level of detail, with
+ *  fewer slices around them at the coarser levels.  The
+ *  generated shape data can also be baked into world space
+ *  and merged, so many objects that never move are drawn
+ *  from one buffer, or gathered into one shared arena that
+ *  indirect draw commands index into.
+ ***********************************************************/
+class ShapeMeshes
+{
+public:
+	// constructor
+	ShapeMeshes();
+	// destructor
+	~ShapeMeshes();
+
+	// per-instance values read by the vertex shader when
+	// drawing with one of the instanced draw methods
+	struct INSTANCE_DATA
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+	};
+
+	// vertices and indices of a shape as generated, each vertex
+	// being a position, normal and texture coordinate
+	struct MESH_DATA
+	{
+		std::vector<GLfloat> verts;
+		std::vector<GLuint> indices;
+	};
+
+	// one vertex of a baked mesh, already in world space and
+	// carrying the color and material of its object
+	struct BAKED_VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 uv;
+		glm::vec4 color;
+		GLfloat materialIndex;
+	};
+
+	// GL data of a mesh merged from many baked objects
+	struct BAKED_MESH
+	{
+		GLuint vao;
+		GLuint vbos[2];
+		GLsizei nIndices;
+	};
+
+	// where one mesh lives in the shared mesh arena, in the
+	// terms of an indirect draw command
+	struct ARENA_MESH
+	{
+		GLuint firstIndex;
+		GLuint indexCount;
+		GLint baseVertex;
+	};
+
+private:
+	// stores the GL data relative to a given mesh
+	struct GLMesh
+	{
+		GLuint vao;			// handle for the vertex array object
+		GLuint vbos[2];		// handles for the vertex buffer objects
+		GLuint nVertices;	// number of vertices for the mesh
+		GLuint nIndices;	// number of indices for the mesh
+	};
+
+	GLMesh m_BoxMesh;
+	GLMesh m_ConeMeshes[LodSelector::LEVEL_COUNT];
+	GLMesh m_CylinderMeshes[LodSelector::LEVEL_COUNT];
+	GLMesh m_PlaneMesh;
+	GLMesh m_PrismMesh;
+
+	// one vertex and index buffer shared by every mesh added to
+	// it, plus a buffer of object indices read per instance
+	struct MESH_ARENA
+	{
+		GLuint vao;
+		GLuint vbos[3];
+		GLuint objectCount;	// object indices in the third buffer
+		std::vector<GLfloat> verts;		// until uploaded
+		std::vector<GLuint> indices;
+	};
+
+	MESH_ARENA m_MeshArena;
+
+	// upload the generated vertex and index data for a mesh
+	void UploadMesh(
+		GLMesh& mesh,
+		const std::vector<GLfloat>& verts,
+		const std::vector<GLuint>& indices);
+	// free the GPU memory used by a mesh
+	void DestroyMesh(GLMesh& mesh);
+	// draw a loaded mesh once
+	void DrawMesh(const GLMesh& mesh);
+	// draw a loaded mesh once for every instance in the buffer,
+	// starting at firstInstance
+	void DrawMeshInstanced(
+		const GLMesh& mesh,
+		GLsizei instanceCount,
+		GLuint instanceBuffer,
+		GLint firstInstance = 0);
+
+public:
+	// generate the vertex and index data of the shapes
+	static void BuildBoxMeshData(MESH_DATA& data);
+	static void BuildConeMeshData(MESH_DATA& data, int lodLevel = 0);
+	static void BuildCylinderMeshData(MESH_DATA& data, int lodLevel = 0);
+	static void BuildPlaneMeshData(MESH_DATA& data);
+	static void BuildPrismMeshData(MESH_DATA& data);
+
+	// load the shape meshes into GPU memory
+	void LoadBoxMesh();
+	void LoadConeMesh();
+	void LoadCylinderMesh();
+	void LoadPlaneMesh();
+	void LoadPrismMesh();
+
+	// draw one object with the shape meshes
+	void DrawBoxMesh();
+	void DrawConeMesh(bool bDrawBottom = true, int lodLevel = 0);
+	void DrawCylinderMesh(bool bDrawTop = true, bool bDrawBottom = true, bool bDrawSides = true, int lodLevel = 0);
+	void DrawPlaneMesh();
+	void DrawPrismMesh();
+
+	// create and free the buffers that hold per-instance data
+	GLuint CreateInstanceBuffer(const std::vector<INSTANCE_DATA>& instances);
+	void UpdateInstanceBuffer(GLuint instanceBuffer, const std::vector<INSTANCE_DATA>& instances);
+	void DestroyInstanceBuffer(GLuint instanceBuffer);
+
+	// draw many objects of the same shape with a single call
+	void DrawBoxMeshInstanced(GLsizei instanceCount, GLuint instanceBuffer);
+	void DrawConeMeshInstanced(GLsizei instanceCount, GLuint instanceBuffer, int lodLevel = 0, GLint firstInstance = 0);
+	void DrawCylinderMeshInstanced(GLsizei instanceCount, GLuint instanceBuffer, int lodLevel = 0, GLint firstInstance = 0);
+	void DrawPlaneMeshInstanced(GLsizei instanceCount, GLuint instanceBuffer);
+	void DrawPrismMeshInstanced(GLsizei instanceCount, GLuint instanceBuffer);
+
+	// append a shape moved into world space to baked mesh data
+	static void AppendBakedMesh(
+		const MESH_DATA& data,
+		const glm::mat4& model,
+		const glm::vec2& uvScale,
+		const glm::vec4& color,
+		int materialIndex,
+		std::vector<BAKED_VERTEX>& verts,
+		std::vector<GLuint>& indices);
+	// send baked mesh data to GPU memory, and free it again
+	void UploadBakedMesh(
+		BAKED_MESH& mesh,
+		const std::vector<BAKED_VERTEX>& verts,
+		const std::vector<GLuint>& indices);
+	void DestroyBakedMesh(BAKED_MESH& mesh);
+	// draw ranges of a baked mesh with a single call, each
+	// range given by its index count and byte offset
+	void DrawBakedMesh(
+		const BAKED_MESH& mesh,
+		const std::vector<GLsizei>& counts,
+		const std::vector<const void*>& offsets);
+
+	// add generated mesh data to the shared mesh arena, before
+	// the arena is uploaded
+	ARENA_MESH AddArenaMesh(const MESH_DATA& data);
+	// send the shared mesh arena to GPU memory, and free it again
+	void UploadMeshArena();
+	void DestroyMeshArena();
+	// make room for objectCount object indices per draw
+	void ReserveArenaObjects(GLuint objectCount);
+	// issue the draw commands held in the bound indirect buffer
+	// against the shared mesh arena with a single call
+	void DrawArenaIndirect(GLintptr commandOffset, GLsizei commandCount, GLsizei indexCount);
+};
@@ -0,0 +1,414 @@
+///////////////////////////////////////////////////////////////////////////////
+// simulationthread.cpp
+// ============
+// step the camera at a fixed rate on a thread of its own and hand the
+// results to the render thread as snapshots to interpolate between
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SimulationThread.h"
+#include "TraceRecorder.h"
+
+// declaration of global variables
+namespace
+{
+	// length of one tick, in seconds
+	const double TICK_SECONDS = 1.0 / SimulationThread::TICKS_PER_SECOND;
+	// ticks run back to back to catch up after a stall, beyond
+	// which the schedule restarts from now instead
+	const int MAX_CATCH_UP_TICKS = 8;
+
+	// degrees of turn per pixel of mouse movement
+	const float MOUSE_SENSITIVITY = 0.12f;
+	// movement speed in units per second, changed by the wheel
+	const float DEFAULT_MOVE_SPEED = 2.5f;
+	const float MIN_MOVE_SPEED = 0.5f;
+	const float MAX_MOVE_SPEED = 10.0f;
+	const float SCROLL_SPEED_STEP = 0.25f;
+	// steepest the camera can look up or down, in degrees
+	const float MAX_PITCH = 89.0f;
+	// keys that keep the camera moving while held
+	const uint32_t MOVEMENT_KEYS =
+		SimulationThread::KEY_FORWARD | SimulationThread::KEY_BACK |
+		SimulationThread::KEY_LEFT | SimulationThread::KEY_RIGHT |
+		SimulationThread::KEY_DOWN | SimulationThread::KEY_UP;
+}
+
+/***********************************************************
+ *  SimulationThread()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SimulationThread::SimulationThread(const glm::vec3& position, float yaw, float pitch)
+{
+	m_bStopping = false;
+	m_bParked = false;
+	m_startTime = std::chrono::steady_clock::now();
+
+	m_state.tick = 0;
+	m_state.time = 0.0;
+	m_state.position = position;
+	m_state.yaw = yaw;
+	m_state.pitch = pitch;
+	m_state.bOrthographic = false;
+	m_state.inputCount = 0;
+	m_moveSpeed = DEFAULT_MOVE_SPEED;
+	m_heldKeys = 0;
+	m_published = m_state;
+
+	m_previous = m_state;
+	m_latest = m_state;
+	m_pushedInputs = 0;
+	m_pushedKeys = 0;
+}
+
+/***********************************************************
+ *  ~SimulationThread()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SimulationThread::~SimulationThread()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the simulation thread.
+ *  The simulation clock starts here, at the first tick.
+ ***********************************************************/
+void SimulationThread::Start()
+{
+	if (m_thread.joinable())
+	{
+		return;
+	}
+
+	m_bStopping = false;
+	m_startTime = std::chrono::steady_clock::now();
+	m_thread = std::thread(&SimulationThread::Run, this);
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for stopping the simulation thread
+ *  and waiting for it to finish its tick, waking it first
+ *  when it is parked.
+ ***********************************************************/
+void SimulationThread::Stop()
+{
+	if (!m_thread.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_parkMutex);
+		m_bStopping = true;
+	}
+	m_inputPushed.notify_one();
+	m_thread.join();
+}
+
+/***********************************************************
+ *  PushInput()
+ *
+ *  This method is used for passing the input of a frame to
+ *  the simulation.  A sample that changes nothing, with the
+ *  same keys as the last one and no mouse or wheel movement,
+ *  is dropped so it does not wake the simulation.  When the
+ *  ring is full the sample is not taken, and the caller
+ *  keeps its movement for the next frame instead of losing
+ *  it.
+ ***********************************************************/
+bool SimulationThread::PushInput(const INPUT_SAMPLE& input)
+{
+	if ((input.keys == m_pushedKeys) &&
+		(input.mouseDeltaX == 0.0f) &&
+		(input.mouseDeltaY == 0.0f) &&
+		(input.scroll == 0.0f))
+	{
+		return(true);
+	}
+
+	if (!m_inputs.Push(input))
+	{
+		return(false);
+	}
+
+	m_pushedInputs++;
+	m_pushedKeys = input.keys;
+	Unpark();
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetInterpolatedCamera()
+ *
+ *  This method is used for getting the camera to draw this
+ *  frame.  The newest pair of snapshots is taken in, and
+ *  the camera is placed one tick in the past, which falls
+ *  between them as long as the simulation keeps up.  When
+ *  it does not, the camera holds at the latest snapshot.
+ *  The projection switches at the latest snapshot rather
+ *  than blending.
+ ***********************************************************/
+SimulationThread::CAMERA_SNAPSHOT SimulationThread::GetInterpolatedCamera()
+{
+	SNAPSHOT_PAIR snapshots;
+	if (m_snapshots.Read(snapshots))
+	{
+		m_previous = snapshots.previous;
+		m_latest = snapshots.latest;
+	}
+
+	if (m_latest.tick == m_previous.tick)
+	{
+		return(m_latest);
+	}
+
+	double renderTime = GetTime() - TICK_SECONDS;
+	float alpha = (float)((renderTime - m_previous.time) / (m_latest.time - m_previous.time));
+	alpha = glm::clamp(alpha, 0.0f, 1.0f);
+
+	CAMERA_SNAPSHOT camera = m_latest;
+	camera.time = m_previous.time + (m_latest.time - m_previous.time) * alpha;
+	camera.position = glm::mix(m_previous.position, m_latest.position, alpha);
+	camera.yaw = glm::mix(m_previous.yaw, m_latest.yaw, alpha);
+	camera.pitch = glm::mix(m_previous.pitch, m_latest.pitch, alpha);
+
+	return(camera);
+}
+
+/***********************************************************
+ *  IsSettled()
+ *
+ *  This method is used for checking whether the camera
+ *  will stay where it is until new input arrives: the
+ *  latest snapshot applied every input sample pushed, no
+ *  movement key is held, and the last tick did not move the
+ *  camera.  Call it after GetInterpolatedCamera(), which
+ *  takes in the snapshots.
+ ***********************************************************/
+bool SimulationThread::IsSettled() const
+{
+	return((m_latest.inputCount == m_pushedInputs) &&
+		((m_pushedKeys & MOVEMENT_KEYS) == 0) &&
+		(m_latest.position == m_previous.position) &&
+		(m_latest.yaw == m_previous.yaw) &&
+		(m_latest.pitch == m_previous.pitch) &&
+		(m_latest.bOrthographic == m_previous.bOrthographic));
+}
+
+/***********************************************************
+ *  GetFront()
+ *
+ *  This method is used for getting the direction a camera
+ *  snapshot looks in.  The orthographic view always looks
+ *  straight on, down the negative Z axis.
+ ***********************************************************/
+glm::vec3 SimulationThread::GetFront(const CAMERA_SNAPSHOT& camera)
+{
+	if (camera.bOrthographic)
+	{
+		return(glm::vec3(0.0f, 0.0f, -1.0f));
+	}
+
+	glm::vec3 front;
+	front.x = cos(glm::radians(camera.yaw)) * cos(glm::radians(camera.pitch));
+	front.y = sin(glm::radians(camera.pitch));
+	front.z = sin(glm::radians(camera.yaw)) * cos(glm::radians(camera.pitch));
+
+	return(glm::normalize(front));
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is the body of the simulation thread.  Each
+ *  tick is due at a fixed time from the start, so the ticks
+ *  do not drift with how long the sleeps take.  Ticks that
+ *  fell behind run back to back, up to a limit, after which
+ *  the schedule restarts from now so a long stall does not
+ *  turn into a burst of catching up.  A snapshot is stamped
+ *  with the time its tick was due, which is what the render
+ *  thread interpolates against.  After a tick with nothing
+ *  to do the thread parks; once input wakes it, the resting
+ *  camera is published again stamped with the wake time, so
+ *  the render thread moves off from there rather than from
+ *  when the thread parked.
+ ***********************************************************/
+void SimulationThread::Run()
+{
+	TRACE_THREAD_NAME("simulation");
+
+	const std::chrono::duration<double> tickLength(TICK_SECONDS);
+	std::chrono::steady_clock::time_point nextTick = m_startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(tickLength);
+
+	while (!m_bStopping)
+	{
+		std::this_thread::sleep_until(nextTick);
+
+		int ticksRun = 0;
+		bool bActive = true;
+		while ((std::chrono::steady_clock::now() >= nextTick) && !m_bStopping)
+		{
+			if (ticksRun == MAX_CATCH_UP_TICKS)
+			{
+				nextTick = std::chrono::steady_clock::now();
+			}
+
+			bActive = Step();
+			m_state.time = std::chrono::duration<double>(nextTick - m_startTime).count();
+			Publish();
+
+			nextTick += std::chrono::duration_cast<std::chrono::steady_clock::duration>(tickLength);
+			ticksRun++;
+		}
+
+		if (!bActive && !m_bStopping)
+		{
+			Park();
+
+			nextTick = std::chrono::steady_clock::now();
+			m_state.tick++;
+			m_state.time = std::chrono::duration<double>(nextTick - m_startTime).count();
+			Publish();
+			nextTick += std::chrono::duration_cast<std::chrono::steady_clock::duration>(tickLength);
+		}
+	}
+}
+
+/***********************************************************
+ *  Step()
+ *
+ *  This method is used for advancing the camera by one tick.
+ *  Every input sample that arrived since the last tick is
+ *  applied: its mouse and wheel movement adds up, the
+ *  projection keys switch on the sample they went down in,
+ *  and the keys held in the newest sample move the camera
+ *  by a tick's worth of its speed.
+ ***********************************************************/
+bool SimulationThread::Step()
+{
+	TRACE_SCOPE("tick");
+
+	bool bActive = false;
+	INPUT_SAMPLE input;
+	while (m_inputs.Pop(input))
+	{
+		bActive = true;
+		m_state.inputCount++;
+
+		uint32_t pressedKeys = input.keys & ~m_heldKeys;
+		if ((pressedKeys & KEY_PERSPECTIVE) != 0)
+		{
+			m_state.bOrthographic = false;
+		}
+		if ((pressedKeys & KEY_ORTHOGRAPHIC) != 0)
+		{
+			m_state.bOrthographic = true;
+		}
+		m_heldKeys = input.keys;
+
+		m_state.yaw += input.mouseDeltaX * MOUSE_SENSITIVITY;
+		m_state.pitch += input.mouseDeltaY * MOUSE_SENSITIVITY;
+		m_state.pitch = glm::clamp(m_state.pitch, -MAX_PITCH, MAX_PITCH);
+
+		m_moveSpeed += input.scroll * SCROLL_SPEED_STEP;
+		m_moveSpeed = glm::clamp(m_moveSpeed, MIN_MOVE_SPEED, MAX_MOVE_SPEED);
+	}
+
+	// WASD moves along the view, QE up and down
+	glm::vec3 front = GetFront(m_state);
+	glm::vec3 up(0.0f, 1.0f, 0.0f);
+	glm::vec3 right = glm::normalize(glm::cross(front, up));
+	float distance = m_moveSpeed * (float)TICK_SECONDS;
+
+	if ((m_heldKeys & KEY_FORWARD) != 0) m_state.position += front * distance;
+	if ((m_heldKeys & KEY_BACK) != 0) m_state.position -= front * distance;
+	if ((m_heldKeys & KEY_LEFT) != 0) m_state.position -= right * distance;
+	if ((m_heldKeys & KEY_RIGHT) != 0) m_state.position += right * distance;
+	if ((m_heldKeys & KEY_DOWN) != 0) m_state.position -= up * distance;
+	if ((m_heldKeys & KEY_UP) != 0) m_state.position += up * distance;
+
+	m_state.tick++;
+
+	return(bActive || ((m_heldKeys & MOVEMENT_KEYS) != 0));
+}
+
+/***********************************************************
+ *  Publish()
+ *
+ *  This method is used for handing the current state to the
+ *  render thread together with the state published before
+ *  it, so the render thread always has the two latest ticks
+ *  to interpolate between, even when it missed the ones in
+ *  between.
+ ***********************************************************/
+void SimulationThread::Publish()
+{
+	SNAPSHOT_PAIR snapshots;
+	snapshots.previous = m_published;
+	snapshots.latest = m_state;
+	m_snapshots.Write(snapshots);
+	m_published = m_state;
+}
+
+/***********************************************************
+ *  Park()
+ *
+ *  This method is used for sleeping until input arrives.
+ *  The parked flag is raised before the ring is checked and
+ *  PushInput() checks the flag after pushing, with a full
+ *  fence on both sides, so at least one of them sees the
+ *  other: either the simulation finds the input, or the
+ *  render thread finds it parked and wakes it.
+ ***********************************************************/
+void SimulationThread::Park()
+{
+	TRACE_SCOPE("parked");
+
+	std::unique_lock<std::mutex> lock(m_parkMutex);
+	m_bParked = true;
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	m_inputPushed.wait(lock, [this]()
+		{
+			return(m_bStopping || !m_inputs.IsEmpty());
+		});
+	m_bParked = false;
+}
+
+/***********************************************************
+ *  Unpark()
+ *
+ *  This method is used for waking the simulation thread
+ *  when it is parked.  Taking the mutex makes sure it is
+ *  already waiting, so the notification is not missed.
+ ***********************************************************/
+void SimulationThread::Unpark()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!m_bParked)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_parkMutex);
+	}
+	m_inputPushed.notify_one();
+}
+
+/***********************************************************
+ *  GetTime()
+ *
+ *  This method is used for getting the seconds passed on
+ *  the simulation clock since the thread started.
+ ***********************************************************/
+double SimulationThread::GetTime() const
+{
+	return(std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count());
+}
@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////
+// simulationthread.h
+// ============
+// step the camera at a fixed rate on a thread of its own and hand the
+// results to the render thread as snapshots to interpolate between
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SpscRing.h"
+#include "TripleBuffer.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+/***********************************************************
+ *  SimulationThread
+ *
+ *  This class runs the camera movement at a fixed tick on
+ *  its own thread, so how far the camera moves no longer
+ *  depends on the frame rate.  The render thread, which has
+ *  to poll the window events, passes the keys held and the
+ *  mouse and wheel movement to the simulation through a
+ *  lock-free ring, and each tick publishes the camera of
+ *  the last two ticks through a triple buffer, which always
+ *  keeps the newest pair however long the render thread
+ *  stays away.  The render thread draws one
+ *  tick in the past, between the two latest snapshots, so
+ *  the motion stays smooth at any frame rate, and a late
+ *  tick only holds the camera still instead of making it
+ *  jump.  While no input arrives and no movement key is
+ *  held, the thread parks until the next input instead of
+ *  ticking on unchanged state.
+ ***********************************************************/
+class SimulationThread
+{
+public:
+	// simulation steps per second
+	static const int TICKS_PER_SECOND = 120;
+
+	// keys that drive the camera, as bits of INPUT_SAMPLE keys
+	enum INPUT_KEY
+	{
+		KEY_FORWARD = 1 << 0,
+		KEY_BACK = 1 << 1,
+		KEY_LEFT = 1 << 2,
+		KEY_RIGHT = 1 << 3,
+		KEY_DOWN = 1 << 4,
+		KEY_UP = 1 << 5,
+		KEY_PERSPECTIVE = 1 << 6,
+		KEY_ORTHOGRAPHIC = 1 << 7
+	};
+
+	// the input gathered by the render thread in one frame
+	struct INPUT_SAMPLE
+	{
+		uint32_t keys;		// INPUT_KEY bits held down
+		float mouseDeltaX;	// cursor movement in pixels
+		float mouseDeltaY;	// positive upwards
+		float scroll;		// wheel movement
+	};
+
+	// the camera as of one tick
+	struct CAMERA_SNAPSHOT
+	{
+		uint64_t tick;
+		double time;		// simulation time of the tick, in seconds
+		glm::vec3 position;
+		float yaw;			// degrees
+		float pitch;		// degrees
+		bool bOrthographic;
+		uint64_t inputCount;	// input samples applied up to this tick
+	};
+
+	// constructor
+	SimulationThread(const glm::vec3& position, float yaw, float pitch);
+	// destructor - stops the thread
+	~SimulationThread();
+
+	// start and stop the simulation thread
+	void Start();
+	void Stop();
+
+	// pass the input of a frame to the simulation, returns
+	// false when the simulation has not taken the earlier
+	// input yet and the ring is full
+	bool PushInput(const INPUT_SAMPLE& input);
+	// take the newly published snapshots and get the camera
+	// one tick before now, between the two latest ones
+	CAMERA_SNAPSHOT GetInterpolatedCamera();
+	// check whether the simulation applied all the input
+	// pushed so far and the camera came to rest
+	bool IsSettled() const;
+	// get the view direction of a camera snapshot
+	static glm::vec3 GetFront(const CAMERA_SNAPSHOT& camera);
+
+private:
+	// the two latest snapshots, published together
+	struct SNAPSHOT_PAIR
+	{
+		CAMERA_SNAPSHOT previous;
+		CAMERA_SNAPSHOT latest;
+	};
+
+	// input from the render thread and snapshots to it
+	SpscRing<INPUT_SAMPLE, 256> m_inputs;
+	TripleBuffer<SNAPSHOT_PAIR> m_snapshots;
+	std::thread m_thread;
+	std::atomic<bool> m_bStopping;
+	// set while the simulation thread sleeps waiting for input,
+	// the mutex and condition only serve to wake it
+	std::atomic<bool> m_bParked;
+	std::mutex m_parkMutex;
+	std::condition_variable m_inputPushed;
+	// the clock both threads measure simulation time on
+	std::chrono::steady_clock::time_point m_startTime;
+
+	// simulation state and the snapshot published last, only
+	// touched by the simulation thread
+	CAMERA_SNAPSHOT m_state;
+	CAMERA_SNAPSHOT m_published;
+	float m_moveSpeed;
+	uint32_t m_heldKeys;
+
+	// the two latest snapshots, the input samples pushed and
+	// the keys of the last one, only touched by the render thread
+	CAMERA_SNAPSHOT m_previous;
+	CAMERA_SNAPSHOT m_latest;
+	uint64_t m_pushedInputs;
+	uint32_t m_pushedKeys;
+
+	// body of the simulation thread
+	void Run();
+	// advance the simulation by one tick, returns false when
+	// there was no input and no movement key is held
+	bool Step();
+	// publish the current state with the one published before
+	void Publish();
+	// sleep until input arrives or the thread is stopped
+	void Park();
+	// wake the thread when it is parked
+	void Unpark();
+	// get the seconds passed on the simulation clock
+	double GetTime() const;
+};
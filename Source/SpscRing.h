@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////
+// spscring.h
+// ============
+// fixed-size lock-free queue between exactly one producer thread and
+// one consumer thread
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/***********************************************************
+ *  SpscRing
+ *
+ *  This class passes values from one thread to another
+ *  without locks.  Only the producer moves the write index
+ *  and only the consumer moves the read index, so each
+ *  index has a single writer; the release store of an index
+ *  publishes the slot it passed, and the acquire load on
+ *  the other side sees the slot before using it.  The two
+ *  indices sit on separate cache lines so the threads do
+ *  not fight over one line.  The indices only count up and
+ *  are masked into the slots, so a full ring still leaves
+ *  every slot usable.
+ ***********************************************************/
+template <typename T, size_t CAPACITY>
+class SpscRing
+{
+	static_assert((CAPACITY > 0) && ((CAPACITY & (CAPACITY - 1)) == 0), "SpscRing capacity must be a power of two");
+
+public:
+	// constructor
+	SpscRing()
+	{
+		m_readIndex = 0;
+		m_writeIndex = 0;
+	}
+
+	// add a value, from the producer thread only, returns
+	// false when the ring is full
+	bool Push(const T& value)
+	{
+		size_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+		if (writeIndex - m_readIndex.load(std::memory_order_acquire) >= CAPACITY)
+		{
+			return(false);
+		}
+
+		m_slots[writeIndex & (CAPACITY - 1)] = value;
+		m_writeIndex.store(writeIndex + 1, std::memory_order_release);
+		return(true);
+	}
+
+	// check whether the ring holds no value, from the
+	// consumer thread only
+	bool IsEmpty() const
+	{
+		return(m_readIndex.load(std::memory_order_relaxed) == m_writeIndex.load(std::memory_order_acquire));
+	}
+
+	// take the oldest value, from the consumer thread only,
+	// returns false when the ring is empty
+	bool Pop(T& value)
+	{
+		size_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+		if (readIndex == m_writeIndex.load(std::memory_order_acquire))
+		{
+			return(false);
+		}
+
+		value = m_slots[readIndex & (CAPACITY - 1)];
+		m_readIndex.store(readIndex + 1, std::memory_order_release);
+		return(true);
+	}
+
+private:
+	// size of a cache line, the padding keeping the indices
+	// on separate lines without needing over-aligned new
+	static const size_t CACHE_LINE_SIZE = 64;
+
+	T m_slots[CAPACITY];
+	char m_slotsPadding[CACHE_LINE_SIZE];
+	// next slot to read, written by the consumer only
+	std::atomic<size_t> m_readIndex;
+	char m_readPadding[CACHE_LINE_SIZE];
+	// next slot to write, written by the producer only
+	std::atomic<size_t> m_writeIndex;
+};
@@ -0,0 +1,548 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture images on worker threads and upload them to OpenGL
+// a few at a time from the render thread
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+#include "CookedTexture.h"
+#include "RenderStats.h"
+#include "TraceRecorder.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// color of the placeholder shown until a texture is resident
+	const unsigned char g_PlaceholderPixel[4] = { 128, 128, 128, 255 };
+	// most decode threads started when no count is passed in
+	const unsigned int MAX_DEFAULT_WORKERS = 4;
+
+	/***********************************************************
+	 *  MapFile()
+	 *
+	 *  This function is used for mapping a whole file into
+	 *  memory read-only.  NULL is returned when the file does
+	 *  not exist or cannot be mapped.
+	 ***********************************************************/
+	unsigned char* MapFile(const std::string& path, size_t& size)
+	{
+		size = 0;
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return(NULL);
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart == 0))
+		{
+			CloseHandle(file);
+			return(NULL);
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		CloseHandle(file);
+		if (NULL == mapping)
+		{
+			return(NULL);
+		}
+
+		// the view keeps the mapping alive once the handle is closed
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (NULL == view)
+		{
+			return(NULL);
+		}
+
+		size = (size_t)fileSize.QuadPart;
+		return((unsigned char*)view);
+#else
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			return(NULL);
+		}
+
+		struct stat fileInfo;
+		if ((fstat(file, &fileInfo) != 0) || (fileInfo.st_size == 0))
+		{
+			close(file);
+			return(NULL);
+		}
+
+		void* view = mmap(NULL, (size_t)fileInfo.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+		if (view == MAP_FAILED)
+		{
+			return(NULL);
+		}
+
+		size = (size_t)fileInfo.st_size;
+		return((unsigned char*)view);
+#endif
+	}
+
+	/***********************************************************
+	 *  UnmapFile()
+	 *
+	 *  This function is used for unmapping a file mapped with
+	 *  MapFile().
+	 ***********************************************************/
+	void UnmapFile(unsigned char* data, size_t size)
+	{
+		if (NULL == data)
+		{
+			return;
+		}
+
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+#else
+		munmap(data, size);
+#endif
+	}
+}
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureLoader::TextureLoader(GLStateCache* pStateCache, unsigned int workerCount)
+{
+	m_pStateCache = pStateCache;
+	m_uploadBuffer = 0;
+	m_pendingCount = 0;
+	m_bStopping = false;
+
+	// cooked BC1 textures are decoded from the source image instead
+	// when the driver cannot sample S3TC compressed textures
+	m_bSupportsBC1 = (GLEW_EXT_texture_compression_s3tc != GL_FALSE);
+
+	glGenBuffers(1, &m_uploadBuffer);
+
+	// leave one core for the render thread
+	if (workerCount == 0)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		workerCount = (cores > 1) ? std::min(cores - 1, MAX_DEFAULT_WORKERS) : 1;
+	}
+
+	// the stb_image flip setting is global and not thread safe, so
+	// it is fixed here once and the workers flip the rows themselves
+	stbi_set_flip_vertically_on_load(false);
+
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		m_workers.emplace_back(&TextureLoader::DecodeWorker, this);
+	}
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_decodeMutex);
+		m_bStopping = true;
+	}
+	m_decodeReady.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+
+	// free the images that were decoded but never uploaded
+	for (DECODED_IMAGE& image : m_decodedImages)
+	{
+		ReleaseImage(image);
+	}
+	m_decodedImages.clear();
+
+	glDeleteBuffers(1, &m_uploadBuffer);
+	m_uploadBuffer = 0;
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  RequestTexture()
+ *
+ *  This method is used for creating a texture that shows a
+ *  placeholder image, and queueing the image file to be
+ *  decoded into it.  It must be called on the render thread.
+ ***********************************************************/
+GLuint TextureLoader::RequestTexture(const std::string& path, bool flipY, GLint minFilter)
+{
+	GLuint texture = 0;
+
+	glGenTextures(1, &texture);
+	m_pStateCache->BindTexture2D(0, texture);
+
+	// set the texture wrapping and filtering parameters, which
+	// stay with the texture when the real image arrives
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, g_PlaceholderPixel);
+	RenderStats::CountBufferUpload(sizeof(g_PlaceholderPixel));
+
+	{
+		std::lock_guard<std::mutex> lock(m_decodeMutex);
+		m_decodeJobs.push_back({ texture, path, flipY });
+	}
+	m_decodeReady.notify_one();
+	m_pendingCount++;
+
+	return(texture);
+}
+
+/***********************************************************
+ *  GetPendingCount()
+ *
+ *  This method is used for getting the number of requested
+ *  textures that still show the placeholder image.
+ ***********************************************************/
+size_t TextureLoader::GetPendingCount() const
+{
+	return(m_pendingCount);
+}
+
+/***********************************************************
+ *  DecodeWorker()
+ *
+ *  This method is used as the body of the decode worker
+ *  threads.  Each one takes jobs off the queue until the
+ *  loader is destroyed.
+ ***********************************************************/
+void TextureLoader::DecodeWorker()
+{
+	TRACE_THREAD_NAME("texture decode");
+
+	for (;;)
+	{
+		DECODE_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_decodeMutex);
+			m_decodeReady.wait(lock, [this]() { return(m_bStopping || !m_decodeJobs.empty()); });
+			if (m_bStopping)
+			{
+				return;
+			}
+			job = m_decodeJobs.front();
+			m_decodeJobs.pop_front();
+		}
+
+		TRACE_BEGIN("DecodeImage");
+		DECODED_IMAGE image = DecodeImage(job);
+		TRACE_END("DecodeImage");
+
+		std::lock_guard<std::mutex> lock(m_decodedMutex);
+		m_decodedImages.push_back(image);
+	}
+}
+
+/***********************************************************
+ *  DecodeImage()
+ *
+ *  This method is used for decoding an image file into
+ *  memory on a worker thread, flipping it vertically when
+ *  requested.  A usable cooked texture is mapped instead of
+ *  decoding the image.  Only RGB and RGBA images are
+ *  supported.
+ ***********************************************************/
+TextureLoader::DECODED_IMAGE TextureLoader::DecodeImage(const DECODE_JOB& job)
+{
+	DECODED_IMAGE image = { job.texture, job.path, 0, 0, 0, NULL, NULL, 0 };
+
+	if (MapCookedTexture(job, image))
+	{
+		return(image);
+	}
+
+	image.pixels = stbi_load(job.path.c_str(), &image.width, &image.height, &image.channels, 0);
+	if (NULL == image.pixels)
+	{
+		return(image);
+	}
+
+	if ((image.channels != 3) && (image.channels != 4))
+	{
+		stbi_image_free(image.pixels);
+		image.pixels = NULL;
+		return(image);
+	}
+
+	if (job.flipY)
+	{
+		size_t rowBytes = (size_t)image.width * image.channels;
+		std::vector<unsigned char> row(rowBytes);
+		for (int top = 0, bottom = image.height - 1; top < bottom; top++, bottom--)
+		{
+			unsigned char* topRow = image.pixels + top * rowBytes;
+			unsigned char* bottomRow = image.pixels + bottom * rowBytes;
+			memcpy(row.data(), topRow, rowBytes);
+			memcpy(topRow, bottomRow, rowBytes);
+			memcpy(bottomRow, row.data(), rowBytes);
+		}
+	}
+
+	return(image);
+}
+
+/***********************************************************
+ *  MapCookedTexture()
+ *
+ *  This method is used for mapping the cooked texture of an
+ *  image file into memory.  False is returned when there is
+ *  no cooked texture, or when it is damaged, flipped the
+ *  other way, or compressed in a format the driver lacks -
+ *  the source image is decoded in those cases.
+ ***********************************************************/
+bool TextureLoader::MapCookedTexture(const DECODE_JOB& job, DECODED_IMAGE& image)
+{
+	size_t size = 0;
+	unsigned char* cookedFile = MapFile(GetCookedTexturePath(job.path), size);
+
+	if (NULL == cookedFile)
+	{
+		return(false);
+	}
+
+	COOKED_TEXTURE_HEADER header = {};
+	bool bUsable = ValidateCookedTexture(cookedFile, size);
+	if (bUsable)
+	{
+		memcpy(&header, cookedFile, sizeof(header));
+		bUsable = (((header.flags & COOKED_FLAG_FLIPPED_Y) != 0) == job.flipY) &&
+			((header.format != COOKED_FORMAT_BC1) || m_bSupportsBC1);
+	}
+
+	if (!bUsable)
+	{
+		UnmapFile(cookedFile, size);
+		return(false);
+	}
+
+	image.width = (int)header.width;
+	image.height = (int)header.height;
+	image.channels = 4;
+	image.cookedFile = cookedFile;
+	image.cookedSize = size;
+
+	return(true);
+}
+
+/***********************************************************
+ *  ReleaseImage()
+ *
+ *  This method is used for freeing the decoded pixels or
+ *  unmapping the cooked texture held by an image.
+ ***********************************************************/
+void TextureLoader::ReleaseImage(DECODED_IMAGE& image)
+{
+	if (NULL != image.pixels)
+	{
+		stbi_image_free(image.pixels);
+		image.pixels = NULL;
+	}
+	if (NULL != image.cookedFile)
+	{
+		UnmapFile(image.cookedFile, image.cookedSize);
+		image.cookedFile = NULL;
+		image.cookedSize = 0;
+	}
+}
+
+/***********************************************************
+ *  PumpUploads()
+ *
+ *  This method is used for uploading the decoded images to
+ *  their textures.  It is called once per frame on the
+ *  render thread, and stops after the byte budget is used so
+ *  no single frame stalls on a large batch of textures.
+ ***********************************************************/
+void TextureLoader::PumpUploads(size_t maxBytesPerCall)
+{
+	TRACE_SCOPE("PumpUploads");
+
+	size_t uploadedBytes = 0;
+
+	while (uploadedBytes < maxBytesPerCall)
+	{
+		DECODED_IMAGE image;
+		{
+			std::lock_guard<std::mutex> lock(m_decodedMutex);
+			if (m_decodedImages.empty())
+			{
+				break;
+			}
+			image = m_decodedImages.front();
+			m_decodedImages.pop_front();
+		}
+
+		m_pendingCount--;
+
+		if (NULL != image.cookedFile)
+		{
+			std::cout << "Successfully loaded cooked texture for image:" << image.path << ", width:" << image.width << ", height:" << image.height << std::endl;
+
+			UploadCookedTexture(image);
+			uploadedBytes += image.cookedSize;
+		}
+		else if (NULL != image.pixels)
+		{
+			std::cout << "Successfully loaded image:" << image.path << ", width:" << image.width << ", height:" << image.height << ", channels:" << image.channels << std::endl;
+
+			UploadImage(image);
+			uploadedBytes += (size_t)image.width * image.height * image.channels;
+		}
+		else
+		{
+			std::cout << "Could not load image:" << image.path << std::endl;
+		}
+
+		ReleaseImage(image);
+	}
+}
+
+/***********************************************************
+ *  UploadImage()
+ *
+ *  This method is used for copying one decoded image into
+ *  the pixel buffer object and specifying the texture from
+ *  it, so the driver can transfer the pixels without
+ *  holding up the render thread.  The mipmaps are then
+ *  generated from the new image.
+ ***********************************************************/
+void TextureLoader::UploadImage(const DECODED_IMAGE& image)
+{
+	TRACE_SCOPE("UploadImage");
+
+	GLsizeiptr size = (GLsizeiptr)image.width * image.height * image.channels;
+
+	// orphan the previous contents so the map never waits on
+	// an upload that is still in flight
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+
+	void* staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (NULL != staging)
+	{
+		memcpy(staging, image.pixels, (size_t)size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+
+	GLenum format = (image.channels == 4) ? GL_RGBA : GL_RGB;
+	GLint internalFormat = (image.channels == 4) ? GL_RGBA8 : GL_RGB8;
+
+	m_pStateCache->BindTexture2D(0, image.texture);
+
+	// RGB rows are not always a multiple of 4 bytes long
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (NULL != staging)
+	{
+		// the data pointer is an offset into the bound pixel buffer
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, (const void*)0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	else
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	RenderStats::CountBufferUpload((size_t)size);
+
+	// generate the texture mipmaps for mapping textures to lower resolutions
+	glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+/***********************************************************
+ *  UploadCookedTexture()
+ *
+ *  This method is used for copying the levels of a mapped
+ *  cooked texture into the pixel buffer object and
+ *  specifying every mip level of the texture from it.  The
+ *  mip chain was built by the cooker, so no mipmaps are
+ *  generated here.
+ ***********************************************************/
+void TextureLoader::UploadCookedTexture(const DECODED_IMAGE& image)
+{
+	TRACE_SCOPE("UploadCookedTexture");
+
+	COOKED_TEXTURE_HEADER header;
+	memcpy(&header, image.cookedFile, sizeof(header));
+
+	std::vector<COOKED_TEXTURE_LEVEL> levels(header.levelCount);
+	memcpy(levels.data(), image.cookedFile + sizeof(header), levels.size() * sizeof(COOKED_TEXTURE_LEVEL));
+
+	// stage the whole file, so each level is an offset into the buffer
+	GLsizeiptr size = (GLsizeiptr)image.cookedSize;
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+
+	void* staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (NULL != staging)
+	{
+		memcpy(staging, image.cookedFile, (size_t)size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+	else
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	m_pStateCache->BindTexture2D(0, image.texture);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)header.levelCount - 1);
+
+	for (GLint i = 0; i < (GLint)levels.size(); i++)
+	{
+		// with the pixel buffer bound the data pointer is an offset into it
+		const void* levelData = (NULL != staging) ?
+			(const void*)(uintptr_t)levels[i].offset :
+			(const void*)(image.cookedFile + levels[i].offset);
+		if (header.format == COOKED_FORMAT_BC1)
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, i, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+				levels[i].width, levels[i].height, 0, levels[i].size, levelData);
+		}
+		else
+		{
+			glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8,
+				levels[i].width, levels[i].height, 0, GL_RGBA, GL_UNSIGNED_BYTE, levelData);
+		}
+	}
+	RenderStats::CountBufferUpload((size_t)size);
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
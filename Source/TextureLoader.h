@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture images on worker threads and upload them to OpenGL
+// a few at a time from the render thread
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLStateCache.h"
+
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class loads textures without blocking the render
+ *  thread.  A requested texture gets its OpenGL name right
+ *  away, holding a 1x1 placeholder image.  Worker threads
+ *  decode the image files, and PumpUploads() copies the
+ *  decoded images into their textures through a pixel buffer
+ *  object, within a byte budget per frame.  The texture name
+ *  never changes, so draws can use it from the start.
+ *
+ *  When a cooked texture (see CookedTexture.h) sits next to
+ *  the source image, it is memory mapped instead, and its
+ *  prebuilt mip levels are uploaded without any decoding.
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// constructor - starts the decode worker threads
+	TextureLoader(GLStateCache* pStateCache, unsigned int workerCount = 0);
+	// destructor - stops the worker threads
+	~TextureLoader();
+
+	// request a texture, returning its OpenGL name at once
+	GLuint RequestTexture(
+		const std::string& path,
+		bool flipY = true,
+		GLint minFilter = GL_LINEAR_MIPMAP_LINEAR);
+	// upload decoded images, stopping once the byte budget is
+	// used - at least one image is uploaded per call
+	void PumpUploads(size_t maxBytesPerCall = 8 * 1024 * 1024);
+	// number of requested textures that are not resident yet
+	size_t GetPendingCount() const;
+
+private:
+	// one image file waiting to be decoded
+	struct DECODE_JOB
+	{
+		GLuint texture;
+		std::string path;
+		bool flipY;
+	};
+
+	// one decoded image waiting to be uploaded - either the
+	// decoded pixels or a mapped cooked texture file
+	struct DECODED_IMAGE
+	{
+		GLuint texture;
+		std::string path;
+		int width;
+		int height;
+		int channels;
+		unsigned char* pixels;		// NULL when decoding failed
+		unsigned char* cookedFile;	// NULL when not cooked
+		size_t cookedSize;
+	};
+
+	// pointer to the OpenGL state cache used for texture binds
+	GLStateCache* m_pStateCache;
+	// pixel buffer object the images are staged in for upload
+	GLuint m_uploadBuffer;
+	// requested textures that are not resident yet
+	size_t m_pendingCount;
+	// BC1 cooked textures can be used by this driver
+	bool m_bSupportsBC1;
+
+	// decode worker threads and their job queue
+	std::vector<std::thread> m_workers;
+	std::deque<DECODE_JOB> m_decodeJobs;
+	std::mutex m_decodeMutex;
+	std::condition_variable m_decodeReady;
+	bool m_bStopping;
+
+	// decoded images waiting for the render thread
+	std::deque<DECODED_IMAGE> m_decodedImages;
+	std::mutex m_decodedMutex;
+
+	// body of each decode worker thread
+	void DecodeWorker();
+	// decode one image file into memory
+	DECODED_IMAGE DecodeImage(const DECODE_JOB& job);
+	// map the cooked texture of an image file into memory
+	bool MapCookedTexture(const DECODE_JOB& job, DECODED_IMAGE& image);
+	// copy one decoded image into its texture
+	void UploadImage(const DECODED_IMAGE& image);
+	// copy the levels of one cooked texture into its texture
+	void UploadCookedTexture(const DECODED_IMAGE& image);
+	// free the memory held by one decoded image
+	void ReleaseImage(DECODED_IMAGE& image);
+};
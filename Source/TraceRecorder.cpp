@@ -0,0 +1,257 @@
+///////////////////////////////////////////////////////////////////////////////
+// tracerecorder.cpp
+// ============
+// record begin/end events of named scopes on every thread and write them
+// as a Chrome trace (trace.json) for chrome://tracing or Perfetto
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TraceRecorder.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// one recorded begin or end event
+	struct TRACE_EVENT
+	{
+		const char* name;
+		char phase;
+		double timestampMicroseconds;
+	};
+
+	// the events of one thread - only that thread writes to it
+	struct THREAD_BUFFER
+	{
+		unsigned int threadID;
+		std::atomic<const char*> threadName;
+		std::atomic<size_t> count;
+		std::atomic<size_t> dropped;
+		// scopes begun and not yet ended, whose end events have
+		// room kept for them, and the scopes nested in the first
+		// dropped one, whose events are all dropped
+		size_t openScopes;
+		size_t droppedScopes;
+		std::unique_ptr<TRACE_EVENT[]> events;
+	};
+
+	// every thread buffer, kept until the program exits so the
+	// events of threads that already ended are still written
+	std::mutex g_RegistryMutex;
+	std::vector<std::unique_ptr<THREAD_BUFFER>> g_ThreadBuffers;
+
+	// time all the event timestamps are relative to
+	const std::chrono::steady_clock::time_point g_TraceEpoch = std::chrono::steady_clock::now();
+
+	// buffer of the calling thread, created on its first event
+	thread_local THREAD_BUFFER* t_pThreadBuffer = NULL;
+
+	/***********************************************************
+	 *  GetThreadBuffer()
+	 *
+	 *  This function is used for getting the buffer of the
+	 *  calling thread, registering a new one the first time.
+	 ***********************************************************/
+	THREAD_BUFFER* GetThreadBuffer()
+	{
+		if (NULL == t_pThreadBuffer)
+		{
+			std::unique_ptr<THREAD_BUFFER> buffer(new THREAD_BUFFER());
+			buffer->threadName = NULL;
+			buffer->count = 0;
+			buffer->dropped = 0;
+			buffer->openScopes = 0;
+			buffer->droppedScopes = 0;
+			buffer->events.reset(new TRACE_EVENT[TraceRecorder::EVENTS_PER_THREAD]);
+
+			std::lock_guard<std::mutex> lock(g_RegistryMutex);
+			buffer->threadID = (unsigned int)g_ThreadBuffers.size() + 1;
+			t_pThreadBuffer = buffer.get();
+			g_ThreadBuffers.push_back(std::move(buffer));
+		}
+
+		return(t_pThreadBuffer);
+	}
+
+	/***********************************************************
+	 *  WriteEscaped()
+	 *
+	 *  This function is used for writing a string as a JSON
+	 *  string value.
+	 ***********************************************************/
+	void WriteEscaped(std::ostream& output, const char* text)
+	{
+		output << '"';
+		for (const char* c = text; *c != '\0'; c++)
+		{
+			if ((*c == '"') || (*c == '\\'))
+				output << '\\';
+			output << *c;
+		}
+		output << '"';
+	}
+}
+
+std::atomic<bool> TraceRecorder::m_bRecording(false);
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting to record events.
+ ***********************************************************/
+void TraceRecorder::Start()
+{
+	m_bRecording = true;
+}
+
+/***********************************************************
+ *  IsRecording()
+ *
+ *  This method is used for checking whether events are
+ *  being recorded.
+ ***********************************************************/
+bool TraceRecorder::IsRecording()
+{
+	return(m_bRecording.load(std::memory_order_relaxed));
+}
+
+/***********************************************************
+ *  Record()
+ *
+ *  This method is used for recording one event in the
+ *  buffer of the calling thread.  A begin event is only
+ *  recorded while its end and the ends of the scopes open
+ *  around it still fit; once one is dropped, everything up
+ *  to its end is dropped too, so the trace stays balanced.
+ ***********************************************************/
+void TraceRecorder::Record(const char* name, char phase)
+{
+	if (!m_bRecording.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	THREAD_BUFFER* pBuffer = GetThreadBuffer();
+	size_t index = pBuffer->count.load(std::memory_order_relaxed);
+	if (phase == 'B')
+	{
+		if ((pBuffer->droppedScopes > 0) || (index + pBuffer->openScopes + 2 > EVENTS_PER_THREAD))
+		{
+			pBuffer->droppedScopes++;
+			pBuffer->dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		pBuffer->openScopes++;
+	}
+	else if (pBuffer->droppedScopes > 0)
+	{
+		pBuffer->droppedScopes--;
+		pBuffer->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	else if (pBuffer->openScopes > 0)
+	{
+		pBuffer->openScopes--;
+	}
+	else if (index >= EVENTS_PER_THREAD)
+	{
+		pBuffer->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	TRACE_EVENT& event = pBuffer->events[index];
+	event.name = name;
+	event.phase = phase;
+	event.timestampMicroseconds =
+		std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - g_TraceEpoch).count();
+
+	// publish the event to the writer
+	pBuffer->count.store(index + 1, std::memory_order_release);
+}
+
+/***********************************************************
+ *  SetThreadName()
+ *
+ *  This method is used for setting the name the calling
+ *  thread is labeled with in the timeline.
+ ***********************************************************/
+void TraceRecorder::SetThreadName(const char* name)
+{
+	if (!m_bRecording.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	GetThreadBuffer()->threadName.store(name, std::memory_order_release);
+}
+
+/***********************************************************
+ *  WriteFile()
+ *
+ *  This method is used for writing the recorded events in
+ *  the Chrome trace event format.  The thread names are
+ *  written as metadata events.  Scopes still open on other
+ *  threads simply have no end event yet.
+ ***********************************************************/
+bool TraceRecorder::WriteFile(const std::string& path)
+{
+	std::ofstream traceFile(path, std::ios::trunc);
+	if (!traceFile.is_open())
+	{
+		std::cout << "ERROR: could not open trace file: " << path << std::endl;
+		return(false);
+	}
+
+	traceFile << std::fixed << std::setprecision(3);
+	traceFile << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+
+	size_t eventCount = 0;
+	size_t droppedCount = 0;
+	bool bFirst = true;
+
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+	for (const std::unique_ptr<THREAD_BUFFER>& buffer : g_ThreadBuffers)
+	{
+		const char* threadName = buffer->threadName.load(std::memory_order_acquire);
+		if (NULL != threadName)
+		{
+			traceFile << (bFirst ? "" : ",\n")
+				<< "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->threadID
+				<< ", \"args\": {\"name\": ";
+			WriteEscaped(traceFile, threadName);
+			traceFile << "}}";
+			bFirst = false;
+		}
+
+		size_t count = buffer->count.load(std::memory_order_acquire);
+		for (size_t i = 0; i < count; i++)
+		{
+			const TRACE_EVENT& event = buffer->events[i];
+			traceFile << (bFirst ? "" : ",\n") << "{\"name\": ";
+			WriteEscaped(traceFile, event.name);
+			traceFile << ", \"ph\": \"" << event.phase << "\", \"ts\": " << event.timestampMicroseconds
+				<< ", \"pid\": 1, \"tid\": " << buffer->threadID << "}";
+			bFirst = false;
+		}
+
+		eventCount += count;
+		droppedCount += buffer->dropped.load(std::memory_order_relaxed);
+	}
+
+	traceFile << "\n]}\n";
+
+	std::cout << "INFO: wrote " << eventCount << " trace events to " << path << std::endl;
+	if (droppedCount > 0)
+	{
+		std::cout << "INFO: dropped " << droppedCount << " trace events past the "
+			<< EVENTS_PER_THREAD << " each thread can hold - trace a shorter session" << std::endl;
+	}
+
+	return(traceFile.good());
+}
@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+// tracerecorder.h
+// ============
+// record begin/end events of named scopes on every thread and write them
+// as a Chrome trace (trace.json) for chrome://tracing or Perfetto
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// set to 0 to compile every trace macro out
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#if TRACE_ENABLED
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+// record a scope from here to the end of the enclosing block
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+// record the begin and end of a scope that is not a block
+#define TRACE_BEGIN(name) TraceRecorder::Record(name, 'B')
+#define TRACE_END(name) TraceRecorder::Record(name, 'E')
+// name the calling thread in the timeline
+#define TRACE_THREAD_NAME(name) TraceRecorder::SetThreadName(name)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_BEGIN(name)
+#define TRACE_END(name)
+#define TRACE_THREAD_NAME(name)
+#endif
+
+/***********************************************************
+ *  TraceRecorder
+ *
+ *  This class collects the trace events.  Every thread
+ *  appends to its own fixed size buffer, so recording an
+ *  event takes no lock - a thread only takes the registry
+ *  lock once, the first time it records.  Each buffer
+ *  publishes its event count with a release store, which
+ *  lets WriteFile() read the buffers while other threads
+ *  keep recording.  A buffer holds EVENTS_PER_THREAD
+ *  events; the frame loop records about 20 a frame on the
+ *  main thread, so it fills after roughly a minute of
+ *  continuous drawing.  Later events are dropped, but room
+ *  is kept for the end events of the scopes already open,
+ *  so every begin written has its end, and WriteFile()
+ *  reports how many were dropped.  Nothing is recorded
+ *  until Start() is called.  Event names must be string
+ *  literals, since only the pointer is stored.
+ ***********************************************************/
+class TraceRecorder
+{
+public:
+	// events each thread can record before new ones are dropped
+	static const size_t EVENTS_PER_THREAD = 1 << 16;
+
+	// start recording events
+	static void Start();
+	// check whether events are being recorded
+	static bool IsRecording();
+	// record one begin ('B') or end ('E') event on the calling thread
+	static void Record(const char* name, char phase);
+	// set the name the calling thread is shown with
+	static void SetThreadName(const char* name);
+	// write every recorded event as a Chrome trace JSON file
+	static bool WriteFile(const std::string& path);
+
+private:
+	static std::atomic<bool> m_bRecording;
+};
+
+/***********************************************************
+ *  TraceScope
+ *
+ *  This class records the begin event of a scope when it is
+ *  constructed and the end event when it goes out of scope.
+ *  Use it through the TRACE_SCOPE() macro.
+ ***********************************************************/
+class TraceScope
+{
+public:
+	// constructor
+	explicit TraceScope(const char* name)
+	{
+		m_name = name;
+		TraceRecorder::Record(m_name, 'B');
+	}
+	// destructor
+	~TraceScope()
+	{
+		TraceRecorder::Record(m_name, 'E');
+	}
+
+private:
+	const char* m_name;
+
+	TraceScope(const TraceScope&);
+	TraceScope& operator=(const TraceScope&);
+};
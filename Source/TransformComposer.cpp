@@ -0,0 +1,564 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformcomposer.cpp
+// ============
+// compose model matrices from scale, Euler rotation and position in
+// closed form, one at a time or in SIMD batches
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformComposer.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || \
+	(defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define TRANSFORM_COMPOSER_SIMD 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC accepts AVX2 intrinsics in any function
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define TRANSFORM_COMPOSER_SIMD 0
+#endif
+
+// declaration of global variables
+namespace
+{
+	const float DEGREES_TO_RADIANS = 0.017453292519943295f;
+
+	/***********************************************************
+	 *  ComposeScalar()
+	 *
+	 *  This function is used for writing out the closed form
+	 *  of translation * rotX * rotY * rotZ * scale for one
+	 *  object.  The matrix is column-major, like glm.
+	 ***********************************************************/
+	void ComposeScalar(
+		float scaleX, float scaleY, float scaleZ,
+		float rotationX, float rotationY, float rotationZ,
+		float positionX, float positionY, float positionZ,
+		float* m)
+	{
+		float ax = rotationX * DEGREES_TO_RADIANS;
+		float ay = rotationY * DEGREES_TO_RADIANS;
+		float az = rotationZ * DEGREES_TO_RADIANS;
+		float cx = cosf(ax), sx = sinf(ax);
+		float cy = cosf(ay), sy = sinf(ay);
+		float cz = cosf(az), sz = sinf(az);
+
+		m[0] = cy * cz * scaleX;
+		m[1] = (cx * sz + sx * sy * cz) * scaleX;
+		m[2] = (sx * sz - cx * sy * cz) * scaleX;
+		m[3] = 0.0f;
+
+		m[4] = -cy * sz * scaleY;
+		m[5] = (cx * cz - sx * sy * sz) * scaleY;
+		m[6] = (sx * cz + cx * sy * sz) * scaleY;
+		m[7] = 0.0f;
+
+		m[8] = sy * scaleZ;
+		m[9] = -sx * cy * scaleZ;
+		m[10] = cx * cy * scaleZ;
+		m[11] = 0.0f;
+
+		m[12] = positionX;
+		m[13] = positionY;
+		m[14] = positionZ;
+		m[15] = 1.0f;
+	}
+
+	/***********************************************************
+	 *  ComposeRangeScalar()
+	 *
+	 *  This function is used for composing a range of objects
+	 *  one at a time.
+	 ***********************************************************/
+	void ComposeRangeScalar(const TRANSFORM_ARRAYS& t, size_t first, size_t last, unsigned char* pOutput, size_t outputStride)
+	{
+		for (size_t i = first; i < last; i++)
+		{
+			float m[16];
+			ComposeScalar(
+				t.scaleX[i], t.scaleY[i], t.scaleZ[i],
+				t.rotationX[i], t.rotationY[i], t.rotationZ[i],
+				t.positionX[i], t.positionY[i], t.positionZ[i],
+				m);
+			memcpy(pOutput + (i - first) * outputStride, m, sizeof(m));
+		}
+	}
+
+#if TRANSFORM_COMPOSER_SIMD
+	// polynomial sine and cosine after reducing the angle to
+	// [-pi/4, pi/4], accurate to about one float ulp
+	const float FOUR_OVER_PI = 1.27323954473516f;
+	const float PI_PART_1 = -0.78515625f;
+	const float PI_PART_2 = -2.4187564849853515625e-4f;
+	const float PI_PART_3 = -3.77489497744594108e-8f;
+	const float SIN_P0 = -1.9515295891e-4f;
+	const float SIN_P1 = 8.3321608736e-3f;
+	const float SIN_P2 = -1.6666654611e-1f;
+	const float COS_P0 = 2.443315711809948e-5f;
+	const float COS_P1 = -1.388731625493765e-3f;
+	const float COS_P2 = 4.166664568298827e-2f;
+
+	/***********************************************************
+	 *  SinCos4()
+	 *
+	 *  This function is used for the sine and cosine of four
+	 *  angles in radians with SSE2.
+	 ***********************************************************/
+	void SinCos4(__m128 x, __m128& sine, __m128& cosine)
+	{
+		const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000));
+
+		__m128 signSin = _mm_and_ps(x, signMask);
+		x = _mm_andnot_ps(signMask, x);
+
+		// octant of the angle, rounded up to even
+		__m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(FOUR_OVER_PI)));
+		octant = _mm_add_epi32(octant, _mm_set1_epi32(1));
+		octant = _mm_and_si128(octant, _mm_set1_epi32(~1));
+		__m128 y = _mm_cvtepi32_ps(octant);
+
+		__m128 swapSignSin = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29));
+		__m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+		__m128 signCos = _mm_castsi128_ps(_mm_slli_epi32(
+			_mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+		signSin = _mm_xor_ps(signSin, swapSignSin);
+
+		// subtract the octant in three parts to keep the precision
+		x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(PI_PART_1)));
+		x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(PI_PART_2)));
+		x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(PI_PART_3)));
+		__m128 z = _mm_mul_ps(x, x);
+
+		__m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_P0), z), _mm_set1_ps(COS_P1));
+		c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(COS_P2));
+		c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+		c = _mm_sub_ps(c, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+		c = _mm_add_ps(c, _mm_set1_ps(1.0f));
+
+		__m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_P0), z), _mm_set1_ps(SIN_P1));
+		s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(SIN_P2));
+		s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), x), x);
+
+		// the octant decides which polynomial is the sine
+		__m128 sinResult = _mm_or_ps(_mm_and_ps(polyMask, s), _mm_andnot_ps(polyMask, c));
+		__m128 cosResult = _mm_or_ps(_mm_and_ps(polyMask, c), _mm_andnot_ps(polyMask, s));
+
+		sine = _mm_xor_ps(sinResult, signSin);
+		cosine = _mm_xor_ps(cosResult, signCos);
+	}
+
+	/***********************************************************
+	 *  StoreMatrices4()
+	 *
+	 *  This function is used for turning the elements of four
+	 *  matrices, one register per element, into four column-
+	 *  major matrices in memory.  The registers hold the upper
+	 *  3x3 elements column by column and then the position.
+	 ***********************************************************/
+	void StoreMatrices4(const __m128 e[12], unsigned char* pOutput, size_t outputStride)
+	{
+		__m128 zero = _mm_setzero_ps();
+		__m128 columns[4][4];
+
+		for (int column = 0; column < 3; column++)
+		{
+			__m128 r0 = e[column * 3 + 0];
+			__m128 r1 = e[column * 3 + 1];
+			__m128 r2 = e[column * 3 + 2];
+			__m128 r3 = zero;
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			columns[0][column] = r0;
+			columns[1][column] = r1;
+			columns[2][column] = r2;
+			columns[3][column] = r3;
+		}
+
+		__m128 t0 = e[9];
+		__m128 t1 = e[10];
+		__m128 t2 = e[11];
+		__m128 t3 = _mm_set1_ps(1.0f);
+		_MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+		columns[0][3] = t0;
+		columns[1][3] = t1;
+		columns[2][3] = t2;
+		columns[3][3] = t3;
+
+		for (int object = 0; object < 4; object++)
+		{
+			float* m = (float*)(pOutput + object * outputStride);
+			_mm_storeu_ps(m + 0, columns[object][0]);
+			_mm_storeu_ps(m + 4, columns[object][1]);
+			_mm_storeu_ps(m + 8, columns[object][2]);
+			_mm_storeu_ps(m + 12, columns[object][3]);
+		}
+	}
+
+	/***********************************************************
+	 *  ComposeRangeSSE2()
+	 *
+	 *  This function is used for composing four objects at a
+	 *  time with SSE2.  The first index and count must be such
+	 *  that every group of four is complete.
+	 ***********************************************************/
+	void ComposeRangeSSE2(const TRANSFORM_ARRAYS& t, size_t first, size_t last, unsigned char* pOutput, size_t outputStride)
+	{
+		const __m128 toRadians = _mm_set1_ps(DEGREES_TO_RADIANS);
+
+		for (size_t i = first; i + 4 <= last; i += 4)
+		{
+			__m128 sx, cx, sy, cy, sz, cz;
+			SinCos4(_mm_mul_ps(_mm_loadu_ps(&t.rotationX[i]), toRadians), sx, cx);
+			SinCos4(_mm_mul_ps(_mm_loadu_ps(&t.rotationY[i]), toRadians), sy, cy);
+			SinCos4(_mm_mul_ps(_mm_loadu_ps(&t.rotationZ[i]), toRadians), sz, cz);
+
+			__m128 scaleX = _mm_loadu_ps(&t.scaleX[i]);
+			__m128 scaleY = _mm_loadu_ps(&t.scaleY[i]);
+			__m128 scaleZ = _mm_loadu_ps(&t.scaleZ[i]);
+			__m128 sxsy = _mm_mul_ps(sx, sy);
+			__m128 cxsy = _mm_mul_ps(cx, sy);
+
+			__m128 e[12];
+			e[0] = _mm_mul_ps(_mm_mul_ps(cy, cz), scaleX);
+			e[1] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(cx, sz), _mm_mul_ps(sxsy, cz)), scaleX);
+			e[2] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sx, sz), _mm_mul_ps(cxsy, cz)), scaleX);
+			e[3] = _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(cy, sz)), scaleY);
+			e[4] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(cx, cz), _mm_mul_ps(sxsy, sz)), scaleY);
+			e[5] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sx, cz), _mm_mul_ps(cxsy, sz)), scaleY);
+			e[6] = _mm_mul_ps(sy, scaleZ);
+			e[7] = _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(sx, cy)), scaleZ);
+			e[8] = _mm_mul_ps(_mm_mul_ps(cx, cy), scaleZ);
+			e[9] = _mm_loadu_ps(&t.positionX[i]);
+			e[10] = _mm_loadu_ps(&t.positionY[i]);
+			e[11] = _mm_loadu_ps(&t.positionZ[i]);
+
+			StoreMatrices4(e, pOutput + (i - first) * outputStride, outputStride);
+		}
+	}
+
+	/***********************************************************
+	 *  SinCos8()
+	 *
+	 *  This function is used for the sine and cosine of eight
+	 *  angles in radians with AVX2, the same way as SinCos4().
+	 ***********************************************************/
+	TARGET_AVX2 void SinCos8(__m256 x, __m256& sine, __m256& cosine)
+	{
+		const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32((int)0x80000000));
+
+		__m256 signSin = _mm256_and_ps(x, signMask);
+		x = _mm256_andnot_ps(signMask, x);
+
+		__m256i octant = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(FOUR_OVER_PI)));
+		octant = _mm256_add_epi32(octant, _mm256_set1_epi32(1));
+		octant = _mm256_and_si256(octant, _mm256_set1_epi32(~1));
+		__m256 y = _mm256_cvtepi32_ps(octant);
+
+		__m256 swapSignSin = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(4)), 29));
+		__m256 polyMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+		__m256 signCos = _mm256_castsi256_ps(_mm256_slli_epi32(
+			_mm256_andnot_si256(_mm256_sub_epi32(octant, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+		signSin = _mm256_xor_ps(signSin, swapSignSin);
+
+		x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(PI_PART_1)));
+		x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(PI_PART_2)));
+		x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(PI_PART_3)));
+		__m256 z = _mm256_mul_ps(x, x);
+
+		__m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(COS_P0), z), _mm256_set1_ps(COS_P1));
+		c = _mm256_add_ps(_mm256_mul_ps(c, z), _mm256_set1_ps(COS_P2));
+		c = _mm256_mul_ps(_mm256_mul_ps(c, z), z);
+		c = _mm256_sub_ps(c, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+		c = _mm256_add_ps(c, _mm256_set1_ps(1.0f));
+
+		__m256 s = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIN_P0), z), _mm256_set1_ps(SIN_P1));
+		s = _mm256_add_ps(_mm256_mul_ps(s, z), _mm256_set1_ps(SIN_P2));
+		s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, z), x), x);
+
+		__m256 sinResult = _mm256_blendv_ps(c, s, polyMask);
+		__m256 cosResult = _mm256_blendv_ps(s, c, polyMask);
+
+		sine = _mm256_xor_ps(sinResult, signSin);
+		cosine = _mm256_xor_ps(cosResult, signCos);
+	}
+
+	/***********************************************************
+	 *  ComposeRangeAVX2()
+	 *
+	 *  This function is used for composing eight objects at a
+	 *  time with AVX2.  The elements are computed 8 wide and
+	 *  stored as two groups of four.
+	 ***********************************************************/
+	TARGET_AVX2 void ComposeRangeAVX2(const TRANSFORM_ARRAYS& t, size_t first, size_t last, unsigned char* pOutput, size_t outputStride)
+	{
+		const __m256 toRadians = _mm256_set1_ps(DEGREES_TO_RADIANS);
+		const __m256 zero = _mm256_setzero_ps();
+
+		for (size_t i = first; i + 8 <= last; i += 8)
+		{
+			__m256 sx, cx, sy, cy, sz, cz;
+			SinCos8(_mm256_mul_ps(_mm256_loadu_ps(&t.rotationX[i]), toRadians), sx, cx);
+			SinCos8(_mm256_mul_ps(_mm256_loadu_ps(&t.rotationY[i]), toRadians), sy, cy);
+			SinCos8(_mm256_mul_ps(_mm256_loadu_ps(&t.rotationZ[i]), toRadians), sz, cz);
+
+			__m256 scaleX = _mm256_loadu_ps(&t.scaleX[i]);
+			__m256 scaleY = _mm256_loadu_ps(&t.scaleY[i]);
+			__m256 scaleZ = _mm256_loadu_ps(&t.scaleZ[i]);
+			__m256 sxsy = _mm256_mul_ps(sx, sy);
+			__m256 cxsy = _mm256_mul_ps(cx, sy);
+
+			__m256 e[12];
+			e[0] = _mm256_mul_ps(_mm256_mul_ps(cy, cz), scaleX);
+			e[1] = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(cx, sz), _mm256_mul_ps(sxsy, cz)), scaleX);
+			e[2] = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(sx, sz), _mm256_mul_ps(cxsy, cz)), scaleX);
+			e[3] = _mm256_mul_ps(_mm256_sub_ps(zero, _mm256_mul_ps(cy, sz)), scaleY);
+			e[4] = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(cx, cz), _mm256_mul_ps(sxsy, sz)), scaleY);
+			e[5] = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(sx, cz), _mm256_mul_ps(cxsy, sz)), scaleY);
+			e[6] = _mm256_mul_ps(sy, scaleZ);
+			e[7] = _mm256_mul_ps(_mm256_sub_ps(zero, _mm256_mul_ps(sx, cy)), scaleZ);
+			e[8] = _mm256_mul_ps(_mm256_mul_ps(cx, cy), scaleZ);
+
+			e[9] = _mm256_loadu_ps(&t.positionX[i]);
+			e[10] = _mm256_loadu_ps(&t.positionY[i]);
+			e[11] = _mm256_loadu_ps(&t.positionZ[i]);
+
+			__m128 low[12];
+			__m128 high[12];
+			for (int element = 0; element < 12; element++)
+			{
+				low[element] = _mm256_castps256_ps128(e[element]);
+				high[element] = _mm256_extractf128_ps(e[element], 1);
+			}
+
+			StoreMatrices4(low, pOutput + (i - first) * outputStride, outputStride);
+			StoreMatrices4(high, pOutput + (i - first + 4) * outputStride, outputStride);
+		}
+	}
+
+	/***********************************************************
+	 *  CpuSupportsAVX2()
+	 *
+	 *  This function is used for checking whether the CPU and
+	 *  the operating system support AVX2.
+	 ***********************************************************/
+	bool CpuSupportsAVX2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return(false);
+		}
+
+		// AVX needs the OS to save the YMM registers
+		__cpuid(info, 1);
+		bool bOSXSave = (info[2] & (1 << 27)) != 0;
+		bool bAVX = (info[2] & (1 << 28)) != 0;
+		if (!bOSXSave || !bAVX || ((_xgetbv(0) & 0x6) != 0x6))
+		{
+			return(false);
+		}
+
+		__cpuidex(info, 7, 0);
+		return((info[1] & (1 << 5)) != 0);
+#else
+		__builtin_cpu_init();
+		return(__builtin_cpu_supports("avx2") != 0);
+#endif
+	}
+#endif
+
+	/***********************************************************
+	 *  DetectSimdPath()
+	 *
+	 *  This function is used for picking the widest
+	 *  instruction set the CPU supports.
+	 ***********************************************************/
+	TransformComposer::SIMD_PATH DetectSimdPath()
+	{
+#if TRANSFORM_COMPOSER_SIMD
+		if (CpuSupportsAVX2())
+		{
+			return(TransformComposer::SIMD_PATH::AVX2);
+		}
+		return(TransformComposer::SIMD_PATH::SSE2);
+#else
+		return(TransformComposer::SIMD_PATH::Scalar);
+#endif
+	}
+
+	// instruction set the batch method uses, and the widest one available
+	const TransformComposer::SIMD_PATH g_SupportedPath = DetectSimdPath();
+	TransformComposer::SIMD_PATH g_SimdPath = g_SupportedPath;
+}
+
+/***********************************************************
+ *  Add()
+ *
+ *  This method is used for appending the transformation
+ *  values of one object.  The index of the object is
+ *  returned.
+ ***********************************************************/
+size_t TRANSFORM_ARRAYS::Add(const glm::vec3& scale, const glm::vec3& rotationDegrees, const glm::vec3& position)
+{
+	scaleX.push_back(scale.x);
+	scaleY.push_back(scale.y);
+	scaleZ.push_back(scale.z);
+	rotationX.push_back(rotationDegrees.x);
+	rotationY.push_back(rotationDegrees.y);
+	rotationZ.push_back(rotationDegrees.z);
+	positionX.push_back(position.x);
+	positionY.push_back(position.y);
+	positionZ.push_back(position.z);
+
+	return(scaleX.size() - 1);
+}
+
+/***********************************************************
+ *  Insert()
+ *
+ *  This method is used for inserting the transformation
+ *  values of one object before the object at index.
+ ***********************************************************/
+void TRANSFORM_ARRAYS::Insert(size_t index, const glm::vec3& scale, const glm::vec3& rotationDegrees, const glm::vec3& position)
+{
+	scaleX.insert(scaleX.begin() + index, scale.x);
+	scaleY.insert(scaleY.begin() + index, scale.y);
+	scaleZ.insert(scaleZ.begin() + index, scale.z);
+	rotationX.insert(rotationX.begin() + index, rotationDegrees.x);
+	rotationY.insert(rotationY.begin() + index, rotationDegrees.y);
+	rotationZ.insert(rotationZ.begin() + index, rotationDegrees.z);
+	positionX.insert(positionX.begin() + index, position.x);
+	positionY.insert(positionY.begin() + index, position.y);
+	positionZ.insert(positionZ.begin() + index, position.z);
+}
+
+/***********************************************************
+ *  Set()
+ *
+ *  This method is used for replacing the transformation
+ *  values of the object at index.
+ ***********************************************************/
+void TRANSFORM_ARRAYS::Set(size_t index, const glm::vec3& scale, const glm::vec3& rotationDegrees, const glm::vec3& position)
+{
+	scaleX[index] = scale.x;
+	scaleY[index] = scale.y;
+	scaleZ[index] = scale.z;
+	rotationX[index] = rotationDegrees.x;
+	rotationY[index] = rotationDegrees.y;
+	rotationZ[index] = rotationDegrees.z;
+	positionX[index] = position.x;
+	positionY[index] = position.y;
+	positionZ[index] = position.z;
+}
+
+/***********************************************************
+ *  Size()
+ *
+ *  This method is used for getting the number of objects.
+ ***********************************************************/
+size_t TRANSFORM_ARRAYS::Size() const
+{
+	return(scaleX.size());
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing every object.
+ ***********************************************************/
+void TRANSFORM_ARRAYS::Clear()
+{
+	scaleX.clear();
+	scaleY.clear();
+	scaleZ.clear();
+	rotationX.clear();
+	rotationY.clear();
+	rotationZ.clear();
+	positionX.clear();
+	positionY.clear();
+	positionZ.clear();
+}
+
+/***********************************************************
+ *  Compose()
+ *
+ *  This method is used for composing the model matrix of a
+ *  single object in closed form.
+ ***********************************************************/
+glm::mat4 TransformComposer::Compose(const glm::vec3& scale, const glm::vec3& rotationDegrees, const glm::vec3& position)
+{
+	glm::mat4 model;
+
+	ComposeScalar(
+		scale.x, scale.y, scale.z,
+		rotationDegrees.x, rotationDegrees.y, rotationDegrees.z,
+		position.x, position.y, position.z,
+		&model[0][0]);
+
+	return(model);
+}
+
+/***********************************************************
+ *  ComposeBatch()
+ *
+ *  This method is used for composing the model matrices of
+ *  a range of objects.  The SIMD path handles whole groups
+ *  of 8 or 4 objects and the scalar path the ones left over.
+ ***********************************************************/
+void TransformComposer::ComposeBatch(
+	const TRANSFORM_ARRAYS& transforms,
+	size_t first,
+	size_t count,
+	void* pOutput,
+	size_t outputStride)
+{
+	unsigned char* pBytes = (unsigned char*)pOutput;
+	size_t last = first + count;
+	size_t simdLast = first;
+
+#if TRANSFORM_COMPOSER_SIMD
+	if (g_SimdPath == SIMD_PATH::AVX2)
+	{
+		simdLast = first + (count & ~(size_t)7);
+		ComposeRangeAVX2(transforms, first, simdLast, pBytes, outputStride);
+	}
+	else if (g_SimdPath == SIMD_PATH::SSE2)
+	{
+		simdLast = first + (count & ~(size_t)3);
+		ComposeRangeSSE2(transforms, first, simdLast, pBytes, outputStride);
+	}
+#endif
+
+	ComposeRangeScalar(transforms, simdLast, last, pBytes + (simdLast - first) * outputStride, outputStride);
+}
+
+/***********************************************************
+ *  GetSimdPath()
+ *
+ *  This method is used for getting the instruction set the
+ *  batch method uses.
+ ***********************************************************/
+TransformComposer::SIMD_PATH TransformComposer::GetSimdPath()
+{
+	return(g_SimdPath);
+}
+
+/***********************************************************
+ *  SetSimdPath()
+ *
+ *  This method is used for choosing the instruction set of
+ *  the batch method.  A path wider than the CPU supports is
+ *  clamped to the widest one that is supported.
+ ***********************************************************/
+void TransformComposer::SetSimdPath(SIMD_PATH path)
+{
+	g_SimdPath = ((int)path <= (int)g_SupportedPath) ? path : g_SupportedPath;
+}
@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformcomposer.h
+// ============
+// compose model matrices from scale, Euler rotation and position in
+// closed form, one at a time or in SIMD batches
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  TRANSFORM_ARRAYS
+ *
+ *  The transformation values of many objects in
+ *  structure-of-arrays layout, so the batch composer can
+ *  load the same value of several objects at once.  The
+ *  rotations are in degrees.
+ ***********************************************************/
+struct TRANSFORM_ARRAYS
+{
+	std::vector<float> scaleX;
+	std::vector<float> scaleY;
+	std::vector<float> scaleZ;
+	std::vector<float> rotationX;
+	std::vector<float> rotationY;
+	std::vector<float> rotationZ;
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> positionZ;
+
+	// append the transformation values of one object
+	size_t Add(const glm::vec3& scale, const glm::vec3& rotationDegrees, const glm::vec3& position);
+	// insert the transformation values of one object before index
+	void Insert(size_t index, const glm::vec3& scale, const glm::vec3& rotationDegrees, const glm::vec3& position);
+	// replace the transformation values of one object
+	void Set(size_t index, const glm::vec3& scale, const glm::vec3& rotationDegrees, const glm::vec3& position);
+	// get the number of objects
+	size_t Size() const;
+	// remove every object
+	void Clear();
+};
+
+/***********************************************************
+ *  TransformComposer
+ *
+ *  This class builds the model matrix translation * rotX *
+ *  rotY * rotZ * scale without building and multiplying
+ *  five separate matrices - every element is written out
+ *  from the sines and cosines of the three angles.  The
+ *  batch method runs 8 objects at a time with AVX2 or 4 at
+ *  a time with SSE2, picked once from what the CPU
+ *  supports, with a scalar loop for the rest.
+ ***********************************************************/
+class TransformComposer
+{
+public:
+	// instruction set used by the batch method
+	enum class SIMD_PATH
+	{
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	// compose the model matrix of one object
+	static glm::mat4 Compose(const glm::vec3& scale, const glm::vec3& rotationDegrees, const glm::vec3& position);
+
+	// compose the model matrices of objects [first, first + count)
+	// of the arrays, writing each one outputStride bytes after
+	// the last so they can go straight into per-instance data
+	static void ComposeBatch(
+		const TRANSFORM_ARRAYS& transforms,
+		size_t first,
+		size_t count,
+		void* pOutput,
+		size_t outputStride = sizeof(glm::mat4));
+
+	// get the instruction set the batch method uses
+	static SIMD_PATH GetSimdPath();
+	// force the batch method to an instruction set the CPU
+	// supports, for comparing the paths
+	static void SetSimdPath(SIMD_PATH path);
+};
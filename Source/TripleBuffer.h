@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// triplebuffer.h
+// ============
+// lock-free hand-over of the latest value from one producer thread to
+// one consumer thread
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/***********************************************************
+ *  TripleBuffer
+ *
+ *  This class passes the newest value from one thread to
+ *  another without locks, where older values that were not
+ *  read in time can be skipped.  Of three slots the producer
+ *  owns one to write into, the consumer owns one to read
+ *  from, and the third is shared.  Writing swaps the written
+ *  slot with the shared one and flags it fresh; reading
+ *  swaps the shared slot in only when it is fresh.  The
+ *  producer never waits and never has to drop the newest
+ *  value, however long the consumer stays away.
+ ***********************************************************/
+template <typename T>
+class TripleBuffer
+{
+public:
+	// constructor
+	TripleBuffer()
+	{
+		m_writeSlot = 0;
+		m_sharedSlot = 1;
+		m_readSlot = 2;
+	}
+
+	// publish a value, from the producer thread only
+	void Write(const T& value)
+	{
+		m_slots[m_writeSlot] = value;
+		int previous = m_sharedSlot.exchange(m_writeSlot | FRESH_BIT, std::memory_order_acq_rel);
+		m_writeSlot = previous & SLOT_MASK;
+	}
+
+	// take the newest value, from the consumer thread only,
+	// returns false when nothing was written since the last read
+	bool Read(T& value)
+	{
+		if ((m_sharedSlot.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+		{
+			return(false);
+		}
+
+		int previous = m_sharedSlot.exchange(m_readSlot, std::memory_order_acq_rel);
+		m_readSlot = previous & SLOT_MASK;
+		value = m_slots[m_readSlot];
+		return(true);
+	}
+
+private:
+	// the shared slot index carries whether it was written
+	// since the consumer last took it
+	static const int SLOT_MASK = 3;
+	static const int FRESH_BIT = 4;
+	// size of a cache line, the padding keeping the indices
+	// on separate lines without needing over-aligned new
+	static const size_t CACHE_LINE_SIZE = 64;
+
+	T m_slots[3];
+	char m_slotsPadding[CACHE_LINE_SIZE];
+	// slot being written, owned by the producer only
+	int m_writeSlot;
+	char m_writePadding[CACHE_LINE_SIZE];
+	// slot being handed over, with FRESH_BIT
+	std::atomic<int> m_sharedSlot;
+	char m_sharedPadding[CACHE_LINE_SIZE];
+	// slot being read, owned by the consumer only
+	int m_readSlot;
+};
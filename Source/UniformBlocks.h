@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformblocks.h
+// ============
+// std140/std430 layouts of the uniform blocks and storage buffers shared
+// between the C++ code and the shaders - keep these in step with the
+// blocks in shaders/*.glsl
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// binding points, matching layout(binding = N) in the shaders
+const GLuint CAMERA_BLOCK_BINDING = 0;
+const GLuint LIGHT_BLOCK_BINDING = 1;
+const GLuint MATERIAL_BUFFER_BINDING = 2;
+const GLuint OBJECT_BUFFER_BINDING = 3;
+const GLuint CULL_INPUT_BINDING = 4;
+const GLuint CULL_BOUNDS_BINDING = 5;
+const GLuint CULL_COMMAND_BINDING = 6;
+
+// sizes of the arrays in the uniform blocks
+const int TOTAL_LIGHTS = 4;
+
+/***********************************************************
+ *  CAMERA_BLOCK
+ *
+ *  Per-frame camera values, written once per frame.
+ ***********************************************************/
+struct CAMERA_BLOCK
+{
+	glm::mat4 projection;
+	glm::mat4 view;
+	glm::vec4 viewPosition;		// w is unused
+};
+
+/***********************************************************
+ *  LIGHT_SOURCE_STD140 / LIGHT_BLOCK
+ *
+ *  The scene light sources, written only when they change.
+ *  The scalars fill the padding after each vec3.
+ ***********************************************************/
+struct LIGHT_SOURCE_STD140
+{
+	glm::vec3 position;
+	float focalStrength;
+	glm::vec3 ambientColor;
+	float specularIntensity;
+	glm::vec3 diffuseColor;
+	float padding0;
+	glm::vec3 specularColor;
+	float padding1;
+};
+
+struct LIGHT_BLOCK
+{
+	LIGHT_SOURCE_STD140 lightSources[TOTAL_LIGHTS];
+};
+
+/***********************************************************
+ *  MATERIAL_STD140
+ *
+ *  One entry of the table of defined materials, held in a
+ *  shader storage buffer and indexed in the shader by the
+ *  materialIndex uniform.  The layout is the same under
+ *  std140 and std430.
+ ***********************************************************/
+struct MATERIAL_STD140
+{
+	glm::vec3 ambientColor;
+	float ambientStrength;
+	glm::vec3 diffuseColor;
+	float shininess;
+	glm::vec3 specularColor;
+	float padding;
+};
+
+/***********************************************************
+ *  OBJECT_STD430
+ *
+ *  The values of one object drawn by the GPU-driven path,
+ *  held in a shader storage buffer and indexed in the
+ *  shader by the object index of the draw command.
+ ***********************************************************/
+struct OBJECT_STD430
+{
+	glm::mat4 model;
+	glm::vec4 color;
+	glm::vec2 uvScale;
+	GLint materialIndex;
+	GLint padding;
+};
+
+/***********************************************************
+ *  CULL_BOUNDS_STD430
+ *
+ *  The world bounding box of one object queued for the GPU
+ *  cull pass, and the draw command the object belongs to.
+ *  An object with bCullable at zero is always kept.
+ ***********************************************************/
+struct CULL_BOUNDS_STD430
+{
+	glm::vec3 center;
+	GLuint commandIndex;
+	glm::vec3 extents;
+	GLuint bCullable;
+};
+
+static_assert(sizeof(CAMERA_BLOCK) == 144, "CAMERA_BLOCK must match the std140 layout");
+static_assert(sizeof(LIGHT_SOURCE_STD140) == 64, "LIGHT_SOURCE_STD140 must match the std140 layout");
+static_assert(sizeof(MATERIAL_STD140) == 48, "MATERIAL_STD140 must match the std140 layout");
+static_assert(sizeof(OBJECT_STD430) == 96, "OBJECT_STD430 must match the std430 layout");
+static_assert(sizeof(CULL_BOUNDS_STD430) == 32, "CULL_BOUNDS_STD430 must match the std430 layout");
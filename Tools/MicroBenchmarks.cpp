@@ -0,0 +1,793 @@
+///////////////////////////////////////////////////////////////////////////////
+// microbenchmarks.cpp
+// ============
+// time the per-draw CPU paths of the scene and shader managers in
+// isolation, and compare the results against a checked-in baseline
+//
+//  usage: MicroBenchmarks [--headless] [--baseline <file>]
+//                         [--write-baseline] [--tolerance <fraction>]
+//                         [--runs <count>] [--strict]
+//
+//  each path is timed with 10 to 100000 objects and reported in
+//  nanoseconds and heap allocations per operation, taken from the
+//  best of several passes over several runs of the whole set, so
+//  other load on the machine does not show up as a regression.  The
+//  exit code is non-zero when a result is slower than the baseline by
+//  more than the tolerance, or allocates more.  A result the baseline
+//  has no entry for passes as new, unless --strict is given, which
+//  fails it.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLStateCache.h"
+#include "SceneManager.h"
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+#include "GLFW/glfw3.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// heap allocations made by the whole program so far
+	std::atomic<unsigned long long> g_AllocationCount(0);
+
+	// the object counts every path is timed with
+	const size_t OBJECT_COUNTS[] = { 10, 100, 1000, 10000, 100000 };
+	// each measurement runs for at least this long, and for
+	// at least this many passes
+	const double MIN_MEASURE_SECONDS = 0.2;
+	const int MIN_PASSES = 5;
+	// a pass repeats the operations until it takes this long,
+	// so reading the clock costs nothing in comparison
+	const double MIN_PASS_SECONDS = 0.01;
+
+	// written by the timed operations so they are not optimized away
+	volatile int g_Sink = 0;
+
+	// timing of one path at one object count
+	struct BENCH_RESULT
+	{
+		std::string name;
+		size_t objects;
+		double nsPerOp;
+		double allocsPerOp;
+	};
+
+	// settings from the command line
+	struct BENCH_OPTIONS
+	{
+		bool bHeadless;
+		bool bWriteBaseline;
+		bool bStrict;
+		double tolerance;
+		int runs;
+		std::string baselinePath;
+	};
+
+	/***********************************************************
+	 *  TimePass()
+	 *
+	 *  This function is used for running the operation with
+	 *  the indices 0 to opsPerPass - 1, repeats times over,
+	 *  and getting the seconds it took.
+	 ***********************************************************/
+	template<typename OPERATION>
+	double TimePass(size_t opsPerPass, size_t repeats, OPERATION& operation)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (size_t repeat = 0; repeat < repeats; repeat++)
+		{
+			for (size_t i = 0; i < opsPerPass; i++)
+			{
+				operation(i);
+			}
+		}
+		return(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	/***********************************************************
+	 *  Measure()
+	 *
+	 *  This function is used for timing an operation that is
+	 *  called with the indices 0 to opsPerPass - 1 in turn.
+	 *  The first pass warms up, so allocations that only
+	 *  happen on first use are not counted, and the pass is
+	 *  repeated more often until it takes MIN_PASS_SECONDS.
+	 *  Passes then run until MIN_MEASURE_SECONDS have passed
+	 *  and there were at least MIN_PASSES.  The time of the
+	 *  fastest pass is reported, since other load can only
+	 *  ever make a pass slower, and likewise the allocations
+	 *  of the pass that made the fewest.  An allocation of
+	 *  the operation recurs in every pass, where the OpenGL
+	 *  driver only allocates now and then, when it compiles
+	 *  another variant of a shader.
+	 ***********************************************************/
+	template<typename OPERATION>
+	BENCH_RESULT Measure(const std::string& name, size_t objects, size_t opsPerPass, OPERATION operation)
+	{
+		size_t repeats = 1;
+		while (TimePass(opsPerPass, repeats, operation) < MIN_PASS_SECONDS)
+		{
+			repeats *= 2;
+		}
+
+		unsigned long long opsPerRepeatedPass = (unsigned long long)repeats * opsPerPass;
+		double elapsed = 0.0;
+		double fastestPass = 0.0;
+		unsigned long long fewestAllocations = 0;
+		int passes = 0;
+
+		do
+		{
+			unsigned long long allocationsBefore = g_AllocationCount.load();
+			double passSeconds = TimePass(opsPerPass, repeats, operation);
+			unsigned long long allocations = g_AllocationCount.load() - allocationsBefore;
+			if ((passes == 0) || (passSeconds < fastestPass))
+			{
+				fastestPass = passSeconds;
+			}
+			if ((passes == 0) || (allocations < fewestAllocations))
+			{
+				fewestAllocations = allocations;
+			}
+			elapsed += passSeconds;
+			passes++;
+		} while ((elapsed < MIN_MEASURE_SECONDS) || (passes < MIN_PASSES));
+
+		BENCH_RESULT result;
+		result.name = name;
+		result.objects = objects;
+		result.nsPerOp = fastestPass * 1.0e9 / (double)opsPerRepeatedPass;
+		result.allocsPerOp = (double)fewestAllocations / (double)opsPerRepeatedPass;
+
+		return(result);
+	}
+
+	/***********************************************************
+	 *  MakeTag()
+	 *
+	 *  This function is used for building the tag of the
+	 *  numbered benchmark material or texture.
+	 ***********************************************************/
+	std::string MakeTag(const char* prefix, size_t index)
+	{
+		return(std::string(prefix) + std::to_string(index));
+	}
+}
+
+// count every heap allocation, so each result can report
+// the allocations made per operation
+void* operator new(size_t size)
+{
+	g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	void* pMemory = malloc((size > 0) ? size : 1);
+	if (NULL == pMemory)
+	{
+		throw std::bad_alloc();
+	}
+	return(pMemory);
+}
+
+void* operator new[](size_t size)
+{
+	return(operator new(size));
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	free(pMemory);
+}
+
+void operator delete[](void* pMemory) noexcept
+{
+	free(pMemory);
+}
+
+void operator delete(void* pMemory, size_t) noexcept
+{
+	free(pMemory);
+}
+
+void operator delete[](void* pMemory, size_t) noexcept
+{
+	free(pMemory);
+}
+
+/***********************************************************
+ *  SceneManagerBenchmark
+ *
+ *  This class times the per-draw paths of a prepared scene.
+ *  It is a friend of SceneManager, so it can call the
+ *  private paths directly and grow the material, texture
+ *  and draw packet lists to each object count.
+ ***********************************************************/
+class SceneManagerBenchmark
+{
+public:
+	// constructor
+	SceneManagerBenchmark(SceneManager* pSceneManager, ShaderManager* pShaderManager, GLStateCache* pStateCache)
+	{
+		m_pSceneManager = pSceneManager;
+		m_pShaderManager = pShaderManager;
+		m_pStateCache = pStateCache;
+		m_scenePackets = pSceneManager->m_drawPackets;
+	}
+
+	// time every path at every object count
+	void Run(std::vector<BENCH_RESULT>& results);
+
+private:
+	SceneManager* m_pSceneManager;
+	ShaderManager* m_pShaderManager;
+	GLStateCache* m_pStateCache;
+	// the draw packets of the scene itself
+	std::vector<SceneManager::DRAW_PACKET> m_scenePackets;
+	// the benchmark materials and textures added so far,
+	// kept so later runs reuse them
+	std::vector<std::string> m_materialTags;
+	std::vector<std::string> m_textureTags;
+
+	// grow the defined materials and loaded textures to a count
+	void AddMaterials(size_t count, std::vector<std::string>& tags);
+	void AddTextures(size_t count, std::vector<std::string>& tags);
+	// replace the draw list with copies of the scene packets
+	void SetPacketCount(size_t count);
+};
+
+/***********************************************************
+ *  AddMaterials()
+ *
+ *  This method is used for defining numbered benchmark
+ *  materials until there are count of them.
+ ***********************************************************/
+void SceneManagerBenchmark::AddMaterials(size_t count, std::vector<std::string>& tags)
+{
+	while (tags.size() < count)
+	{
+		SceneManager::OBJECT_MATERIAL material;
+		material.ambientStrength = 0.2f;
+		material.ambientColor = glm::vec3(0.5f);
+		material.diffuseColor = glm::vec3(0.7f);
+		material.specularColor = glm::vec3(0.1f);
+		material.shininess = 16.0f;
+		material.tag = MakeTag("benchmark material ", tags.size());
+
+		m_pSceneManager->AddObjectMaterial(material);
+		tags.push_back(material.tag);
+	}
+}
+
+/***********************************************************
+ *  AddTextures()
+ *
+ *  This method is used for registering numbered benchmark
+ *  textures until there are count of them.  They only need
+ *  a tag to be looked up, so no OpenGL texture is created.
+ ***********************************************************/
+void SceneManagerBenchmark::AddTextures(size_t count, std::vector<std::string>& tags)
+{
+	while (tags.size() < count)
+	{
+		SceneManager::TEXTURE_INFO texture;
+		texture.tag = MakeTag("benchmark texture ", tags.size());
+		texture.ID = 0;
+
+		m_pSceneManager->m_textureHandles[texture.tag] = (SceneManager::TEXTURE_HANDLE)m_pSceneManager->m_textureIDs.size();
+		m_pSceneManager->m_textureIDs.push_back(texture);
+		tags.push_back(texture.tag);
+	}
+}
+
+/***********************************************************
+ *  SetPacketCount()
+ *
+ *  This method is used for filling the draw list with count
+ *  copies of the scene packets, each copy of the scene
+ *  moved to its own cell of a grid.  Only the first copy
+ *  is the baked scene itself, so the others are drawn as
+ *  separate packets.
+ ***********************************************************/
+void SceneManagerBenchmark::SetPacketCount(size_t count)
+{
+	std::vector<SceneManager::DRAW_PACKET>& packets = m_pSceneManager->m_drawPackets;
+	packets.clear();
+
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t copy = i / m_scenePackets.size();
+		SceneManager::DRAW_PACKET packet = m_scenePackets[i % m_scenePackets.size()];
+		packet.model[3] += glm::vec4((float)(copy % 64) * 12.0f, 0.0f, -(float)(copy / 64) * 12.0f, 0.0f);
+		if (copy > 0)
+		{
+			packet.staticBatch = SceneManager::INVALID_HANDLE;
+		}
+		packets.push_back(packet);
+	}
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for timing every path at every
+ *  object count.  Transforms, tags and values cycle through
+ *  one entry per object, so larger counts also show the
+ *  cost of working sets that no longer fit in the caches.
+ ***********************************************************/
+void SceneManagerBenchmark::Run(std::vector<BENCH_RESULT>& results)
+{
+	ShaderManager::UNIFORM_HANDLE modelHandle = m_pSceneManager->m_uniforms.model;
+	ShaderManager::UNIFORM_HANDLE colorHandle = m_pSceneManager->m_uniforms.objectColor;
+
+	for (size_t objects : OBJECT_COUNTS)
+	{
+		std::cout << "INFO: timing " << objects << " objects" << std::endl;
+
+		// one set of transformation values and matrices per object
+		std::vector<glm::vec3> scales(objects);
+		std::vector<glm::vec3> rotations(objects);
+		std::vector<glm::vec3> positions(objects);
+		std::vector<glm::mat4> matrices(objects);
+		std::vector<glm::vec4> colors(objects);
+		TRANSFORM_ARRAYS transforms;
+		BOUNDS_ARRAYS bounds;
+		bounds.Resize(objects);
+		for (size_t i = 0; i < objects; i++)
+		{
+			float t = (float)i;
+			scales[i] = glm::vec3(1.0f + fmodf(t * 0.37f, 2.0f));
+			rotations[i] = glm::vec3(fmodf(t * 7.0f, 360.0f), fmodf(t * 13.0f, 360.0f), fmodf(t * 29.0f, 360.0f));
+			positions[i] = glm::vec3(fmodf(t, 100.0f), 0.0f, -fmodf(t * 0.01f, 100.0f));
+			matrices[i] = m_pSceneManager->BuildModelMatrix(scales[i], rotations[i].x, rotations[i].y, rotations[i].z, positions[i]);
+			colors[i] = glm::vec4(fmodf(t * 0.01f, 1.0f), 0.5f, 0.5f, 1.0f);
+			transforms.Add(scales[i], rotations[i], positions[i]);
+			bounds.Set(i, positions[i], scales[i] * 0.5f);
+		}
+
+		AddMaterials(objects, m_materialTags);
+		AddTextures(objects, m_textureTags);
+
+		m_pStateCache->UseProgram(m_pShaderManager->m_programID);
+
+		results.push_back(Measure("SetTransformations", objects, objects,
+			[&](size_t i)
+			{
+				m_pSceneManager->SetTransformations(scales[i], rotations[i].x, rotations[i].y, rotations[i].z, positions[i]);
+			}));
+
+		results.push_back(Measure("BuildModelMatrix", objects, objects,
+			[&](size_t i)
+			{
+				matrices[i] = m_pSceneManager->BuildModelMatrix(scales[i], rotations[i].x, rotations[i].y, rotations[i].z, positions[i]);
+			}));
+
+		// every matrix composed in one call, as an instance batch upload does
+		results.push_back(Measure("TransformComposer::ComposeBatch", objects, 1,
+			[&](size_t)
+			{
+				TransformComposer::ComposeBatch(transforms, 0, objects, &matrices[0]);
+			}));
+
+		// every box tested against a camera that sees about half of them
+		FrustumCuller::FRUSTUM frustum = FrustumCuller::ExtractFrustum(
+			glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f) *
+			glm::lookAt(glm::vec3(50.0f, 5.0f, 10.0f), glm::vec3(50.0f, 0.0f, -50.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+		std::vector<uint32_t> visible;
+		results.push_back(Measure("FrustumCuller::CullBounds", objects, 1,
+			[&](size_t)
+			{
+				FrustumCuller::CullBounds(frustum, bounds, visible);
+				g_Sink = (int)visible.size();
+			}));
+
+		// the same boxes and camera through the spatial index
+		BoundingVolumeHierarchy spatialIndex;
+		spatialIndex.Build(bounds);
+		results.push_back(Measure("BoundingVolumeHierarchy::QueryFrustum", objects, 1,
+			[&](size_t)
+			{
+				spatialIndex.QueryFrustum(frustum, visible);
+				g_Sink = (int)visible.size();
+			}));
+
+		results.push_back(Measure("FindMaterial", objects, objects,
+			[&](size_t i)
+			{
+				SceneManager::OBJECT_MATERIAL material;
+				g_Sink = m_pSceneManager->FindMaterial(m_materialTags[i], material) ? 1 : 0;
+			}));
+
+		results.push_back(Measure("FindTextureSlot", objects, objects,
+			[&](size_t i)
+			{
+				g_Sink = m_pSceneManager->FindTextureSlot(m_textureTags[i]);
+			}));
+
+		results.push_back(Measure("SetShaderMaterial", objects, objects,
+			[&](size_t i)
+			{
+				m_pSceneManager->SetShaderMaterial(m_materialTags[i]);
+			}));
+
+		results.push_back(Measure("ShaderManager::setMat4Value", objects, objects,
+			[&](size_t i)
+			{
+				m_pShaderManager->setMat4Value(modelHandle, matrices[i]);
+			}));
+
+		results.push_back(Measure("ShaderManager::setVec4Value(name)", objects, objects,
+			[&](size_t i)
+			{
+				m_pShaderManager->setVec4Value("objectColor", colors[i]);
+			}));
+
+		results.push_back(Measure("GLStateCache::SetMat4Value", objects, objects,
+			[&](size_t i)
+			{
+				m_pStateCache->SetMat4Value(modelHandle, matrices[i]);
+			}));
+
+		results.push_back(Measure("GLStateCache::SetVec4Value(unchanged)", objects, objects,
+			[&](size_t)
+			{
+				m_pStateCache->SetVec4Value(colorHandle, colors[0]);
+			}));
+
+		// a whole frame of the scene copied to the object count
+		SetPacketCount(objects);
+		glFinish();
+		results.push_back(Measure("RenderScene", objects, 1,
+			[&](size_t)
+			{
+				m_pSceneManager->RenderScene();
+			}));
+		glFinish();
+	}
+
+	SetPacketCount(m_scenePackets.size());
+}
+
+/***********************************************************
+ *  ParseOptions()
+ *
+ *  This function is used for reading the settings from the
+ *  command line.
+ ***********************************************************/
+BENCH_OPTIONS ParseOptions(int argc, char* argv[])
+{
+	BENCH_OPTIONS options;
+	options.bHeadless = false;
+	options.bWriteBaseline = false;
+	options.bStrict = false;
+	options.tolerance = 0.20;
+	options.runs = 3;
+	options.baselinePath = "Tools/MicroBenchmarks.baseline";
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		bool bHasValue = (i + 1 < argc);
+
+		if (argument == "--headless")
+			options.bHeadless = true;
+		else if (argument == "--write-baseline")
+			options.bWriteBaseline = true;
+		else if (argument == "--strict")
+			options.bStrict = true;
+		else if ((argument == "--baseline") && bHasValue)
+			options.baselinePath = argv[++i];
+		else if ((argument == "--tolerance") && bHasValue)
+			options.tolerance = atof(argv[++i]);
+		else if ((argument == "--runs") && bHasValue)
+			options.runs = std::max(1, atoi(argv[++i]));
+	}
+
+	return(options);
+}
+
+/***********************************************************
+ *  CreateContext()
+ *
+ *  This function is used for creating a hidden window with
+ *  an OpenGL context, or with --headless a window on the
+ *  null platform with an OSMesa context, which needs no
+ *  display at all.
+ ***********************************************************/
+GLFWwindow* CreateContext(const BENCH_OPTIONS& options)
+{
+	if (options.bHeadless)
+	{
+#ifdef GLFW_PLATFORM_NULL
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else
+		std::cout << "ERROR: --headless needs GLFW 3.4 or newer" << std::endl;
+		return(NULL);
+#endif
+	}
+
+	if (glfwInit() == GLFW_FALSE)
+	{
+		std::cout << "ERROR: GLFW failed to initialize" << std::endl;
+		return(NULL);
+	}
+
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, options.bHeadless ? 5 : 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	if (options.bHeadless)
+	{
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+	}
+
+	GLFWwindow* window = glfwCreateWindow(64, 64, "MicroBenchmarks", NULL, NULL);
+	if (NULL == window)
+	{
+		std::cout << "ERROR: could not create the OpenGL context" << std::endl;
+		glfwTerminate();
+		return(NULL);
+	}
+	glfwMakeContextCurrent(window);
+
+	GLenum GLEWInitResult = options.bHeadless ? glewContextInit() : glewInit();
+	if (GLEW_OK != GLEWInitResult)
+	{
+		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		return(NULL);
+	}
+
+	return(window);
+}
+
+/***********************************************************
+ *  LoadBaseline()
+ *
+ *  This function is used for reading the baseline results.
+ *  Each line holds the name, the object count, ns/op and
+ *  allocations/op separated by tabs.  Lines starting with #
+ *  are comments.
+ ***********************************************************/
+std::map<std::pair<std::string, size_t>, BENCH_RESULT> LoadBaseline(const std::string& path)
+{
+	std::map<std::pair<std::string, size_t>, BENCH_RESULT> baseline;
+
+	std::ifstream baselineFile(path);
+	std::string line;
+	while (std::getline(baselineFile, line))
+	{
+		if (line.empty() || (line[0] == '#'))
+		{
+			continue;
+		}
+
+		std::istringstream fields(line);
+		BENCH_RESULT result;
+		std::string objects;
+		std::string nsPerOp;
+		std::string allocsPerOp;
+		if (std::getline(fields, result.name, '\t') &&
+			std::getline(fields, objects, '\t') &&
+			std::getline(fields, nsPerOp, '\t') &&
+			std::getline(fields, allocsPerOp, '\t'))
+		{
+			result.objects = (size_t)atoll(objects.c_str());
+			result.nsPerOp = atof(nsPerOp.c_str());
+			result.allocsPerOp = atof(allocsPerOp.c_str());
+			baseline[std::make_pair(result.name, result.objects)] = result;
+		}
+	}
+
+	return(baseline);
+}
+
+/***********************************************************
+ *  WriteBaseline()
+ *
+ *  This function is used for writing the results as the
+ *  new baseline.  The OpenGL renderer is noted with them,
+ *  since the times only compare on the same machine.
+ ***********************************************************/
+bool WriteBaseline(const std::string& path, const std::vector<BENCH_RESULT>& results)
+{
+	std::ofstream baselineFile(path, std::ios::trunc);
+	if (!baselineFile.is_open())
+	{
+		std::cout << "ERROR: could not write baseline file: " << path << std::endl;
+		return(false);
+	}
+
+	const GLubyte* pRenderer = glGetString(GL_RENDERER);
+	baselineFile << "# MicroBenchmarks baseline - regenerate with: MicroBenchmarks --write-baseline\n";
+	baselineFile << "# measured with the OpenGL renderer: " << ((NULL != pRenderer) ? (const char*)pRenderer : "unknown") << "\n";
+	baselineFile << "# name\tobjects\tns_per_op\tallocs_per_op\n";
+	baselineFile << std::fixed;
+	for (const BENCH_RESULT& result : results)
+	{
+		baselineFile << result.name << "\t" << result.objects << "\t"
+			<< std::setprecision(2) << result.nsPerOp << "\t"
+			<< std::setprecision(4) << result.allocsPerOp << "\n";
+	}
+
+	std::cout << "INFO: wrote baseline " << path << std::endl;
+
+	return(baselineFile.good());
+}
+
+/***********************************************************
+ *  ReportResults()
+ *
+ *  This function is used for printing the results next to
+ *  the baseline.  The number of regressions is returned,
+ *  and the number of results the baseline has no entry for
+ *  is put in missing.
+ ***********************************************************/
+int ReportResults(const std::vector<BENCH_RESULT>& results,
+	const std::map<std::pair<std::string, size_t>, BENCH_RESULT>& baseline,
+	double tolerance,
+	int& missing)
+{
+	int regressions = 0;
+	missing = 0;
+
+	std::cout << std::endl << std::left
+		<< std::setw(40) << "benchmark" << std::right
+		<< std::setw(8) << "objects"
+		<< std::setw(14) << "ns/op"
+		<< std::setw(12) << "allocs/op"
+		<< std::setw(14) << "baseline"
+		<< std::setw(10) << "change" << std::endl;
+
+	for (const BENCH_RESULT& result : results)
+	{
+		std::cout << std::left << std::setw(40) << result.name << std::right
+			<< std::setw(8) << result.objects << std::fixed
+			<< std::setw(14) << std::setprecision(2) << result.nsPerOp
+			<< std::setw(12) << std::setprecision(4) << result.allocsPerOp;
+
+		auto found = baseline.find(std::make_pair(result.name, result.objects));
+		if (found == baseline.end())
+		{
+			std::cout << std::setw(14) << "-" << std::setw(10) << "new" << std::endl;
+			missing++;
+			continue;
+		}
+
+		const BENCH_RESULT& base = found->second;
+		double change = (base.nsPerOp > 0.0) ? (result.nsPerOp / base.nsPerOp - 1.0) : 0.0;
+		bool bSlower = change > tolerance;
+		bool bMoreAllocations = result.allocsPerOp > base.allocsPerOp + 0.01;
+
+		std::cout << std::setw(14) << std::setprecision(2) << base.nsPerOp
+			<< std::setw(9) << std::setprecision(1) << (change * 100.0) << "%";
+		if (bSlower || bMoreAllocations)
+		{
+			std::cout << "  REGRESSION" << (bMoreAllocations ? " (allocations)" : "");
+			regressions++;
+		}
+		std::cout << std::endl;
+	}
+
+	return(regressions);
+}
+
+/***********************************************************
+ *  KeepFastest()
+ *
+ *  This function is used for folding the results of another
+ *  run into the results so far.  Each keeps its fastest
+ *  time and fewest allocations, since load that comes and
+ *  goes for seconds at a time can cover every pass of one
+ *  measurement.
+ ***********************************************************/
+void KeepFastest(std::vector<BENCH_RESULT>& results, const std::vector<BENCH_RESULT>& runResults)
+{
+	if (results.empty())
+	{
+		results = runResults;
+		return;
+	}
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		results[i].nsPerOp = std::min(results[i].nsPerOp, runResults[i].nsPerOp);
+		results[i].allocsPerOp = std::min(results[i].allocsPerOp, runResults[i].allocsPerOp);
+	}
+}
+
+/***********************************************************
+ *  main()
+ *
+ *  This function is the entry point of the micro-benchmarks.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	BENCH_OPTIONS options = ParseOptions(argc, argv);
+
+	GLFWwindow* window = CreateContext(options);
+	if (NULL == window)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	ShaderManager* pShaderManager = new ShaderManager();
+	pShaderManager->LoadShaders(
+		"shaders/vertexShader.glsl",
+		"shaders/fragmentShader.glsl");
+	GLStateCache* pStateCache = new GLStateCache();
+	pStateCache->UseProgram(pShaderManager->m_programID);
+
+	SceneManager* pSceneManager = new SceneManager(pShaderManager, pStateCache);
+	pSceneManager->PrepareScene();
+
+	std::vector<BENCH_RESULT> results;
+	{
+		SceneManagerBenchmark benchmark(pSceneManager, pShaderManager, pStateCache);
+		for (int run = 0; run < options.runs; run++)
+		{
+			std::cout << "INFO: run " << (run + 1) << " of " << options.runs << std::endl;
+			std::vector<BENCH_RESULT> runResults;
+			benchmark.Run(runResults);
+			KeepFastest(results, runResults);
+		}
+	}
+
+	int exitCode = EXIT_SUCCESS;
+	int missing = 0;
+	if (options.bWriteBaseline)
+	{
+		ReportResults(results, LoadBaseline(options.baselinePath), options.tolerance, missing);
+		if (!WriteBaseline(options.baselinePath, results))
+		{
+			exitCode = EXIT_FAILURE;
+		}
+	}
+	else
+	{
+		int regressions = ReportResults(results, LoadBaseline(options.baselinePath), options.tolerance, missing);
+		if (regressions > 0)
+		{
+			std::cout << std::endl << "ERROR: " << regressions << " results regressed past the "
+				<< (options.tolerance * 100.0) << "% tolerance" << std::endl;
+			exitCode = EXIT_FAILURE;
+		}
+
+		// a result without a baseline entry cannot regress, so
+		// --strict fails it rather than letting it pass unchecked
+		if ((missing > 0) && options.bStrict)
+		{
+			std::cout << std::endl << "ERROR: " << missing << " results have no entry in the baseline "
+				<< options.baselinePath << std::endl;
+			exitCode = EXIT_FAILURE;
+		}
+		else if (missing > 0)
+		{
+			std::cout << std::endl << "INFO: " << missing << " results have no entry in the baseline "
+				<< options.baselinePath << " and were not checked" << std::endl;
+		}
+	}
+
+	delete pSceneManager;
+	delete pStateCache;
+	delete pShaderManager;
+	glfwDestroyWindow(window);
+	glfwTerminate();
+
+	return(exitCode);
+}
@@ -0,0 +1,351 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecooker.cpp
+// ============
+// offline tool that converts source images into cooked textures with
+// a prebuilt mip chain, optionally compressed to BC1
+//
+//  usage: TextureCooker [--bc1] [--no-flip] <image> [<image> ...]
+//
+//  each image is written next to its source with the .ctex extension
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CookedTexture.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// one level of the mip chain as RGBA8 pixels
+	struct MIP_LEVEL
+	{
+		uint32_t width;
+		uint32_t height;
+		std::vector<unsigned char> pixels;
+	};
+
+	// every level starts on this boundary in the cooked file
+	const uint32_t LEVEL_ALIGNMENT = 16;
+}
+
+/***********************************************************
+ *  BuildMipChain()
+ *
+ *  This function is used for building the full mip chain
+ *  down to 1x1, each level averaging 2x2 pixels of the one
+ *  above.  An odd row or column is folded into the last
+ *  pixel by clamping the sample position.
+ ***********************************************************/
+std::vector<MIP_LEVEL> BuildMipChain(const unsigned char* pixels, uint32_t width, uint32_t height)
+{
+	std::vector<MIP_LEVEL> levels(1);
+	levels[0].width = width;
+	levels[0].height = height;
+	levels[0].pixels.assign(pixels, pixels + (size_t)width * height * 4);
+
+	while ((levels.back().width > 1) || (levels.back().height > 1))
+	{
+		const MIP_LEVEL& source = levels.back();
+		MIP_LEVEL level;
+		level.width = std::max(1u, source.width / 2);
+		level.height = std::max(1u, source.height / 2);
+		level.pixels.resize((size_t)level.width * level.height * 4);
+
+		for (uint32_t y = 0; y < level.height; y++)
+		{
+			uint32_t y0 = std::min(y * 2, source.height - 1);
+			uint32_t y1 = std::min(y * 2 + 1, source.height - 1);
+			for (uint32_t x = 0; x < level.width; x++)
+			{
+				uint32_t x0 = std::min(x * 2, source.width - 1);
+				uint32_t x1 = std::min(x * 2 + 1, source.width - 1);
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					uint32_t sum =
+						source.pixels[((size_t)y0 * source.width + x0) * 4 + c] +
+						source.pixels[((size_t)y0 * source.width + x1) * 4 + c] +
+						source.pixels[((size_t)y1 * source.width + x0) * 4 + c] +
+						source.pixels[((size_t)y1 * source.width + x1) * 4 + c];
+					level.pixels[((size_t)y * level.width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+
+		levels.push_back(level);
+	}
+
+	return(levels);
+}
+
+/***********************************************************
+ *  PackRGB565()
+ *
+ *  This function is used for packing an 8-bit RGB color into
+ *  the 5:6:5 format used by the BC1 block endpoints.
+ ***********************************************************/
+uint16_t PackRGB565(const int rgb[3])
+{
+	return((uint16_t)(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3)));
+}
+
+/***********************************************************
+ *  UnpackRGB565()
+ *
+ *  This function is used for expanding a 5:6:5 color back
+ *  to 8 bits per channel, the same way the GPU does.
+ ***********************************************************/
+void UnpackRGB565(uint16_t packed, int rgb[3])
+{
+	int r = (packed >> 11) & 0x1F;
+	int g = (packed >> 5) & 0x3F;
+	int b = packed & 0x1F;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+/***********************************************************
+ *  CompressBlockBC1()
+ *
+ *  This function is used for compressing one 4x4 block of
+ *  RGBA8 pixels into 8 bytes of BC1.  The endpoints are the
+ *  corners of the color bounding box, pulled in slightly,
+ *  and every pixel takes the closest of the four colors.
+ ***********************************************************/
+void CompressBlockBC1(const unsigned char block[16][4], unsigned char output[8])
+{
+	int minColor[3] = { 255, 255, 255 };
+	int maxColor[3] = { 0, 0, 0 };
+
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			minColor[c] = std::min(minColor[c], (int)block[i][c]);
+			maxColor[c] = std::max(maxColor[c], (int)block[i][c]);
+		}
+	}
+
+	// inset the bounding box by 1/16 to reduce the error
+	for (int c = 0; c < 3; c++)
+	{
+		int inset = (maxColor[c] - minColor[c]) >> 4;
+		minColor[c] = std::min(255, minColor[c] + inset);
+		maxColor[c] = std::max(0, maxColor[c] - inset);
+	}
+
+	uint16_t color0 = PackRGB565(maxColor);
+	uint16_t color1 = PackRGB565(minColor);
+
+	// color0 > color1 selects the opaque four color mode
+	if (color0 < color1)
+	{
+		std::swap(color0, color1);
+	}
+
+	int palette[4][3];
+	UnpackRGB565(color0, palette[0]);
+	UnpackRGB565(color1, palette[1]);
+	for (int c = 0; c < 3; c++)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			int bestIndex = 0;
+			int bestError = INT32_MAX;
+			for (int p = 0; p < 4; p++)
+			{
+				int error = 0;
+				for (int c = 0; c < 3; c++)
+				{
+					int delta = (int)block[i][c] - palette[p][c];
+					error += delta * delta;
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					bestIndex = p;
+				}
+			}
+			indices |= (uint32_t)bestIndex << (i * 2);
+		}
+	}
+
+	output[0] = (unsigned char)(color0 & 0xFF);
+	output[1] = (unsigned char)(color0 >> 8);
+	output[2] = (unsigned char)(color1 & 0xFF);
+	output[3] = (unsigned char)(color1 >> 8);
+	output[4] = (unsigned char)(indices & 0xFF);
+	output[5] = (unsigned char)((indices >> 8) & 0xFF);
+	output[6] = (unsigned char)((indices >> 16) & 0xFF);
+	output[7] = (unsigned char)(indices >> 24);
+}
+
+/***********************************************************
+ *  CompressLevelBC1()
+ *
+ *  This function is used for compressing a whole mip level
+ *  to BC1.  Blocks along the right and bottom edges repeat
+ *  the last column and row of pixels.
+ ***********************************************************/
+std::vector<unsigned char> CompressLevelBC1(const MIP_LEVEL& level)
+{
+	uint32_t blocksX = (level.width + 3) / 4;
+	uint32_t blocksY = (level.height + 3) / 4;
+	std::vector<unsigned char> output((size_t)blocksX * blocksY * 8);
+
+	for (uint32_t by = 0; by < blocksY; by++)
+	{
+		for (uint32_t bx = 0; bx < blocksX; bx++)
+		{
+			unsigned char block[16][4];
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint32_t x = std::min(bx * 4 + (i % 4), level.width - 1);
+				uint32_t y = std::min(by * 4 + (i / 4), level.height - 1);
+				memcpy(block[i], &level.pixels[((size_t)y * level.width + x) * 4], 4);
+			}
+			CompressBlockBC1(block, &output[((size_t)by * blocksX + bx) * 8]);
+		}
+	}
+
+	return(output);
+}
+
+/***********************************************************
+ *  CookTexture()
+ *
+ *  This function is used for converting one source image
+ *  into a cooked texture file.  True is returned when the
+ *  file was written.
+ ***********************************************************/
+bool CookTexture(const std::string& sourcePath, bool bCompress, bool bFlipY)
+{
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+
+	// match the orientation the runtime loads the images in
+	stbi_set_flip_vertically_on_load(bFlipY);
+
+	// every level is stored with 4 channels
+	unsigned char* image = stbi_load(sourcePath.c_str(), &width, &height, &colorChannels, 4);
+	if (NULL == image)
+	{
+		std::cout << "Could not load image:" << sourcePath << std::endl;
+		return(false);
+	}
+
+	std::vector<MIP_LEVEL> levels = BuildMipChain(image, (uint32_t)width, (uint32_t)height);
+	stbi_image_free(image);
+
+	COOKED_TEXTURE_HEADER header = {};
+	header.magic = COOKED_TEXTURE_MAGIC;
+	header.version = COOKED_TEXTURE_VERSION;
+	header.format = bCompress ? COOKED_FORMAT_BC1 : COOKED_FORMAT_RGBA8;
+	header.flags = bFlipY ? COOKED_FLAG_FLIPPED_Y : 0;
+	header.width = (uint32_t)width;
+	header.height = (uint32_t)height;
+	header.levelCount = (uint32_t)levels.size();
+
+	// lay out the level data after the header and level table
+	std::vector<COOKED_TEXTURE_LEVEL> levelTable(levels.size());
+	std::vector<std::vector<unsigned char>> levelData(levels.size());
+	uint32_t offset = (uint32_t)(sizeof(header) + levelTable.size() * sizeof(COOKED_TEXTURE_LEVEL));
+
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		levelData[i] = bCompress ? CompressLevelBC1(levels[i]) : levels[i].pixels;
+
+		offset = (offset + LEVEL_ALIGNMENT - 1) & ~(LEVEL_ALIGNMENT - 1);
+		levelTable[i].width = levels[i].width;
+		levelTable[i].height = levels[i].height;
+		levelTable[i].offset = offset;
+		levelTable[i].size = GetCookedLevelSize(header.format, levels[i].width, levels[i].height);
+		offset += levelTable[i].size;
+	}
+
+	std::string cookedPath = GetCookedTexturePath(sourcePath);
+	std::ofstream cookedFile(cookedPath, std::ios::binary | std::ios::trunc);
+	if (!cookedFile.is_open())
+	{
+		std::cout << "Could not write cooked texture:" << cookedPath << std::endl;
+		return(false);
+	}
+
+	cookedFile.write((const char*)&header, sizeof(header));
+	cookedFile.write((const char*)levelTable.data(), levelTable.size() * sizeof(COOKED_TEXTURE_LEVEL));
+
+	static const char padding[LEVEL_ALIGNMENT] = {};
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		std::streamoff position = cookedFile.tellp();
+		cookedFile.write(padding, levelTable[i].offset - (uint32_t)position);
+		cookedFile.write((const char*)levelData[i].data(), levelData[i].size());
+	}
+
+	if (!cookedFile.good())
+	{
+		std::cout << "Could not write cooked texture:" << cookedPath << std::endl;
+		return(false);
+	}
+
+	std::cout << "Cooked " << sourcePath << " -> " << cookedPath
+		<< " (" << width << "x" << height << ", " << levels.size() << " levels, "
+		<< (bCompress ? "BC1" : "RGBA8") << ", " << offset << " bytes)" << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  main()
+ *
+ *  This function is the entry point of the texture cooker.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	bool bCompress = false;
+	bool bFlipY = true;
+	std::vector<std::string> sourcePaths;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument == "--bc1")
+			bCompress = true;
+		else if (argument == "--no-flip")
+			bFlipY = false;
+		else
+			sourcePaths.push_back(argument);
+	}
+
+	if (sourcePaths.empty())
+	{
+		std::cout << "usage: TextureCooker [--bc1] [--no-flip] <image> [<image> ...]" << std::endl;
+		return(EXIT_FAILURE);
+	}
+
+	int failures = 0;
+	for (const std::string& sourcePath : sourcePaths)
+	{
+		if (!CookTexture(sourcePath, bCompress, bFlipY))
+		{
+			failures++;
+		}
+	}
+
+	return((failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
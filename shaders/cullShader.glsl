@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+// cullShader.glsl
+// ============
+// test the objects queued for the GPU-driven draws against the view
+// frustum, and copy the ones that can be seen into the object buffer
+// of their draw command
+///////////////////////////////////////////////////////////////////////////////
+
+#version 440 core
+
+// objects tested by one work group - see CULL_GROUP_SIZE in
+// IndirectRenderer.cpp
+layout (local_size_x = 64) in;
+
+// per-object values of the GPU-driven draws - see OBJECT_STD430
+// in UniformBlocks.h
+struct ObjectData
+{
+	mat4 model;
+	vec4 color;
+	vec2 uvScale;
+	int materialIndex;
+};
+
+// world bounds of a queued object - see CULL_BOUNDS_STD430
+// in UniformBlocks.h
+struct CullBounds
+{
+	vec3 center;
+	uint commandIndex;
+	vec3 extents;
+	uint bCullable;
+};
+
+// one indirect draw command, laid out as OpenGL reads it
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+// the objects as queued, and their bounds
+layout (std430, binding = 4) readonly buffer CullInputBuffer
+{
+	ObjectData inputObjects[];
+};
+
+layout (std430, binding = 5) readonly buffer CullBoundsBuffer
+{
+	CullBounds bounds[];
+};
+
+// the commands of the frame, each queued with no instances
+// and room from its base instance for every one of its objects
+layout (std430, binding = 6) buffer CullCommandBuffer
+{
+	DrawCommand commands[];
+};
+
+// the objects that survived, read by the vertex shader
+layout (std430, binding = 3) writeonly buffer ObjectBuffer
+{
+	ObjectData objects[];
+};
+
+// normalized planes of the view frustum, pointing inwards
+uniform vec4 frustumPlanes[6];
+// range of queued objects tested by this dispatch
+uniform int firstObject;
+uniform int objectCount;
+
+void main()
+{
+	if (gl_GlobalInvocationID.x >= uint(objectCount))
+	{
+		return;
+	}
+	uint objectIndex = uint(firstObject) + gl_GlobalInvocationID.x;
+	CullBounds box = bounds[objectIndex];
+
+	// the box is outside when the corner farthest along a
+	// plane normal is still behind that plane
+	if (box.bCullable != 0u)
+	{
+		for (int i = 0; i < 6; i++)
+		{
+			vec4 plane = frustumPlanes[i];
+			if (dot(plane.xyz, box.center) + plane.w + dot(abs(plane.xyz), box.extents) < 0.0f)
+			{
+				return;
+			}
+		}
+	}
+
+	// take the next free instance of the command, so its
+	// surviving objects end up packed from its base instance
+	uint slot = atomicAdd(commands[box.commandIndex].instanceCount, 1u);
+	objects[commands[box.commandIndex].baseInstance + slot] = inputObjects[objectIndex];
+}
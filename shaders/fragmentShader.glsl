@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// fragmentShader.glsl
+// ============
+// shade each fragment with the object color or texture, lit by the
+// scene light sources using the Phong lighting model
+///////////////////////////////////////////////////////////////////////////////
+
+#version 440 core
+
+// the members are ordered so the std140/std430 layouts match
+// MATERIAL_STD140 and LIGHT_SOURCE_STD140 in UniformBlocks.h
+struct Material
+{
+	vec3 ambientColor;
+	float ambientStrength;
+	vec3 diffuseColor;
+	float shininess;
+	vec3 specularColor;
+};
+
+struct LightSource
+{
+	vec3 position;
+	float focalStrength;
+	vec3 ambientColor;
+	float specularIntensity;
+	vec3 diffuseColor;
+	vec3 specularColor;
+};
+
+#define TOTAL_LIGHTS 4
+
+// per-frame camera values
+layout (std140, binding = 0) uniform CameraBlock
+{
+	mat4 projection;
+	mat4 view;
+	vec4 viewPosition;
+};
+
+// scene light sources, written only when the lights change
+layout (std140, binding = 1) uniform LightBlock
+{
+	LightSource lightSources[TOTAL_LIGHTS];
+};
+
+// table of the defined materials, sized by the application
+layout (std430, binding = 2) readonly buffer MaterialBuffer
+{
+	Material materials[];
+};
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+flat in vec4 fragmentObjectColor;
+flat in int fragmentMaterialIndex;
+
+out vec4 outFragmentColor;
+
+uniform bool bUseTexture = false;
+uniform bool bUseLighting = false;
+uniform sampler2D objectTexture;
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+uniform int materialIndex = 0;
+
+vec3 CalcLightSource(LightSource light, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection);
+
+void main()
+{
+	vec4 baseColor = fragmentObjectColor;
+	if (bUseTexture == true)
+	{
+		baseColor = texture(objectTexture, fragmentTextureCoordinate * UVscale);
+	}
+
+	if (bUseLighting == true)
+	{
+		// baked static geometry carries its material per vertex
+		Material material = materials[(fragmentMaterialIndex >= 0) ? fragmentMaterialIndex : materialIndex];
+		vec3 lightNormal = normalize(fragmentVertexNormal);
+		vec3 viewDirection = normalize(viewPosition.xyz - fragmentPosition);
+
+		// the material ambient term is applied once, the light
+		// sources add their own ambient, diffuse and specular terms
+		vec3 phongResult = material.ambientStrength * material.ambientColor;
+		for (int i = 0; i < TOTAL_LIGHTS; i++)
+		{
+			phongResult += CalcLightSource(lightSources[i], material, lightNormal, fragmentPosition, viewDirection);
+		}
+
+		outFragmentColor = vec4(phongResult * baseColor.rgb, baseColor.a);
+	}
+	else
+	{
+		outFragmentColor = baseColor;
+	}
+}
+
+vec3 CalcLightSource(LightSource light, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection)
+{
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+
+	// ambient lighting
+	ambient = light.ambientColor;
+
+	// diffuse lighting
+	vec3 lightDirection = normalize(light.position - vertexPosition);
+	float impact = max(dot(lightNormal, lightDirection), 0.0f);
+	diffuse = impact * light.diffuseColor * material.diffuseColor;
+
+	// specular lighting
+	vec3 reflectDirection = reflect(-lightDirection, lightNormal);
+	float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0f), max(light.focalStrength, material.shininess));
+	specular = light.specularIntensity * specularComponent * light.specularColor * material.specularColor;
+
+	return(ambient + diffuse + specular);
+}
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////
+// vertexShader.glsl
+// ============
+// transform the mesh vertices into clip space and pass the world-space
+// position, normal, texture coordinate, color and material to the
+// fragment shader
+///////////////////////////////////////////////////////////////////////////////
+
+#version 440 core
+
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+// per-instance attributes, only read when bUseInstancing is set
+layout (location = 3) in mat4 inInstanceModel;		// locations 3 to 6
+layout (location = 7) in vec4 inInstanceColor;
+
+// per-vertex attributes of baked static geometry, only read
+// when bUseBakedVertices is set
+layout (location = 8) in vec4 inVertexColor;
+layout (location = 9) in float inMaterialIndex;
+
+// index of the object of a GPU-driven draw into the object
+// buffer, only read when bUseObjectBuffer is set
+layout (location = 10) in uint inObjectIndex;
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+flat out vec4 fragmentObjectColor;
+flat out int fragmentMaterialIndex;	// -1 to use the materialIndex uniform
+
+// per-frame camera values - see CAMERA_BLOCK in UniformBlocks.h
+layout (std140, binding = 0) uniform CameraBlock
+{
+	mat4 projection;
+	mat4 view;
+	vec4 viewPosition;
+};
+
+// per-object values of the GPU-driven draws - see OBJECT_STD430
+// in UniformBlocks.h
+struct ObjectData
+{
+	mat4 model;
+	vec4 color;
+	vec2 uvScale;
+	int materialIndex;
+};
+
+layout (std430, binding = 3) readonly buffer ObjectBuffer
+{
+	ObjectData objects[];
+};
+
+uniform mat4 model;
+uniform vec4 objectColor = vec4(1.0f);
+uniform bool bUseInstancing = false;
+uniform bool bUseBakedVertices = false;
+uniform bool bUseObjectBuffer = false;
+
+void main()
+{
+	mat4 worldMatrix = model;
+	vec4 color = objectColor;
+	int material = -1;
+	vec2 uvScale = vec2(1.0f);
+
+	if (bUseInstancing == true)
+	{
+		worldMatrix = inInstanceModel;
+		color = inInstanceColor;
+	}
+	else if (bUseBakedVertices == true)
+	{
+		// already in world space
+		worldMatrix = mat4(1.0f);
+		color = inVertexColor;
+		material = int(inMaterialIndex);
+	}
+	else if (bUseObjectBuffer == true)
+	{
+		worldMatrix = objects[inObjectIndex].model;
+		color = objects[inObjectIndex].color;
+		uvScale = objects[inObjectIndex].uvScale;
+		material = objects[inObjectIndex].materialIndex;
+	}
+
+	fragmentPosition = vec3(worldMatrix * vec4(inVertexPosition, 1.0f));
+	fragmentVertexNormal = mat3(transpose(inverse(worldMatrix))) * inVertexNormal;
+	fragmentTextureCoordinate = inTextureCoordinate * uvScale;
+	fragmentObjectColor = color;
+	fragmentMaterialIndex = material;
+
+	gl_Position = projection * view * vec4(fragmentPosition, 1.0f);
+}